@@ -33,3 +33,12 @@ function(karen_add_test test_name test_source test_link_libs)
    target_link_libraries(${test_name} ${test_link_libs})
    add_test("${test_name}" "${test_name}")
 endfunction(karen_add_test)
+
+function(karen_add_benchmark bench_name bench_sources bench_link_libs)
+   add_executable(${bench_name} ${bench_sources})
+   set_target_properties(${bench_name} PROPERTIES
+      COMPILE_FLAGS "${karen_cxx_flags}"
+      LINK_FLAGS "${karen_ld_flags}"
+   )
+   target_link_libraries(${bench_name} ${bench_link_libs})
+endfunction(karen_add_benchmark)
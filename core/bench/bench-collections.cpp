@@ -0,0 +1,901 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <list>
+#include <map>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <KarenCore/allocator.h>
+#include <KarenCore/array.h>
+#include <KarenCore/bench.h>
+#include <KarenCore/heap.h>
+#include <KarenCore/list.h>
+#include <KarenCore/map.h>
+#include <KarenCore/queue.h>
+#include <KarenCore/set.h>
+
+using namespace karen;
+
+/*
+ * Number of elements of the collections used by lookup benchmarks.
+ */
+static const int COLLECTION_SIZE = 1024;
+
+typedef TreeMap<int, int> IntTreeMap;
+typedef BTreeMap<int, int> IntBTreeMap;
+
+/*
+ * Obtain a map of given type whose keys are the even numbers below twice
+ * given size. Building the large ones takes long, so the last map built 
+ * is kept for the benchmarks that follow on the same size.
+ */
+template <class MapType>
+static const MapType&
+orderedMapFixture(int size)
+{
+   static MapType* map = NULL;
+   static int mapSize = 0;
+   if (mapSize != size)
+   {
+      delete map;
+      std::vector<Tuple<const int, int> > entries;
+      entries.reserve(size);
+      for (int i = 0; i < size; i++)
+         entries.push_back(Tuple<const int, int>(i * 2, i));
+      map = new MapType(&entries[0], size);
+      mapSize = size;
+   }
+   return *map;
+}
+
+/*
+ * Ordered map benchmarks on given size: random lookups, and a sequential
+ * scan that visits one entry per iteration.
+ */
+#define KAREN_DECL_ORDERED_MAP_BENCHMARKS(MapType, size) \
+   KAREN_DECL_BENCHMARK(MapType##Get_##size, \
+   { \
+      const MapType& m = orderedMapFixture<MapType>(size); \
+      resetMeasurement(); \
+      unsigned int seed = 1; \
+      unsigned long sum = 0; \
+      for (unsigned long i = 0; i < iterations; i++) \
+      { \
+         seed = seed * 1103515245 + 12345; \
+         sum += m.get((int) ((seed >> 8) % size) * 2); \
+      } \
+      doNotOptimize(sum); \
+   }); \
+   KAREN_DECL_BENCHMARK(MapType##Scan_##size, \
+   { \
+      const MapType& m = orderedMapFixture<MapType>(size); \
+      resetMeasurement(); \
+      MapType::ConstFastIterator it = m.fastEnd(); \
+      unsigned long sum = 0; \
+      for (unsigned long i = 0; i < iterations; i++) \
+      { \
+         if (it == m.fastEnd()) \
+            it = m.fastBegin(); \
+         sum += (it++)->get<1>(); \
+      } \
+      doNotOptimize(sum); \
+   });
+
+KAREN_BEGIN_BENCHMARK_SUITE(ArrayBenchmarks);
+
+   KAREN_DECL_BENCHMARK(dynArrayAppend,
+   {
+      DynArray<int> a;
+      for (unsigned long i = 0; i < iterations; i++)
+         a.append((int) i);
+      doNotOptimize(a);
+   });
+
+   KAREN_DECL_BENCHMARK(stdVectorPushBack,
+   {
+      std::vector<int> a;
+      for (unsigned long i = 0; i < iterations; i++)
+         a.push_back((int) i);
+      doNotOptimize(a);
+   });
+
+   KAREN_DECL_BENCHMARK(dynArrayGet,
+   {
+      DynArray<int> a(COLLECTION_SIZE);
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += a.get(i % COLLECTION_SIZE);
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(stdVectorAt,
+   {
+      std::vector<int> a(COLLECTION_SIZE);
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += a.at(i % COLLECTION_SIZE);
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(dynArrayShortLived,
+   {
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         DynArray<int> a;
+         for (int j = 0; j < 8; j++)
+            a.append(j);
+         doNotOptimize(a);
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(smallDynArrayShortLived,
+   {
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         SmallDynArray<int, 8> a;
+         for (int j = 0; j < 8; j++)
+            a.append(j);
+         doNotOptimize(a);
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(dynArrayFromRawArray,
+   {
+      int raw[COLLECTION_SIZE] = { 0 };
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         DynArray<int> a(raw, COLLECTION_SIZE);
+         doNotOptimize(a);
+      }
+   });
+
+KAREN_END_BENCHMARK_SUITE(ArrayBenchmarks);
+
+KAREN_BEGIN_BENCHMARK_SUITE(ListBenchmarks);
+
+   KAREN_DECL_BENCHMARK(linkedListInsertRemove,
+   {
+      LinkedList<int> l;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         l.insertBack((int) i);
+         l.insertFront((int) i);
+         l.removeFirst();
+         l.removeLast();
+      }
+      doNotOptimize(l);
+   });
+
+   KAREN_DECL_BENCHMARK(stdListInsertRemove,
+   {
+      std::list<int> l;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         l.push_back((int) i);
+         l.push_front((int) i);
+         l.pop_front();
+         l.pop_back();
+      }
+      doNotOptimize(l);
+   });
+
+KAREN_END_BENCHMARK_SUITE(ListBenchmarks);
+
+KAREN_BEGIN_BENCHMARK_SUITE(MapBenchmarks);
+
+   KAREN_DECL_BENCHMARK(treeMapPut,
+   {
+      TreeMap<int, int> m;
+      for (unsigned long i = 0; i < iterations; i++)
+         m.put((int) (i % COLLECTION_SIZE), (int) i);
+      doNotOptimize(m);
+   });
+
+   KAREN_DECL_BENCHMARK(stdMapInsert,
+   {
+      std::map<int, int> m;
+      for (unsigned long i = 0; i < iterations; i++)
+         m[(int) (i % COLLECTION_SIZE)] = (int) i;
+      doNotOptimize(m);
+   });
+
+   KAREN_DECL_BENCHMARK(treeMapGet,
+   {
+      TreeMap<int, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m.put(i, i);
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += m.get((int) (i % COLLECTION_SIZE));
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(treeMapHasKey,
+   {
+      TreeMap<int, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m.put(i * 2, i);
+      resetMeasurement();
+      int hits = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         hits += m.hasKey((int) (i % (2 * COLLECTION_SIZE))) ? 1 : 0;
+      doNotOptimize(hits);
+   });
+
+   KAREN_DECL_BENCHMARK(stdMapFind,
+   {
+      std::map<int, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m[i] = i;
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += m.find((int) (i % COLLECTION_SIZE))->second;
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(hashMapPut,
+   {
+      HashMap<int, int> m;
+      for (unsigned long i = 0; i < iterations; i++)
+         m.put((int) (i % COLLECTION_SIZE), (int) i);
+      doNotOptimize(m);
+   });
+
+   KAREN_DECL_BENCHMARK(hashMapGet,
+   {
+      HashMap<int, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m.put(i, i);
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += m.get((int) (i % COLLECTION_SIZE));
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(hashMapHasKey,
+   {
+      HashMap<int, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m.put(i * 2, i);
+      resetMeasurement();
+      int hits = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         hits += m.hasKey((int) (i % (2 * COLLECTION_SIZE))) ? 1 : 0;
+      doNotOptimize(hits);
+   });
+
+   KAREN_DECL_BENCHMARK(stdUnorderedMapFind,
+   {
+      std::unordered_map<int, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m[i] = i;
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += m.find((int) (i % COLLECTION_SIZE))->second;
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(treeMapGetPointerKey,
+   {
+      static int objects[COLLECTION_SIZE];
+      TreeMap<const int*, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m.put(&objects[i], i);
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += m.get(&objects[i % COLLECTION_SIZE]);
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(hashMapGetPointerKey,
+   {
+      static int objects[COLLECTION_SIZE];
+      HashMap<const int*, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m.put(&objects[i], i);
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += m.get(&objects[i % COLLECTION_SIZE]);
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(hashMapGetStringKey,
+   {
+      HashMap<String, int> m;
+      DynArray<String> keys;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+      {
+         keys.append(String::format("key-%d", i));
+         m.put(keys[i], i);
+      }
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += m.get(keys[i % COLLECTION_SIZE]);
+      doNotOptimize(sum);
+   });
+
+KAREN_END_BENCHMARK_SUITE(MapBenchmarks);
+
+KAREN_BEGIN_BENCHMARK_SUITE(OrderedMapBenchmarks);
+
+   KAREN_DECL_BENCHMARK(treeMapPutRandom,
+   {
+      TreeMap<int, int> m;
+      unsigned int seed = 1;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         m.put((int) (seed >> 1), (int) i);
+      }
+      doNotOptimize(m);
+   });
+
+   KAREN_DECL_BENCHMARK(btreeMapPutRandom,
+   {
+      BTreeMap<int, int> m;
+      unsigned int seed = 1;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         m.put((int) (seed >> 1), (int) i);
+      }
+      doNotOptimize(m);
+   });
+
+   KAREN_DECL_BENCHMARK(treeMapBuildSorted,
+   {
+      std::vector<Tuple<const int, int> > entries;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         entries.push_back(Tuple<const int, int>(i, i));
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         TreeMap<int, int> m(&entries[0], COLLECTION_SIZE);
+         doNotOptimize(m);
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(btreeMapBuildSorted,
+   {
+      std::vector<Tuple<const int, int> > entries;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         entries.push_back(Tuple<const int, int>(i, i));
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         BTreeMap<int, int> m(&entries[0], COLLECTION_SIZE);
+         doNotOptimize(m);
+      }
+   });
+
+   KAREN_DECL_ORDERED_MAP_BENCHMARKS(IntTreeMap, 1000);
+   KAREN_DECL_ORDERED_MAP_BENCHMARKS(IntBTreeMap, 1000);
+   KAREN_DECL_ORDERED_MAP_BENCHMARKS(IntTreeMap, 10000);
+   KAREN_DECL_ORDERED_MAP_BENCHMARKS(IntBTreeMap, 10000);
+   KAREN_DECL_ORDERED_MAP_BENCHMARKS(IntTreeMap, 100000);
+   KAREN_DECL_ORDERED_MAP_BENCHMARKS(IntBTreeMap, 100000);
+   KAREN_DECL_ORDERED_MAP_BENCHMARKS(IntTreeMap, 1000000);
+   KAREN_DECL_ORDERED_MAP_BENCHMARKS(IntBTreeMap, 1000000);
+   KAREN_DECL_ORDERED_MAP_BENCHMARKS(IntTreeMap, 10000000);
+   KAREN_DECL_ORDERED_MAP_BENCHMARKS(IntBTreeMap, 10000000);
+
+KAREN_END_BENCHMARK_SUITE(OrderedMapBenchmarks);
+
+KAREN_BEGIN_BENCHMARK_SUITE(SetBenchmarks);
+
+   KAREN_DECL_BENCHMARK(treeSetInsert,
+   {
+      TreeSet<int> s;
+      for (unsigned long i = 0; i < iterations; i++)
+         s.insert((int) (i % COLLECTION_SIZE));
+      doNotOptimize(s);
+   });
+
+   KAREN_DECL_BENCHMARK(stdSetInsert,
+   {
+      std::set<int> s;
+      for (unsigned long i = 0; i < iterations; i++)
+         s.insert((int) (i % COLLECTION_SIZE));
+      doNotOptimize(s);
+   });
+
+   KAREN_DECL_BENCHMARK(hashSetInsert,
+   {
+      HashSet<int> s;
+      for (unsigned long i = 0; i < iterations; i++)
+         s.insert((int) (i % COLLECTION_SIZE));
+      doNotOptimize(s);
+   });
+
+   KAREN_DECL_BENCHMARK(stdUnorderedSetInsert,
+   {
+      std::unordered_set<int> s;
+      for (unsigned long i = 0; i < iterations; i++)
+         s.insert((int) (i % COLLECTION_SIZE));
+      doNotOptimize(s);
+   });
+
+KAREN_END_BENCHMARK_SUITE(SetBenchmarks);
+
+KAREN_BEGIN_BENCHMARK_SUITE(QueueBenchmarks);
+
+   KAREN_DECL_BENCHMARK(priorityQueuePutPoll,
+   {
+      PriorityQueue<int> q;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         q.put(i);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         q.put(q.poll() - COLLECTION_SIZE);
+      doNotOptimize(q);
+   });
+
+   KAREN_DECL_BENCHMARK(stdPriorityQueuePushPop,
+   {
+      std::priority_queue<int> q;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         q.push(i);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         int t = q.top();
+         q.pop();
+         q.push(t - COLLECTION_SIZE);
+      }
+      doNotOptimize(q);
+   });
+
+   KAREN_DECL_BENCHMARK(heapPriorityQueuePutPoll,
+   {
+      PriorityQueue<int, DefaultLessThan<int>, DaryHeap<int> > q;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         q.put(i);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         q.put(q.poll() - COLLECTION_SIZE);
+      doNotOptimize(q);
+   });
+
+   KAREN_DECL_BENCHMARK(treeMultisetInsertRandom,
+   {
+      TreeMultiset<int> s;
+      unsigned int seed = 1;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         s.insert((int) (seed >> 1));
+      }
+      doNotOptimize(s);
+   });
+
+   KAREN_DECL_BENCHMARK(daryHeapInsertRandom,
+   {
+      DaryHeap<int> h;
+      unsigned int seed = 1;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         h.insert((int) (seed >> 1));
+      }
+      doNotOptimize(h);
+   });
+
+   KAREN_DECL_BENCHMARK(daryHeapHeapifyRandom,
+   {
+      std::vector<int> elems(iterations);
+      unsigned int seed = 1;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         elems[i] = (int) (seed >> 1);
+      }
+      resetMeasurement();
+      DaryHeap<int> h(&elems[0], iterations);
+      doNotOptimize(h);
+   });
+
+   /*
+    * Change the priority of random elements, as a timer queue does when
+    * timers are rescheduled. The tree has no handles, so it removes each
+    * element through an iterator and inserts it again.
+    */
+   KAREN_DECL_BENCHMARK(treeMultisetReschedule,
+   {
+      TreeMultiset<int> s;
+      std::vector<Iterator<const int> > its;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         its.push_back(s.insert(i * 16));
+      resetMeasurement();
+      unsigned int seed = 1;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         Iterator<const int>& it = its[(seed >> 8) % COLLECTION_SIZE];
+         s.remove(it);
+         it = s.insert((int) ((seed >> 1) % (COLLECTION_SIZE * 16)));
+      }
+      doNotOptimize(s);
+   });
+
+   KAREN_DECL_BENCHMARK(daryHeapReschedule,
+   {
+      DaryHeap<int> h;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         h.insert(i * 16);
+      resetMeasurement();
+      unsigned int seed = 1;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         h.update((seed >> 8) % COLLECTION_SIZE, 
+               (int) ((seed >> 1) % (COLLECTION_SIZE * 16)));
+      }
+      doNotOptimize(h);
+   });
+
+KAREN_END_BENCHMARK_SUITE(QueueBenchmarks);
+
+/*
+ * Payload long enough to be stored out of line, so each copy of it costs
+ * an allocation that is reported by the benchmarks.
+ */
+static const String PAYLOAD("a payload that does not fit in small strings");
+
+KAREN_BEGIN_BENCHMARK_SUITE(MoveBenchmarks);
+
+   KAREN_DECL_BENCHMARK(dynArrayAppendCopy,
+   {
+      DynArray<String> a;
+      a.reserve(1);
+      String s(PAYLOAD);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         a.append(s);
+         a.clear();
+      }
+      doNotOptimize(a);
+   });
+
+   KAREN_DECL_BENCHMARK(dynArrayAppendMove,
+   {
+      DynArray<String> a;
+      a.reserve(1);
+      String s(PAYLOAD);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         a.append(std::move(s));
+         s = std::move(a[0]);
+         a.clear();
+      }
+      doNotOptimize(a);
+   });
+
+   KAREN_DECL_BENCHMARK(queuePutPollCopy,
+   {
+      Queue<String> q;
+      String s(PAYLOAD);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         q.put(s);
+         doNotOptimize(q.poll());
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(queuePutPollMove,
+   {
+      Queue<String> q;
+      String s(PAYLOAD);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         q.put(std::move(s));
+         s = q.poll();
+      }
+      doNotOptimize(s);
+   });
+
+   KAREN_DECL_BENCHMARK(priorityQueuePutPollCopy,
+   {
+      PriorityQueue<String> q;
+      String s(PAYLOAD);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         q.put(s);
+         doNotOptimize(q.poll());
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(priorityQueuePutPollMove,
+   {
+      PriorityQueue<String> q;
+      String s(PAYLOAD);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         q.put(std::move(s));
+         s = q.poll();
+      }
+      doNotOptimize(s);
+   });
+
+   KAREN_DECL_BENCHMARK(treeMapPutCopy,
+   {
+      TreeMap<int, String> m;
+      String s(PAYLOAD);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         m.put(0, s);
+         m.remove(0);
+      }
+      doNotOptimize(m);
+   });
+
+   KAREN_DECL_BENCHMARK(treeMapPutMove,
+   {
+      TreeMap<int, String> m;
+      String s(PAYLOAD);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         m.put(0, std::move(s));
+         s = std::move(m.get(0));
+         m.remove(0);
+      }
+      doNotOptimize(m);
+   });
+
+KAREN_END_BENCHMARK_SUITE(MoveBenchmarks);
+
+/*
+ * Benchmark inserting and removing elements at both ends of a linked
+ * list which nodes are obtained from given allocator.
+ */
+#define KAREN_DECL_LIST_CHURN_BENCHMARK(name, ListType) \
+   KAREN_DECL_BENCHMARK(name, \
+   { \
+      ListType l; \
+      for (unsigned long i = 0; i < iterations; i++) \
+      { \
+         l.insertBack((int) i); \
+         l.insertFront((int) i); \
+         l.removeFirst(); \
+         l.removeLast(); \
+      } \
+      doNotOptimize(l); \
+   })
+
+/*
+ * Benchmark replacing the entries of a tree map of COLLECTION_SIZE 
+ * entries which nodes are obtained from given allocator.
+ */
+#define KAREN_DECL_TREE_MAP_CHURN_BENCHMARK(name, MapType) \
+   KAREN_DECL_BENCHMARK(name, \
+   { \
+      MapType m; \
+      for (int i = 0; i < COLLECTION_SIZE; i++) \
+         m.put(i, i); \
+      resetMeasurement(); \
+      for (unsigned long i = 0; i < iterations; i++) \
+      { \
+         int k = (int) (i * 7919) % COLLECTION_SIZE; \
+         m.remove(k); \
+         m.put(k, k); \
+      } \
+      doNotOptimize(m); \
+   })
+
+/*
+ * Benchmark replacing the elements of a tree set of COLLECTION_SIZE 
+ * elements which nodes are obtained from given allocator.
+ */
+#define KAREN_DECL_TREE_SET_CHURN_BENCHMARK(name, SetType) \
+   KAREN_DECL_BENCHMARK(name, \
+   { \
+      SetType s; \
+      for (int i = 0; i < COLLECTION_SIZE; i++) \
+         s.insert(i); \
+      resetMeasurement(); \
+      for (unsigned long i = 0; i < iterations; i++) \
+      { \
+         int k = (int) (i * 7919) % COLLECTION_SIZE; \
+         s.removeAll(k); \
+         s.insert(k); \
+      } \
+      doNotOptimize(s); \
+   })
+
+typedef LinkedList<int, PoolAllocator<int> > PoolIntLinkedList;
+typedef LinkedList<int, ArenaAllocator<int> > ArenaIntLinkedList;
+typedef TreeMap<int, int, PoolAllocator<Tuple<const int, int> > > 
+      PoolIntTreeMap;
+typedef TreeSet<int, DefaultLessThan<int>, PoolAllocator<int> > 
+      PoolIntTreeSet;
+typedef TreeMultiset<int, DefaultLessThan<int>, PoolAllocator<int> > 
+      PoolIntTreeMultiset;
+
+KAREN_BEGIN_BENCHMARK_SUITE(AllocatorBenchmarks);
+
+   KAREN_DECL_LIST_CHURN_BENCHMARK(
+         linkedListChurn, LinkedList<int>);
+   KAREN_DECL_LIST_CHURN_BENCHMARK(
+         poolLinkedListChurn, PoolIntLinkedList);
+
+   KAREN_DECL_BENCHMARK(arenaLinkedListBuild,
+   {
+      Arena arena;
+      for (unsigned long i = 0; i < iterations; i += COLLECTION_SIZE)
+      {
+         {
+            ArenaIntLinkedList l((ArenaAllocator<int>(arena)));
+            for (int j = 0; j < COLLECTION_SIZE; j++)
+               l.insertBack(j);
+            doNotOptimize(l);
+         }
+         // The list must be destroyed before its nodes are released
+         arena.release();
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(linkedListBuild,
+   {
+      for (unsigned long i = 0; i < iterations; i += COLLECTION_SIZE)
+      {
+         LinkedList<int> l;
+         for (int j = 0; j < COLLECTION_SIZE; j++)
+            l.insertBack(j);
+         doNotOptimize(l);
+      }
+   });
+
+   KAREN_DECL_TREE_MAP_CHURN_BENCHMARK(
+         treeMapChurn, IntTreeMap);
+   KAREN_DECL_TREE_MAP_CHURN_BENCHMARK(
+         poolTreeMapChurn, PoolIntTreeMap);
+
+   KAREN_DECL_TREE_SET_CHURN_BENCHMARK(
+         treeSetChurn, TreeSet<int>);
+   KAREN_DECL_TREE_SET_CHURN_BENCHMARK(
+         poolTreeSetChurn, PoolIntTreeSet);
+
+   KAREN_DECL_TREE_SET_CHURN_BENCHMARK(
+         treeMultisetChurn, TreeMultiset<int>);
+   KAREN_DECL_TREE_SET_CHURN_BENCHMARK(
+         poolTreeMultisetChurn, PoolIntTreeMultiset);
+
+KAREN_END_BENCHMARK_SUITE(AllocatorBenchmarks);
+
+KAREN_BEGIN_BENCHMARK_SUITE(LookupMissBenchmarks);
+
+   KAREN_DECL_BENCHMARK(treeMapGetMissCatch,
+   {
+      TreeMap<int, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m.put(i * 2, i);
+      resetMeasurement();
+      int misses = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         try { m.get((int) (i % COLLECTION_SIZE) * 2 + 1); }
+         catch (NotFoundException&) { misses++; }
+      }
+      doNotOptimize(misses);
+   });
+
+   KAREN_DECL_BENCHMARK(treeMapTryGetMiss,
+   {
+      TreeMap<int, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m.put(i * 2, i);
+      resetMeasurement();
+      int misses = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         misses += m.tryGet((int) (i % COLLECTION_SIZE) * 2 + 1) ? 0 : 1;
+      doNotOptimize(misses);
+   });
+
+   KAREN_DECL_BENCHMARK(hashMapGetMissCatch,
+   {
+      HashMap<int, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m.put(i * 2, i);
+      resetMeasurement();
+      int misses = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         try { m.get((int) (i % COLLECTION_SIZE) * 2 + 1); }
+         catch (NotFoundException&) { misses++; }
+      }
+      doNotOptimize(misses);
+   });
+
+   KAREN_DECL_BENCHMARK(hashMapTryGetMiss,
+   {
+      HashMap<int, int> m;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         m.put(i * 2, i);
+      resetMeasurement();
+      int misses = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         misses += m.tryGet((int) (i % COLLECTION_SIZE) * 2 + 1) ? 0 : 1;
+      doNotOptimize(misses);
+   });
+
+   KAREN_DECL_BENCHMARK(dynArrayGetOutOfBoundsCatch,
+   {
+      DynArray<int> a;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         a.append(i);
+      resetMeasurement();
+      int misses = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         try { a.get(COLLECTION_SIZE + i % 16); }
+         catch (OutOfBoundsException&) { misses++; }
+      }
+      doNotOptimize(misses);
+   });
+
+   KAREN_DECL_BENCHMARK(dynArrayTryGetOutOfBounds,
+   {
+      DynArray<int> a;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         a.append(i);
+      resetMeasurement();
+      int misses = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         misses += a.tryGet(COLLECTION_SIZE + i % 16) ? 0 : 1;
+      doNotOptimize(misses);
+   });
+
+   KAREN_DECL_BENCHMARK(hashSetFind,
+   {
+      HashSet<int> s;
+      for (int i = 0; i < COLLECTION_SIZE; i++)
+         s.insert(i * 2);
+      resetMeasurement();
+      int hits = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         hits += s.find((int) (i % (2 * COLLECTION_SIZE))) ? 1 : 0;
+      doNotOptimize(hits);
+   });
+
+KAREN_END_BENCHMARK_SUITE(LookupMissBenchmarks);
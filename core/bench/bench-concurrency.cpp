@@ -0,0 +1,338 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <KarenCore/bench.h>
+#include <KarenCore/concurrent-queue.h>
+#include <KarenCore/pointer.h>
+
+using namespace karen;
+
+/*
+ * Capacity of the queues shared by the threads.
+ */
+static const int QUEUE_CAPACITY = 1024;
+
+/*
+ * Number of elements put and polled at once by batch benchmarks.
+ */
+static const int BATCH_SIZE = 32;
+
+/*
+ * Bounded queue guarded by a mutex, as a reference for the lock-free one.
+ */
+class LockedQueue
+{
+public:
+
+   inline LockedQueue(unsigned long capacity) : _capacity(capacity) {}
+
+   inline void put(long t)
+   {
+      std::unique_lock<std::mutex> lock(_mutex);
+      while (_queue.size() >= _capacity)
+         _notFull.wait(lock);
+      _queue.push_back(t);
+      _notEmpty.notify_one();
+   }
+
+   inline long poll()
+   {
+      std::unique_lock<std::mutex> lock(_mutex);
+      while (_queue.empty())
+         _notEmpty.wait(lock);
+      long t = _queue.front();
+      _queue.pop_front();
+      _notFull.notify_one();
+      return t;
+   }
+
+private:
+
+   unsigned long           _capacity;
+   std::deque<long>        _queue;
+   std::mutex              _mutex;
+   std::condition_variable _notEmpty;
+   std::condition_variable _notFull;
+
+};
+
+/*
+ * Pass given number of elements from producer threads to consumer 
+ * threads through a queue of given type, one element at a time.
+ */
+template <class QueueType>
+static long
+passElements(unsigned int producers, 
+             unsigned int consumers, 
+             unsigned long count)
+{
+   QueueType q(QUEUE_CAPACITY);
+   std::vector<std::thread> threads;
+   std::vector<long> sums(consumers, 0);
+   for (unsigned int p = 0; p < producers; p++)
+   {
+      unsigned long share = count / producers + (p < count % producers);
+      threads.push_back(std::thread([&q, share]()
+      {
+         for (unsigned long i = 0; i < share; i++)
+            q.put((long) i);
+      }));
+   }
+   for (unsigned int c = 0; c < consumers; c++)
+   {
+      unsigned long share = count / consumers + (c < count % consumers);
+      threads.push_back(std::thread([&q, &sums, c, share]()
+      {
+         for (unsigned long i = 0; i < share; i++)
+            sums[c] += q.poll();
+      }));
+   }
+   long sum = 0;
+   for (unsigned int i = 0; i < threads.size(); i++)
+      threads[i].join();
+   for (unsigned int c = 0; c < consumers; c++)
+      sum += sums[c];
+   return sum;
+}
+
+/*
+ * Pass given number of elements from one producer thread to one consumer
+ * thread through a concurrent queue, in batches of BATCH_SIZE elements.
+ */
+template <class QueueType>
+static long
+passBatches(unsigned long count)
+{
+   QueueType q(QUEUE_CAPACITY);
+   long sum = 0;
+   std::thread producer([&q, count]()
+   {
+      long batch[BATCH_SIZE];
+      for (int i = 0; i < BATCH_SIZE; i++)
+         batch[i] = i;
+      unsigned long put = 0;
+      while (put < count)
+      {
+         unsigned long n = count - put;
+         if (n > BATCH_SIZE)
+            n = BATCH_SIZE;
+         n = q.putAll(batch, n);
+         if (!n)
+            std::this_thread::yield();
+         put += n;
+      }
+   });
+   std::thread consumer([&q, &sum, count]()
+   {
+      long batch[BATCH_SIZE];
+      unsigned long polled = 0;
+      while (polled < count)
+      {
+         unsigned long n = q.pollMany(batch, BATCH_SIZE);
+         if (!n)
+            std::this_thread::yield();
+         for (unsigned long i = 0; i < n; i++)
+            sum += batch[i];
+         polled += n;
+      }
+   });
+   producer.join();
+   consumer.join();
+   return sum;
+}
+
+typedef ConcurrentQueue<long> MpmcQueue;
+typedef ConcurrentQueue<long, SINGLE_PRODUCER_CONSUMER> SpscQueue;
+
+/*
+ * Benchmark passing elements through given queue type with given number
+ * of producer and consumer threads.
+ */
+#define KAREN_DECL_CONTENTION_BENCHMARK(QueueType, producers, consumers) \
+   KAREN_DECL_BENCHMARK(QueueType##_##producers##x##consumers, \
+   { \
+      doNotOptimize(passElements<QueueType>( \
+            producers, consumers, iterations)); \
+   })
+
+KAREN_BEGIN_BENCHMARK_SUITE(ConcurrentQueueBenchmarks);
+
+   KAREN_DECL_BENCHMARK(mpmcQueueTryPutPoll,
+   {
+      MpmcQueue q(QUEUE_CAPACITY);
+      long t = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         q.tryPut((long) i);
+         q.tryPoll(t);
+      }
+      doNotOptimize(t);
+   });
+
+   KAREN_DECL_BENCHMARK(spscQueueTryPutPoll,
+   {
+      SpscQueue q(QUEUE_CAPACITY);
+      long t = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         q.tryPut((long) i);
+         q.tryPoll(t);
+      }
+      doNotOptimize(t);
+   });
+
+   KAREN_DECL_CONTENTION_BENCHMARK(LockedQueue, 1, 1);
+   KAREN_DECL_CONTENTION_BENCHMARK(LockedQueue, 2, 2);
+   KAREN_DECL_CONTENTION_BENCHMARK(LockedQueue, 4, 4);
+   KAREN_DECL_CONTENTION_BENCHMARK(MpmcQueue, 1, 1);
+   KAREN_DECL_CONTENTION_BENCHMARK(MpmcQueue, 2, 2);
+   KAREN_DECL_CONTENTION_BENCHMARK(MpmcQueue, 4, 4);
+   KAREN_DECL_CONTENTION_BENCHMARK(MpmcQueue, 4, 1);
+   KAREN_DECL_CONTENTION_BENCHMARK(SpscQueue, 1, 1);
+
+   KAREN_DECL_BENCHMARK(MpmcQueueBatches_1x1,
+   {
+      doNotOptimize(passBatches<MpmcQueue>(iterations));
+   });
+
+   KAREN_DECL_BENCHMARK(SpscQueueBatches_1x1,
+   {
+      doNotOptimize(passBatches<SpscQueue>(iterations));
+   });
+
+KAREN_END_BENCHMARK_SUITE(ConcurrentQueueBenchmarks);
+
+/*
+ * Copy and release given shared pointer from given number of threads, 
+ * as many times as given in total.
+ */
+template <class PtrType>
+static void
+copyShared(const PtrType& shared, unsigned int nthreads, unsigned long count)
+{
+   std::vector<std::thread> threads;
+   for (unsigned int t = 0; t < nthreads; t++)
+   {
+      unsigned long share = count / nthreads + (t < count % nthreads);
+      threads.push_back(std::thread([&shared, share]()
+      {
+         for (unsigned long i = 0; i < share; i++)
+         {
+            PtrType copy = shared;
+            Benchmark::doNotOptimize(copy);
+         }
+      }));
+   }
+   for (unsigned int i = 0; i < threads.size(); i++)
+      threads[i].join();
+}
+
+/*
+ * Small objects whose creation is dominated by their allocation.
+ */
+struct SmallObject
+{
+   unsigned long value;
+
+   SmallObject() : value(0) {}
+};
+
+struct RefCountedSmallObject : public SmallObject, public RefCounted<> {};
+
+/*
+ * Benchmark copying a shared pointer of given type from given number of
+ * threads at the same time.
+ */
+#define KAREN_DECL_REFCOUNT_BENCHMARK(PtrType, nthreads) \
+   KAREN_DECL_BENCHMARK(PtrType##Copy_##nthreads##Threads, \
+   { \
+      PtrType<int> shared = new int(0); \
+      resetMeasurement(); \
+      copyShared(shared, nthreads, iterations); \
+   })
+
+KAREN_BEGIN_BENCHMARK_SUITE(RefCountBenchmarks);
+
+   KAREN_DECL_BENCHMARK(ptrCopy,
+   {
+      Ptr<int> shared = new int(0);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         Ptr<int> copy = shared;
+         doNotOptimize(copy);
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(atomicPtrCopy,
+   {
+      AtomicPtr<int> shared = new int(0);
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         AtomicPtr<int> copy = shared;
+         doNotOptimize(copy);
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(ptrCreate,
+   {
+      for (unsigned long i = 0; i < iterations; i++)
+         doNotOptimize(Ptr<SmallObject>(new SmallObject()));
+   });
+
+   KAREN_DECL_BENCHMARK(makePtrCreate,
+   {
+      for (unsigned long i = 0; i < iterations; i++)
+         doNotOptimize(makePtr<SmallObject>());
+   });
+
+   KAREN_DECL_BENCHMARK(refCountedCreate,
+   {
+      for (unsigned long i = 0; i < iterations; i++)
+         doNotOptimize(
+               Ptr<RefCountedSmallObject>(new RefCountedSmallObject()));
+   });
+
+   KAREN_DECL_BENCHMARK(weakPtrLock,
+   {
+      AtomicPtr<int> shared = new int(0);
+      WeakPtr<int, AtomicCounting> weak = shared;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         doNotOptimize(weak.lock());
+   });
+
+   KAREN_DECL_REFCOUNT_BENCHMARK(AtomicPtr, 1);
+   KAREN_DECL_REFCOUNT_BENCHMARK(AtomicPtr, 2);
+   KAREN_DECL_REFCOUNT_BENCHMARK(AtomicPtr, 4);
+   KAREN_DECL_REFCOUNT_BENCHMARK(AtomicPtr, 8);
+
+KAREN_END_BENCHMARK_SUITE(RefCountBenchmarks);
@@ -0,0 +1,95 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <functional>
+#include <vector>
+
+#include <KarenCore/bench.h>
+#include <KarenCore/events.h>
+
+using namespace karen;
+
+/*
+ * Number of subscribers registered in the event channels.
+ */
+static const int SUBSCRIBERS = 8;
+
+KAREN_DECL_EVENT(BenchmarkEvent, int value);
+
+class BenchmarkEventChannel : public LocalEventChannel
+{
+public:
+
+   inline void send(const Event& ev)
+   { this->sendEvent(ev); }
+};
+
+class BenchmarkEventConsumer
+{
+public:
+
+   int total;
+
+   inline BenchmarkEventConsumer() : total(0) {}
+
+   void onEvent(const BenchmarkEvent& ev)
+   { total += ev.value; }
+};
+
+KAREN_BEGIN_BENCHMARK_SUITE(EventBenchmarks);
+
+   KAREN_DECL_BENCHMARK(localEventChannelSendEvent,
+   {
+      BenchmarkEventChannel channel;
+      BenchmarkEventConsumer consumer;
+      for (int i = 0; i < SUBSCRIBERS; i++)
+         channel.subscribe(&consumer, &BenchmarkEventConsumer::onEvent);
+      BenchmarkEvent ev;
+      ev.value = 1;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         channel.send(ev);
+      doNotOptimize(consumer.total);
+   });
+
+   KAREN_DECL_BENCHMARK(stdFunctionVectorInvoke,
+   {
+      BenchmarkEventConsumer consumer;
+      std::vector<std::function<void(const Event&)>> subscribers;
+      for (int i = 0; i < SUBSCRIBERS; i++)
+         subscribers.push_back([&consumer](const Event& ev) {
+            auto narrowed = dynamic_cast<const BenchmarkEvent*>(&ev);
+            if (narrowed)
+               consumer.onEvent(*narrowed);
+         });
+      BenchmarkEvent ev;
+      ev.value = 1;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         for (auto& s : subscribers)
+            s(ev);
+      doNotOptimize(consumer.total);
+   });
+
+KAREN_END_BENCHMARK_SUITE(EventBenchmarks);
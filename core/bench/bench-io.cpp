@@ -0,0 +1,553 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <cstring>
+
+#include <KarenCore/bench.h>
+#include <KarenCore/buffer-pool.h>
+#include <KarenCore/buffer.h>
+#include <KarenCore/file.h>
+#include <KarenCore/io-engine.h>
+#include <KarenCore/stream.h>
+
+using namespace karen;
+
+static const unsigned long BUFFER_SIZE = 4096;
+static const unsigned long FRAME_BUFFER_SIZE = 1920 * 1080 * 4;
+
+KAREN_BEGIN_BENCHMARK_SUITE(BufferBenchmarks);
+
+   KAREN_DECL_BENCHMARK(bufferWrite,
+   {
+      Buffer buf(BUFFER_SIZE);
+      UInt8 src[64];
+      memset(src, 0xab, sizeof(src));
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         buf.write(src, sizeof(src), (i * sizeof(src)) % BUFFER_SIZE);
+      doNotOptimize(buf);
+   });
+
+   KAREN_DECL_BENCHMARK(bufferRead,
+   {
+      Buffer buf(BUFFER_SIZE);
+      UInt8 dst[64];
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         buf.read(dst, sizeof(dst), (i * sizeof(dst)) % BUFFER_SIZE);
+      doNotOptimize(dst);
+   });
+
+   KAREN_DECL_BENCHMARK(allocateFrameBuffer,
+   {
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         Buffer buf(FRAME_BUFFER_SIZE);
+         UInt8* data = (UInt8*) (void*) buf;
+         for (unsigned long off = 0; off < FRAME_BUFFER_SIZE; off += 4096)
+            data[off] = i;
+         sum += data[0];
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(allocateFrameBufferFromPool,
+   {
+      BufferPool& pool = BufferPool::defaultPool();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         Buffer buf(pool, FRAME_BUFFER_SIZE);
+         UInt8* data = (UInt8*) (void*) buf;
+         for (unsigned long off = 0; off < FRAME_BUFFER_SIZE; off += 4096)
+            data[off] = i;
+         sum += data[0];
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(rawMemcpy,
+   {
+      UInt8* buf = new UInt8[BUFFER_SIZE];
+      UInt8 dst[64];
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         memcpy(dst, buf + (i * sizeof(dst)) % BUFFER_SIZE, sizeof(dst));
+         doNotOptimize(dst);
+      }
+      delete[] buf;
+   });
+
+   KAREN_DECL_BENCHMARK(inputStreamReadInt,
+   {
+      Buffer buf(BUFFER_SIZE);
+      Ptr<BufferInputStream> is = new BufferInputStream(&buf);
+      resetMeasurement();
+      long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         if (!is->bytesLeftToRead())
+            is = new BufferInputStream(&buf);
+         sum += is->read<int>();
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(rawReadInt,
+   {
+      Buffer buf(BUFFER_SIZE);
+      const UInt8* data = (const UInt8*) (const void*) buf;
+      resetMeasurement();
+      long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         int v;
+         memcpy(&v, data + (i * sizeof(int)) % BUFFER_SIZE, sizeof(int));
+         sum += v;
+      }
+      doNotOptimize(sum);
+   });
+
+KAREN_END_BENCHMARK_SUITE(BufferBenchmarks);
+
+/*
+ * File streams counting the calls that reach the file, which for the POSIX
+ * backend are read(2) and write(2) system calls. Each benchmark iteration
+ * transfers one megabyte of 32-bit values, so the events per operation are
+ * the system calls per megabyte.
+ */
+static const char* STREAM_FILE = "/tmp/karen-bench-io";
+static const unsigned long VALUES_PER_MB = 1024 * 1024 / sizeof(UInt32);
+
+class CountingFileInputStream : public InputStream
+{
+public:
+
+   inline CountingFileInputStream(File* file) : _file(file) {}
+
+   virtual unsigned long readBytes(void* dst, unsigned long len)
+         throw (IOException)
+   {
+      Benchmark::countEvents();
+      return _file->readBytes(dst, len);
+   }
+
+private:
+
+   File* _file;
+
+};
+
+class CountingFileOutputStream : public OutputStream
+{
+public:
+
+   inline CountingFileOutputStream(File* file) : _file(file) {}
+
+   virtual unsigned long writeBytes(const void* data, unsigned long len)
+         throw (IOException)
+   {
+      Benchmark::countEvents();
+      return _file->writeBytes(data, len);
+   }
+
+private:
+
+   File* _file;
+
+};
+
+static void writeStreamFile()
+{
+   static bool written = false;
+   if (written)
+      return;
+   UInt32* values = new UInt32[VALUES_PER_MB];
+   for (unsigned long i = 0; i < VALUES_PER_MB; i++)
+      values[i] = i;
+   File file(STREAM_FILE, FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+   file.writeArray(values, VALUES_PER_MB);
+   delete[] values;
+   written = true;
+}
+
+KAREN_BEGIN_BENCHMARK_SUITE(FileStreamBenchmarks);
+
+   KAREN_DECL_BENCHMARK(writeValuesUnbuffered,
+   {
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         File file(STREAM_FILE, FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         CountingFileOutputStream os(&file);
+         for (UInt32 v = 0; v < VALUES_PER_MB; v++)
+            os.write<UInt32>(v);
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(writeValuesBuffered,
+   {
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         File file(STREAM_FILE, FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         CountingFileOutputStream os(&file);
+         BufferedOutputStream bos(&os);
+         for (UInt32 v = 0; v < VALUES_PER_MB; v++)
+            bos.write<UInt32>(v);
+         bos.flush();
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(writeArray,
+   {
+      UInt32* values = new UInt32[VALUES_PER_MB];
+      for (unsigned long v = 0; v < VALUES_PER_MB; v++)
+         values[v] = v;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         File file(STREAM_FILE, FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         CountingFileOutputStream os(&file);
+         os.writeArray(values, VALUES_PER_MB);
+      }
+      delete[] values;
+   });
+
+   KAREN_DECL_BENCHMARK(readValuesUnbuffered,
+   {
+      writeStreamFile();
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         File file(STREAM_FILE, FileOpenMode::READ_ONLY_MODE);
+         CountingFileInputStream is(&file);
+         for (unsigned long v = 0; v < VALUES_PER_MB; v++)
+            sum += is.read<UInt32>();
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(readValuesBuffered,
+   {
+      writeStreamFile();
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         File file(STREAM_FILE, FileOpenMode::READ_ONLY_MODE);
+         CountingFileInputStream is(&file);
+         BufferedInputStream bis(&is);
+         for (unsigned long v = 0; v < VALUES_PER_MB; v++)
+            sum += bis.read<UInt32>();
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(readArray,
+   {
+      writeStreamFile();
+      UInt32* values = new UInt32[VALUES_PER_MB];
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         File file(STREAM_FILE, FileOpenMode::READ_ONLY_MODE);
+         CountingFileInputStream is(&file);
+         is.readArray(values, VALUES_PER_MB);
+      }
+      doNotOptimize(values[VALUES_PER_MB - 1]);
+      delete[] values;
+   });
+
+KAREN_END_BENCHMARK_SUITE(FileStreamBenchmarks);
+
+/*
+ * Loading an asset by reading it into an allocated buffer against viewing
+ * it through a file mapping. Both touch one byte per page, so the mapping
+ * faults every page in while the read copies every byte.
+ */
+static const char* ASSET_FILE = "/tmp/karen-bench-asset";
+static const unsigned long ASSET_LENGTH = 16 * 1024 * 1024;
+static const unsigned long PAGE_LENGTH = 4096;
+
+static void writeAssetFile()
+{
+   static bool written = false;
+   if (written)
+      return;
+   MappedFile asset(ASSET_FILE, READ_WRITE_MAPPING);
+   asset.resize(ASSET_LENGTH);
+   UInt8* data = (UInt8*) (void*) asset.buffer();
+   for (unsigned long i = 0; i < ASSET_LENGTH; i++)
+      data[i] = i;
+   written = true;
+}
+
+KAREN_BEGIN_BENCHMARK_SUITE(MappedFileBenchmarks);
+
+   KAREN_DECL_BENCHMARK(loadAssetByReading,
+   {
+      writeAssetFile();
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         File file(ASSET_FILE, FileOpenMode::READ_ONLY_MODE);
+         Buffer buf(ASSET_LENGTH);
+         file.readArray((UInt8*) (void*) buf, ASSET_LENGTH);
+         const UInt8* data = (const UInt8*) (const void*) buf;
+         for (unsigned long off = 0; off < ASSET_LENGTH; off += PAGE_LENGTH)
+            sum += data[off];
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(loadAssetByMapping,
+   {
+      writeAssetFile();
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         MappedFile asset(ASSET_FILE, READ_ONLY_MAPPING);
+         asset.advise(SEQUENTIAL_ACCESS);
+         const UInt8* data = (const UInt8*) (const void*) asset.buffer();
+         for (unsigned long off = 0; off < ASSET_LENGTH; off += PAGE_LENGTH)
+            sum += data[off];
+      }
+      doNotOptimize(sum);
+   });
+
+KAREN_END_BENCHMARK_SUITE(MappedFileBenchmarks);
+
+/*
+ * Blocking positional reads against the asynchronous engines, for small
+ * random reads and for large sequential ones. The asynchronous variants
+ * enqueue a whole batch, submit it at once and wait for it to drain.
+ */
+static const char* ENGINE_FILE = "/tmp/karen-bench-engine";
+static const unsigned long ENGINE_FILE_LENGTH = 64 * 1024 * 1024;
+static const unsigned long RANDOM_BLOCK_LENGTH = 4096;
+static const unsigned long RANDOM_BLOCKS = 256;
+static const unsigned long SEQUENTIAL_CHUNK_LENGTH = 1024 * 1024;
+
+class NullIoCallback : public IoCallback
+{
+public:
+
+   virtual void onIoCompletion(const IoCompletion&) {}
+};
+
+static NullIoCallback nullIoCallback;
+
+static void writeEngineFile()
+{
+   static bool written = false;
+   if (written)
+      return;
+   File file(ENGINE_FILE, FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+   Buffer chunk(SEQUENTIAL_CHUNK_LENGTH);
+   UInt8* data = (UInt8*) (void*) chunk;
+   for (unsigned long i = 0; i < SEQUENTIAL_CHUNK_LENGTH; i++)
+      data[i] = i;
+   for (unsigned long off = 0; off < ENGINE_FILE_LENGTH; 
+        off += SEQUENTIAL_CHUNK_LENGTH)
+      file.writeArray(data, SEQUENTIAL_CHUNK_LENGTH);
+   written = true;
+}
+
+static unsigned long randomBlockOffset(unsigned long i)
+{
+   unsigned long nblocks = ENGINE_FILE_LENGTH / RANDOM_BLOCK_LENGTH;
+   return ((i * 2654435761ul) % nblocks) * RANDOM_BLOCK_LENGTH;
+}
+
+static IoEngine& benchEngine(bool threadPool)
+{
+   static AtomicPtr<IoEngine> engines[2];
+   AtomicPtr<IoEngine>& engine = engines[threadPool ? 1 : 0];
+   if (engine.isNull())
+   {
+      IoEngineOptions options;
+      options.forceThreadPool = threadPool;
+      engine = IoEngine::create(options);
+   }
+   return *engine;
+}
+
+static void readRandomBlocks(bool threadPool, unsigned long iterations)
+{
+   AsyncFile file(benchEngine(threadPool), ENGINE_FILE, 
+                  FileOpenMode::READ_ONLY_MODE);
+   Buffer buf(RANDOM_BLOCKS * RANDOM_BLOCK_LENGTH);
+   UInt8* data = (UInt8*) (void*) buf;
+   for (unsigned long i = 0; i < iterations; i++)
+   {
+      for (unsigned long b = 0; b < RANDOM_BLOCKS; b++)
+         file.read(data + b * RANDOM_BLOCK_LENGTH, RANDOM_BLOCK_LENGTH, 
+                   randomBlockOffset(i * RANDOM_BLOCKS + b), 
+                   &nullIoCallback);
+      file.engine().submit();
+      file.engine().drain();
+   }
+   Benchmark::doNotOptimize(data[0]);
+}
+
+static void readSequentialChunks(bool threadPool, unsigned long iterations)
+{
+   AsyncFile file(benchEngine(threadPool), ENGINE_FILE, 
+                  FileOpenMode::READ_ONLY_MODE);
+   Buffer buf(ENGINE_FILE_LENGTH);
+   UInt8* data = (UInt8*) (void*) buf;
+   for (unsigned long i = 0; i < iterations; i++)
+   {
+      for (unsigned long off = 0; off < ENGINE_FILE_LENGTH; 
+           off += SEQUENTIAL_CHUNK_LENGTH)
+         file.read(data + off, SEQUENTIAL_CHUNK_LENGTH, off, 
+                   &nullIoCallback);
+      file.engine().submit();
+      file.engine().drain();
+   }
+   Benchmark::doNotOptimize(data[0]);
+}
+
+KAREN_BEGIN_BENCHMARK_SUITE(IoEngineBenchmarks);
+
+   KAREN_DECL_BENCHMARK(randomReadsBlocking,
+   {
+      writeEngineFile();
+      File file(ENGINE_FILE, FileOpenMode::READ_ONLY_MODE);
+      Buffer buf(RANDOM_BLOCKS * RANDOM_BLOCK_LENGTH);
+      UInt8* data = (UInt8*) (void*) buf;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         for (unsigned long b = 0; b < RANDOM_BLOCKS; b++)
+            file.readAt(data + b * RANDOM_BLOCK_LENGTH, RANDOM_BLOCK_LENGTH, 
+                        randomBlockOffset(i * RANDOM_BLOCKS + b));
+      doNotOptimize(data[0]);
+   });
+
+   KAREN_DECL_BENCHMARK(randomReadsUring,
+   {
+      writeEngineFile();
+      benchEngine(false);
+      resetMeasurement();
+      readRandomBlocks(false, iterations);
+   });
+
+   KAREN_DECL_BENCHMARK(randomReadsThreadPool,
+   {
+      writeEngineFile();
+      benchEngine(true);
+      resetMeasurement();
+      readRandomBlocks(true, iterations);
+   });
+
+   KAREN_DECL_BENCHMARK(sequentialReadsBlocking,
+   {
+      writeEngineFile();
+      File file(ENGINE_FILE, FileOpenMode::READ_ONLY_MODE);
+      Buffer buf(ENGINE_FILE_LENGTH);
+      UInt8* data = (UInt8*) (void*) buf;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         for (unsigned long off = 0; off < ENGINE_FILE_LENGTH; 
+              off += SEQUENTIAL_CHUNK_LENGTH)
+            file.readAt(data + off, SEQUENTIAL_CHUNK_LENGTH, off);
+      doNotOptimize(data[0]);
+   });
+
+   KAREN_DECL_BENCHMARK(sequentialReadsUring,
+   {
+      writeEngineFile();
+      benchEngine(false);
+      resetMeasurement();
+      readSequentialChunks(false, iterations);
+   });
+
+   KAREN_DECL_BENCHMARK(sequentialReadsThreadPool,
+   {
+      writeEngineFile();
+      benchEngine(true);
+      resetMeasurement();
+      readSequentialChunks(true, iterations);
+   });
+
+KAREN_END_BENCHMARK_SUITE(IoEngineBenchmarks);
+
+/*
+ * Copying a multi-gigabyte file in kernel space against copying it through
+ * a user buffer. Each iteration copies the whole file, so these are better
+ * run with few samples. 
+ */
+static const char* COPY_SOURCE_FILE = "/tmp/karen-bench-copy-src";
+static const char* COPY_TARGET_FILE = "/tmp/karen-bench-copy-dst";
+static const unsigned long COPY_FILE_LENGTH = 2048ul * 1024 * 1024;
+
+static void writeCopySourceFile()
+{
+   static bool written = false;
+   if (written)
+      return;
+   File file(COPY_SOURCE_FILE, FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+   Buffer chunk(SEQUENTIAL_CHUNK_LENGTH);
+   UInt8* data = (UInt8*) (void*) chunk;
+   for (unsigned long i = 0; i < SEQUENTIAL_CHUNK_LENGTH; i++)
+      data[i] = i;
+   for (unsigned long off = 0; off < COPY_FILE_LENGTH; 
+        off += SEQUENTIAL_CHUNK_LENGTH)
+      file.writeArray(data, SEQUENTIAL_CHUNK_LENGTH);
+   written = true;
+}
+
+KAREN_BEGIN_BENCHMARK_SUITE(FileCopyBenchmarks);
+
+   KAREN_DECL_BENCHMARK(copyInKernel,
+   {
+      writeCopySourceFile();
+      resetMeasurement();
+      unsigned long ncopied = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         ncopied += File::copyFile(COPY_SOURCE_FILE, COPY_TARGET_FILE);
+      doNotOptimize(ncopied);
+   });
+
+   KAREN_DECL_BENCHMARK(copyThroughUserBuffer,
+   {
+      writeCopySourceFile();
+      Ptr<FileFactory> factory = FileFactory::getActiveFileFactory();
+      resetMeasurement();
+      unsigned long ncopied = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         File src(COPY_SOURCE_FILE, FileOpenMode::READ_ONLY_MODE);
+         File dst(COPY_TARGET_FILE, FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         ncopied += factory->FileFactory::transfer(
+               src, 0, dst, 0, COPY_FILE_LENGTH);
+      }
+      doNotOptimize(ncopied);
+   });
+
+KAREN_END_BENCHMARK_SUITE(FileCopyBenchmarks);
@@ -0,0 +1,66 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include <KarenCore/bench.h>
+
+using namespace karen;
+
+KAREN_BENCHMARK_ALLOCATION_HOOKS
+
+int main(int argc, char* argv[])
+{
+   BenchmarkOptions options;
+   bool json = false;
+   for (int i = 1; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "--json"))
+         json = true;
+      else if (!strcmp(argv[i], "--csv"))
+         json = false;
+      else if (!strncmp(argv[i], "--filter=", 9))
+         options.filter = argv[i] + 9;
+      else if (!strncmp(argv[i], "--samples=", 10))
+         options.samples = atoi(argv[i] + 10);
+      else if (!strncmp(argv[i], "--min-time=", 11))
+         options.minSampleTime = atof(argv[i] + 11);
+      else
+      {
+         std::cerr << "usage: " << argv[0] << " [--csv|--json] "
+            "[--filter=substring] [--samples=n] [--min-time=ms]" << std::endl;
+         return 1;
+      }
+   }
+   if (options.samples == 0)
+      options.samples = 1;
+
+   CsvBenchmarkReporter csv;
+   JsonBenchmarkReporter js;
+   BenchmarkReporter& reporter = json ? 
+         (BenchmarkReporter&) js : (BenchmarkReporter&) csv;
+   BenchmarkSuite::runAll(reporter, options);
+   return 0;
+}
@@ -0,0 +1,658 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <KarenCore/array.h>
+#include <KarenCore/atom.h>
+#include <KarenCore/bench.h>
+#include <KarenCore/format.h>
+#include <KarenCore/map.h>
+#include <KarenCore/numeric.h>
+#include <KarenCore/parsing.h>
+#include <KarenCore/simd.h>
+#include <KarenCore/string.h>
+
+using namespace karen;
+
+static const char* SAMPLE_TEXT = 
+      "the quick brown fox jumps over the lazy dog";
+
+KAREN_BEGIN_BENCHMARK_SUITE(StringBenchmarks);
+
+   KAREN_DECL_BENCHMARK(stringConcat,
+   {
+      String a(SAMPLE_TEXT), b(" and again");
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         String c = a + b;
+         doNotOptimize(c);
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(stdStringConcat,
+   {
+      std::string a(SAMPLE_TEXT), b(" and again");
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         std::string c = a + b;
+         doNotOptimize(c);
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(stringFindChar,
+   {
+      String a(SAMPLE_TEXT);
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += a.findChar('g');
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(stdStringFind,
+   {
+      std::string a(SAMPLE_TEXT);
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += a.find('g');
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(stringStartsWith,
+   {
+      String a(SAMPLE_TEXT), b("the quick");
+      int hits = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         hits += a.startsWith(b) ? 1 : 0;
+      doNotOptimize(hits);
+   });
+
+   KAREN_DECL_BENCHMARK(stdStringCompareHead,
+   {
+      std::string a(SAMPLE_TEXT), b("the quick");
+      int hits = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         hits += (a.compare(0, b.length(), b) == 0) ? 1 : 0;
+      doNotOptimize(hits);
+   });
+
+   KAREN_DECL_BENCHMARK(stringToUpperCase,
+   {
+      String a(SAMPLE_TEXT);
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         String b = a.toUpperCase();
+         doNotOptimize(b);
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(stringTokenize,
+   {
+      String a(SAMPLE_TEXT);
+      DynArray<String> tokens;
+      for (unsigned long i = 0; i < iterations; i++)
+         tokenizeString(a, tokens);
+      doNotOptimize(tokens);
+   });
+
+   KAREN_DECL_BENCHMARK(stringViewTokenize,
+   {
+      String a(SAMPLE_TEXT);
+      DynArray<StringView> tokens;
+      for (unsigned long i = 0; i < iterations; i++)
+         tokenizeString(a, tokens);
+      doNotOptimize(tokens);
+   });
+
+   KAREN_DECL_BENCHMARK(stringSlice,
+   {
+      String a(SAMPLE_TEXT);
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += a.slice(i % 16, 20).length();
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(stringSliceView,
+   {
+      String a(SAMPLE_TEXT);
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += a.sliceView(i % 16, 20).length();
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(stringStartsWithLiteral,
+   {
+      String a(SAMPLE_TEXT);
+      int hits = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         hits += a.startsWith("the quick") ? 1 : 0;
+      doNotOptimize(hits);
+   });
+
+   KAREN_DECL_BENCHMARK(stdStringTokenize,
+   {
+      std::string a(SAMPLE_TEXT);
+      std::vector<std::string> tokens;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         tokens.clear();
+         std::string::size_type b = 0, e;
+         while ((e = a.find(' ', b)) != std::string::npos)
+         {
+            if (e > b)
+               tokens.push_back(a.substr(b, e - b));
+            b = e + 1;
+         }
+         if (b < a.length())
+            tokens.push_back(a.substr(b));
+      }
+      doNotOptimize(tokens);
+   });
+
+KAREN_END_BENCHMARK_SUITE(StringBenchmarks);
+
+/*
+ * One megabyte of words of random length separated by spaces, with some
+ * commas and line feeds.
+ */
+static const String&
+megabyteText()
+{
+   static String text;
+   if (text.isEmpty())
+   {
+      unsigned seed = 42;
+      while (text.length() < 1024 * 1024)
+      {
+         seed = seed * 1103515245 + 12345;
+         text.append('w', 1 + (seed >> 16) % 12);
+         text.append((seed >> 8) % 16 ? ' ' : ((seed >> 8) % 32 ? ',' : '\n'), 1);
+      }
+   }
+   return text;
+}
+
+/*
+ * Byte by byte tokenizer as implemented before Tokenizer was available.
+ */
+static void
+scalarTokenizeString(const String& str, Array<String>& tokens, char separator)
+{
+   tokens.clear();
+   const char *p = str, *b;
+   int c;
+   while (p && (*p != '\0'))
+   {
+      while (*p == separator)
+         p++;
+      b = p;
+      c = 0;
+      while (*p != separator && *p != '\0')
+      {
+         c++;
+         p++;
+      }
+      while (p && (*p == separator))
+         p++;
+      tokens.append(String(b, c));
+   }
+}
+
+#define KAREN_DECL_TOKENIZER_BENCHMARK(name, level) \
+   KAREN_DECL_BENCHMARK(name, \
+   { \
+      const String& text = megabyteText(); \
+      setSimdLevel(level); \
+      Tokenizer tokenizer(" ,\n"); \
+      setSimdLevel(detectSimdLevel()); \
+      resetMeasurement(); \
+      unsigned long count = 0; \
+      for (unsigned long i = 0; i < iterations; i++) \
+         for (const StringView& token : tokenizer.tokens(text)) \
+            count += token.length(); \
+      doNotOptimize(count); \
+   })
+
+KAREN_BEGIN_BENCHMARK_SUITE(TokenizerBenchmarks);
+
+   KAREN_DECL_BENCHMARK(scalarTokenizeStringMegabyte,
+   {
+      const String& text = megabyteText();
+      DynArray<String> tokens;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         scalarTokenizeString(text, tokens, ' ');
+      doNotOptimize(tokens);
+   });
+
+   KAREN_DECL_BENCHMARK(tokenizeStringMegabyte,
+   {
+      const String& text = megabyteText();
+      DynArray<String> tokens;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         tokenizeString(text, tokens, ' ');
+      doNotOptimize(tokens);
+   });
+
+   KAREN_DECL_BENCHMARK(tokenizeStringViewMegabyte,
+   {
+      const String& text = megabyteText();
+      DynArray<StringView> tokens;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+         tokenizeString(text, tokens, ' ');
+      doNotOptimize(tokens);
+   });
+
+   KAREN_DECL_TOKENIZER_BENCHMARK(
+         tokenizerIterateScalarMegabyte, karen::SIMD_SCALAR);
+   KAREN_DECL_TOKENIZER_BENCHMARK(
+         tokenizerIterateSse2Megabyte, karen::SIMD_SSE2);
+   KAREN_DECL_TOKENIZER_BENCHMARK(
+         tokenizerIterateAvx2Megabyte, karen::SIMD_AVX2);
+
+   KAREN_DECL_BENCHMARK(tokenizerBatchMegabyte,
+   {
+      const String& text = megabyteText();
+      StringView input(text);
+      Tokenizer tokenizer(" ,\n");
+      std::vector<TokenSpan> spans(4096);
+      resetMeasurement();
+      unsigned long count = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         unsigned long offset = 0, n;
+         while ((n = tokenizer.tokenize(
+               input, &spans[0], spans.size(), offset)) > 0)
+            count += n;
+      }
+      doNotOptimize(count);
+   });
+
+KAREN_END_BENCHMARK_SUITE(TokenizerBenchmarks);
+
+/*
+ * Text of given length whose only 'Q' is at its beginning, and whose only
+ * 'Z' and "needle" are at its end.
+ */
+static String
+searchText(unsigned long len)
+{
+   String text("Q");
+   for (unsigned long i = 0; text.length() + 7 < len; i++)
+      text.append("Lorem ipsum dolor sit amet nee"[i % 30], 1);
+   return text.append(String("needleZ")).head(len);
+}
+
+#define KAREN_DECL_STRING_SEARCH_BENCHMARKS(size) \
+   KAREN_DECL_BENCHMARK(findChar_##size, \
+   { \
+      String text = searchText(size); \
+      resetMeasurement(); \
+      unsigned long sum = 0; \
+      for (unsigned long i = 0; i < iterations; i++) \
+         sum += text.findChar('Z'); \
+      doNotOptimize(sum); \
+   }); \
+   KAREN_DECL_BENCHMARK(reverseFindChar_##size, \
+   { \
+      String text = searchText(size); \
+      resetMeasurement(); \
+      unsigned long sum = 0; \
+      for (unsigned long i = 0; i < iterations; i++) \
+         sum += text.reverseFindChar('Q'); \
+      doNotOptimize(sum); \
+   }); \
+   KAREN_DECL_BENCHMARK(find_##size, \
+   { \
+      String text = searchText(size); \
+      resetMeasurement(); \
+      unsigned long sum = 0; \
+      for (unsigned long i = 0; i < iterations; i++) \
+         sum += text.find("needle"); \
+      doNotOptimize(sum); \
+   }); \
+   KAREN_DECL_BENCHMARK(stdStringFind_##size, \
+   { \
+      std::string text((const std::string&) searchText(size)); \
+      resetMeasurement(); \
+      unsigned long sum = 0; \
+      for (unsigned long i = 0; i < iterations; i++) \
+         sum += text.find("needle"); \
+      doNotOptimize(sum); \
+   }); \
+   KAREN_DECL_BENCHMARK(toLowerCase_##size, \
+   { \
+      String text = searchText(size); \
+      resetMeasurement(); \
+      for (unsigned long i = 0; i < iterations; i++) \
+      { \
+         String lower = text.toLowerCase(); \
+         doNotOptimize(lower); \
+      } \
+   }); \
+   KAREN_DECL_BENCHMARK(toUpperCaseInPlace_##size, \
+   { \
+      String text = searchText(size); \
+      resetMeasurement(); \
+      for (unsigned long i = 0; i < iterations; i++) \
+         text.toUpperCaseInPlace(); \
+      doNotOptimize(text); \
+   })
+
+KAREN_BEGIN_BENCHMARK_SUITE(StringSearchBenchmarks);
+
+   KAREN_DECL_STRING_SEARCH_BENCHMARKS(16);
+   KAREN_DECL_STRING_SEARCH_BENCHMARKS(256);
+   KAREN_DECL_STRING_SEARCH_BENCHMARKS(4096);
+   KAREN_DECL_STRING_SEARCH_BENCHMARKS(65536);
+   KAREN_DECL_STRING_SEARCH_BENCHMARKS(1048576);
+
+KAREN_END_BENCHMARK_SUITE(StringSearchBenchmarks);
+
+/*
+ * Property-like keys sharing a long common prefix, so comparing their
+ * strings reads most of their characters.
+ */
+static const char* PROPERTY_KEYS[] = {
+   "karen.ui.application.screen-width",
+   "karen.ui.application.screen-height",
+   "karen.ui.application.fullscreen",
+   "karen.ui.application.double-buffer",
+   "karen.ui.application.ui-engine",
+   "karen.ui.application.frame-rate",
+   "karen.ui.application.title",
+   "karen.ui.application.icon",
+};
+
+static const unsigned long PROPERTY_KEY_COUNT = 8;
+
+KAREN_BEGIN_BENCHMARK_SUITE(AtomBenchmarks);
+
+   KAREN_DECL_BENCHMARK(stringMapGet,
+   {
+      HashMap<String, int> map;
+      DynArray<String> keys;
+      for (unsigned long k = 0; k < PROPERTY_KEY_COUNT; k++)
+      {
+         map.put(String(PROPERTY_KEYS[k]), k);
+         keys.append(String(PROPERTY_KEYS[k]));
+      }
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += map[keys[i % PROPERTY_KEY_COUNT]];
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(atomMapGet,
+   {
+      AtomMap<int> map;
+      DynArray<Atom> keys;
+      for (unsigned long k = 0; k < PROPERTY_KEY_COUNT; k++)
+      {
+         map.put(Atom(PROPERTY_KEYS[k]), k);
+         keys.append(Atom(PROPERTY_KEYS[k]));
+      }
+      resetMeasurement();
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += map[keys[i % PROPERTY_KEY_COUNT]];
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(stringEquals,
+   {
+      String a(PROPERTY_KEYS[0]), b(PROPERTY_KEYS[1]);
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += (i & 1 ? a : b) == a;
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(atomEquals,
+   {
+      Atom a(PROPERTY_KEYS[0]), b(PROPERTY_KEYS[1]);
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += (i & 1 ? a : b) == a;
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(atomIntern,
+   {
+      StringView key(PROPERTY_KEYS[0]);
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         Atom atom(key);
+         doNotOptimize(atom);
+      }
+   });
+
+KAREN_END_BENCHMARK_SUITE(AtomBenchmarks);
+
+/*
+ * Comma separated list of pseudo-random numbers of varying length, either
+ * integers or decimals with an exponent.
+ */
+static const String&
+numberListText(bool decimals)
+{
+   static String text[2];
+   String& list = text[decimals];
+   if (list.isEmpty())
+   {
+      unsigned long long seed = 42;
+      for (unsigned i = 0; i < 10000; i++)
+      {
+         seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+         long value = (long) (seed >> (24 + (seed >> 3) % 40));
+         if (i)
+            list.append(',', 1);
+         if (decimals)
+            list.append(String::format("%.*g", 1 + (int) (seed % 17), 
+                  value * 1e-7));
+         else
+            list.append(String::fromLong(seed & 1 ? -value : value));
+      }
+   }
+   return list;
+}
+
+KAREN_BEGIN_BENCHMARK_SUITE(NumericBenchmarks);
+
+   KAREN_DECL_BENCHMARK(strtolList,
+   {
+      const String& text = numberListText(false);
+      resetMeasurement();
+      long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         char* p = const_cast<char*>((const char*) text);
+         while (*p)
+         {
+            sum += std::strtol(p, &p, 10);
+            if (*p == ',')
+               p++;
+         }
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(tokenizeAndToLongList,
+   {
+      const String& text = numberListText(false);
+      DynArray<String> tokens;
+      resetMeasurement();
+      long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         tokenizeString(text, tokens, ',');
+         for (const String& token : tokens)
+            sum += Integer::toLong(token);
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(integerParseList,
+   {
+      const String& text = numberListText(false);
+      DynArray<long> values;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         values.clear();
+         Integer::parseList(text, values);
+      }
+      doNotOptimize(values);
+   });
+
+   KAREN_DECL_BENCHMARK(strtodList,
+   {
+      const String& text = numberListText(true);
+      resetMeasurement();
+      double sum = 0.0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         char* p = const_cast<char*>((const char*) text);
+         while (*p)
+         {
+            sum += std::strtod(p, &p);
+            if (*p == ',')
+               p++;
+         }
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(floatParseList,
+   {
+      const String& text = numberListText(true);
+      DynArray<double> values;
+      resetMeasurement();
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         values.clear();
+         Float::parseList(text, values);
+      }
+      doNotOptimize(values);
+   });
+
+   KAREN_DECL_BENCHMARK(fromLong,
+   {
+      long value = -1234567890123L;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         String str = String::fromLong(value + i);
+         doNotOptimize(str);
+      }
+   });
+
+   KAREN_DECL_BENCHMARK(integerFormat,
+   {
+      char buffer[Integer::FORMAT_LENGTH];
+      long value = -1234567890123L;
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+         sum += Integer::format(value + i, buffer);
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(snprintfShortestDouble,
+   {
+      char buffer[32];
+      double value = 0.1;
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         value = value * 1.0000001 + 1e-9;
+         sum += std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(floatFormat,
+   {
+      char buffer[Float::FORMAT_LENGTH];
+      double value = 0.1;
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         value = value * 1.0000001 + 1e-9;
+         sum += Float::format(value, buffer);
+      }
+      doNotOptimize(sum);
+   });
+
+KAREN_END_BENCHMARK_SUITE(NumericBenchmarks);
+
+KAREN_BEGIN_BENCHMARK_SUITE(FormatBenchmarks);
+
+   KAREN_DECL_BENCHMARK(stringFormat,
+   {
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         String str = String::format("cannot read %d bytes at %s:%d (%.2f)",
+                                     (int) i, "buffer.cpp", 42, 0.5);
+         sum += str.length();
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(builderFormat,
+   {
+      StringBuilder builder;
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         builder.clear();
+         KAREN_FORMAT(builder, "cannot read %d bytes at %s:%d (%.2f)",
+                      i, "buffer.cpp", 42, 0.5);
+         sum += builder.length();
+      }
+      doNotOptimize(sum);
+   });
+
+   KAREN_DECL_BENCHMARK(builderFormatShortest,
+   {
+      StringBuilder builder;
+      unsigned long sum = 0;
+      for (unsigned long i = 0; i < iterations; i++)
+      {
+         builder.clear();
+         KAREN_FORMAT(builder, "cannot read %d bytes at %s:%d (%s)",
+                      i, "buffer.cpp", 42, 0.5);
+         sum += builder.length();
+      }
+      doNotOptimize(sum);
+   });
+
+KAREN_END_BENCHMARK_SUITE(FormatBenchmarks);
@@ -25,18 +25,26 @@
 #ifndef KAREN_CORE_H
 #define KAREN_CORE_H
 
+#include "KarenCore/allocator.h"
+#include "KarenCore/atom.h"
+#include "KarenCore/bench.h"
 #include "KarenCore/bolt.h"
+#include "KarenCore/buffer-pool.h"
 #include "KarenCore/buffer.h"
 #include "KarenCore/collection-inl.h"
 #include "KarenCore/collection.h"
 #include "KarenCore/exception.h"
 #include "KarenCore/file-posix.h"
 #include "KarenCore/file.h"
+#include "KarenCore/format.h"
+#include "KarenCore/hash.h"
+#include "KarenCore/io-engine.h"
 #include "KarenCore/iterator.h"
 #include "KarenCore/numeric.h"
 #include "KarenCore/parsing.h"
 #include "KarenCore/platform.h"
 #include "KarenCore/pointer.h"
+#include "KarenCore/simd.h"
 #include "KarenCore/stream.h"
 #include "KarenCore/string.h"
 #include "KarenCore/test.h"
@@ -0,0 +1,178 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_ALLOCATOR_INL_H
+#define KAREN_CORE_ALLOCATOR_INL_H
+
+#include <cstdint>
+#include <new>
+
+#include "KarenCore/allocator.h"
+
+namespace karen {
+
+template <std::size_t Size>
+thread_local typename FixedSizePool<Size>::Cache FixedSizePool<Size>::_cache;
+
+template <std::size_t Size>
+void*
+FixedSizePool<Size>::allocate()
+{
+   Cache& cache = _cache;
+   if (!cache.head)
+      refill(cache);
+   Block* block = cache.head;
+   cache.head = block->next;
+   cache.count--;
+   return block;
+}
+
+template <std::size_t Size>
+void
+FixedSizePool<Size>::deallocate(void* block)
+{
+   Cache& cache = _cache;
+   if (!cache.head && !cache.closed)
+      registerFlusher();
+   Block* b = static_cast<Block*>(block);
+   b->next = cache.head;
+   cache.head = b;
+   if (++cache.count > CACHE_CAPACITY || cache.closed)
+      drain(cache, cache.closed ? 
+            cache.count : (unsigned long) TRANSFER_BLOCKS);
+}
+
+template <std::size_t Size>
+FixedSizePool<Size>::CacheFlusher::~CacheFlusher()
+{
+   _cache.closed = true;
+   drain(_cache, _cache.count);
+}
+
+template <std::size_t Size>
+void
+FixedSizePool<Size>::registerFlusher()
+{
+   // Flush the cache to the shared list when this thread exits
+   static thread_local CacheFlusher flusher;
+   (void) flusher;
+}
+
+template <std::size_t Size>
+typename FixedSizePool<Size>::SharedList&
+FixedSizePool<Size>::sharedList()
+{
+   // Never destroyed, since blocks may be released by static objects
+   static SharedList* list = new SharedList();
+   return *list;
+}
+
+template <std::size_t Size>
+void
+FixedSizePool<Size>::refill(Cache& cache)
+{
+   if (!cache.closed)
+      registerFlusher();
+
+   SharedList& shared = sharedList();
+   {
+      std::lock_guard<std::mutex> guard(shared.lock);
+      unsigned long nblocks = cache.closed ? 
+            1 : (unsigned long) TRANSFER_BLOCKS;
+      while (shared.head && nblocks--)
+      {
+         Block* block = shared.head;
+         shared.head = block->next;
+         block->next = cache.head;
+         cache.head = block;
+         cache.count++;
+      }
+   }
+   if (cache.head)
+      return;
+
+   char* chunk = static_cast<char*>(::operator new(Size * CHUNK_BLOCKS));
+   for (unsigned long i = CHUNK_BLOCKS; i > 0; i--)
+   {
+      Block* block = reinterpret_cast<Block*>(chunk + (i - 1) * Size);
+      block->next = cache.head;
+      cache.head = block;
+   }
+   cache.count += CHUNK_BLOCKS;
+}
+
+template <std::size_t Size>
+void
+FixedSizePool<Size>::drain(Cache& cache, unsigned long nblocks)
+{
+   if (!nblocks)
+      return;
+   Block* first = cache.head;
+   Block* last = first;
+   for (unsigned long i = 1; i < nblocks; i++)
+      last = last->next;
+   cache.head = last->next;
+   cache.count -= nblocks;
+
+   SharedList& shared = sharedList();
+   std::lock_guard<std::mutex> guard(shared.lock);
+   last->next = shared.head;
+   shared.head = first;
+}
+
+template <class T>
+T*
+PoolAllocator<T>::allocate(std::size_t n)
+{
+   if (POOLED && n == 1)
+      return static_cast<T*>(Pool::allocate());
+   return static_cast<T*>(::operator new(n * sizeof(T)));
+}
+
+template <class T>
+void
+PoolAllocator<T>::deallocate(T* p, std::size_t n)
+{
+   if (POOLED && n == 1)
+      Pool::deallocate(p);
+   else
+      ::operator delete(p);
+}
+
+void*
+Arena::allocate(unsigned long size, unsigned long alignment)
+{
+   std::uintptr_t cursor = reinterpret_cast<std::uintptr_t>(_cursor);
+   std::uintptr_t aligned = 
+         (cursor + alignment - 1) & ~(std::uintptr_t) (alignment - 1);
+   if (!_cursor || aligned + size > reinterpret_cast<std::uintptr_t>(_limit))
+      return allocateFromNewChunk(size, alignment);
+   _cursor = reinterpret_cast<char*>(aligned + size);
+   _allocatedBytes += size;
+   return reinterpret_cast<void*>(aligned);
+}
+
+}; // namespace karen
+
+#endif
@@ -0,0 +1,262 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_ALLOCATOR_H
+#define KAREN_CORE_ALLOCATOR_H
+
+#include <cstddef>
+#include <mutex>
+#include <type_traits>
+
+#include "KarenCore/platform.h"
+
+namespace karen {
+
+/**
+ * Fixed size block pool. This class template provides blocks of Size
+ * bytes from a free list shared by all the threads. Each thread keeps
+ * its own cache of free blocks, so most allocations and deallocations
+ * take no lock. The shared list is refilled with chunks of blocks that
+ * are never returned to the system, so the pool keeps the memory of its
+ * peak usage. Size must be a multiple of the fundamental alignment.
+ */
+template <std::size_t Size>
+class FixedSizePool
+{
+public:
+
+   /**
+    * Allocate a new block.
+    */
+   inline static void* allocate();
+
+   /**
+    * Deallocate given block, which must have been allocated by this pool.
+    */
+   inline static void deallocate(void* block);
+
+private:
+
+   enum
+   {
+      CACHE_CAPACITY = 256,   // Blocks kept by a thread cache
+      TRANSFER_BLOCKS = 64,   // Blocks moved between caches and shared list
+      CHUNK_BLOCKS = 64,      // Blocks allocated from the system at once
+   };
+
+   struct Block { Block* next; };
+
+   /*
+    * Thread cache of free blocks. It is trivially destructible, so the
+    * pool may be used by static objects destroyed after thread exit. The
+    * cache is closed once it is flushed at thread exit.
+    */
+   struct Cache
+   {
+      Block*         head;
+      unsigned long  count;
+      bool           closed;
+   };
+
+   struct CacheFlusher
+   {
+      inline ~CacheFlusher();
+   };
+
+   struct SharedList
+   {
+      std::mutex  lock;
+      Block*      head;
+
+      inline SharedList() : head(NULL) {}
+   };
+
+   static thread_local Cache _cache;
+
+   inline static SharedList& sharedList();
+
+   inline static void registerFlusher();
+
+   static void refill(Cache& cache);
+
+   static void drain(Cache& cache, unsigned long nblocks);
+};
+
+/**
+ * Pool allocator class. This class template provides a standard allocator
+ * that obtains single objects from the FixedSizePool for their size. It
+ * is intended for node based collections like LinkedList or TreeMap,
+ * which allocate one node per element. Allocations of several objects
+ * at once fall back to the global operator new. All pool allocators are
+ * interchangeable.
+ */
+template <class T>
+class PoolAllocator
+{
+public:
+
+   typedef T value_type;
+
+   inline PoolAllocator() {}
+
+   template <class U>
+   inline PoolAllocator(const PoolAllocator<U>&) {}
+
+   inline T* allocate(std::size_t n);
+
+   inline void deallocate(T* p, std::size_t n);
+
+private:
+
+   enum
+   {
+      ALIGNMENT = std::alignment_of<std::max_align_t>::value,
+      BLOCK_SIZE = (sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT,
+      POOLED = std::alignment_of<T>::value <= ALIGNMENT,
+   };
+
+   typedef FixedSizePool<BLOCK_SIZE> Pool;
+};
+
+template <class T, class U>
+inline bool operator == (const PoolAllocator<T>&, const PoolAllocator<U>&)
+{ return true; }
+
+template <class T, class U>
+inline bool operator != (const PoolAllocator<T>&, const PoolAllocator<U>&)
+{ return false; }
+
+/**
+ * Memory arena class. This class provides memory from chunks by bumping
+ * a pointer, so allocations are very cheap and objects can't be
+ * individually deallocated. Instead, all the memory is released at once
+ * when the arena is released or destroyed. The objects allocated from
+ * the arena must be destroyed before that. Arenas are not thread safe.
+ */
+class KAREN_EXPORT Arena
+{
+public:
+
+   /**
+    * Create a new arena that obtains memory in chunks of given size.
+    */
+   Arena(unsigned long chunkSize = 64 * 1024);
+
+   /**
+    * Destroy the arena, releasing all its memory.
+    */
+   ~Arena();
+
+   /**
+    * Allocate given number of bytes with given alignment, which must be
+    * a power of two.
+    */
+   inline void* allocate(
+         unsigned long size,
+         unsigned long alignment = std::alignment_of<std::max_align_t>::value);
+
+   /**
+    * Release all the memory allocated from this arena.
+    */
+   void release();
+
+   /**
+    * Obtain the number of bytes allocated since the last release.
+    */
+   inline unsigned long allocatedBytes() const
+   { return _allocatedBytes; }
+
+private:
+
+   struct Chunk { Chunk* next; };
+
+   Chunk*         _chunks;
+   char*          _cursor;
+   char*          _limit;
+   unsigned long  _chunkSize;
+   unsigned long  _allocatedBytes;
+
+   Arena(const Arena&);
+
+   Arena& operator = (const Arena&);
+
+   void* allocateFromNewChunk(unsigned long size, unsigned long alignment);
+};
+
+/**
+ * Arena allocator class. This class template provides a standard allocator
+ * that obtains memory from an arena. Deallocations do nothing, since the
+ * memory is released along with the arena, so it suits collections that
+ * are built and discarded as a whole. Two arena allocators are equal if
+ * they use the same arena.
+ */
+template <class T>
+class ArenaAllocator
+{
+public:
+
+   typedef T value_type;
+
+   inline ArenaAllocator(Arena& arena) : _arena(&arena) {}
+
+   template <class U>
+   inline ArenaAllocator(const ArenaAllocator<U>& alloc)
+    : _arena(alloc._arena) {}
+
+   inline T* allocate(std::size_t n)
+   {
+      return static_cast<T*>(_arena->allocate(
+            n * sizeof(T), std::alignment_of<T>::value));
+   }
+
+   inline void deallocate(T*, std::size_t) {}
+
+   template <class U> friend class ArenaAllocator;
+
+   template <class U, class V>
+   friend bool operator == (const ArenaAllocator<U>&,
+                            const ArenaAllocator<V>&);
+
+private:
+
+   Arena* _arena;
+};
+
+template <class T, class U>
+inline bool operator == (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{ return a._arena == b._arena; }
+
+template <class T, class U>
+inline bool operator != (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{ return !(a == b); }
+
+}; // namespace karen
+
+using karen::Arena;
+using karen::ArenaAllocator;
+using karen::PoolAllocator;
+
+#include "KarenCore/allocator-inl.h"
+
+#endif
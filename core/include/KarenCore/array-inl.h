@@ -25,6 +25,9 @@
 #ifndef KAREN_CORE_ARRAY_INL_H
 #define KAREN_CORE_ARRAY_INL_H
 
+#include <cstring>
+#include <new>
+
 #include "KarenCore/array.h"
 
 namespace karen {
@@ -41,121 +44,120 @@ Array<T>::operator[] (unsigned long pos)
 throw (OutOfBoundsException)
 { return this->get(pos); }
 
-template <class T>
-DynArray<T>::DynArray() : _impl(new std::vector<T>()) {}
+template <class T, class Allocator>
+DynArray<T, Allocator>::DynArray() : _impl() {}
 
-template <class T>
-DynArray<T>::DynArray(unsigned long size) : _impl(new std::vector<T>(size)) {}
+template <class T, class Allocator>
+DynArray<T, Allocator>::DynArray(unsigned long size) : _impl(size) {}
 
-template <class T>
-DynArray<T>::DynArray(const T* tv, unsigned long len)
-   : _impl(new std::vector<T>())
-{ for (unsigned long i = 0; i < len; i++) append(tv[i]); }
+template <class T, class Allocator>
+DynArray<T, Allocator>::DynArray(const T* tv, unsigned long len)
+   : _impl(tv, tv + len)
+{}
 
-template <class T>
-DynArray<T>::~DynArray()
-{ delete _impl; }
+template <class T, class Allocator>
+DynArray<T, Allocator>::DynArray(const Allocator& alloc) : _impl(alloc) {}
 
-template <class T>
+template <class T, class Allocator>
 unsigned long
-DynArray<T>::size() const
-{ return _impl->size(); }
+DynArray<T, Allocator>::size() const
+{ return _impl.size(); }
 
-template <class T>
+template <class T, class Allocator>
 void
-DynArray<T>::clear()
-{ return _impl->clear(); }
+DynArray<T, Allocator>::clear()
+{ return _impl.clear(); }
 
-template <class T>
+template <class T, class Allocator>
 Iterator<T>
-DynArray<T>::begin()
+DynArray<T, Allocator>::begin()
 { 
    Ptr<AbstractIterator<T> > it = 
-      new DynArrayIterator(*this, _impl->begin(), _impl->end());
+      new DynArrayIterator(*this, _impl.begin(), _impl.end());
    return Iterator<T>(it);
 }
 
-template <class T>
+template <class T, class Allocator>
 Iterator<T>
-DynArray<T>::end()
+DynArray<T, Allocator>::end()
 { 
    Ptr<AbstractIterator<T> > it = 
-      new DynArrayIterator(*this, _impl->end(), _impl->end());
+      new DynArrayIterator(*this, _impl.end(), _impl.end());
    return Iterator<T>(it);
 }
 
-template <class T>
+template <class T, class Allocator>
 Iterator<const T>
-DynArray<T>::begin() const
+DynArray<T, Allocator>::begin() const
 { 
    Ptr<AbstractIterator<const T> > it = 
-      new DynArrayIterator(*this, _impl->begin(), _impl->end());
+      new DynArrayIterator(*this, _impl.begin(), _impl.end());
    return Iterator<const T>(it);
 }
 
-template <class T>
+template <class T, class Allocator>
 Iterator<const T>
-DynArray<T>::end() const
+DynArray<T, Allocator>::end() const
 {
    Ptr<AbstractIterator<const T> > it = 
-      new DynArrayIterator(*this, _impl->end(), _impl->end());
+      new DynArrayIterator(*this, _impl.end(), _impl.end());
    return Iterator<const T>(it);
 }
 
-template <class T>
+template <class T, class Allocator>
 Iterator<T>
-DynArray<T>::rbegin()
+DynArray<T, Allocator>::rbegin()
 { 
    Ptr<AbstractIterator<T> > it = 
-      new DynArrayReverseIterator(*this, _impl->rbegin(), _impl->rend());
+      new DynArrayReverseIterator(*this, _impl.rbegin(), _impl.rend());
    return Iterator<T>(it);
 }
 
-template <class T>
+template <class T, class Allocator>
 Iterator<T>
-DynArray<T>::rend()
+DynArray<T, Allocator>::rend()
 { 
    Ptr<AbstractIterator<T> > it = 
-      new DynArrayReverseIterator(*this, _impl->rend(), _impl->rend());
+      new DynArrayReverseIterator(*this, _impl.rend(), _impl.rend());
    return Iterator<T>(it);
 }
 
-template <class T>
+template <class T, class Allocator>
 Iterator<const T>
-DynArray<T>::rbegin() const
+DynArray<T, Allocator>::rbegin() const
 { 
    Ptr<AbstractIterator<const T> > it = 
-      new DynArrayReverseIterator(*this, _impl->rbegin(), _impl->rend());
+      new DynArrayReverseIterator(*this, _impl.rbegin(), _impl.rend());
    return Iterator<const T>(it);
 }
 
-template <class T>
+template <class T, class Allocator>
 Iterator<const T>
-DynArray<T>::rend() const
+DynArray<T, Allocator>::rend() const
 {
    Ptr<AbstractIterator<const T> > it = 
-      new DynArrayReverseIterator(*this, _impl->rend(), _impl->rend());
+      new DynArrayReverseIterator(*this, _impl.rend(), _impl.rend());
    return Iterator<const T>(it);
 }
 
-template <class T>
+template <class T, class Allocator>
 void
-DynArray<T>::remove(Iterator<T>& it)
+DynArray<T, Allocator>::remove(Iterator<T>& it)
 {
    DynArrayIterator* nit = it.template impl<DynArrayIterator>();
    DynArrayReverseIterator* nrit = it.template impl<DynArrayReverseIterator>();
    if (nit && (nit->collection() == this))
    {
       Ptr<AbstractIterator<T>> newIt = 
-         new DynArrayIterator(*this, _impl->erase(nit->impl()), _impl->end());
+         new DynArrayIterator(*this, _impl.erase(nit->impl()), _impl.end());
       it = newIt;
    }
    else if (nrit && (nrit->collection() == this))
    {
       typename _Impl::reverse_iterator newItImpl =
-         typename _Impl::reverse_iterator(_impl->erase(--(nrit->impl().base())));
+         typename _Impl::reverse_iterator(_impl.erase(--(nrit->impl().base())));
       Ptr<AbstractIterator<T>> newIt = new DynArrayReverseIterator(
-            *this, newItImpl, _impl->rend());
+            *this, newItImpl, _impl.rend());
       it = newIt;
    }
    else
@@ -164,50 +166,569 @@ DynArray<T>::remove(Iterator<T>& it)
             " the iterator does not belongs to this collection");
 }
    
-template <class T>
+template <class T, class Allocator>
 const T&
-DynArray<T>::get(unsigned long pos) const 
+DynArray<T, Allocator>::get(unsigned long pos) const 
 throw (OutOfBoundsException)
 {
-   return const_cast<DynArray<T>*>(this)->get(pos);
+   return const_cast<DynArray<T, Allocator>*>(this)->get(pos);
 }
 
-template <class T>
+template <class T, class Allocator>
 T&
-DynArray<T>::get(unsigned long pos)
+DynArray<T, Allocator>::get(unsigned long pos)
 throw (OutOfBoundsException)
 {
-   if (pos < _impl->size())
-      return _impl->at(pos);
+   if (pos < _impl.size())
+      return _impl.at(pos);
    else
       KAREN_THROW(OutOfBoundsException, 
          "cannot obtain element at position %d: "
          "no such position for target dynamic array", pos);
 }
 
-template <class T>
+template <class T, class Allocator>
+const T*
+DynArray<T, Allocator>::tryGet(unsigned long pos) const
+{ return pos < _impl.size() ? &_impl[pos] : NULL; }
+
+template <class T, class Allocator>
+T*
+DynArray<T, Allocator>::tryGet(unsigned long pos)
+{ return pos < _impl.size() ? &_impl[pos] : NULL; }
+
+template <class T, class Allocator>
 void
-DynArray<T>::resize(unsigned long size)
-{ _impl->resize(size); }
+DynArray<T, Allocator>::resize(unsigned long size)
+{ _impl.resize(size); }
 
-template <class T>
+template <class T, class Allocator>
+void
+DynArray<T, Allocator>::set(const T& t, unsigned long pos) 
+throw (OutOfBoundsException)
+{
+   if (pos < _impl.size())
+      _impl[pos] = t;
+   else
+      KAREN_THROW(OutOfBoundsException, 
+         "cannot set element at position %d: "
+         "no such position for target dynamic array", pos);
+}
+
+template <class T, class Allocator>
 void
-DynArray<T>::set(const T& t, unsigned long pos) 
+DynArray<T, Allocator>::set(T&& t, unsigned long pos) 
 throw (OutOfBoundsException)
 {
-   if (pos < _impl->size())
-      (*_impl)[pos] = t;
+   if (pos < _impl.size())
+      _impl[pos] = std::move(t);
    else
       KAREN_THROW(OutOfBoundsException, 
          "cannot set element at position %d: "
          "no such position for target dynamic array", pos);
 }
 
+template <class T, class Allocator>
+void
+DynArray<T, Allocator>::append(const T& t)
+{ _impl.push_back(t); }
+
+template <class T, class Allocator>
+void
+DynArray<T, Allocator>::append(T&& t)
+{ _impl.push_back(std::move(t)); }
+
+template <class T, class Allocator>
+template <class ... Args>
+void
+DynArray<T, Allocator>::emplaceBack(Args&& ... args)
+{ _impl.emplace_back(std::forward<Args>(args)...); }
+
+template <class T, class Allocator>
+unsigned long
+DynArray<T, Allocator>::capacity() const
+{ return _impl.capacity(); }
+
+template <class T, class Allocator>
+void
+DynArray<T, Allocator>::reserve(unsigned long capacity)
+{ _impl.reserve(capacity); }
+
+template <class T, class Allocator>
+void
+DynArray<T, Allocator>::shrinkToFit()
+{ _impl.shrink_to_fit(); }
+
+template <class T, class Allocator>
+typename DynArray<T, Allocator>::FastIterator
+DynArray<T, Allocator>::fastBegin()
+{ return _impl.begin(); }
+
+template <class T, class Allocator>
+typename DynArray<T, Allocator>::FastIterator
+DynArray<T, Allocator>::fastEnd()
+{ return _impl.end(); }
+
+template <class T, class Allocator>
+typename DynArray<T, Allocator>::ConstFastIterator
+DynArray<T, Allocator>::fastBegin() const
+{ return _impl.begin(); }
+
+template <class T, class Allocator>
+typename DynArray<T, Allocator>::ConstFastIterator
+DynArray<T, Allocator>::fastEnd() const
+{ return _impl.end(); }
+
+template <class T, class Allocator>
+FastRange<typename DynArray<T, Allocator>::FastIterator>
+DynArray<T, Allocator>::fast()
+{ return FastRange<FastIterator>(fastBegin(), fastEnd()); }
+
+template <class T, class Allocator>
+FastRange<typename DynArray<T, Allocator>::ConstFastIterator>
+DynArray<T, Allocator>::fast() const
+{ return FastRange<ConstFastIterator>(fastBegin(), fastEnd()); }
+
+/*
+ * Element operations used by SmallDynArray to copy, relocate and destroy
+ * elements in raw storage. Trivially copyable types are processed as
+ * plain memory blocks.
+ */
+template <class T, bool TriviallyCopyable = 
+      std::is_trivially_copyable<T>::value>
+struct ArrayElementOps
+{
+   inline static void copy(T* dst, const T* src, unsigned long n)
+   { for (unsigned long i = 0; i < n; i++) new (dst + i) T(src[i]); }
+
+   inline static void relocate(T* dst, T* src, unsigned long n)
+   {
+      for (unsigned long i = 0; i < n; i++)
+      {
+         new (dst + i) T(std::move(src[i]));
+         src[i].~T();
+      }
+   }
+
+   inline static void destroy(T* first, unsigned long n)
+   { for (unsigned long i = 0; i < n; i++) first[i].~T(); }
+};
+
 template <class T>
+struct ArrayElementOps<T, true>
+{
+   inline static void copy(T* dst, const T* src, unsigned long n)
+   { if (n) std::memcpy(dst, src, n * sizeof(T)); }
+
+   inline static void relocate(T* dst, T* src, unsigned long n)
+   { if (n) std::memcpy(dst, src, n * sizeof(T)); }
+
+   inline static void destroy(T*, unsigned long) {}
+};
+
+template <class T, unsigned long N>
+SmallDynArray<T, N>::SmallDynArray()
+   : _data(inlineData()), _size(0), _capacity(N)
+{}
+
+template <class T, unsigned long N>
+SmallDynArray<T, N>::SmallDynArray(unsigned long size)
+   : _data(inlineData()), _size(0), _capacity(N)
+{ resize(size); }
+
+template <class T, unsigned long N>
+SmallDynArray<T, N>::SmallDynArray(const T* tv, unsigned long len)
+   : _data(inlineData()), _size(0), _capacity(N)
+{
+   reserve(len);
+   ArrayElementOps<T>::copy(_data, tv, len);
+   _size = len;
+}
+
+template <class T, unsigned long N>
+SmallDynArray<T, N>::SmallDynArray(const SmallDynArray& other)
+   : _data(inlineData()), _size(0), _capacity(N)
+{
+   reserve(other._size);
+   ArrayElementOps<T>::copy(_data, other._data, other._size);
+   _size = other._size;
+}
+
+template <class T, unsigned long N>
+SmallDynArray<T, N>::SmallDynArray(SmallDynArray&& other)
+   : _data(inlineData()), _size(0), _capacity(N)
+{ steal(other); }
+
+template <class T, unsigned long N>
+SmallDynArray<T, N>::~SmallDynArray()
+{
+   ArrayElementOps<T>::destroy(_data, _size);
+   if (!isInline())
+      ::operator delete(_data);
+}
+
+template <class T, unsigned long N>
+SmallDynArray<T, N>&
+SmallDynArray<T, N>::operator = (const SmallDynArray& other)
+{
+   if (this != &other)
+   {
+      clear();
+      reserve(other._size);
+      ArrayElementOps<T>::copy(_data, other._data, other._size);
+      _size = other._size;
+   }
+   return *this;
+}
+
+template <class T, unsigned long N>
+SmallDynArray<T, N>&
+SmallDynArray<T, N>::operator = (SmallDynArray&& other)
+{
+   if (this != &other)
+   {
+      clear();
+      if (!isInline())
+      {
+         ::operator delete(_data);
+         _data = inlineData();
+         _capacity = N;
+      }
+      steal(other);
+   }
+   return *this;
+}
+
+template <class T, unsigned long N>
+unsigned long
+SmallDynArray<T, N>::size() const
+{ return _size; }
+
+template <class T, unsigned long N>
 void
-DynArray<T>::append(const T& t)
-{ _impl->push_back(t); }
+SmallDynArray<T, N>::clear()
+{
+   ArrayElementOps<T>::destroy(_data, _size);
+   _size = 0;
+}
+
+template <class T, unsigned long N>
+Iterator<T>
+SmallDynArray<T, N>::begin()
+{ 
+   Ptr<AbstractIterator<T> > it = 
+      new SmallDynArrayIterator(*this, _data, _data + _size);
+   return Iterator<T>(it);
+}
+
+template <class T, unsigned long N>
+Iterator<T>
+SmallDynArray<T, N>::end()
+{ 
+   Ptr<AbstractIterator<T> > it = 
+      new SmallDynArrayIterator(*this, _data + _size, _data + _size);
+   return Iterator<T>(it);
+}
+
+template <class T, unsigned long N>
+Iterator<const T>
+SmallDynArray<T, N>::begin() const
+{ 
+   Ptr<AbstractIterator<const T> > it = 
+      new SmallDynArrayIterator(*this, _data, _data + _size);
+   return Iterator<const T>(it);
+}
+
+template <class T, unsigned long N>
+Iterator<const T>
+SmallDynArray<T, N>::end() const
+{
+   Ptr<AbstractIterator<const T> > it = 
+      new SmallDynArrayIterator(*this, _data + _size, _data + _size);
+   return Iterator<const T>(it);
+}
+
+template <class T, unsigned long N>
+Iterator<T>
+SmallDynArray<T, N>::rbegin()
+{ 
+   Ptr<AbstractIterator<T> > it = new SmallDynArrayReverseIterator(*this, 
+         std::reverse_iterator<T*>(_data + _size), 
+         std::reverse_iterator<T*>(_data));
+   return Iterator<T>(it);
+}
+
+template <class T, unsigned long N>
+Iterator<T>
+SmallDynArray<T, N>::rend()
+{ 
+   Ptr<AbstractIterator<T> > it = new SmallDynArrayReverseIterator(*this, 
+         std::reverse_iterator<T*>(_data), 
+         std::reverse_iterator<T*>(_data));
+   return Iterator<T>(it);
+}
+
+template <class T, unsigned long N>
+Iterator<const T>
+SmallDynArray<T, N>::rbegin() const
+{ 
+   Ptr<AbstractIterator<const T> > it = new SmallDynArrayReverseIterator(
+         *this, 
+         std::reverse_iterator<T*>(_data + _size), 
+         std::reverse_iterator<T*>(_data));
+   return Iterator<const T>(it);
+}
+
+template <class T, unsigned long N>
+Iterator<const T>
+SmallDynArray<T, N>::rend() const
+{
+   Ptr<AbstractIterator<const T> > it = new SmallDynArrayReverseIterator(
+         *this, 
+         std::reverse_iterator<T*>(_data), 
+         std::reverse_iterator<T*>(_data));
+   return Iterator<const T>(it);
+}
+
+template <class T, unsigned long N>
+void
+SmallDynArray<T, N>::remove(Iterator<T>& it)
+{
+   SmallDynArrayIterator* nit = 
+         it.template impl<SmallDynArrayIterator>();
+   SmallDynArrayReverseIterator* nrit = 
+         it.template impl<SmallDynArrayReverseIterator>();
+   if (nit && (nit->collection() == this))
+   {
+      Ptr<AbstractIterator<T>> newIt = new SmallDynArrayIterator(
+            *this, erase(nit->impl()), _data + _size);
+      it = newIt;
+   }
+   else if (nrit && (nrit->collection() == this))
+   {
+      std::reverse_iterator<T*> newItImpl(erase(nrit->impl().base() - 1));
+      Ptr<AbstractIterator<T>> newIt = new SmallDynArrayReverseIterator(
+            *this, newItImpl, std::reverse_iterator<T*>(_data));
+      it = newIt;
+   }
+   else
+      KAREN_THROW(InvalidInputException, 
+            "cannot remove element from small dynamic array from given "
+            "iterator: the iterator does not belongs to this collection");
+}
+   
+template <class T, unsigned long N>
+const T&
+SmallDynArray<T, N>::get(unsigned long pos) const 
+throw (OutOfBoundsException)
+{
+   return const_cast<SmallDynArray<T, N>*>(this)->get(pos);
+}
+
+template <class T, unsigned long N>
+T&
+SmallDynArray<T, N>::get(unsigned long pos)
+throw (OutOfBoundsException)
+{
+   if (pos < _size)
+      return _data[pos];
+   else
+      KAREN_THROW(OutOfBoundsException, 
+         "cannot obtain element at position %d: "
+         "no such position for target small dynamic array", pos);
+}
+
+template <class T, unsigned long N>
+const T*
+SmallDynArray<T, N>::tryGet(unsigned long pos) const
+{ return pos < _size ? _data + pos : NULL; }
+
+template <class T, unsigned long N>
+T*
+SmallDynArray<T, N>::tryGet(unsigned long pos)
+{ return pos < _size ? _data + pos : NULL; }
+
+template <class T, unsigned long N>
+void
+SmallDynArray<T, N>::resize(unsigned long size)
+{
+   if (size > _size)
+   {
+      reserve(size);
+      for (unsigned long i = _size; i < size; i++)
+         new (_data + i) T();
+   }
+   else
+      ArrayElementOps<T>::destroy(_data + size, _size - size);
+   _size = size;
+}
+
+template <class T, unsigned long N>
+void
+SmallDynArray<T, N>::set(const T& t, unsigned long pos) 
+throw (OutOfBoundsException)
+{
+   if (pos < _size)
+      _data[pos] = t;
+   else
+      KAREN_THROW(OutOfBoundsException, 
+         "cannot set element at position %d: "
+         "no such position for target small dynamic array", pos);
+}
+
+template <class T, unsigned long N>
+void
+SmallDynArray<T, N>::set(T&& t, unsigned long pos) 
+throw (OutOfBoundsException)
+{
+   if (pos < _size)
+      _data[pos] = std::move(t);
+   else
+      KAREN_THROW(OutOfBoundsException, 
+         "cannot set element at position %d: "
+         "no such position for target small dynamic array", pos);
+}
+
+template <class T, unsigned long N>
+void
+SmallDynArray<T, N>::append(const T& t)
+{ emplaceBack(t); }
+
+template <class T, unsigned long N>
+void
+SmallDynArray<T, N>::append(T&& t)
+{ emplaceBack(std::move(t)); }
+
+template <class T, unsigned long N>
+template <class ... Args>
+void
+SmallDynArray<T, N>::emplaceBack(Args&& ... args)
+{
+   if (_size == _capacity)
+   {
+      // args may refer to an element of this array, so the new element
+      // is built before the storage is reallocated
+      T t(std::forward<Args>(args)...);
+      reallocate(_capacity * 2);
+      new (_data + _size) T(std::move(t));
+   }
+   else
+      new (_data + _size) T(std::forward<Args>(args)...);
+   _size++;
+}
+
+template <class T, unsigned long N>
+unsigned long
+SmallDynArray<T, N>::capacity() const
+{ return _capacity; }
+
+template <class T, unsigned long N>
+void
+SmallDynArray<T, N>::reserve(unsigned long capacity)
+{
+   if (capacity > _capacity)
+      reallocate(capacity);
+}
+
+template <class T, unsigned long N>
+void
+SmallDynArray<T, N>::shrinkToFit()
+{
+   if (!isInline() && _size < _capacity)
+      reallocate(_size);
+}
+
+template <class T, unsigned long N>
+bool
+SmallDynArray<T, N>::isInline() const
+{ return _data == reinterpret_cast<const T*>(&_inline); }
+
+template <class T, unsigned long N>
+typename SmallDynArray<T, N>::FastIterator
+SmallDynArray<T, N>::fastBegin()
+{ return _data; }
+
+template <class T, unsigned long N>
+typename SmallDynArray<T, N>::FastIterator
+SmallDynArray<T, N>::fastEnd()
+{ return _data + _size; }
+
+template <class T, unsigned long N>
+typename SmallDynArray<T, N>::ConstFastIterator
+SmallDynArray<T, N>::fastBegin() const
+{ return _data; }
+
+template <class T, unsigned long N>
+typename SmallDynArray<T, N>::ConstFastIterator
+SmallDynArray<T, N>::fastEnd() const
+{ return _data + _size; }
+
+template <class T, unsigned long N>
+FastRange<typename SmallDynArray<T, N>::FastIterator>
+SmallDynArray<T, N>::fast()
+{ return FastRange<FastIterator>(fastBegin(), fastEnd()); }
+
+template <class T, unsigned long N>
+FastRange<typename SmallDynArray<T, N>::ConstFastIterator>
+SmallDynArray<T, N>::fast() const
+{ return FastRange<ConstFastIterator>(fastBegin(), fastEnd()); }
+
+template <class T, unsigned long N>
+T*
+SmallDynArray<T, N>::inlineData()
+{ return reinterpret_cast<T*>(&_inline); }
+
+template <class T, unsigned long N>
+void
+SmallDynArray<T, N>::steal(SmallDynArray& other)
+{
+   // This array must be empty and inline when called.
+   if (other.isInline())
+      ArrayElementOps<T>::relocate(_data, other._data, other._size);
+   else
+   {
+      _data = other._data;
+      _capacity = other._capacity;
+      other._data = other.inlineData();
+      other._capacity = N;
+   }
+   _size = other._size;
+   other._size = 0;
+}
+
+template <class T, unsigned long N>
+void
+SmallDynArray<T, N>::reallocate(unsigned long capacity)
+{
+   T* newData;
+   if (capacity <= N)
+   {
+      if (isInline())
+         return;
+      newData = inlineData();
+      capacity = N;
+   }
+   else
+      newData = static_cast<T*>(::operator new(capacity * sizeof(T)));
+   ArrayElementOps<T>::relocate(newData, _data, _size);
+   if (!isInline())
+      ::operator delete(_data);
+   _data = newData;
+   _capacity = capacity;
+}
+
+template <class T, unsigned long N>
+T*
+SmallDynArray<T, N>::erase(T* pos)
+{
+   T* last = _data + _size - 1;
+   for (T* p = pos; p != last; p++)
+      *p = std::move(*(p + 1));
+   last->~T();
+   _size--;
+   return pos;
+}
 
 }
 
-#endif   
+#endif
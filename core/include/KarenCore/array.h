@@ -25,6 +25,7 @@
 #ifndef KAREN_CORE_ARRAY_H
 #define KAREN_CORE_ARRAY_H
 
+#include <type_traits>
 #include <vector>
  
 #include "KarenCore/collection.h"
@@ -71,6 +72,20 @@ public:
    virtual T& get(unsigned long pos)
          throw (OutOfBoundsException) = 0;
 
+   /**
+    * Obtain a pointer to the element located in given position, or a null
+    * pointer if there is no such position. Unlike get(), this does not
+    * throw on invalid positions, which makes it cheaper when they are
+    * expected.
+    */
+   virtual const T* tryGet(unsigned long pos) const = 0;
+
+   /**
+    * Obtain a pointer to the element located in given position, or a null
+    * pointer if there is no such position.
+    */
+   virtual T* tryGet(unsigned long pos) = 0;
+
    /**
     * Resize the array to allocate space for size elements. If the array
     * already have space for the given size, nothing is done.
@@ -84,14 +99,31 @@ public:
    virtual void set(const T& t, unsigned long pos) 
          throw (OutOfBoundsException) = 0;
 
+   /**
+    * Set the element placed at given position by moving given value into
+    * it. If there is no such position, a OutOfBoundsException is thrown.
+    */
+   virtual void set(T&& t, unsigned long pos) 
+         throw (OutOfBoundsException) = 0;
+
    /**
     * Append the given element at the end of the array.
     */
    virtual void append(const T& t) = 0;
 
+   /**
+    * Append the given element at the end of the array by moving it.
+    */
+   virtual void append(T&& t) = 0;
+
 };
 
-template <class T>
+/**
+ * Dynamic array class. This class implements the Array interface by
+ * means of a contiguous block of heap memory that grows as new elements
+ * are appended. The memory is obtained from given Allocator.
+ */
+template <class T, class Allocator = std::allocator<T> >
 class DynArray : public Array<T>
 {
 public:
@@ -107,12 +139,18 @@ public:
    inline DynArray(unsigned long size);
    
    /**
-    * Create a new dynamic array from a raw C-array.
+    * Create a new dynamic array from a raw C-array. The storage is
+    * allocated once, and the elements are bulk-copied if T is trivially
+    * copyable.
     */
    inline DynArray(const T* tv, unsigned long len);
 
-   inline ~DynArray();
-   
+   /**
+    * Create a new empty dynamic array which memory is obtained from given
+    * allocator.
+    */
+   inline explicit DynArray(const Allocator& alloc);
+
    inline virtual unsigned long size() const;
 
    inline void clear();
@@ -141,16 +179,67 @@ public:
    inline virtual T& get(unsigned long pos)
          throw (OutOfBoundsException);
 
+   inline virtual const T* tryGet(unsigned long pos) const;
+
+   inline virtual T* tryGet(unsigned long pos);
+
    inline virtual void resize(unsigned long size);
    
    inline virtual void set(const T& t, unsigned long pos) 
          throw (OutOfBoundsException);
 
-   virtual void append(const T& t);
+   inline virtual void set(T&& t, unsigned long pos) 
+         throw (OutOfBoundsException);
+
+   inline virtual void append(const T& t);
+
+   inline virtual void append(T&& t);
+
+   /**
+    * Append a new element at the end of the array constructing it in
+    * place from given arguments.
+    */
+   template <class ... Args>
+   inline void emplaceBack(Args&& ... args);
+
+   /**
+    * Obtain the number of elements the array may hold before it has to
+    * allocate new storage.
+    */
+   inline unsigned long capacity() const;
+
+   /**
+    * Ensure the array may hold at least the given number of elements
+    * without allocating new storage. 
+    */
+   inline void reserve(unsigned long capacity);
+
+   /**
+    * Release the storage that is not used by the current elements.
+    */
+   inline void shrinkToFit();
+
+   /**
+    * Fast iterator types. See FastRange for details.
+    */
+   typedef typename std::vector<T, Allocator>::iterator FastIterator;
+   typedef typename std::vector<T, Allocator>::const_iterator ConstFastIterator;
+
+   inline FastIterator fastBegin();
+
+   inline FastIterator fastEnd();
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<FastIterator> fast();
+
+   inline FastRange<ConstFastIterator> fast() const;
 
 private:
 
-   typedef std::vector<T> _Impl;
+   typedef std::vector<T, Allocator> _Impl;
 
    typedef IteratorImpl<T, DynArray, 
          typename _Impl::iterator> DynArrayIterator;
@@ -158,8 +247,176 @@ private:
    typedef IteratorImpl<T, DynArray, 
          typename _Impl::reverse_iterator> DynArrayReverseIterator;
 
-   mutable _Impl* _impl;
+   mutable _Impl _impl;
+   
+};
+
+/**
+ * Small dynamic array class. This class implements the Array interface
+ * keeping the first N elements in storage embedded in the object itself,
+ * so arrays that never grow beyond N elements do not touch the heap at 
+ * all. Once the inline storage is exhausted the elements are moved to a
+ * heap block that doubles its capacity each time it grows. It is aimed
+ * to be used for short-lived arrays whose usual size is known in 
+ * advance, as local variables or members of per-frame structures. 
+ */
+template <class T, unsigned long N>
+class SmallDynArray : public Array<T>
+{
+public:
+
+   static_assert(N > 0, "small dynamic array inline capacity must be positive");
+
+   /**
+    * Create a new small dynamic array with an initial size of 0. 
+    */
+   inline SmallDynArray();
+   
+   /**
+    * Create a new small dynamic array with a given initial size.
+    */
+   inline SmallDynArray(unsigned long size);
+   
+   /**
+    * Create a new small dynamic array from a raw C-array. The elements
+    * are bulk-copied if T is trivially copyable.
+    */
+   inline SmallDynArray(const T* tv, unsigned long len);
+
+   inline SmallDynArray(const SmallDynArray& other);
+
+   /**
+    * Move the contents of the array passed as argument to the new one. A
+    * heap block is taken over as is; inline elements are moved one by one.
+    * The source array is left empty and inline.
+    */
+   inline SmallDynArray(SmallDynArray&& other);
+
+   inline ~SmallDynArray();
+
+   inline SmallDynArray& operator = (const SmallDynArray& other);
+
+   /**
+    * Move assignment operator.
+    */
+   inline SmallDynArray& operator = (SmallDynArray&& other);
    
+   inline virtual unsigned long size() const;
+
+   inline void clear();
+
+   inline virtual Iterator<T> begin();
+   
+   inline virtual Iterator<T> end();
+   
+   inline virtual Iterator<const T> begin() const;
+   
+   inline virtual Iterator<const T> end() const;
+
+   inline virtual Iterator<T> rbegin();
+   
+   inline virtual Iterator<T> rend();
+   
+   inline virtual Iterator<const T> rbegin() const;
+   
+   inline virtual Iterator<const T> rend() const;
+
+   inline virtual void remove(Iterator<T>& it);
+
+   inline virtual const T& get(unsigned long pos) const 
+      throw (OutOfBoundsException);
+
+   inline virtual T& get(unsigned long pos)
+         throw (OutOfBoundsException);
+
+   inline virtual const T* tryGet(unsigned long pos) const;
+
+   inline virtual T* tryGet(unsigned long pos);
+
+   inline virtual void resize(unsigned long size);
+   
+   inline virtual void set(const T& t, unsigned long pos) 
+         throw (OutOfBoundsException);
+
+   inline virtual void set(T&& t, unsigned long pos) 
+         throw (OutOfBoundsException);
+
+   inline virtual void append(const T& t);
+
+   inline virtual void append(T&& t);
+
+   /**
+    * Append a new element at the end of the array constructing it in
+    * place from given arguments.
+    */
+   template <class ... Args>
+   inline void emplaceBack(Args&& ... args);
+
+   /**
+    * Obtain the number of elements the array may hold before it has to
+    * allocate new storage. It is never less than N.
+    */
+   inline unsigned long capacity() const;
+
+   /**
+    * Ensure the array may hold at least the given number of elements
+    * without allocating new storage. 
+    */
+   inline void reserve(unsigned long capacity);
+
+   /**
+    * Release the heap storage that is not used by the current elements.
+    * If they fit in the inline storage, the heap block is freed.
+    */
+   inline void shrinkToFit();
+
+   /**
+    * Check whether elements are stored inline, i.e., no heap storage
+    * is in use.
+    */
+   inline bool isInline() const;
+
+   /**
+    * Fast iterator types. See FastRange for details.
+    */
+   typedef T* FastIterator;
+   typedef const T* ConstFastIterator;
+
+   inline FastIterator fastBegin();
+
+   inline FastIterator fastEnd();
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<FastIterator> fast();
+
+   inline FastRange<ConstFastIterator> fast() const;
+
+private:
+
+   typedef IteratorImpl<T, SmallDynArray, T*> SmallDynArrayIterator;
+
+   typedef IteratorImpl<T, SmallDynArray, 
+         std::reverse_iterator<T*> > SmallDynArrayReverseIterator;
+
+   typedef typename std::aligned_storage<
+         sizeof(T) * N, std::alignment_of<T>::value>::type _InlineStorage;
+
+   T*                _data;
+   unsigned long     _size;
+   unsigned long     _capacity;
+   _InlineStorage    _inline;
+
+   inline T* inlineData();
+
+   inline void steal(SmallDynArray& other);
+
+   inline void reallocate(unsigned long capacity);
+
+   inline T* erase(T* pos);
+
 };
 
 }
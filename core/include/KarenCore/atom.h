@@ -0,0 +1,173 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_ATOM_H
+#define KAREN_CORE_ATOM_H
+
+#include "KarenCore/hash.h"
+#include "KarenCore/map.h"
+#include "KarenCore/platform.h"
+#include "KarenCore/string.h"
+
+namespace karen {
+
+/**
+ * Atom statistics. This struct provides the state of the global table of
+ * interned strings.
+ */
+struct AtomStats
+{
+   unsigned long        size;       // Number of interned strings
+   unsigned long long   lookups;    // Number of strings interned so far
+   unsigned long long   hits;       // Lookups that found an interned string
+
+   /**
+    * Obtain the ratio of lookups that found an interned string.
+    */
+   inline double hitRate() const
+   { return lookups ? (double) hits / lookups : 0.0; }
+};
+
+/**
+ * Atom class. This class provides an interned string: a string that is
+ * stored only once in a global table, so atoms of equal strings refer
+ * to the same entry. Thus, atoms are compared by address and hashed by
+ * the hash cached in their entry, which is the hash of their string.
+ * Creating an atom takes a lookup in the table, so atoms are aimed to be
+ * created once and compared many times, as for property keys or names.
+ * Interned strings are never released. The table is thread safe.
+ */
+class KAREN_EXPORT Atom
+{
+public:
+
+   /**
+    * Create a new atom for the empty string.
+    */
+   inline Atom() : _entry(emptyEntry()) {}
+
+   /**
+    * Create a new atom for given string, interning it if needed.
+    */
+   explicit Atom(const StringView& str);
+
+   /**
+    * Create a new atom for given null-terminated string, interning it if
+    * needed.
+    */
+   explicit Atom(const char* str);
+
+   /**
+    * Create a new atom for given string, interning it if needed.
+    */
+   explicit Atom(const String& str);
+
+   /**
+    * Obtain the interned string of this atom.
+    */
+   inline const String& str() const
+   { return _entry->str; }
+
+   /**
+    * Obtain the cached hash of this atom, which is the hash of its string.
+    */
+   inline unsigned long long hash() const
+   { return _entry->hash; }
+
+   /**
+    * Obtain the length of the string of this atom.
+    */
+   inline String::Length length() const
+   { return _entry->str.length(); }
+
+   /**
+    * Cast operator to the interned string.
+    */
+   inline operator const String& () const
+   { return _entry->str; }
+
+   inline bool operator == (const Atom& atom) const
+   { return _entry == atom._entry; }
+
+   inline bool operator != (const Atom& atom) const
+   { return _entry != atom._entry; }
+
+   /**
+    * Less than operator. Atoms are ordered by their strings, so ordered
+    * collections of atoms don't depend on the order they were interned.
+    */
+   inline bool operator < (const Atom& atom) const
+   { return _entry != atom._entry && _entry->str < atom._entry->str; }
+
+   /**
+    * Obtain the statistics of the table of interned strings.
+    */
+   static AtomStats stats();
+
+private:
+
+   struct Entry
+   {
+      String               str;
+      unsigned long long   hash;
+   };
+
+   const Entry* _entry;
+
+   static const Entry* emptyEntry();
+
+   static const Entry* intern(const StringView& str);
+};
+
+/**
+ * Interned string type, an alias of Atom.
+ */
+typedef Atom InternedString;
+
+/**
+ * Default hash functor for atoms. Atoms are hashed by their cached hash,
+ * so no character is read.
+ */
+template <>
+struct DefaultHash<Atom, void>
+{
+   inline unsigned long long operator() (const Atom& t) const
+   { return t.hash(); }
+};
+
+/**
+ * Atom map type. This is a hash map keyed by atoms, whose lookups take
+ * the cached hash of the key and compare keys by address.
+ */
+template <class T>
+using AtomMap = HashMap<Atom, T>;
+
+}; // namespace karen
+
+using karen::Atom;
+using karen::AtomMap;
+using karen::AtomStats;
+using karen::InternedString;
+
+#endif
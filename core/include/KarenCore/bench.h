@@ -0,0 +1,315 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_BENCH_H
+#define KAREN_CORE_BENCH_H
+
+#define KAREN_MAX_BENCHMARKS_PER_SUITE 256
+#define KAREN_MAX_BENCHMARK_SUITES 64
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "KarenCore/string.h"
+#include "KarenCore/timing.h"
+
+namespace karen {
+
+// Pre-declarations
+class BenchmarkReporter;
+
+/**
+ * Benchmark class. This abstract class provides the interface for a
+ * micro-benchmark, i.e. a piece of code that is executed a given number of
+ * iterations while the time and heap allocations it takes are measured.
+ */
+class KAREN_EXPORT Benchmark
+{
+public:
+
+   String name;
+
+   inline Benchmark(const String& name) : name(name) {}
+
+   inline virtual ~Benchmark() {}
+
+   /**
+    * Run the benchmark body the given number of iterations. 
+    */
+   virtual void run(unsigned long iterations) = 0;
+
+   /**
+    * Measure one execution of the benchmark for the given number of
+    * iterations. It returns the elapsed time in milliseconds, and stores 
+    * the number of heap allocations performed in allocs and the number of
+    * events counted by the benchmark body in events.
+    */
+   double measure(unsigned long iterations, 
+                  unsigned long& allocs,
+                  unsigned long& events);
+
+   /**
+    * Restart the measurement. This may be invoked from the benchmark body
+    * after its setup code in order to exclude the setup from the results.
+    */
+   void resetMeasurement();
+
+   /**
+    * Account a new heap allocation. This is invoked by the allocation
+    * hooks defined by KAREN_BENCHMARK_ALLOCATION_HOOKS.
+    */
+   inline static void countAllocation()
+   { _allocationCount.fetch_add(1, std::memory_order_relaxed); }
+
+   /**
+    * Account n occurrences of an event chosen by the benchmark body, such
+    * as system calls or cache misses. Their count per iteration is reported
+    * along with the time and allocations.
+    */
+   inline static void countEvents(unsigned long n = 1)
+   { _eventCount.fetch_add(n, std::memory_order_relaxed); }
+
+   /**
+    * Prevent the compiler from optimizing away the computation of the
+    * given value.
+    */
+   template <typename T>
+   inline static void doNotOptimize(const T& value)
+   {
+#if KAREN_COMPILER == KAREN_COMPILER_GCC || \
+    KAREN_COMPILER == KAREN_COMPILER_CLANG
+      asm volatile("" : : "g"(&value) : "memory");
+#else
+      _sink = (const void*) &value;
+#endif
+   }
+
+private:
+
+   static std::atomic<unsigned long> _allocationCount;
+   static std::atomic<unsigned long> _eventCount;
+   static const void* volatile _sink;
+
+   Counter _counter;
+   unsigned long _allocsAtStart;
+   unsigned long _eventsAtStart;
+
+};
+
+/**
+ * Benchmark result. This struct contains the statistics collected after
+ * running a benchmark. Time figures are expressed in nanoseconds per
+ * operation, where each iteration of the benchmark is one operation. 
+ * Percentiles are computed among the samples taken for the benchmark.
+ */
+struct BenchmarkResult
+{
+   const Benchmark*  benchmark;
+   unsigned long     iterations;
+   unsigned int      samples;
+   double            nsPerOp;
+   double            p50;
+   double            p90;
+   double            p99;
+   double            allocsPerOp;
+   double            eventsPerOp;
+};
+
+/**
+ * Benchmark options. This struct indicates how benchmarks are run.
+ */
+struct KAREN_EXPORT BenchmarkOptions
+{
+   unsigned int   samples;          //!< Number of samples per benchmark
+   double         minSampleTime;    //!< Minimum time of a sample (ms)
+   String         filter;           //!< Only run benchmarks containing this
+
+   BenchmarkOptions() : samples(15), minSampleTime(10.0), filter() {}
+};
+
+/**
+ * Benchmark suite class. This class groups a set of benchmarks. Suites 
+ * declared with KAREN_BEGIN_BENCHMARK_SUITE are registered automatically
+ * so they can be run all at once by runAll(). 
+ */
+class KAREN_EXPORT BenchmarkSuite
+{
+public:
+
+   BenchmarkSuite(const String& name);
+
+   virtual ~BenchmarkSuite();
+
+   /**
+    * Run the benchmarks of this suite, sending the results to the given
+    * reporter. It returns the number of benchmarks run.
+    */
+   unsigned int run(BenchmarkReporter& reporter, 
+                    const BenchmarkOptions& options);
+
+   /**
+    * Run all the registered benchmark suites. It returns the number of
+    * benchmarks run.
+    */
+   static unsigned int runAll(BenchmarkReporter& reporter,
+                              const BenchmarkOptions& options);
+
+protected:
+
+   void addBenchmark(Benchmark* benchmark);
+
+private:
+
+   String _name;
+   Benchmark* _benchmarks[KAREN_MAX_BENCHMARKS_PER_SUITE];
+   unsigned int _nextBenchmark;
+
+   static BenchmarkSuite* _suites[KAREN_MAX_BENCHMARK_SUITES];
+   static unsigned int _nextSuite;
+};
+
+#define KAREN_BEGIN_BENCHMARK_SUITE(name) \
+   class name : public ::karen::BenchmarkSuite { \
+   public:\
+      inline name() : ::karen::BenchmarkSuite(#name) {
+
+#define KAREN_DECL_BENCHMARK(name, ...) \
+         struct name : ::karen::Benchmark { \
+            inline name() : ::karen::Benchmark(#name) {} \
+            virtual void run(unsigned long iterations) { __VA_ARGS__ }\
+         }; \
+         this->addBenchmark(new name());
+
+#define KAREN_END_BENCHMARK_SUITE(name) \
+      }\
+   }; \
+   static name karenBenchmarkSuiteInstance##name
+
+/*
+ * Allocation hooks. This macro replaces the global allocation operators
+ * so each heap allocation is accounted by Benchmark class. It must be
+ * used once in the benchmark executable. 
+ */
+#define KAREN_BENCHMARK_ALLOCATION_HOOKS \
+   void* operator new(std::size_t size) { \
+      ::karen::Benchmark::countAllocation(); \
+      void* p = std::malloc(size ? size : 1); \
+      if (!p) throw std::bad_alloc(); \
+      return p; \
+   } \
+   void* operator new[](std::size_t size) { \
+      ::karen::Benchmark::countAllocation(); \
+      void* p = std::malloc(size ? size : 1); \
+      if (!p) throw std::bad_alloc(); \
+      return p; \
+   } \
+   void operator delete(void* p) throw () { std::free(p); } \
+   void operator delete[](void* p) throw () { std::free(p); }
+
+/*
+ * Benchmark reporter class. This abstract class provides the interface 
+ * for an object with the ability to report benchmark results.
+ */
+class KAREN_EXPORT BenchmarkReporter
+{
+public:
+
+   inline virtual ~BenchmarkReporter() {}
+
+   /**
+    * Report begin of the benchmark run.
+    */
+   virtual void beginReport() = 0;
+
+   /**
+    * Report end of the benchmark run.
+    */
+   virtual void endReport() = 0;
+
+   /**
+    * Report begin of benchmark suite.
+    */
+   virtual void beginBenchmarkSuite(const String& suiteName) = 0;
+
+   /**
+    * Report end of benchmark suite.
+    */
+   virtual void endBenchmarkSuite() = 0;
+
+   /**
+    * Report the result of a benchmark.
+    */
+   virtual void reportResult(const BenchmarkResult& result) = 0;
+
+};
+
+//! CSV benchmark reporter, writing one line per benchmark to stdout
+class KAREN_EXPORT CsvBenchmarkReporter : public BenchmarkReporter
+{
+public:
+
+   virtual void beginReport();
+
+   virtual void endReport();
+
+   virtual void beginBenchmarkSuite(const String& suiteName);
+
+   virtual void endBenchmarkSuite();
+
+   virtual void reportResult(const BenchmarkResult& result);
+
+private:
+
+   String _suiteName;
+
+};
+
+//! JSON benchmark reporter, writing a JSON document to stdout
+class KAREN_EXPORT JsonBenchmarkReporter : public BenchmarkReporter
+{
+public:
+
+   inline JsonBenchmarkReporter() : _firstSuite(true), _firstResult(true) {}
+
+   virtual void beginReport();
+
+   virtual void endReport();
+
+   virtual void beginBenchmarkSuite(const String& suiteName);
+
+   virtual void endBenchmarkSuite();
+
+   virtual void reportResult(const BenchmarkResult& result);
+
+private:
+
+   bool _firstSuite;
+   bool _firstResult;
+
+};
+
+}; // namespace karen
+
+#endif
@@ -0,0 +1,827 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+
+#ifndef KAREN_CORE_BTREE_INL_H
+#define KAREN_CORE_BTREE_INL_H
+
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "KarenCore/btree.h"
+
+namespace karen {
+
+/*
+ * Moves elements between the slots of B-tree nodes, destroying the 
+ * source ones. relocate() may be used on overlapping ranges when moving
+ * elements towards lower addresses, and relocateBackward() when moving
+ * them towards higher addresses. Trivially copyable elements such as 
+ * integer keys and child pointers are moved with memmove. 
+ */
+template <class T, bool TriviallyCopyable = 
+      std::is_trivially_copyable<T>::value>
+struct BTreeSlotOps
+{
+   inline static void relocate(T* dst, T* src, unsigned int n)
+   {
+      for (unsigned int i = 0; i < n; i++)
+      {
+         new (dst + i) T(std::move(src[i]));
+         src[i].~T();
+      }
+   }
+
+   inline static void relocateBackward(T* dst, T* src, unsigned int n)
+   {
+      for (unsigned int i = n; i > 0; i--)
+      {
+         new (dst + i - 1) T(std::move(src[i - 1]));
+         src[i - 1].~T();
+      }
+   }
+};
+
+template <class T>
+struct BTreeSlotOps<T, true>
+{
+   inline static void relocate(T* dst, T* src, unsigned int n)
+   { if (n) std::memmove(dst, src, n * sizeof(T)); }
+
+   inline static void relocateBackward(T* dst, T* src, unsigned int n)
+   { if (n) std::memmove(dst, src, n * sizeof(T)); }
+};
+
+template <class V>
+BTreeIterator<V>::BTreeIterator()
+   : _leaf(NULL), _index(0), _tail(NULL)
+{}
+
+template <class V>
+BTreeIterator<V>::BTreeIterator(
+      Leaf* leaf, unsigned int index, Leaf* const* tail)
+   : _leaf(leaf), _index(index), _tail(tail)
+{}
+
+template <class V>
+template <class Other>
+BTreeIterator<V>::BTreeIterator(const BTreeIterator<Other>& it)
+   : _leaf(it._leaf), _index(it._index), _tail(it._tail)
+{}
+
+template <class V>
+V&
+BTreeIterator<V>::operator * () const
+{ return _leaf->at(_index); }
+
+template <class V>
+V*
+BTreeIterator<V>::operator -> () const
+{ return &_leaf->at(_index); }
+
+template <class V>
+BTreeIterator<V>&
+BTreeIterator<V>::operator ++ ()
+{
+   if (++_index == _leaf->count)
+   {
+      _leaf = _leaf->next;
+      _index = 0;
+   }
+   return *this;
+}
+
+template <class V>
+BTreeIterator<V>
+BTreeIterator<V>::operator ++ (int)
+{
+   BTreeIterator it(*this);
+   ++(*this);
+   return it;
+}
+
+template <class V>
+BTreeIterator<V>&
+BTreeIterator<V>::operator -- ()
+{
+   if (!_leaf)
+   {
+      _leaf = *_tail;
+      _index = _leaf->count - 1;
+   }
+   else if (!_index)
+   {
+      _leaf = _leaf->prev;
+      _index = _leaf->count - 1;
+   }
+   else
+      _index--;
+   return *this;
+}
+
+template <class V>
+BTreeIterator<V>
+BTreeIterator<V>::operator -- (int)
+{
+   BTreeIterator it(*this);
+   --(*this);
+   return it;
+}
+
+template <class V>
+bool
+BTreeIterator<V>::operator == (const BTreeIterator& it) const
+{ return _leaf == it._leaf && _index == it._index; }
+
+template <class V>
+bool
+BTreeIterator<V>::operator != (const BTreeIterator& it) const
+{ return !(*this == it); }
+
+template <class V, class K, class KeyOf, class Compare>
+BTree<V, K, KeyOf, Compare>::BTree(const Compare& cmp)
+   : _root(NULL), _head(NULL), _tail(NULL), _size(0), _cmp(cmp)
+{}
+
+template <class V, class K, class KeyOf, class Compare>
+BTree<V, K, KeyOf, Compare>::BTree(const BTree& tree)
+   : _root(NULL), _head(NULL), _tail(NULL), _size(0), _cmp(tree._cmp)
+{ assignSorted(tree.begin(), tree.end()); }
+
+template <class V, class K, class KeyOf, class Compare>
+BTree<V, K, KeyOf, Compare>::~BTree()
+{ clear(); }
+
+template <class V, class K, class KeyOf, class Compare>
+BTree<V, K, KeyOf, Compare>&
+BTree<V, K, KeyOf, Compare>::operator = (const BTree& tree)
+{
+   if (this != &tree)
+   {
+      _cmp = tree._cmp;
+      assignSorted(tree.begin(), tree.end());
+   }
+   return *this;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+unsigned long
+BTree<V, K, KeyOf, Compare>::size() const
+{ return _size; }
+
+template <class V, class K, class KeyOf, class Compare>
+void
+BTree<V, K, KeyOf, Compare>::clear()
+{
+   if (_root)
+      destroy(_root);
+   _root = NULL;
+   _head = NULL;
+   _tail = NULL;
+   _size = 0;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::iterator
+BTree<V, K, KeyOf, Compare>::begin()
+{ return iterator(_head, 0, &_tail); }
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::iterator
+BTree<V, K, KeyOf, Compare>::end()
+{ return iterator(NULL, 0, &_tail); }
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::const_iterator
+BTree<V, K, KeyOf, Compare>::begin() const
+{ return const_iterator(_head, 0, &_tail); }
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::const_iterator
+BTree<V, K, KeyOf, Compare>::end() const
+{ return const_iterator(NULL, 0, &_tail); }
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::iterator
+BTree<V, K, KeyOf, Compare>::find(const K& k)
+{
+   if (!_root)
+      return end();
+   Leaf* leaf = findLeaf(k);
+   unsigned int pos = leafLowerBound(leaf, k);
+   if (pos < leaf->count && !_cmp(k, keyAt(leaf, pos)))
+      return iterator(leaf, pos, &_tail);
+   return end();
+}
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::const_iterator
+BTree<V, K, KeyOf, Compare>::find(const K& k) const
+{ return const_cast<BTree*>(this)->find(k); }
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::iterator
+BTree<V, K, KeyOf, Compare>::lowerBound(const K& k)
+{
+   if (!_root)
+      return end();
+   Leaf* leaf = findLeaf(k);
+   return iteratorAt(leaf, leafLowerBound(leaf, k));
+}
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::const_iterator
+BTree<V, K, KeyOf, Compare>::lowerBound(const K& k) const
+{ return const_cast<BTree*>(this)->lowerBound(k); }
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::iterator
+BTree<V, K, KeyOf, Compare>::upperBound(const K& k)
+{
+   if (!_root)
+      return end();
+   Leaf* leaf = findLeaf(k);
+   return iteratorAt(leaf, leafUpperBound(leaf, k));
+}
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::const_iterator
+BTree<V, K, KeyOf, Compare>::upperBound(const K& k) const
+{ return const_cast<BTree*>(this)->upperBound(k); }
+
+template <class V, class K, class KeyOf, class Compare>
+template <class ... Args>
+std::pair<typename BTree<V, K, KeyOf, Compare>::iterator, bool>
+BTree<V, K, KeyOf, Compare>::emplace(const K& k, Args&& ... args)
+{
+   if (!_root)
+      _root = _head = _tail = newLeaf();
+
+   InsertResult result;
+   result.split = NULL;
+   insert(_root, k, result, std::forward<Args>(args)...);
+   if (result.split)
+   {
+      // The root was split: the tree grows one level
+      Inner* root = newInner();
+      BTreeSlotOps<K>::relocate(&root->key(0), result.separatorKey(), 1);
+      root->children[0] = _root;
+      root->children[1] = result.split;
+      root->count = 1;
+      _root = root;
+   }
+   if (result.inserted)
+      _size++;
+   return std::pair<iterator, bool>(
+         iterator(result.leaf, result.index, &_tail), result.inserted);
+}
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::iterator
+BTree<V, K, KeyOf, Compare>::erase(const iterator& it)
+{
+   // Erasing may move any element around, so look the next one up again
+   K k(KeyOf()(*it));
+   erase(k);
+   return lowerBound(k);
+}
+
+template <class V, class K, class KeyOf, class Compare>
+bool
+BTree<V, K, KeyOf, Compare>::erase(const K& k)
+{
+   if (!_root || !eraseFrom(_root, k))
+      return false;
+
+   _size--;
+   if (_root->leaf)
+   {
+      if (!_root->count)
+      {
+         delete _head;
+         _root = _head = _tail = NULL;
+      }
+   }
+   else if (!_root->count)
+   {
+      // The root has a single child left: the tree shrinks one level
+      Inner* root = static_cast<Inner*>(_root);
+      _root = root->children[0];
+      delete root;
+   }
+   return true;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+template <class InputIterator>
+void
+BTree<V, K, KeyOf, Compare>::assignSorted(
+      InputIterator first, InputIterator last)
+{
+   clear();
+
+   // Fill the leaves up, from left to right
+   Leaf* leaf = NULL;
+   for (; first != last; ++first)
+   {
+      if (!leaf || leaf->count == Leaf::CAPACITY)
+      {
+         Leaf* next = newLeaf();
+         next->prev = leaf;
+         if (leaf)
+            leaf->next = next;
+         else
+            _head = next;
+         leaf = next;
+      }
+      new (&leaf->at(leaf->count)) V(*first);
+      leaf->count++;
+      _size++;
+   }
+   _tail = leaf;
+   if (!leaf)
+      return;
+
+   // Even the last two leaves out so the last one is half full at least
+   if (leaf->prev && leaf->count < LEAF_MIN)
+   {
+      Leaf* prev = leaf->prev;
+      unsigned int n = (prev->count + leaf->count) / 2 - leaf->count;
+      BTreeSlotOps<V>::relocateBackward(
+            &leaf->at(n), &leaf->at(0), leaf->count);
+      BTreeSlotOps<V>::relocate(
+            &leaf->at(0), &prev->at(prev->count - n), n);
+      prev->count -= n;
+      leaf->count += n;
+   }
+
+   // Build the inner levels bottom-up, spreading children evenly
+   std::vector<std::pair<BTreeNode*, const K*> > level;
+   for (leaf = _head; leaf; leaf = leaf->next)
+      level.push_back(std::make_pair(leaf, &keyAt(leaf, 0)));
+   while (level.size() > 1)
+   {
+      unsigned long nodes = 
+            (level.size() + Inner::CAPACITY) / (Inner::CAPACITY + 1);
+      std::vector<std::pair<BTreeNode*, const K*> > upper;
+      upper.reserve(nodes);
+      unsigned long pos = 0;
+      for (unsigned long i = 0; i < nodes; i++)
+      {
+         unsigned long n = (level.size() - pos) / (nodes - i);
+         Inner* inner = newInner();
+         inner->children[0] = level[pos].first;
+         for (unsigned long j = 1; j < n; j++)
+         {
+            new (&inner->key(j - 1)) K(*level[pos + j].second);
+            inner->children[j] = level[pos + j].first;
+         }
+         inner->count = n - 1;
+         upper.push_back(std::make_pair(inner, level[pos].second));
+         pos += n;
+      }
+      level.swap(upper);
+   }
+   _root = level[0].first;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+const K&
+BTree<V, K, KeyOf, Compare>::keyAt(Leaf* leaf, unsigned int i) const
+{ return KeyOf()(leaf->at(i)); }
+
+template <class V, class K, class KeyOf, class Compare>
+unsigned int
+BTree<V, K, KeyOf, Compare>::leafLowerBound(Leaf* leaf, const K& k) const
+{
+   unsigned int lo = 0, hi = leaf->count;
+   while (lo < hi)
+   {
+      unsigned int mid = (lo + hi) / 2;
+      if (_cmp(keyAt(leaf, mid), k))
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   return lo;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+unsigned int
+BTree<V, K, KeyOf, Compare>::leafUpperBound(Leaf* leaf, const K& k) const
+{
+   unsigned int lo = 0, hi = leaf->count;
+   while (lo < hi)
+   {
+      unsigned int mid = (lo + hi) / 2;
+      if (_cmp(k, keyAt(leaf, mid)))
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+   return lo;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+unsigned int
+BTree<V, K, KeyOf, Compare>::childIndex(Inner* inner, const K& k) const
+{
+   unsigned int lo = 0, hi = inner->count;
+   while (lo < hi)
+   {
+      unsigned int mid = (lo + hi) / 2;
+      if (_cmp(k, inner->key(mid)))
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+   return lo;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::Leaf*
+BTree<V, K, KeyOf, Compare>::findLeaf(const K& k) const
+{
+   BTreeNode* node = _root;
+   while (!node->leaf)
+   {
+      Inner* inner = static_cast<Inner*>(node);
+      node = inner->children[childIndex(inner, k)];
+   }
+   return static_cast<Leaf*>(node);
+}
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::iterator
+BTree<V, K, KeyOf, Compare>::iteratorAt(Leaf* leaf, unsigned int index)
+{
+   if (index == leaf->count)
+   {
+      leaf = leaf->next;
+      index = 0;
+   }
+   return iterator(leaf, index, &_tail);
+}
+
+template <class V, class K, class KeyOf, class Compare>
+template <class ... Args>
+void
+BTree<V, K, KeyOf, Compare>::insert(
+      BTreeNode* node, 
+      const K& k, 
+      InsertResult& result, 
+      Args&& ... args)
+{
+   if (node->leaf)
+   {
+      insertIntoLeaf(static_cast<Leaf*>(node), k, result, 
+                     std::forward<Args>(args)...);
+      return;
+   }
+   Inner* inner = static_cast<Inner*>(node);
+   unsigned int pos = childIndex(inner, k);
+   insert(inner->children[pos], k, result, std::forward<Args>(args)...);
+   if (result.split)
+      insertChild(inner, pos, result);
+}
+
+template <class V, class K, class KeyOf, class Compare>
+template <class ... Args>
+void
+BTree<V, K, KeyOf, Compare>::insertIntoLeaf(
+      Leaf* leaf, 
+      const K& k, 
+      InsertResult& result, 
+      Args&& ... args)
+{
+   unsigned int pos = leafLowerBound(leaf, k);
+   if (pos < leaf->count && !_cmp(k, keyAt(leaf, pos)))
+   {
+      result.leaf = leaf;
+      result.index = pos;
+      result.inserted = false;
+      return;
+   }
+
+   // Build the element before moving any other, args may refer to them
+   V value(std::forward<Args>(args)...);
+   result.inserted = true;
+   if (leaf->count == Leaf::CAPACITY)
+   {
+      Leaf* right = newLeaf();
+      right->prev = leaf;
+      right->next = leaf->next;
+      if (leaf->next)
+         leaf->next->prev = right;
+      else
+         _tail = right;
+      leaf->next = right;
+
+      // Split so both halves hold (CAPACITY + 1) / 2 elements at least
+      unsigned int half = (Leaf::CAPACITY + 1) / 2;
+      unsigned int keep = (pos < half) ? half - 1 : half;
+      right->count = Leaf::CAPACITY - keep;
+      BTreeSlotOps<V>::relocate(&right->at(0), &leaf->at(keep), right->count);
+      leaf->count = keep;
+      if (pos >= half)
+      {
+         pos -= half;
+         leaf = right;
+      }
+      result.split = right;
+   }
+   BTreeSlotOps<V>::relocateBackward(
+         &leaf->at(pos + 1), &leaf->at(pos), leaf->count - pos);
+   new (&leaf->at(pos)) V(std::move(value));
+   leaf->count++;
+   result.leaf = leaf;
+   result.index = pos;
+   if (result.split)
+      new (result.separatorKey()) K(
+            keyAt(static_cast<Leaf*>(result.split), 0));
+}
+
+template <class V, class K, class KeyOf, class Compare>
+void
+BTree<V, K, KeyOf, Compare>::insertChild(
+      Inner* inner, 
+      unsigned int pos, 
+      InsertResult& result)
+{
+   BTreeNode* child = result.split;
+   if (inner->count < Inner::CAPACITY)
+   {
+      BTreeSlotOps<K>::relocateBackward(
+            &inner->key(pos + 1), &inner->key(pos), inner->count - pos);
+      BTreeSlotOps<BTreeNode*>::relocateBackward(
+            inner->children + pos + 2, inner->children + pos + 1,
+            inner->count - pos);
+      BTreeSlotOps<K>::relocate(&inner->key(pos), result.separatorKey(), 1);
+      inner->children[pos + 1] = child;
+      inner->count++;
+      result.split = NULL;
+      return;
+   }
+
+   // Lay the CAPACITY + 1 keys out in order and split them around the 
+   // middle one, which is moved up to the parent
+   typename std::aligned_storage<sizeof(K), std::alignment_of<K>::value>
+         ::type storage[Inner::CAPACITY + 1];
+   BTreeNode* children[Inner::CAPACITY + 2];
+   K* keys = reinterpret_cast<K*>(storage);
+   BTreeSlotOps<K>::relocate(keys, &inner->key(0), pos);
+   BTreeSlotOps<K>::relocate(keys + pos, result.separatorKey(), 1);
+   BTreeSlotOps<K>::relocate(
+         keys + pos + 1, &inner->key(pos), inner->count - pos);
+   std::memcpy(children, inner->children, (pos + 1) * sizeof(BTreeNode*));
+   children[pos + 1] = child;
+   std::memcpy(children + pos + 2, inner->children + pos + 1, 
+               (inner->count - pos) * sizeof(BTreeNode*));
+
+   unsigned int half = (Inner::CAPACITY + 1) / 2;
+   Inner* right = newInner();
+   BTreeSlotOps<K>::relocate(&inner->key(0), keys, half);
+   std::memcpy(inner->children, children, (half + 1) * sizeof(BTreeNode*));
+   inner->count = half;
+   BTreeSlotOps<K>::relocate(result.separatorKey(), keys + half, 1);
+   right->count = Inner::CAPACITY - half;
+   BTreeSlotOps<K>::relocate(&right->key(0), keys + half + 1, right->count);
+   std::memcpy(right->children, children + half + 1, 
+               (right->count + 1) * sizeof(BTreeNode*));
+   result.split = right;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+bool
+BTree<V, K, KeyOf, Compare>::eraseFrom(BTreeNode* node, const K& k)
+{
+   if (node->leaf)
+   {
+      Leaf* leaf = static_cast<Leaf*>(node);
+      unsigned int pos = leafLowerBound(leaf, k);
+      if (pos == leaf->count || _cmp(k, keyAt(leaf, pos)))
+         return false;
+      leaf->at(pos).~V();
+      BTreeSlotOps<V>::relocate(
+            &leaf->at(pos), &leaf->at(pos + 1), leaf->count - pos - 1);
+      leaf->count--;
+      return true;
+   }
+
+   Inner* inner = static_cast<Inner*>(node);
+   unsigned int pos = childIndex(inner, k);
+   BTreeNode* child = inner->children[pos];
+   if (!eraseFrom(child, k))
+      return false;
+   if (child->leaf)
+   {
+      if (child->count < LEAF_MIN)
+         rebalanceLeaf(inner, pos);
+   }
+   else if (child->count < INNER_MIN)
+      rebalanceInner(inner, pos);
+   return true;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+void
+BTree<V, K, KeyOf, Compare>::rebalanceLeaf(Inner* parent, unsigned int pos)
+{
+   Leaf* leaf = static_cast<Leaf*>(parent->children[pos]);
+   Leaf* left = pos ? 
+         static_cast<Leaf*>(parent->children[pos - 1]) : NULL;
+   Leaf* right = (pos < parent->count) ? 
+         static_cast<Leaf*>(parent->children[pos + 1]) : NULL;
+   if (left && left->count > LEAF_MIN)
+   {
+      BTreeSlotOps<V>::relocateBackward(
+            &leaf->at(1), &leaf->at(0), leaf->count);
+      BTreeSlotOps<V>::relocate(&leaf->at(0), &left->at(left->count - 1), 1);
+      left->count--;
+      leaf->count++;
+      replaceKey(parent, pos - 1, keyAt(leaf, 0));
+   }
+   else if (right && right->count > LEAF_MIN)
+   {
+      BTreeSlotOps<V>::relocate(&leaf->at(leaf->count), &right->at(0), 1);
+      BTreeSlotOps<V>::relocate(
+            &right->at(0), &right->at(1), right->count - 1);
+      right->count--;
+      leaf->count++;
+      replaceKey(parent, pos, keyAt(right, 0));
+   }
+   else if (left)
+      mergeLeaves(parent, pos - 1);
+   else if (right)
+      mergeLeaves(parent, pos);
+}
+
+template <class V, class K, class KeyOf, class Compare>
+void
+BTree<V, K, KeyOf, Compare>::rebalanceInner(Inner* parent, unsigned int pos)
+{
+   Inner* inner = static_cast<Inner*>(parent->children[pos]);
+   Inner* left = pos ? 
+         static_cast<Inner*>(parent->children[pos - 1]) : NULL;
+   Inner* right = (pos < parent->count) ? 
+         static_cast<Inner*>(parent->children[pos + 1]) : NULL;
+   if (left && left->count > INNER_MIN)
+   {
+      // Rotate the last child of left through the parent
+      BTreeSlotOps<K>::relocateBackward(
+            &inner->key(1), &inner->key(0), inner->count);
+      BTreeSlotOps<BTreeNode*>::relocateBackward(
+            inner->children + 1, inner->children, inner->count + 1);
+      BTreeSlotOps<K>::relocate(&inner->key(0), &parent->key(pos - 1), 1);
+      inner->children[0] = left->children[left->count];
+      BTreeSlotOps<K>::relocate(
+            &parent->key(pos - 1), &left->key(left->count - 1), 1);
+      left->count--;
+      inner->count++;
+   }
+   else if (right && right->count > INNER_MIN)
+   {
+      // Rotate the first child of right through the parent
+      BTreeSlotOps<K>::relocate(
+            &inner->key(inner->count), &parent->key(pos), 1);
+      inner->children[inner->count + 1] = right->children[0];
+      BTreeSlotOps<K>::relocate(&parent->key(pos), &right->key(0), 1);
+      BTreeSlotOps<K>::relocate(
+            &right->key(0), &right->key(1), right->count - 1);
+      BTreeSlotOps<BTreeNode*>::relocate(
+            right->children, right->children + 1, right->count);
+      right->count--;
+      inner->count++;
+   }
+   else if (left)
+      mergeInners(parent, pos - 1);
+   else if (right)
+      mergeInners(parent, pos);
+}
+
+template <class V, class K, class KeyOf, class Compare>
+void
+BTree<V, K, KeyOf, Compare>::mergeLeaves(Inner* parent, unsigned int pos)
+{
+   Leaf* left = static_cast<Leaf*>(parent->children[pos]);
+   Leaf* right = static_cast<Leaf*>(parent->children[pos + 1]);
+   BTreeSlotOps<V>::relocate(
+         &left->at(left->count), &right->at(0), right->count);
+   left->count += right->count;
+   left->next = right->next;
+   if (right->next)
+      right->next->prev = left;
+   else
+      _tail = left;
+   delete right;
+   parent->key(pos).~K();
+   removeSeparator(parent, pos);
+}
+
+template <class V, class K, class KeyOf, class Compare>
+void
+BTree<V, K, KeyOf, Compare>::mergeInners(Inner* parent, unsigned int pos)
+{
+   Inner* left = static_cast<Inner*>(parent->children[pos]);
+   Inner* right = static_cast<Inner*>(parent->children[pos + 1]);
+   BTreeSlotOps<K>::relocate(&left->key(left->count), &parent->key(pos), 1);
+   BTreeSlotOps<K>::relocate(
+         &left->key(left->count + 1), &right->key(0), right->count);
+   std::memcpy(left->children + left->count + 1, right->children, 
+               (right->count + 1) * sizeof(BTreeNode*));
+   left->count += right->count + 1;
+   delete right;
+   removeSeparator(parent, pos);
+}
+
+template <class V, class K, class KeyOf, class Compare>
+void
+BTree<V, K, KeyOf, Compare>::removeSeparator(Inner* parent, unsigned int pos)
+{
+   // The key at pos is already gone, and so is the child after it
+   BTreeSlotOps<K>::relocate(
+         &parent->key(pos), &parent->key(pos + 1), parent->count - pos - 1);
+   BTreeSlotOps<BTreeNode*>::relocate(
+         parent->children + pos + 1, parent->children + pos + 2, 
+         parent->count - pos - 1);
+   parent->count--;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+void
+BTree<V, K, KeyOf, Compare>::replaceKey(
+      Inner* inner, unsigned int pos, const K& k)
+{
+   inner->key(pos).~K();
+   new (&inner->key(pos)) K(k);
+}
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::Leaf*
+BTree<V, K, KeyOf, Compare>::newLeaf()
+{
+   Leaf* leaf = new Leaf;
+   leaf->count = 0;
+   leaf->leaf = true;
+   leaf->prev = NULL;
+   leaf->next = NULL;
+   return leaf;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+typename BTree<V, K, KeyOf, Compare>::Inner*
+BTree<V, K, KeyOf, Compare>::newInner()
+{
+   Inner* inner = new Inner;
+   inner->count = 0;
+   inner->leaf = false;
+   return inner;
+}
+
+template <class V, class K, class KeyOf, class Compare>
+void
+BTree<V, K, KeyOf, Compare>::destroy(BTreeNode* node)
+{
+   if (node->leaf)
+   {
+      Leaf* leaf = static_cast<Leaf*>(node);
+      for (unsigned int i = 0; i < leaf->count; i++)
+         leaf->at(i).~V();
+      delete leaf;
+   }
+   else
+   {
+      Inner* inner = static_cast<Inner*>(node);
+      for (unsigned int i = 0; i < inner->count; i++)
+         inner->key(i).~K();
+      for (unsigned int i = 0; i <= inner->count; i++)
+         destroy(inner->children[i]);
+      delete inner;
+   }
+}
+
+}
+
+#endif
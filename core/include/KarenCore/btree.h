@@ -0,0 +1,336 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+
+#ifndef KAREN_CORE_BTREE_H
+#define KAREN_CORE_BTREE_H
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "KarenCore/first-class.h"
+#include "KarenCore/platform.h"
+
+namespace karen {
+
+/**
+ * B-tree node class. This is the header shared by the leaf and the inner
+ * nodes of a BTree. The elements or keys of a node are sized to span
+ * NODE_BYTES, that is four cache lines, so a node is searched with a few
+ * cache misses while the tree is kept very shallow.
+ */
+struct BTreeNode
+{
+   enum { NODE_BYTES = 256 };
+
+   unsigned short count;   //!< Number of elements (leaves) or keys (inner)
+   bool           leaf;
+};
+
+/**
+ * B-tree leaf node template class. A leaf stores up to CAPACITY elements 
+ * inline in key order. Leaves are doubly linked in key order as well, so
+ * iterating the tree never climbs it. 
+ */
+template <class V>
+struct BTreeLeaf : BTreeNode
+{
+   enum 
+   { 
+      CAPACITY = sizeof(V) * 4 < NODE_BYTES ? NODE_BYTES / sizeof(V) : 4
+   };
+
+   BTreeLeaf* prev;
+   BTreeLeaf* next;
+   typename std::aligned_storage<
+         sizeof(V), std::alignment_of<V>::value>::type slots[CAPACITY];
+
+   inline V& at(unsigned int i)
+   { return *reinterpret_cast<V*>(slots + i); }
+};
+
+/**
+ * B-tree inner node template class. An inner node stores up to CAPACITY 
+ * separator keys and one child more. Every key in children[i] is less 
+ * than key(i), and every key in children[i + 1] is not less than it. 
+ */
+template <class K>
+struct BTreeInner : BTreeNode
+{
+   enum 
+   { 
+      CAPACITY = (sizeof(K) + sizeof(void*)) * 4 < NODE_BYTES ? 
+            NODE_BYTES / (sizeof(K) + sizeof(void*)) : 4
+   };
+
+   typename std::aligned_storage<
+         sizeof(K), std::alignment_of<K>::value>::type keys[CAPACITY];
+   BTreeNode* children[CAPACITY + 1];
+
+   inline K& key(unsigned int i)
+   { return *reinterpret_cast<K*>(keys + i); }
+};
+
+/**
+ * B-tree iterator template class. This class provides a bidirectional,
+ * STL-compatible iterator over the elements of a BTree, walking its 
+ * leaves through their links. It is instantiated with a const-qualified 
+ * value type for constant iteration.
+ */
+template <class V>
+class BTreeIterator
+{
+public:
+
+   typedef std::bidirectional_iterator_tag iterator_category;
+   typedef typename std::remove_const<V>::type value_type;
+   typedef long difference_type;
+   typedef V* pointer;
+   typedef V& reference;
+
+   typedef BTreeLeaf<value_type> Leaf;
+
+   inline BTreeIterator();
+
+   /**
+    * Create a new iterator to given element of given leaf. A null leaf
+    * means the end of the tree, whose last leaf is read from tail. 
+    */
+   inline BTreeIterator(Leaf* leaf, unsigned int index, Leaf* const* tail);
+
+   /**
+    * Create a constant iterator from a non-constant one.
+    */
+   template <class Other>
+   inline BTreeIterator(const BTreeIterator<Other>& it);
+
+   inline V& operator * () const;
+
+   inline V* operator -> () const;
+
+   inline BTreeIterator& operator ++ ();
+
+   inline BTreeIterator operator ++ (int);
+
+   inline BTreeIterator& operator -- ();
+
+   inline BTreeIterator operator -- (int);
+
+   inline bool operator == (const BTreeIterator& it) const;
+
+   inline bool operator != (const BTreeIterator& it) const;
+
+private:
+
+   template <class Other>
+   friend class BTreeIterator;
+
+   Leaf*          _leaf;
+   unsigned int   _index;
+   Leaf* const*   _tail;
+
+};
+
+/**
+ * B-tree template class. This class implements a B+tree: elements are 
+ * stored inline in the leaves, which hold tens of them, and the inner 
+ * nodes only hold copies of the keys to route searches. Compared to a 
+ * binary search tree this performs one allocation every several elements
+ * instead of one per element, and lookups and ordered scans touch far
+ * fewer cache lines. Nodes are kept at least half full on erasure by 
+ * borrowing elements from or merging with a sibling. 
+ *
+ * This is not aimed to be used directly but as the implementation of
+ * BTreeMap. V is the type of the stored elements and K the type of their
+ * keys, which are obtained from the elements by KeyOf and ordered by 
+ * Compare. K must be copy constructible. Iterators are invalidated by
+ * any insertion or erasure. 
+ */
+template <class V, class K, class KeyOf, class Compare>
+class BTree
+{
+public:
+
+   typedef BTreeIterator<V> iterator;
+   typedef BTreeIterator<const V> const_iterator;
+
+   inline BTree(const Compare& cmp = Compare());
+
+   inline BTree(const BTree& tree);
+
+   inline ~BTree();
+
+   inline BTree& operator = (const BTree& tree);
+
+   inline unsigned long size() const;
+
+   inline void clear();
+
+   inline iterator begin();
+
+   inline iterator end();
+
+   inline const_iterator begin() const;
+
+   inline const_iterator end() const;
+
+   inline iterator find(const K& k);
+
+   inline const_iterator find(const K& k) const;
+
+   /**
+    * Obtain an iterator to the first element whose key is not less than
+    * given one, or end() if there is no such element.
+    */
+   inline iterator lowerBound(const K& k);
+
+   inline const_iterator lowerBound(const K& k) const;
+
+   /**
+    * Obtain an iterator to the first element whose key is greater than
+    * given one, or end() if there is no such element.
+    */
+   inline iterator upperBound(const K& k);
+
+   inline const_iterator upperBound(const K& k) const;
+
+   /**
+    * Insert an element with given key constructing it from given args if 
+    * there is no element with such key yet. It returns an iterator to the 
+    * element with that key and whether it was inserted. 
+    */
+   template <class ... Args>
+   inline std::pair<iterator, bool> emplace(const K& k, Args&& ... args);
+
+   /**
+    * Remove the element pointed by given iterator. It returns an iterator
+    * to the next element.
+    */
+   inline iterator erase(const iterator& it);
+
+   /**
+    * Remove the element with given key, if any. It returns whether some
+    * element was removed.
+    */
+   inline bool erase(const K& k);
+
+   /**
+    * Replace the contents of the tree by the elements in given range, 
+    * which must be sorted by strictly ascending keys. The tree is built 
+    * bottom-up in linear time, with its leaves full.
+    */
+   template <class InputIterator>
+   inline void assignSorted(InputIterator first, InputIterator last);
+
+private:
+
+   typedef BTreeLeaf<V> Leaf;
+   typedef BTreeInner<K> Inner;
+
+   enum 
+   { 
+      LEAF_MIN = Leaf::CAPACITY / 2, 
+      INNER_MIN = Inner::CAPACITY / 2
+   };
+
+   /*
+    * The outcome of inserting into a subtree. When the subtree root was 
+    * split, split is its new right sibling and separator holds the first
+    * key under it, to be moved into the parent. 
+    */
+   struct InsertResult
+   {
+      Leaf*          leaf;
+      unsigned int   index;
+      bool           inserted;
+      BTreeNode*     split;
+      typename std::aligned_storage<
+            sizeof(K), std::alignment_of<K>::value>::type separator;
+
+      inline K* separatorKey()
+      { return reinterpret_cast<K*>(&separator); }
+   };
+
+   BTreeNode*     _root;
+   Leaf*          _head;
+   Leaf*          _tail;
+   unsigned long  _size;
+   Compare        _cmp;
+
+   inline const K& keyAt(Leaf* leaf, unsigned int i) const;
+
+   inline unsigned int leafLowerBound(Leaf* leaf, const K& k) const;
+
+   inline unsigned int leafUpperBound(Leaf* leaf, const K& k) const;
+
+   inline unsigned int childIndex(Inner* inner, const K& k) const;
+
+   inline Leaf* findLeaf(const K& k) const;
+
+   inline iterator iteratorAt(Leaf* leaf, unsigned int index);
+
+   template <class ... Args>
+   inline void insert(BTreeNode* node, 
+                      const K& k, 
+                      InsertResult& result, 
+                      Args&& ... args);
+
+   template <class ... Args>
+   inline void insertIntoLeaf(Leaf* leaf, 
+                              const K& k, 
+                              InsertResult& result, 
+                              Args&& ... args);
+
+   inline void insertChild(Inner* inner, 
+                           unsigned int pos, 
+                           InsertResult& result);
+
+   inline bool eraseFrom(BTreeNode* node, const K& k);
+
+   inline void rebalanceLeaf(Inner* parent, unsigned int pos);
+
+   inline void rebalanceInner(Inner* parent, unsigned int pos);
+
+   inline void mergeLeaves(Inner* parent, unsigned int pos);
+
+   inline void mergeInners(Inner* parent, unsigned int pos);
+
+   inline void removeSeparator(Inner* parent, unsigned int pos);
+
+   inline void replaceKey(Inner* inner, unsigned int pos, const K& k);
+
+   inline Leaf* newLeaf();
+
+   inline Inner* newInner();
+
+   inline void destroy(BTreeNode* node);
+
+};
+
+}
+
+#include "KarenCore/btree-inl.h"
+
+#endif
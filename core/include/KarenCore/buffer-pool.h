@@ -0,0 +1,218 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_BUFFER_POOL_H
+#define KAREN_CORE_BUFFER_POOL_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "KarenCore/buffer.h"
+#include "KarenCore/exception.h"
+#include "KarenCore/platform.h"
+
+namespace karen {
+
+/**
+ * Buffer pool statistics. Acquisitions served with memory released before
+ * are hits, and those that need new memory from the system are misses.
+ */
+struct BufferPoolStatistics
+{
+   /** Number of acquisitions served with released memory. */
+   unsigned long hits;
+
+   /** Number of acquisitions that obtained new memory from the system. */
+   unsigned long misses;
+
+   /** Number of bytes currently obtained from the system by the pool. */
+   unsigned long systemBytes;
+
+   /**
+    * Obtain the ratio of acquisitions that were hits.
+    */
+   inline double hitRatio() const
+   { return (hits + misses) ? (double) hits / (hits + misses) : 0.0; }
+};
+
+/**
+ * Buffer pool class. This class provides aligned memory for buffers that 
+ * are acquired and released over and over, like scratch images or I/O 
+ * buffers. Lengths are rounded up to power of two size classes, and the 
+ * memory released is kept in a free list per class to serve later 
+ * acquisitions. Each thread keeps its own cache of free blocks, so most 
+ * acquisitions and releases take no lock; the caches exchange blocks with
+ * lists shared by all the threads. Lengths above the largest size class 
+ * are not pooled. Memory released to a pool must have been acquired from
+ * it, and the pool must outlive all its buffers.
+ */
+class KAREN_EXPORT BufferPool : public BufferReleaser
+{
+public:
+
+   /** Alignment of a cache line, suitable for SIMD operations. */
+   static const unsigned long CACHE_LINE_ALIGNMENT = 64;
+
+   /** Alignment of a memory page, suitable for direct I/O. */
+   static const unsigned long PAGE_ALIGNMENT = 4096;
+
+   /** 
+    * Alignment of a huge memory page. Blocks as large as a huge page are 
+    * advised to be backed by huge pages where the system supports it.
+    */
+   static const unsigned long HUGE_PAGE_ALIGNMENT = 2 * 1024 * 1024;
+
+   /** Length of the smallest size class. */
+   static const unsigned long MIN_CLASS_LENGTH = 64;
+
+   /** Default length of the largest size class. */
+   static const unsigned long DEFAULT_MAX_CLASS_LENGTH = 64 * 1024 * 1024;
+
+   /**
+    * Obtain the default pool, which provides cache line aligned memory. It
+    * is never destroyed, so it may be used by static objects.
+    */
+   static BufferPool& defaultPool();
+
+   /**
+    * Obtain the length of the size class for given length, that is the
+    * smallest power of two not below it nor below MIN_CLASS_LENGTH.
+    */
+   static unsigned long classLength(unsigned long length);
+
+   /**
+    * Create a new pool whose memory is aligned to given alignment, with 
+    * size classes up to maxClassLength. If alignment is not a power of 
+    * two or maxClassLength is not a power of two between MIN_CLASS_LENGTH
+    * and the largest supported class, a InvalidInputException is thrown. 
+    */
+   BufferPool(unsigned long alignment = CACHE_LINE_ALIGNMENT, 
+              unsigned long maxClassLength = DEFAULT_MAX_CLASS_LENGTH)
+         throw (InvalidInputException);
+
+   /**
+    * Destroy the pool, returning its memory to the system, including that
+    * cached by threads.
+    */
+   virtual ~BufferPool();
+
+   /**
+    * Obtain the alignment of the memory provided by this pool.
+    */
+   inline unsigned long alignment() const
+   { return _alignment; }
+
+   /**
+    * Obtain the length of the largest size class of this pool.
+    */
+   inline unsigned long maxClassLength() const
+   { return _maxClassLength; }
+
+   /**
+    * Acquire a block of at least given length. If there is not enough 
+    * memory, a std::bad_alloc is thrown.
+    */
+   void* acquire(unsigned long length);
+
+   /**
+    * Release a block acquired from this pool with given length. 
+    */
+   void release(void* data, unsigned long length);
+
+   inline virtual void releaseBuffer(void* data, unsigned long length)
+   { release(data, length); }
+
+   /**
+    * Return to the system the free blocks in the shared lists and in the
+    * cache of the calling thread. Blocks cached by other threads are kept.
+    */
+   void trim();
+
+   /**
+    * Obtain the statistics of this pool.
+    */
+   BufferPoolStatistics statistics() const;
+
+private:
+
+   struct Block { Block* next; };
+
+   struct FreeList
+   {
+      Block*         head;
+      unsigned long  count;
+   };
+
+   struct ThreadCache;
+
+   struct ThreadCacheTable;
+
+   struct ThreadCacheFlusher;
+
+   enum 
+   { 
+      MAX_CLASSES = 40,          // Classes up to 2^45 bytes
+      CACHE_CLASS_BYTES = 1024 * 1024, // Bytes kept by a thread cache class
+      CACHE_CLASS_BLOCKS = 64,   // Blocks kept by a thread cache class
+   };
+
+   unsigned long              _id;
+   unsigned long              _alignment;
+   unsigned long              _maxClassLength;
+   unsigned int               _nclasses;
+   mutable std::mutex         _mutex;
+   FreeList                   _shared[MAX_CLASSES];
+   std::vector<ThreadCache*>  _caches;
+   std::atomic<unsigned long> _hits;
+   std::atomic<unsigned long> _misses;
+   std::atomic<unsigned long> _systemBytes;
+
+   BufferPool(const BufferPool&);
+
+   BufferPool& operator = (const BufferPool&);
+
+   static unsigned int classIndex(unsigned long length);
+
+   static ThreadCacheTable& threadCacheTable();
+
+   ThreadCache* threadCache();
+
+   unsigned long cacheCapacity(unsigned int index) const;
+
+   void* allocateBlock(unsigned long length);
+
+   void freeBlock(void* block, unsigned long length);
+
+   void refill(ThreadCache& cache, unsigned int index);
+
+   void drain(ThreadCache& cache, unsigned int index, unsigned long nblocks);
+
+   void retire(ThreadCache& cache);
+
+};
+
+}; // namespace karen
+
+#endif
@@ -30,6 +30,29 @@
 
 namespace karen {
 
+class BufferPool;
+
+/**
+ * Buffer releaser class. This abstract class provides the interface for an
+ * object that owns the memory of buffers borrowing it, and takes it back 
+ * when those buffers are destroyed.
+ */
+class KAREN_EXPORT BufferReleaser
+{
+public:
+
+   /**
+    * Virtual destructor.
+    */
+   inline virtual ~BufferReleaser() {}
+
+   /**
+    * Take back the memory borrowed by a buffer being destroyed.
+    */
+   virtual void releaseBuffer(void* data, unsigned long length) = 0;
+
+};
+
 /**
  * Dynamic data buffer class. This class provides an implementation for a
  * dynamic data buffer. That's a data buffer which is automatically enlarged
@@ -50,6 +73,22 @@ public:
     * not be allocated in stack, and its deallocation is managed by the buffer.
     */
    Buffer(void* data, unsigned long length);
+
+   /**
+    * Create a new buffer that borrows given memory instead of owning it, 
+    * so it views that memory with no copy. On buffer destruction, the 
+    * memory is passed back to releaser, or just left alone if releaser is 
+    * null. The memory must outlive the buffer. 
+    */
+   Buffer(void* data, unsigned long length, BufferReleaser* releaser);
+
+   /**
+    * Create a new buffer of given length that borrows its memory from 
+    * given pool, so it is aligned as the pool memory is. On buffer 
+    * destruction, the memory is returned to the pool, which must outlive
+    * the buffer.
+    */
+   Buffer(BufferPool& pool, unsigned long length);
    
    /**
     * Create a new buffer as a copy of the one passed as argument.
@@ -121,6 +160,12 @@ public:
    inline unsigned long length() const
    { return _length; }
    
+   /**
+    * Check whether this buffer borrows its memory rather than owning it.
+    */
+   inline bool isBorrowed() const
+   { return !_owned; }
+
    /**
     * Check whether this buffer is dirty. A buffer is marked as dirty on each
     * write or set operation. This method may be used in combination with
@@ -180,9 +225,13 @@ public:
    
 private:
 
-   unsigned long  _length;
-   UInt8*         _data;
-   bool           _dirty;
+   unsigned long     _length;
+   UInt8*            _data;
+   bool              _dirty;
+   bool              _owned;
+   BufferReleaser*   _releaser;
+
+   void release();
    
 };
 
@@ -208,6 +257,11 @@ public:
    virtual unsigned long readBytes(void* data, unsigned long len) 
          throw (IOException);
 
+   /**
+    * Skip len bytes of the buffer without copying them.
+    */
+   virtual unsigned long skip(unsigned long len) throw (IOException);
+
 private:
 
    const Buffer*        _buffer;
@@ -143,7 +143,10 @@ ConstStdIteratorAdaptor<T, CollectionType, StdIteratorType>::ConstStdIteratorAda
 template <typename T, typename CollectionType, typename StdIteratorType>
 ConstStdIteratorAdaptor<T, CollectionType, StdIteratorType>*
 ConstStdIteratorAdaptor<T, CollectionType, StdIteratorType>::clone() const
-{ return new ConstStdIteratorAdaptor(*_collection, _stdIterator, _stdEnd); }
+{
+   return new ConstStdIteratorAdaptor(
+         *this->_collection, this->_stdIterator, this->_stdEnd);
+}
    
 template <typename T, typename CollectionType, typename StdIteratorType>
 Ptr<AbstractIterator<const T>>
@@ -162,14 +165,17 @@ StdIteratorAdaptor<T, CollectionType, StdIteratorType>::StdIteratorAdaptor(
 template <typename T, typename CollectionType, typename StdIteratorType>
 StdIteratorAdaptor<T, CollectionType, StdIteratorType>*
 StdIteratorAdaptor<T, CollectionType, StdIteratorType>::clone() const
-{ return new StdIteratorAdaptor(*_collection, _stdIterator, _stdEnd); }
+{
+   return new StdIteratorAdaptor(
+         *this->_collection, this->_stdIterator, this->_stdEnd);
+}
    
 template <typename T, typename CollectionType, typename StdIteratorType>
 Ptr<AbstractIterator<const T>>
 StdIteratorAdaptor<T, CollectionType, StdIteratorType>::toConstIterator()
 {
    return new ConstStdIteratorAdaptor<T, CollectionType, StdIteratorType>(
-         _collection, _stdIterator, _stdEnd);
+         *this->_collection, this->_stdIterator, this->_stdEnd);
 }
    
 }; // namespace karen
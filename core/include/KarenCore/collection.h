@@ -137,6 +137,43 @@ public:
 
 };
 
+/**
+ * Fast range template class. This class wraps a pair of STL-compatible
+ * iterators so they may be used in a range-based for loop. Collections
+ * return it from their fast() member to provide an iteration path with
+ * no heap allocations nor virtual calls, at the cost of not being usable
+ * through the Collection interface. Fast iterators are invalidated in the
+ * same cases the backing STL container invalidates its own iterators.
+ */
+template <class StdIterator>
+class FastRange
+{
+public:
+
+   /**
+    * Create a new range from given begin and end iterators.
+    */
+   inline FastRange(const StdIterator& begin, const StdIterator& end)
+      : _begin(begin), _end(end) {}
+
+   /**
+    * Obtain an iterator to the beginning of the range.
+    */
+   inline StdIterator begin() const
+   { return _begin; }
+
+   /**
+    * Obtain an iterator to the end of the range (actually beyond it).
+    */
+   inline StdIterator end() const
+   { return _end; }
+
+private:
+
+   StdIterator _begin;
+   StdIterator _end;
+};
+
 template <class T, class Backend>
 class CollectionAdaptor : public Collection<T>
 {
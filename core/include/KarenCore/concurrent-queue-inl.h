@@ -0,0 +1,506 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_CONCURRENT_QUEUE_INL_H
+#define KAREN_CORE_CONCURRENT_QUEUE_INL_H
+
+#include <chrono>
+#include <new>
+
+#include "KarenCore/concurrent-queue.h"
+
+namespace karen {
+
+template <class T, QueueConcurrency Concurrency>
+ConcurrentRing<T, Concurrency>::ConcurrentRing(unsigned long capacity)
+ : _slots(new Slot[capacity]), _mask(capacity - 1), _tail(0), _head(0)
+{
+   for (unsigned long i = 0; i < capacity; i++)
+      _slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <class T, QueueConcurrency Concurrency>
+ConcurrentRing<T, Concurrency>::~ConcurrentRing()
+{
+   unsigned long tail = _tail.load(std::memory_order_relaxed);
+   for (unsigned long pos = _head.load(std::memory_order_relaxed); 
+        pos != tail; pos++)
+      _slots[pos & _mask].element()->~T();
+   delete [] _slots;
+}
+
+template <class T, QueueConcurrency Concurrency>
+unsigned long
+ConcurrentRing<T, Concurrency>::capacity() const
+{ return _mask + 1; }
+
+template <class T, QueueConcurrency Concurrency>
+unsigned long
+ConcurrentRing<T, Concurrency>::size() const
+{
+   unsigned long head = _head.load(std::memory_order_acquire);
+   unsigned long tail = _tail.load(std::memory_order_acquire);
+   long n = (long) (tail - head);
+   if (n < 0)
+      return 0;
+   return ((unsigned long) n > _mask) ? _mask + 1 : n;
+}
+
+template <class T, QueueConcurrency Concurrency>
+template <class ... Args>
+bool
+ConcurrentRing<T, Concurrency>::push(Args&& ... args)
+{
+   unsigned long pos;
+   if (!claim(_tail, 0, 1, pos))
+      return false;
+   Slot& slot = _slots[pos & _mask];
+   new (slot.element()) T(std::forward<Args>(args)...);
+   slot.sequence.store(pos + 1, std::memory_order_release);
+   return true;
+}
+
+template <class T, QueueConcurrency Concurrency>
+unsigned long
+ConcurrentRing<T, Concurrency>::pushMany(
+      const T* elems, unsigned long nelems)
+{
+   unsigned long first;
+   unsigned long n = claim(_tail, 0, nelems, first);
+   for (unsigned long i = 0; i < n; i++)
+   {
+      Slot& slot = _slots[(first + i) & _mask];
+      new (slot.element()) T(elems[i]);
+      slot.sequence.store(first + i + 1, std::memory_order_release);
+   }
+   return n;
+}
+
+template <class T, QueueConcurrency Concurrency>
+bool
+ConcurrentRing<T, Concurrency>::pop(T& t)
+{
+   unsigned long pos;
+   if (!claim(_head, 1, 1, pos))
+      return false;
+   Slot& slot = _slots[pos & _mask];
+   t = std::move(*slot.element());
+   slot.element()->~T();
+   slot.sequence.store(pos + _mask + 1, std::memory_order_release);
+   return true;
+}
+
+template <class T, QueueConcurrency Concurrency>
+unsigned long
+ConcurrentRing<T, Concurrency>::popMany(T* elems, unsigned long nelems)
+{
+   unsigned long first;
+   unsigned long n = claim(_head, 1, nelems, first);
+   for (unsigned long i = 0; i < n; i++)
+   {
+      Slot& slot = _slots[(first + i) & _mask];
+      elems[i] = std::move(*slot.element());
+      slot.element()->~T();
+      slot.sequence.store(first + i + _mask + 1, std::memory_order_release);
+   }
+   return n;
+}
+
+template <class T, QueueConcurrency Concurrency>
+unsigned long
+ConcurrentRing<T, Concurrency>::claim(
+      std::atomic<unsigned long>& counter,
+      unsigned long offset,
+      unsigned long nelems,
+      unsigned long& first)
+{
+   if (!nelems)
+      return 0;
+   unsigned long pos = counter.load(std::memory_order_relaxed);
+   for (;;)
+   {
+      // Count the consecutive slots ready for this lap. No other thread
+      // may take them without advancing the counter past pos, so a
+      // successful exchange claims all of them at once
+      unsigned long n = 0;
+      long diff = 0;
+      while (n < nelems)
+      {
+         diff = (long) (_slots[(pos + n) & _mask].sequence.load(
+               std::memory_order_acquire) - (pos + n + offset));
+         if (diff != 0)
+            break;
+         n++;
+      }
+      if (n > 0)
+      {
+         if (counter.compare_exchange_weak(
+               pos, pos + n, std::memory_order_relaxed))
+         {
+            first = pos;
+            return n;
+         }
+      }
+      else if (diff < 0)
+         // The slot still holds the element of the previous lap (when
+         // pushing) or has not been written yet (when popping)
+         return 0;
+      else
+         pos = counter.load(std::memory_order_relaxed);
+   }
+}
+
+template <class T>
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::ConcurrentRing(
+      unsigned long capacity)
+ : _slots(new Slot[capacity]), _mask(capacity - 1), 
+   _tail(0), _headCache(0), _head(0), _tailCache(0)
+{
+}
+
+template <class T>
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::~ConcurrentRing()
+{
+   unsigned long tail = _tail.load(std::memory_order_relaxed);
+   for (unsigned long pos = _head.load(std::memory_order_relaxed); 
+        pos != tail; pos++)
+      element(pos)->~T();
+   delete [] _slots;
+}
+
+template <class T>
+unsigned long
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::capacity() const
+{ return _mask + 1; }
+
+template <class T>
+unsigned long
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::size() const
+{
+   unsigned long head = _head.load(std::memory_order_acquire);
+   unsigned long tail = _tail.load(std::memory_order_acquire);
+   long n = (long) (tail - head);
+   return (n < 0) ? 0 : n;
+}
+
+template <class T>
+template <class ... Args>
+bool
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::push(Args&& ... args)
+{
+   unsigned long tail = _tail.load(std::memory_order_relaxed);
+   if (!freeSlots(tail, 1))
+      return false;
+   new (element(tail)) T(std::forward<Args>(args)...);
+   _tail.store(tail + 1, std::memory_order_release);
+   return true;
+}
+
+template <class T>
+unsigned long
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::pushMany(
+      const T* elems, unsigned long nelems)
+{
+   unsigned long tail = _tail.load(std::memory_order_relaxed);
+   unsigned long n = freeSlots(tail, nelems);
+   for (unsigned long i = 0; i < n; i++)
+      new (element(tail + i)) T(elems[i]);
+   _tail.store(tail + n, std::memory_order_release);
+   return n;
+}
+
+template <class T>
+bool
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::pop(T& t)
+{
+   unsigned long head = _head.load(std::memory_order_relaxed);
+   if (!usedSlots(head, 1))
+      return false;
+   t = std::move(*element(head));
+   element(head)->~T();
+   _head.store(head + 1, std::memory_order_release);
+   return true;
+}
+
+template <class T>
+unsigned long
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::popMany(
+      T* elems, unsigned long nelems)
+{
+   unsigned long head = _head.load(std::memory_order_relaxed);
+   unsigned long n = usedSlots(head, nelems);
+   for (unsigned long i = 0; i < n; i++)
+   {
+      elems[i] = std::move(*element(head + i));
+      element(head + i)->~T();
+   }
+   _head.store(head + n, std::memory_order_release);
+   return n;
+}
+
+template <class T>
+T*
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::element(unsigned long pos)
+{ return reinterpret_cast<T*>(&_slots[pos & _mask]); }
+
+template <class T>
+unsigned long
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::freeSlots(
+      unsigned long tail, unsigned long nelems)
+{
+   unsigned long n = _mask + 1 - (tail - _headCache);
+   if (n < nelems)
+   {
+      _headCache = _head.load(std::memory_order_acquire);
+      n = _mask + 1 - (tail - _headCache);
+   }
+   return (n < nelems) ? n : nelems;
+}
+
+template <class T>
+unsigned long
+ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>::usedSlots(
+      unsigned long head, unsigned long nelems)
+{
+   unsigned long n = _tailCache - head;
+   if (n < nelems)
+   {
+      _tailCache = _tail.load(std::memory_order_acquire);
+      n = _tailCache - head;
+   }
+   return (n < nelems) ? n : nelems;
+}
+
+template <class T, QueueConcurrency Concurrency>
+template <class Value>
+struct ConcurrentQueue<T, Concurrency>::PutAttempt
+{
+   ConcurrentRing<T, Concurrency>& ring;
+   Value& value;
+
+   inline bool operator () ()
+   { return ring.push(std::forward<Value>(value)); }
+};
+
+template <class T, QueueConcurrency Concurrency>
+struct ConcurrentQueue<T, Concurrency>::PollAttempt
+{
+   ConcurrentRing<T, Concurrency>& ring;
+   T& value;
+
+   inline bool operator () ()
+   { return ring.pop(value); }
+};
+
+template <class T, QueueConcurrency Concurrency>
+ConcurrentQueue<T, Concurrency>::ConcurrentQueue(unsigned long capacity)
+throw (InvalidInputException)
+ : _ring(roundCapacity(capacity)), _waiters(0)
+{
+}
+
+template <class T, QueueConcurrency Concurrency>
+unsigned long
+ConcurrentQueue<T, Concurrency>::capacity() const
+{ return _ring.capacity(); }
+
+template <class T, QueueConcurrency Concurrency>
+unsigned long
+ConcurrentQueue<T, Concurrency>::size() const
+{ return _ring.size(); }
+
+template <class T, QueueConcurrency Concurrency>
+bool
+ConcurrentQueue<T, Concurrency>::isEmpty() const
+{ return _ring.size() == 0; }
+
+template <class T, QueueConcurrency Concurrency>
+bool
+ConcurrentQueue<T, Concurrency>::tryPut(const T& t)
+{
+   if (!_ring.push(t))
+      return false;
+   wakeUp();
+   return true;
+}
+
+template <class T, QueueConcurrency Concurrency>
+bool
+ConcurrentQueue<T, Concurrency>::tryPut(T&& t)
+{
+   if (!_ring.push(std::move(t)))
+      return false;
+   wakeUp();
+   return true;
+}
+
+template <class T, QueueConcurrency Concurrency>
+template <class ... Args>
+bool
+ConcurrentQueue<T, Concurrency>::tryEmplace(Args&& ... args)
+{
+   if (!_ring.push(std::forward<Args>(args)...))
+      return false;
+   wakeUp();
+   return true;
+}
+
+template <class T, QueueConcurrency Concurrency>
+bool
+ConcurrentQueue<T, Concurrency>::tryPoll(T& t)
+{
+   if (!_ring.pop(t))
+      return false;
+   wakeUp();
+   return true;
+}
+
+template <class T, QueueConcurrency Concurrency>
+bool
+ConcurrentQueue<T, Concurrency>::tryPoll(T& t, unsigned long millis)
+{
+   PollAttempt attempt = { _ring, t };
+   if (!await(attempt, (long) millis))
+      return false;
+   wakeUp();
+   return true;
+}
+
+template <class T, QueueConcurrency Concurrency>
+unsigned long
+ConcurrentQueue<T, Concurrency>::putAll(const T* elems, unsigned long nelems)
+{
+   unsigned long n = _ring.pushMany(elems, nelems);
+   if (n)
+      wakeUp();
+   return n;
+}
+
+template <class T, QueueConcurrency Concurrency>
+unsigned long
+ConcurrentQueue<T, Concurrency>::pollMany(T* elems, unsigned long nelems)
+{
+   unsigned long n = _ring.popMany(elems, nelems);
+   if (n)
+      wakeUp();
+   return n;
+}
+
+template <class T, QueueConcurrency Concurrency>
+void
+ConcurrentQueue<T, Concurrency>::put(const T& t)
+{
+   PutAttempt<const T&> attempt = { _ring, t };
+   await(attempt, -1);
+   wakeUp();
+}
+
+template <class T, QueueConcurrency Concurrency>
+void
+ConcurrentQueue<T, Concurrency>::put(T&& t)
+{
+   PutAttempt<T> attempt = { _ring, t };
+   await(attempt, -1);
+   wakeUp();
+}
+
+template <class T, QueueConcurrency Concurrency>
+T
+ConcurrentQueue<T, Concurrency>::poll()
+{
+   T t;
+   PollAttempt attempt = { _ring, t };
+   await(attempt, -1);
+   wakeUp();
+   return t;
+}
+
+template <class T, QueueConcurrency Concurrency>
+template <class Attempt>
+bool
+ConcurrentQueue<T, Concurrency>::await(Attempt attempt, long millis)
+{
+   for (int i = 0; i < SPIN_ATTEMPTS; i++)
+   {
+      if (attempt())
+         return true;
+      std::this_thread::yield();
+   }
+
+   // Registering as waiter before the last attempt, and the fence in
+   // wakeUp(), ensure that either this thread sees the change that 
+   // another thread made to the queue or the other thread notifies it
+   _waiters.fetch_add(1);
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   bool done;
+   {
+      std::unique_lock<std::mutex> lock(_mutex);
+      std::chrono::steady_clock::time_point deadline = 
+            std::chrono::steady_clock::now() + 
+            std::chrono::milliseconds(millis < 0 ? 0 : millis);
+      while (!(done = attempt()))
+      {
+         if (millis < 0)
+            _cond.wait(lock);
+         else if (_cond.wait_until(lock, deadline) == 
+                  std::cv_status::timeout)
+         {
+            done = attempt();
+            break;
+         }
+      }
+   }
+   _waiters.fetch_sub(1);
+   return done;
+}
+
+template <class T, QueueConcurrency Concurrency>
+void
+ConcurrentQueue<T, Concurrency>::wakeUp()
+{
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (_waiters.load(std::memory_order_relaxed) > 0)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _cond.notify_all();
+   }
+}
+
+template <class T, QueueConcurrency Concurrency>
+unsigned long
+ConcurrentQueue<T, Concurrency>::roundCapacity(unsigned long capacity)
+throw (InvalidInputException)
+{
+   if (!capacity)
+      KAREN_THROW(InvalidInputException, 
+            "cannot create concurrent queue with no capacity");
+   unsigned long n = 1;
+   while (n < capacity)
+      n <<= 1;
+   return n;
+}
+
+}
+
+#endif
@@ -0,0 +1,346 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_CONCURRENT_QUEUE_H
+#define KAREN_CORE_CONCURRENT_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "KarenCore/exception.h"
+
+namespace karen {
+
+/**
+ * Queue concurrency enumeration. This enumeration describes how many
+ * threads may put elements into a concurrent queue and poll them from it
+ * at the same time.
+ */
+enum QueueConcurrency
+{
+   MULTIPLE_PRODUCERS_CONSUMERS,
+   SINGLE_PRODUCER_CONSUMER,
+};
+
+/**
+ * Concurrent ring template class. This class implements the lock-free
+ * bounded ring buffer that backs a ConcurrentQueue. The general template
+ * supports any number of producer and consumer threads. Each slot carries
+ * a sequence number that tells whether it is ready to be written or read
+ * for a given lap of the ring, so threads only contend on the counter 
+ * they advance. Operations never block: they fail when the ring is full
+ * or empty. 
+ */
+template <class T, QueueConcurrency Concurrency>
+class ConcurrentRing
+{
+public:
+
+   /**
+    * Create a new ring with given capacity, which must be a power of two.
+    */
+   inline ConcurrentRing(unsigned long capacity);
+
+   inline ~ConcurrentRing();
+
+   inline unsigned long capacity() const;
+
+   /**
+    * Obtain the number of elements in the ring. The result is approximate
+    * when other threads are operating on the ring. 
+    */
+   inline unsigned long size() const;
+
+   /**
+    * Construct a new element at the tail of the ring from given arguments.
+    * It returns false with no effect if the ring is full. 
+    */
+   template <class ... Args>
+   inline bool push(Args&& ... args);
+
+   /**
+    * Copy as many of given elements as fit at the tail of the ring, 
+    * returning how many were copied. 
+    */
+   inline unsigned long pushMany(const T* elems, unsigned long nelems);
+
+   /**
+    * Move the head element of the ring into given variable. It returns 
+    * false with no effect if the ring is empty. 
+    */
+   inline bool pop(T& t);
+
+   /**
+    * Move up to given number of elements from the head of the ring into
+    * given array, returning how many were moved. 
+    */
+   inline unsigned long popMany(T* elems, unsigned long nelems);
+
+private:
+
+   enum { CACHE_LINE = 64 };
+
+   struct Slot
+   {
+      std::atomic<unsigned long> sequence;
+      typename std::aligned_storage<
+            sizeof(T), std::alignment_of<T>::value>::type storage;
+
+      inline T* element()
+      { return reinterpret_cast<T*>(&storage); }
+   };
+
+   /*
+    * The counters are kept in different cache lines, so producers and
+    * consumers do not invalidate each other's lines when advancing them.
+    */
+   char                       _pad0[CACHE_LINE];
+   Slot*                      _slots;
+   unsigned long              _mask;
+   char                       _pad1[CACHE_LINE];
+   std::atomic<unsigned long> _tail;
+   char                       _pad2[CACHE_LINE];
+   std::atomic<unsigned long> _head;
+   char                       _pad3[CACHE_LINE];
+
+   /*
+    * Claim up to given number of consecutive slots ready for the lap 
+    * at counter position plus given offset, returning the first claimed
+    * position and the number of claimed slots.
+    */
+   inline unsigned long claim(std::atomic<unsigned long>& counter,
+                              unsigned long offset,
+                              unsigned long nelems,
+                              unsigned long& first);
+
+   ConcurrentRing(const ConcurrentRing&);
+   ConcurrentRing& operator = (const ConcurrentRing&);
+
+};
+
+/**
+ * Concurrent ring for a single producer and a single consumer. Since each
+ * counter is only advanced by one thread, slots need no sequence numbers
+ * and each side keeps a private copy of the other side's counter that is
+ * only refreshed when the ring looks full or empty.
+ */
+template <class T>
+class ConcurrentRing<T, SINGLE_PRODUCER_CONSUMER>
+{
+public:
+
+   inline ConcurrentRing(unsigned long capacity);
+
+   inline ~ConcurrentRing();
+
+   inline unsigned long capacity() const;
+
+   inline unsigned long size() const;
+
+   template <class ... Args>
+   inline bool push(Args&& ... args);
+
+   inline unsigned long pushMany(const T* elems, unsigned long nelems);
+
+   inline bool pop(T& t);
+
+   inline unsigned long popMany(T* elems, unsigned long nelems);
+
+private:
+
+   enum { CACHE_LINE = 64 };
+
+   typedef typename std::aligned_storage<
+         sizeof(T), std::alignment_of<T>::value>::type Slot;
+
+   char                       _pad0[CACHE_LINE];
+   Slot*                      _slots;
+   unsigned long              _mask;
+   char                       _pad1[CACHE_LINE];
+   std::atomic<unsigned long> _tail;
+   unsigned long              _headCache;
+   char                       _pad2[CACHE_LINE];
+   std::atomic<unsigned long> _head;
+   unsigned long              _tailCache;
+   char                       _pad3[CACHE_LINE];
+
+   inline T* element(unsigned long pos);
+
+   inline unsigned long freeSlots(unsigned long tail, unsigned long nelems);
+
+   inline unsigned long usedSlots(unsigned long head, unsigned long nelems);
+
+   ConcurrentRing(const ConcurrentRing&);
+   ConcurrentRing& operator = (const ConcurrentRing&);
+
+};
+
+/**
+ * Concurrent queue template class. This class implements a bounded FIFO
+ * queue that may be shared among threads with no locks. It is backed by
+ * a ConcurrentRing, so elements are stored inline and putting or polling
+ * them never allocates. The Concurrency parameter selects whether any 
+ * number of threads may put and poll at the same time, or just one 
+ * producer and one consumer thread, which is cheaper. 
+ *
+ * The tryPut() and tryPoll() operations, as well as their batch versions
+ * putAll() and pollMany(), never block. The put() and poll() operations
+ * wait until there is room or an element is available: they spin for a 
+ * while and then sleep until another thread operates on the queue. 
+ * Threads that never wait pay no locking cost. 
+ */
+template <class T, QueueConcurrency Concurrency = MULTIPLE_PRODUCERS_CONSUMERS>
+class ConcurrentQueue
+{
+public:
+
+   /**
+    * Create a new queue able to hold given number of elements, rounded
+    * up to the next power of two. It throws an InvalidInputException if
+    * capacity is zero. 
+    */
+   inline ConcurrentQueue(unsigned long capacity)
+         throw (InvalidInputException);
+
+   /**
+    * Obtain the maximum number of elements the queue may hold.
+    */
+   inline unsigned long capacity() const;
+
+   /**
+    * Obtain the number of elements in the queue. The result is approximate
+    * when other threads are operating on the queue. 
+    */
+   inline unsigned long size() const;
+
+   /**
+    * Check whether the queue is empty. The result is approximate when
+    * other threads are operating on the queue. 
+    */
+   inline bool isEmpty() const;
+
+   /**
+    * Try to put a new element in the queue. It returns false if the queue
+    * is full. 
+    */
+   inline bool tryPut(const T& t);
+
+   /**
+    * Try to put a new element in the queue by moving it. It returns false
+    * if the queue is full, leaving given element untouched. 
+    */
+   inline bool tryPut(T&& t);
+
+   /**
+    * Try to put a new element in the queue constructing it in place from
+    * given arguments. It returns false if the queue is full. 
+    */
+   template <class ... Args>
+   inline bool tryEmplace(Args&& ... args);
+
+   /**
+    * Try to retrieve the next element of the queue by moving it into 
+    * given variable. It returns false if the queue is empty. 
+    */
+   inline bool tryPoll(T& t);
+
+   /**
+    * Try to retrieve the next element of the queue by moving it into 
+    * given variable, waiting up to given milliseconds for an element to
+    * be available. It returns false if the queue is still empty. 
+    */
+   inline bool tryPoll(T& t, unsigned long millis);
+
+   /**
+    * Put as many of given elements as fit in the queue, returning how 
+    * many were put. Elements are put in order. 
+    */
+   inline unsigned long putAll(const T* elems, unsigned long nelems);
+
+   /**
+    * Retrieve up to given number of elements from the queue into given 
+    * array, returning how many were retrieved. 
+    */
+   inline unsigned long pollMany(T* elems, unsigned long nelems);
+
+   /**
+    * Put a new element in the queue, waiting for room if it is full.
+    */
+   inline void put(const T& t);
+
+   /**
+    * Put a new element in the queue by moving it, waiting for room if it
+    * is full. 
+    */
+   inline void put(T&& t);
+
+   /**
+    * Retrieve the next element of the queue, waiting for one if it is 
+    * empty. The element is moved out of the queue rather than copied,
+    * into a default-constructed one. 
+    */
+   inline T poll();
+
+private:
+
+   enum { SPIN_ATTEMPTS = 64 };
+
+   ConcurrentRing<T, Concurrency> _ring;
+   std::atomic<unsigned int>      _waiters;
+   std::mutex                     _mutex;
+   std::condition_variable        _cond;
+
+   template <class Value>
+   struct PutAttempt;
+
+   struct PollAttempt;
+
+   static inline unsigned long roundCapacity(unsigned long capacity)
+         throw (InvalidInputException);
+
+   /*
+    * Repeat given attempt until it succeeds or given milliseconds elapse,
+    * where a negative value means waiting forever. 
+    */
+   template <class Attempt>
+   inline bool await(Attempt attempt, long millis);
+
+   /*
+    * Wake up the threads waiting for the queue to change, if any.
+    */
+   inline void wakeUp();
+
+   ConcurrentQueue(const ConcurrentQueue&);
+   ConcurrentQueue& operator = (const ConcurrentQueue&);
+
+};
+
+}
+
+#include "KarenCore/concurrent-queue-inl.h"
+
+#endif
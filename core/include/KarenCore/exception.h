@@ -26,14 +26,67 @@
 #define KAREN_CORE_EXCEPTION_H
 
 #include <exception>
+#include <type_traits>
 
+#include "KarenCore/format.h"
 #include "KarenCore/platform.h"
 
 namespace karen {
 
-template <typename CharType> class StringBase;
+/**
+ * Exception cause class. This class captures a format and its arguments 
+ * to build the cause of an exception only when it is read, so throwing an
+ * exception formats nothing and allocates no memory. The arguments are 
+ * copied inline, including the text of the string ones, which is 
+ * truncated if it doesn't fit. The format is not copied, so it must 
+ * outlive the exception, as string literals do. Arguments beyond MAX_ARGS
+ * are ignored. The cause is formatted as StringBuilder::appendFormat()
+ * does. 
+ */
+class KAREN_EXPORT ExceptionCause
+{
+public:
+
+   enum
+   {
+      MAX_ARGS = 6,
+      TEXT_CAPACITY = 256,
+   };
+
+   /**
+    * Create a new exception cause from given format and arguments.
+    */
+   template <class ... Args>
+   inline explicit ExceptionCause(const char* format, const Args& ... args)
+    : _format(format), _nargs(0), _textLength(0)
+   { capture(args...); }
+
+   /**
+    * Obtain the cause by formatting the captured arguments.
+    */
+   String format() const;
+
+private:
+
+   const char*    _format;
+   FormatArg      _args[MAX_ARGS];
+   unsigned short _textOffsets[MAX_ARGS];
+   unsigned int   _nargs;
+   char           _text[TEXT_CAPACITY];
+   unsigned int   _textLength;
 
-typedef StringBase<char> String;
+   inline void capture() {}
+
+   template <class A, class ... Rest>
+   inline void capture(const A& a, const Rest& ... rest)
+   {
+      if (_nargs < MAX_ARGS)
+         append(FormatArg(a));
+      capture(rest...);
+   }
+
+   void append(const FormatArg& arg);
+};
 
 /**
  * Abstract exception class. This class provides an abstraction for a
@@ -45,10 +98,21 @@ class KAREN_EXPORT Exception : public std::exception
 public:
 
    /**
-    * Obtain exception cause.
+    * Obtain exception cause. It is formatted the first time it is read.
     */
-   inline const String& cause() const
-   { return *_cause; }
+   const String& cause() const;
+
+   /**
+    * Obtain the name of the source file where the exception was raised.
+    */
+   inline const char* sourceFile() const
+   { return _sourceFile; }
+
+   /**
+    * Obtain the line of the source file where the exception was raised.
+    */
+   inline long sourceLine() const
+   { return _sourceLine; }
    
    /**
     * Obtain nested exception. If there is no nested exception, it returns
@@ -81,6 +145,22 @@ protected:
     */
    Exception(const String& cause,
              Exception* nestedException);
+
+   /**
+    * Create a new exception from given lazy cause, source filename and
+    * source line. The source filename is not copied, so it must outlive
+    * the exception as __FILE__ does. If there is a nested exception, the
+    * cause is formatted right away, since the nested exception may not
+    * outlive this one. 
+    */
+   Exception(const ExceptionCause& cause,
+             const char* sourceFile,
+             long sourceLine,
+             Exception* nestedException = nullptr);
+
+   Exception(const Exception& e);
+
+   Exception& operator = (const Exception& e);
    
    /**
     * Virtual destructor. 
@@ -94,10 +174,14 @@ private:
              long sourceLine,
              Exception* nestedException);
 
-   String*        _cause;
-   String*        _sourceFile;
-   long           _sourceLine;
-   Exception*     _nestedException;
+   void copy(const Exception& e);
+
+   ExceptionCause    _lazyCause;
+   mutable String*   _cause;
+   const char*       _sourceFile;
+   String*           _sourceFileCopy;
+   long              _sourceLine;
+   Exception*        _nestedException;
 
 };
 
@@ -111,6 +195,10 @@ private:
                 long line, karen::Exception* nestedException) \
         : karen::Exception(cause, file, line, nestedException) {}\
       \
+      classname(const karen::ExceptionCause& cause, const char* file, \
+                long line, karen::Exception* nestedException = nullptr) \
+        : karen::Exception(cause, file, line, nestedException) {}\
+      \
    }
 
 #define KAREN_DECL_CHILD_EXCEPTION(classname, parent) \
@@ -123,13 +211,24 @@ private:
                 long line, Exception* nestedException) \
         : Exception(cause, file, line, nestedException) {}\
       \
+      classname(const karen::ExceptionCause& cause, const char* file, \
+                long line, karen::Exception* nestedException = nullptr) \
+        : parent(cause, file, line, nestedException) {}\
+      \
    }
 
+/*
+ * Throw an exception of given class whose cause is given format literal
+ * with the given arguments. The format is checked against the arguments
+ * when compiling. 
+ */
 #define KAREN_THROW(classname, msg, ...) throw classname(\
-   String::format(msg, ## __VA_ARGS__), __FILE__, __LINE__);
+   karen::ExceptionCause(KAREN_CHECKED_FORMAT(msg, ## __VA_ARGS__), \
+         ## __VA_ARGS__), __FILE__, __LINE__);
 
 #define KAREN_THROW_NESTED(classname, nested, msg, ...) throw classname(\
-   String::format(msg, ## __VA_ARGS__), __FILE__, __LINE__, &nested);
+   karen::ExceptionCause(KAREN_CHECKED_FORMAT(msg, ## __VA_ARGS__), \
+         ## __VA_ARGS__), __FILE__, __LINE__, &nested);
 
 /**
  * Internal error exception. This exception is raised when an unexpected
@@ -51,18 +51,106 @@ public:
    
    ~PosixFile();
 
+   /**
+    * Obtain the file descriptor of this file.
+    */
+   inline int descriptor() const
+   { return _fd; }
+
    virtual unsigned long readBytes(void* dest, unsigned long nbytes) 
          throw (IOException);
 
    virtual unsigned long writeBytes(const void* src, unsigned long nbytes) 
          throw (IOException);   
 
+   virtual unsigned long readAt(
+         void* dest, 
+         unsigned long nbytes, 
+         unsigned long offset) throw (IOException);
+
+   virtual unsigned long writeAt(
+         const void* src, 
+         unsigned long nbytes, 
+         unsigned long offset) throw (IOException);
+
+   virtual unsigned long readv(const IoVec* vecs, unsigned int count) 
+         throw (IOException);
+
+   virtual unsigned long writev(const IoVec* vecs, unsigned int count) 
+         throw (IOException);
+
+   virtual unsigned long size() const throw (IOException);
+
+   virtual unsigned long seek(long offset, SeekOrigin origin)
+         throw (IOException);
+
+   virtual unsigned long tell() const throw (IOException);
+
+   virtual void advise(
+         FileAccessAdvice advice, 
+         unsigned long offset,
+         unsigned long len) throw (IOException);
+
 private:
 
    int _fd;
 
 };
 
+/**
+ * Posix mapped file class. This class provides a mmap-based implementation
+ * of MappedFile. It should never been used directy. Use wrapper class 
+ * MappedFile instead. 
+ */
+class PosixMappedFile : public AbstractMappedFile
+{
+public:
+
+   /**
+    * Map the file at given location in given mode. If the file cannot be 
+    * opened or mapped, a IOException is thrown.
+    */
+   PosixMappedFile(const String& location, 
+                   FileMappingMode mode) throw (IOException);
+
+   ~PosixMappedFile();
+
+   inline virtual Buffer& buffer()
+   { return _view; }
+
+   inline virtual const Buffer& buffer() const
+   { return _view; }
+
+   inline virtual FileMappingMode mode() const
+   { return _mode; }
+
+   virtual void advise(
+         FileAccessAdvice advice, 
+         unsigned long offset,
+         unsigned long len) throw (IOException);
+
+   virtual void sync(
+         unsigned long offset, 
+         unsigned long len, 
+         bool wait) throw (IOException);
+
+   virtual void resize(unsigned long length) 
+         throw (IOException, InvalidStateException);
+
+private:
+
+   int               _fd;
+   FileMappingMode   _mode;
+   Buffer            _view;
+
+   void map(unsigned long length) throw (IOException);
+
+   void unmap();
+
+   void pageRange(unsigned long& offset, unsigned long& len) const;
+
+};
+
 class PosixFileFactory : public FileFactory
 {
 public:
@@ -71,6 +159,25 @@ public:
          const String& location, 
          const FileOpenMode& mode) throw (IOException);
 
+   virtual Ptr<AbstractMappedFile> createMappedFile(
+         const String& location,
+         FileMappingMode mode) throw (IOException);
+
+   /**
+    * Transfer the bytes in kernel space when both files are POSIX files,
+    * either directly or wrapped by File. On Linux, copy_file_range() is
+    * tried first, which may share the blocks on filesystems supporting 
+    * reflinks, and splice() through a pipe next. Both address the files by
+    * offset, so their positions are never moved. Otherwise, or if the 
+    * kernel refuses both, the bytes are copied through a user buffer. 
+    */
+   virtual unsigned long transfer(
+         AbstractFile& src, 
+         unsigned long srcOffset,
+         AbstractFile& dst, 
+         unsigned long dstOffset,
+         unsigned long len) throw (IOException);
+
 };
 
 }; // namespace karen
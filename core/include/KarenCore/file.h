@@ -25,6 +25,7 @@
 #ifndef KAREN_CORE_FILE_H
 #define KAREN_CORE_FILE_H
 
+#include "KarenCore/buffer.h"
 #include "KarenCore/exception.h"
 #include "KarenCore/pointer.h"
 #include "KarenCore/stream.h"
@@ -81,11 +82,47 @@ struct KAREN_EXPORT FileOpenMode
    
 };
 
+/**
+ * File access advice. This enumeration describes the expected pattern of 
+ * access to a range of a file or mapping, so the system may prefetch or drop
+ * its pages accordingly.
+ */
+enum FileAccessAdvice
+{
+   NORMAL_ACCESS,       //!< No particular pattern
+   SEQUENTIAL_ACCESS,   //!< Accessed from lower to higher offsets
+   RANDOM_ACCESS,       //!< Accessed in random order
+   WILL_NEED_ACCESS,    //!< Accessed soon; prefetching is advisable
+   DONT_NEED_ACCESS,    //!< Not accessed soon; pages may be dropped
+};
+
+/**
+ * Seek origin. This enumeration indicates the position a file seek offset
+ * is relative to.
+ */
+enum SeekOrigin
+{
+   SEEK_FROM_BEGIN,     //!< Offset from the beginning of the file
+   SEEK_FROM_CURRENT,   //!< Offset from the current position
+   SEEK_FROM_END,       //!< Offset from the end of the file
+};
+
+/**
+ * I/O vector. This struct describes one of the memory regions a vectored
+ * read scatters data into or a vectored write gathers data from.
+ */
+struct KAREN_EXPORT IoVec
+{
+   void*          data;    //!< Start of the region
+   unsigned long  length;  //!< Length of the region in bytes
+};
+
 /**
  * Abstract file class. This class provides the interface for an abstract
- * file. This interface provides only read and write methods, but not
- * open or close. It follows RAII principles so the file is opened in 
- * AbstractFile object creation and it is closed when it is destroyed.
+ * file. This interface provides sequential, positional and vectored read
+ * and write methods, but not open or close. It follows RAII principles so
+ * the file is opened in AbstractFile object creation and it is closed when
+ * it is destroyed.
  * AbstractFile inherits from InputStream and OutputStream, allowing its 
  * instances to behave as streams for reading and writing. 
  */
@@ -115,6 +152,78 @@ public:
    virtual unsigned long writeBytes(const void* src, unsigned long nbytes) 
          throw (IOException) = 0;
 
+   /**
+    * Read nbytes from given offset of this file and store them in dest. It
+    * returns the number of read bytes, which is less than nbytes only if
+    * the end of the file is reached. The file position is neither used nor
+    * modified, so several threads may read from one file at once. If the
+    * file cannot be read, a IOException is thrown.
+    */
+   virtual unsigned long readAt(
+         void* dest, 
+         unsigned long nbytes, 
+         unsigned long offset) throw (IOException) = 0;
+
+   /**
+    * Write nbytes from src at given offset of this file. It returns the 
+    * number of bytes written, which is nbytes unless the file accepts no
+    * further data. The file position is neither used nor 
+    * modified, so several threads may write to one file at once. If the 
+    * file cannot be written, a IOException is thrown. 
+    */
+   virtual unsigned long writeAt(
+         const void* src, 
+         unsigned long nbytes, 
+         unsigned long offset) throw (IOException) = 0;
+
+   /**
+    * Read from this file into the count regions described by vecs, filling
+    * each before the next one. It returns the number of bytes read, or zero
+    * if there are no further data to be read. If file cannot be read, a
+    * IOException is thrown.
+    */
+   virtual unsigned long readv(const IoVec* vecs, unsigned int count) 
+         throw (IOException) = 0;
+
+   /**
+    * Write to this file the contents of the count regions described by 
+    * vecs, in order. It returns the number of bytes written. If file cannot
+    * be written, a IOException is thrown.
+    */
+   virtual unsigned long writev(const IoVec* vecs, unsigned int count) 
+         throw (IOException) = 0;
+
+   /**
+    * Obtain the size of the file in bytes. If it cannot be obtained, a
+    * IOException is thrown.
+    */
+   virtual unsigned long size() const throw (IOException) = 0;
+
+   /**
+    * Move the file position to given offset relative to origin, and return
+    * the new position from the beginning of the file. If the resulting 
+    * position is not valid, a IOException is thrown.
+    */
+   virtual unsigned long seek(long offset, SeekOrigin origin = SEEK_FROM_BEGIN)
+         throw (IOException) = 0;
+
+   /**
+    * Obtain the file position from the beginning of the file. If it cannot
+    * be obtained, a IOException is thrown.
+    */
+   virtual unsigned long tell() const throw (IOException) = 0;
+
+   /**
+    * Advise the system about how the given range of this file will be 
+    * accessed, so it may prefetch or drop cached pages. A zero len extends
+    * the range to the end of the file. Backends ignore the advices they
+    * cannot honour. If the advice is not accepted, a IOException is thrown.
+    */
+   virtual void advise(
+         FileAccessAdvice advice, 
+         unsigned long offset = 0,
+         unsigned long len = 0) throw (IOException) = 0;
+
 };
 
 template class KAREN_EXPORT Ptr<AbstractFile>;
@@ -139,6 +248,49 @@ public:
    File(const String& location, const FileOpenMode& mode) 
       throw (IOException, InvalidStateException);
 
+   /**
+    * Copy the file placed at location from into location to, truncating
+    * it first if it already exists. The bytes are transferred as transfer()
+    * does. It returns the number of bytes copied. If any file cannot be 
+    * opened or the copy fails, a IOException is thrown. If no file factory
+    * has been activated, a InvalidStateException is thrown.
+    */
+   static unsigned long copyFile(const String& from, const String& to)
+      throw (IOException, InvalidStateException);
+
+   /**
+    * Transfer len bytes from src starting at srcOffset into dst starting at
+    * dstOffset. The active file factory performs the transfer, so it may 
+    * be done in kernel space without crossing into user memory when both
+    * files are backed by it. The file positions are not modified. The 
+    * transfer stops earlier if the end of src is reached. It returns the
+    * number of bytes transferred. If the transfer fails, a IOException is 
+    * thrown. If no file factory has been activated, a InvalidStateException
+    * is thrown.
+    */
+   static unsigned long transfer(
+         AbstractFile& src, 
+         unsigned long srcOffset,
+         AbstractFile& dst, 
+         unsigned long dstOffset,
+         unsigned long len) throw (IOException, InvalidStateException);
+
+   /**
+    * Transfer len bytes from src into dst at the same offset in both. 
+    */
+   inline static unsigned long transfer(
+         AbstractFile& src, 
+         AbstractFile& dst, 
+         unsigned long offset,
+         unsigned long len) throw (IOException, InvalidStateException)
+   { return transfer(src, offset, dst, offset, len); }
+
+   /**
+    * Obtain the implementation of AbstractFile this file delegates on.
+    */
+   inline AbstractFile& delegate()
+   { return *_impl; }
+
    inline virtual unsigned long readBytes(
          void* dest, 
          unsigned long nbytes) throw (IOException)
@@ -149,12 +301,204 @@ public:
          unsigned long nbytes) throw (IOException)
    { return _impl->writeBytes(src, nbytes); }
 
+   inline virtual unsigned long skip(unsigned long nbytes) throw (IOException)
+   { return _impl->skip(nbytes); }
+
+   inline virtual void flush() throw (IOException)
+   { _impl->flush(); }
+
+   inline virtual unsigned long readAt(
+         void* dest, 
+         unsigned long nbytes, 
+         unsigned long offset) throw (IOException)
+   { return _impl->readAt(dest, nbytes, offset); }
+
+   inline virtual unsigned long writeAt(
+         const void* src, 
+         unsigned long nbytes, 
+         unsigned long offset) throw (IOException)
+   { return _impl->writeAt(src, nbytes, offset); }
+
+   inline virtual unsigned long readv(const IoVec* vecs, unsigned int count) 
+         throw (IOException)
+   { return _impl->readv(vecs, count); }
+
+   inline virtual unsigned long writev(const IoVec* vecs, unsigned int count) 
+         throw (IOException)
+   { return _impl->writev(vecs, count); }
+
+   inline virtual unsigned long size() const throw (IOException)
+   { return _impl->size(); }
+
+   inline virtual unsigned long seek(
+         long offset, 
+         SeekOrigin origin = SEEK_FROM_BEGIN) throw (IOException)
+   { return _impl->seek(offset, origin); }
+
+   inline virtual unsigned long tell() const throw (IOException)
+   { return _impl->tell(); }
+
+   inline virtual void advise(
+         FileAccessAdvice advice, 
+         unsigned long offset = 0,
+         unsigned long len = 0) throw (IOException)
+   { _impl->advise(advice, offset, len); }
+
 private:
 
    Ptr<AbstractFile> _impl;
 
 };
 
+/**
+ * File mapping mode. This enumeration indicates how the contents of a file
+ * are mapped into memory. 
+ */
+enum FileMappingMode
+{
+   /** The mapping may be read but not written. */
+   READ_ONLY_MAPPING,
+   
+   /** 
+    * The mapping may be read and written, and writes are carried to the 
+    * file. The file is created if it doesn't exist. 
+    */
+   READ_WRITE_MAPPING,
+   
+   /**
+    * The mapping may be read and written, but writes are private to the
+    * mapping and never carried to the file. 
+    */
+   COPY_ON_WRITE_MAPPING,
+};
+
+/**
+ * Abstract mapped file class. This class provides the interface for a 
+ * file whose contents are mapped into memory, so they are read and written
+ * by accessing a buffer instead of by streaming bytes in and out. The 
+ * mapping is established in object creation and released when it is 
+ * destroyed.
+ */
+class KAREN_EXPORT AbstractMappedFile
+{
+public:
+
+   /**
+    * Virtual destructor.
+    */
+   inline virtual ~AbstractMappedFile() {}
+
+   /**
+    * Obtain the buffer that views the mapped contents. The buffer borrows 
+    * the mapping memory, so no byte is copied, and objects may point 
+    * straight into it. The buffer and any pointer into it are valid until
+    * the file is resized or destroyed.
+    */
+   virtual Buffer& buffer() = 0;
+
+   /**
+    * Obtain the buffer that views the mapped contents.
+    */
+   virtual const Buffer& buffer() const = 0;
+
+   /**
+    * Obtain the mode the file was mapped with.
+    */
+   virtual FileMappingMode mode() const = 0;
+
+   /**
+    * Advise the system about how the given range of the mapping will be 
+    * accessed. A zero len extends the range to the end of the mapping. If 
+    * the advice is not accepted, a IOException is thrown.
+    */
+   virtual void advise(
+         FileAccessAdvice advice, 
+         unsigned long offset = 0,
+         unsigned long len = 0) throw (IOException) = 0;
+
+   /**
+    * Write the modified pages in the given range of the mapping to the 
+    * file. A zero len extends the range to the end of the mapping. If wait
+    * is true, this method returns once the pages are written; otherwise,
+    * it only schedules the writing. It does nothing for mappings whose
+    * writes are not carried to the file. If the pages cannot be written, 
+    * a IOException is thrown. 
+    */
+   virtual void sync(
+         unsigned long offset = 0, 
+         unsigned long len = 0, 
+         bool wait = true) throw (IOException) = 0;
+
+   /**
+    * Resize the file and its mapping to given length, preserving the 
+    * contents up to the smaller of both lengths. Grown bytes are zero. The
+    * mapping may be moved, so the buffer must be obtained again. If the 
+    * file was not mapped in READ_WRITE_MAPPING mode, a InvalidStateException
+    * is thrown. If the file cannot be resized, a IOException is thrown. 
+    */
+   virtual void resize(unsigned long length) 
+         throw (IOException, InvalidStateException) = 0;
+
+};
+
+template class KAREN_EXPORT Ptr<AbstractMappedFile>;
+
+/**
+ * Mapped file class. This class provides a concrete representation of a
+ * mapped file not bounded to the concrete backend that supports it. As 
+ * File does, it wraps an actual implementation of AbstractMappedFile 
+ * obtained from the active file factory. 
+ */
+class KAREN_EXPORT MappedFile : public AbstractMappedFile
+{
+public:
+
+   /**
+    * Map the file placed at given location in given mode. If there is no 
+    * file in given location or it cannot be mapped, a IOException is 
+    * thrown. If no file factory has been activated, a InvalidStateException
+    * is thrown.
+    */
+   MappedFile(const String& location, FileMappingMode mode)
+      throw (IOException, InvalidStateException);
+
+   inline virtual Buffer& buffer()
+   { return _impl->buffer(); }
+
+   inline virtual const Buffer& buffer() const
+   { return _impl->buffer(); }
+
+   /**
+    * Obtain the length of the mapping, that is the file size.
+    */
+   inline unsigned long length() const
+   { return _impl->buffer().length(); }
+
+   inline virtual FileMappingMode mode() const
+   { return _impl->mode(); }
+
+   inline virtual void advise(
+         FileAccessAdvice advice, 
+         unsigned long offset = 0,
+         unsigned long len = 0) throw (IOException)
+   { _impl->advise(advice, offset, len); }
+
+   inline virtual void sync(
+         unsigned long offset = 0, 
+         unsigned long len = 0, 
+         bool wait = true) throw (IOException)
+   { _impl->sync(offset, len, wait); }
+
+   inline virtual void resize(unsigned long length) 
+         throw (IOException, InvalidStateException)
+   { _impl->resize(length); }
+
+private:
+
+   Ptr<AbstractMappedFile> _impl;
+
+};
+
 #if KAREN_COMPILER == KAREN_COMPILER_MSVC
 class FileFactory;
 template class KAREN_EXPORT Ptr<FileFactory>;
@@ -162,7 +506,8 @@ template class KAREN_EXPORT Ptr<FileFactory>;
 
 /**
  * File factory class. This abstract class provides the interface
- * for a factory able to create instances of AbstractFile class. The purpose
+ * for a factory able to create instances of AbstractFile and 
+ * AbstractMappedFile classes. The purpose
  * of this factory is not being used directly by client code, but to configure
  * a concrete implementation for FileFactory that will be used by File class
  * to instantiate a concrete implementation. 
@@ -198,6 +543,33 @@ public:
          const String& location, 
          const FileOpenMode& mode) throw (IOException) = 0;
 
+   /**
+    * Create a concrete implementation of AbstractMappedFile that may be
+    * used by MappedFile class as delegate.
+    */
+   virtual Ptr<AbstractMappedFile> createMappedFile(
+         const String& location,
+         FileMappingMode mode) throw (IOException) = 0;
+
+   /**
+    * Transfer len bytes from src starting at srcOffset into dst starting at
+    * dstOffset, as File::transfer() does. The default implementation reads
+    * and writes blocks of TRANSFER_BLOCK_LENGTH bytes through a user 
+    * buffer. Factories override it to have the kernel move the bytes for
+    * the files they create.
+    */
+   virtual unsigned long transfer(
+         AbstractFile& src, 
+         unsigned long srcOffset,
+         AbstractFile& dst, 
+         unsigned long dstOffset,
+         unsigned long len) throw (IOException);
+
+   /**
+    * The length of the blocks the default transfer implementation uses.
+    */
+   static const unsigned long TRANSFER_BLOCK_LENGTH = 1024 * 1024;
+
 private:
 
    static Ptr<FileFactory> _activeFactory;
@@ -103,6 +103,30 @@ struct GreaterThanOrEquals : BinaryPredicate<Left, Right>
    { return "is greater than or equals to"; }
 };
 
+/**
+ * Default less than functor. Unlike LessThan, this is not a predicate
+ * object but a plain functor with no virtual members, aimed to be used
+ * as comparison parameter of ordered collections.
+ */
+template <typename T>
+struct DefaultLessThan
+{
+   inline bool operator() (const T& lhs, const T& rhs) const
+   { return lhs < rhs; }
+};
+
+/**
+ * Default equals functor. Unlike Equals, this is not a predicate object
+ * but a plain functor with no virtual members, aimed to be used as 
+ * equality parameter of hashed collections.
+ */
+template <typename T>
+struct DefaultEquals
+{
+   inline bool operator() (const T& lhs, const T& rhs) const
+   { return lhs == rhs; }
+};
+
 };
 
 #endif
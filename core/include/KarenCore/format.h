@@ -0,0 +1,386 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_FORMAT_H
+#define KAREN_CORE_FORMAT_H
+
+#include <cstring>
+#include <type_traits>
+
+#include "KarenCore/platform.h"
+
+namespace karen {
+
+template <typename CharType> class StringBase;
+template <typename CharType> class StringViewBase;
+
+typedef StringBase<char> String;
+typedef StringViewBase<char> StringView;
+
+/**
+ * Format argument class. This class provides a type-erased reference to
+ * an argument of a format, so formatting code is compiled once rather than
+ * per argument type. Text arguments are referenced, not copied, so the
+ * argument must not outlive them. 
+ */
+class KAREN_EXPORT FormatArg
+{
+public:
+
+   enum Kind
+   {
+      NONE,
+      SIGNED,
+      UNSIGNED,
+      FLOATING,
+      CHARACTER,
+      BOOLEAN,
+      TEXT,
+      POINTER,
+   };
+
+   Kind kind;
+   union
+   {
+      long long            s;
+      unsigned long long   u;
+      double               d;
+      const void*          p;
+      struct
+      {
+         const char*       str;
+         unsigned long     len;
+      } text;
+   };
+
+   /**
+    * Create a new empty argument, which formats nothing.
+    */
+   inline FormatArg() : kind(NONE), u(0) {}
+
+   template <class T>
+   inline FormatArg(T t, typename std::enable_if<
+         (std::is_integral<T>::value && std::is_signed<T>::value &&
+          !std::is_same<T, char>::value) || 
+         std::is_enum<T>::value>::type* = 0) 
+    : kind(SIGNED), s((long long) t) {}
+
+   template <class T>
+   inline FormatArg(T t, typename std::enable_if<
+         std::is_integral<T>::value && std::is_unsigned<T>::value &&
+         !std::is_same<T, char>::value && 
+         !std::is_same<T, bool>::value>::type* = 0)
+    : kind(UNSIGNED), u(t) {}
+
+   inline FormatArg(char c) : kind(CHARACTER), s(c) {}
+
+   inline FormatArg(bool b) : kind(BOOLEAN), u(b) {}
+
+   inline FormatArg(double d) : kind(FLOATING), d(d) {}
+
+   inline FormatArg(float f) : kind(FLOATING), d(f) {}
+
+   inline FormatArg(long double d) : kind(FLOATING), d((double) d) {}
+
+   inline FormatArg(const char* str) : kind(TEXT)
+   { setText(str, str ? std::strlen(str) : 0); }
+
+   inline FormatArg(char* str) : kind(TEXT)
+   { setText(str, str ? std::strlen(str) : 0); }
+
+   inline FormatArg(const unsigned char* str) : kind(TEXT)
+   { setText((const char*) str, str ? std::strlen((const char*) str) : 0); }
+
+   inline FormatArg(unsigned char* str) : kind(TEXT)
+   { setText((const char*) str, str ? std::strlen((const char*) str) : 0); }
+
+   FormatArg(const String& str);
+
+   FormatArg(const StringView& str);
+
+   template <class T>
+   inline FormatArg(T* p) : kind(POINTER), p(p) {}
+
+private:
+
+   inline void setText(const char* str, unsigned long len)
+   {
+      text.str = str;
+      text.len = len;
+   }
+};
+
+/**
+ * String builder class. This class provides a buffer to build strings by
+ * appending text to it. Its first characters are stored in the builder
+ * itself, so short strings are built without allocating memory, and its
+ * capacity doubles when exhausted. The content is always null-terminated.
+ * A builder may be cleared and reused to keep its capacity. 
+ */
+class KAREN_EXPORT StringBuilder
+{
+public:
+
+   enum { INLINE_CAPACITY = 119 };
+
+   /**
+    * Create a new empty string builder.
+    */
+   inline StringBuilder()
+    : _data(_inline), _length(0), _capacity(INLINE_CAPACITY)
+   { _inline[0] = '\0'; }
+
+   ~StringBuilder();
+
+   StringBuilder(const StringBuilder&) = delete;
+
+   StringBuilder& operator = (const StringBuilder&) = delete;
+
+   /**
+    * Obtain the characters appended so far, followed by a null character.
+    */
+   inline const char* data() const
+   { return _data; }
+
+   /**
+    * Obtain the number of characters appended so far.
+    */
+   inline unsigned long length() const
+   { return _length; }
+
+   /**
+    * Obtain the number of characters that fit without growing the buffer.
+    */
+   inline unsigned long capacity() const
+   { return _capacity; }
+
+   inline bool isEmpty() const
+   { return !_length; }
+
+   /**
+    * Remove every character, keeping the capacity.
+    */
+   inline void clear()
+   { _data[_length = 0] = '\0'; }
+
+   /**
+    * Make room for at least given number of characters.
+    */
+   inline void reserve(unsigned long capacity)
+   {
+      if (capacity > _capacity)
+         grow(capacity);
+   }
+
+   inline StringBuilder& append(char c)
+   {
+      if (_length == _capacity)
+         grow(_length + 1);
+      _data[_length++] = c;
+      _data[_length] = '\0';
+      return *this;
+   }
+
+   /**
+    * Append given character as many times as indicated.
+    */
+   StringBuilder& append(char c, unsigned long count);
+
+   inline StringBuilder& append(const char* str, unsigned long len)
+   {
+      if (_length + len > _capacity)
+         grow(_length + len);
+      std::memcpy(_data + _length, str, len);
+      _length += len;
+      _data[_length] = '\0';
+      return *this;
+   }
+
+   inline StringBuilder& append(const char* str)
+   { return append(str, std::strlen(str)); }
+
+   StringBuilder& append(const StringView& str);
+
+   /**
+    * Append the given format with its conversions replaced by the given 
+    * arguments, as printf() does. The conversion of each argument is
+    * chosen by its type, while the flags, width and precision of the
+    * conversion are honored, so %d prints any integer and %s prints any
+    * argument. Conversions without argument are appended verbatim. Use 
+    * KAREN_FORMAT to check the format against the arguments when 
+    * compiling.
+    */
+   template <class ... Args>
+   inline StringBuilder& appendFormat(const char* format, const Args& ... args)
+   {
+      const FormatArg list[] = { FormatArg(args)..., FormatArg() };
+      return appendFormatArgs(format, list, sizeof...(Args));
+   }
+
+   /**
+    * Append given format with its conversions replaced by the given
+    * type-erased arguments, as appendFormat() does.
+    */
+   StringBuilder& appendFormatArgs(
+         const char* format, const FormatArg* args, unsigned int nargs);
+
+   /**
+    * Obtain a view of the characters appended so far.
+    */
+   StringView view() const;
+
+   /**
+    * Obtain a string with the characters appended so far.
+    */
+   String toString() const;
+
+private:
+
+   char*          _data;
+   unsigned long  _length;
+   unsigned long  _capacity;
+   char           _inline[INLINE_CAPACITY + 1];
+
+   void grow(unsigned long capacity);
+};
+
+/*
+ * Compile time checks of formats. As C++11 requires, each constexpr 
+ * function is a single return statement.
+ */
+
+constexpr bool
+isFormatModifier(char c)
+{
+   return c == '-' || c == '+' || c == ' ' || c == '#' || c == '.' ||
+          (c >= '0' && c <= '9') || c == 'h' || c == 'l' || c == 'L' || 
+          c == 'q' || c == 'j' || c == 'z' || c == 't';
+}
+
+constexpr const char*
+skipFormatModifiers(const char* p)
+{ return isFormatModifier(*p) ? skipFormatModifiers(p + 1) : p; }
+
+/*
+ * Find the conversion character of the next conversion of given format,
+ * or its terminator if there is none.
+ */
+constexpr const char*
+nextFormatConversion(const char* p)
+{
+   return !*p ? p :
+          *p != '%' ? nextFormatConversion(p + 1) :
+          p[1] == '%' ? nextFormatConversion(p + 2) :
+          skipFormatModifiers(p + 1);
+}
+
+constexpr bool
+containsChar(const char* str, char c)
+{ return *str && (*str == c || containsChar(str + 1, c)); }
+
+/*
+ * Conversions accepted by each type of argument. Any argument may be 
+ * printed with %s. 
+ */
+template <class T, class Enable = void>
+struct FormatConversions
+{ static constexpr const char* accepted() { return "s"; } };
+
+template <class T>
+struct FormatConversions<T, typename std::enable_if<
+      std::is_integral<T>::value || std::is_enum<T>::value>::type>
+{ static constexpr const char* accepted() { return "sdiuxXoc"; } };
+
+template <class T>
+struct FormatConversions<T, typename std::enable_if<
+      std::is_floating_point<T>::value>::type>
+{ static constexpr const char* accepted() { return "sfFeEgGaA"; } };
+
+template <class T>
+struct FormatConversions<T*, void>
+{ static constexpr const char* accepted() { return "sp"; } };
+
+template <class ... Args>
+struct FormatChecker;
+
+template <>
+struct FormatChecker<>
+{
+   static constexpr bool accepts(const char* format)
+   { return !*nextFormatConversion(format); }
+};
+
+template <class A, class ... Rest>
+struct FormatChecker<A, Rest...>
+{
+   static constexpr bool accepts(const char* format)
+   {
+      return *nextFormatConversion(format) && 
+             containsChar(
+                  FormatConversions<typename std::decay<A>::type>::accepted(),
+                  *nextFormatConversion(format)) &&
+             FormatChecker<Rest...>::accepts(nextFormatConversion(format) + 1);
+   }
+};
+
+/*
+ * Obtain the checker of given arguments. This is only used in unevaluated
+ * contexts to deduce the types of the arguments.
+ */
+template <class ... Args>
+FormatChecker<Args...> formatChecker(const Args& ... args);
+
+template <bool Valid>
+struct CheckedFormat
+{
+   static_assert(Valid, 
+         "the format conversions do not match the number or type of "
+         "the arguments");
+
+   static constexpr const char* format(const char* format)
+   { return format; }
+};
+
+}; // namespace karen
+
+/**
+ * Obtain given format literal, checking when compiling that it has a
+ * conversion for each of given arguments that fits its type.
+ */
+#define KAREN_CHECKED_FORMAT(fmt, ...) \
+   karen::CheckedFormat<decltype(karen::formatChecker(__VA_ARGS__))::accepts( \
+         fmt)>::format(fmt)
+
+/**
+ * Append given format literal with the given arguments to given string
+ * builder, checking the format against the arguments when compiling. 
+ */
+#define KAREN_FORMAT(builder, fmt, ...) \
+   (builder).appendFormat( \
+         KAREN_CHECKED_FORMAT(fmt, ## __VA_ARGS__), ## __VA_ARGS__)
+
+using karen::FormatArg;
+using karen::StringBuilder;
+
+#endif
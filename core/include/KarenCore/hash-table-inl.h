@@ -0,0 +1,495 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_HASH_TABLE_INL_H
+#define KAREN_CORE_HASH_TABLE_INL_H
+
+#include <cstring>
+#include <new>
+
+#include "KarenCore/hash-table.h"
+
+#if KAREN_COMPILER == KAREN_COMPILER_MSVC
+   #include <intrin.h>
+#endif
+
+namespace karen {
+
+unsigned int
+HashTableBitMask::lowest() const
+{
+#if KAREN_COMPILER == KAREN_COMPILER_MSVC
+   unsigned long pos;
+   _BitScanForward64(&pos, _mask);
+#else
+   unsigned int pos = __builtin_ctzll(_mask);
+#endif
+#ifdef KAREN_HASH_TABLE_HAVE_SSE2
+   return pos;
+#else
+   return pos >> 3;
+#endif
+}
+
+#ifdef KAREN_HASH_TABLE_HAVE_SSE2
+
+HashTableGroup::HashTableGroup(const signed char* ctrl)
+   : _ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)))
+{}
+
+HashTableBitMask
+HashTableGroup::match(signed char h2) const
+{
+   return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl));
+}
+
+HashTableBitMask
+HashTableGroup::matchEmpty() const
+{
+   return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(EMPTY), _ctrl));
+}
+
+HashTableBitMask
+HashTableGroup::matchEmptyOrDeleted() const
+{
+   // EMPTY and DELETED are the only negative values below -1
+   return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), _ctrl));
+}
+
+#else
+
+/*
+ * Portable group matching. The eight control bytes are loaded in a word
+ * and matched with the bit tricks described in "Bit Twiddling Hacks"; 
+ * match() may report false positives on used slots next to a real match,
+ * which are discarded when keys are compared.
+ */
+static const unsigned long long HASH_TABLE_LSBS = 0x0101010101010101ULL;
+static const unsigned long long HASH_TABLE_MSBS = 0x8080808080808080ULL;
+
+HashTableGroup::HashTableGroup(const signed char* ctrl)
+{
+   std::memcpy(&_ctrl, ctrl, sizeof(_ctrl));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+   _ctrl = __builtin_bswap64(_ctrl);
+#endif
+}
+
+HashTableBitMask
+HashTableGroup::match(signed char h2) const
+{
+   unsigned long long x = _ctrl ^ (HASH_TABLE_LSBS * (unsigned char) h2);
+   return (x - HASH_TABLE_LSBS) & ~x & HASH_TABLE_MSBS;
+}
+
+HashTableBitMask
+HashTableGroup::matchEmpty() const
+{ return (_ctrl & (~_ctrl << 6)) & HASH_TABLE_MSBS; }
+
+HashTableBitMask
+HashTableGroup::matchEmptyOrDeleted() const
+{ return (_ctrl & (~_ctrl << 7)) & HASH_TABLE_MSBS; }
+
+#endif
+
+template <class V>
+HashTableIterator<V>::HashTableIterator()
+   : _ctrl(NULL), _slots(NULL), _capacity(0), _index(0)
+{}
+
+template <class V>
+HashTableIterator<V>::HashTableIterator(
+      const signed char* ctrl, 
+      V* slots, 
+      unsigned long capacity,
+      unsigned long index)
+   : _ctrl(ctrl), _slots(slots), _capacity(capacity), _index(index)
+{}
+
+template <class V>
+template <class Other>
+HashTableIterator<V>::HashTableIterator(const HashTableIterator<Other>& it)
+   : _ctrl(it._ctrl), _slots(it._slots), 
+     _capacity(it._capacity), _index(it._index)
+{}
+
+template <class V>
+V&
+HashTableIterator<V>::operator * () const
+{ return _slots[_index]; }
+
+template <class V>
+V*
+HashTableIterator<V>::operator -> () const
+{ return _slots + _index; }
+
+template <class V>
+HashTableIterator<V>&
+HashTableIterator<V>::operator ++ ()
+{
+   do { _index++; } while (_index < _capacity && _ctrl[_index] < 0);
+   return *this;
+}
+
+template <class V>
+HashTableIterator<V>
+HashTableIterator<V>::operator ++ (int)
+{
+   HashTableIterator it(*this);
+   ++(*this);
+   return it;
+}
+
+template <class V>
+HashTableIterator<V>&
+HashTableIterator<V>::operator -- ()
+{
+   do { _index--; } while (_ctrl[_index] < 0);
+   return *this;
+}
+
+template <class V>
+HashTableIterator<V>
+HashTableIterator<V>::operator -- (int)
+{
+   HashTableIterator it(*this);
+   --(*this);
+   return it;
+}
+
+template <class V>
+bool
+HashTableIterator<V>::operator == (const HashTableIterator& it) const
+{ return _index == it._index && _slots == it._slots; }
+
+template <class V>
+bool
+HashTableIterator<V>::operator != (const HashTableIterator& it) const
+{ return !(*this == it); }
+
+template <class V>
+unsigned long
+HashTableIterator<V>::index() const
+{ return _index; }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+HashTable<V, K, KeyOf, Hash, Equals>::HashTable(
+      const Hash& hash, const Equals& equals)
+   : _ctrl(NULL), _slots(NULL), _capacity(0), _size(0), _growthLeft(0),
+     _hash(hash), _equals(equals)
+{}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+HashTable<V, K, KeyOf, Hash, Equals>::HashTable(const HashTable& table)
+   : _ctrl(NULL), _slots(NULL), _capacity(0), _size(0), _growthLeft(0),
+     _hash(table._hash), _equals(table._equals)
+{ *this = table; }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+HashTable<V, K, KeyOf, Hash, Equals>::~HashTable()
+{ destroyAll(); }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+HashTable<V, K, KeyOf, Hash, Equals>&
+HashTable<V, K, KeyOf, Hash, Equals>::operator = (const HashTable& table)
+{
+   if (this != &table)
+   {
+      destroyAll();
+      _hash = table._hash;
+      _equals = table._equals;
+      if (table._capacity)
+      {
+         _ctrl = new signed char[table._capacity];
+         _slots = static_cast<V*>(
+               ::operator new(table._capacity * sizeof(V)));
+         std::memcpy(_ctrl, table._ctrl, table._capacity);
+         for (unsigned long i = 0; i < table._capacity; i++)
+            if (_ctrl[i] >= 0)
+               new (_slots + i) V(table._slots[i]);
+      }
+      _capacity = table._capacity;
+      _size = table._size;
+      _growthLeft = table._growthLeft;
+   }
+   return *this;
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+unsigned long
+HashTable<V, K, KeyOf, Hash, Equals>::size() const
+{ return _size; }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+unsigned long
+HashTable<V, K, KeyOf, Hash, Equals>::capacity() const
+{ return _capacity; }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+void
+HashTable<V, K, KeyOf, Hash, Equals>::clear()
+{
+   if (!_capacity)
+      return;
+   for (unsigned long i = 0; i < _capacity; i++)
+      if (_ctrl[i] >= 0)
+         _slots[i].~V();
+   std::memset(_ctrl, HashTableGroup::EMPTY, _capacity);
+   _size = 0;
+   _growthLeft = maxLoad(_capacity);
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+void
+HashTable<V, K, KeyOf, Hash, Equals>::reserve(unsigned long size)
+{
+   unsigned long capacity = HashTableGroup::WIDTH;
+   while (maxLoad(capacity) < size)
+      capacity *= 2;
+   if (capacity > _capacity)
+      rehash(capacity);
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+typename HashTable<V, K, KeyOf, Hash, Equals>::iterator
+HashTable<V, K, KeyOf, Hash, Equals>::begin()
+{
+   unsigned long i = 0;
+   while (i < _capacity && _ctrl[i] < 0)
+      i++;
+   return iterator(_ctrl, _slots, _capacity, i);
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+typename HashTable<V, K, KeyOf, Hash, Equals>::iterator
+HashTable<V, K, KeyOf, Hash, Equals>::end()
+{ return iterator(_ctrl, _slots, _capacity, _capacity); }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+typename HashTable<V, K, KeyOf, Hash, Equals>::const_iterator
+HashTable<V, K, KeyOf, Hash, Equals>::begin() const
+{ return const_cast<HashTable*>(this)->begin(); }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+typename HashTable<V, K, KeyOf, Hash, Equals>::const_iterator
+HashTable<V, K, KeyOf, Hash, Equals>::end() const
+{ return const_cast<HashTable*>(this)->end(); }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+typename HashTable<V, K, KeyOf, Hash, Equals>::iterator
+HashTable<V, K, KeyOf, Hash, Equals>::find(const K& k)
+{ return iterator(_ctrl, _slots, _capacity, findIndex(k, _hash(k))); }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+typename HashTable<V, K, KeyOf, Hash, Equals>::const_iterator
+HashTable<V, K, KeyOf, Hash, Equals>::find(const K& k) const
+{ return const_cast<HashTable*>(this)->find(k); }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+template <class ... Args>
+std::pair<typename HashTable<V, K, KeyOf, Hash, Equals>::iterator, bool>
+HashTable<V, K, KeyOf, Hash, Equals>::emplace(const K& k, Args&& ... args)
+{
+   unsigned long long h = _hash(k);
+   unsigned long index = findIndex(k, h);
+   if (index != _capacity)
+      return std::make_pair(iterator(_ctrl, _slots, _capacity, index), false);
+
+   if (!_growthLeft)
+   {
+      // args may refer to elements of this table, so the new element is
+      // built before they are relocated
+      V v(std::forward<Args>(args)...);
+      grow();
+      return insertAt(findInsertIndex(h), h, std::move(v));
+   }
+   return insertAt(findInsertIndex(h), h, std::forward<Args>(args)...);
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+typename HashTable<V, K, KeyOf, Hash, Equals>::iterator
+HashTable<V, K, KeyOf, Hash, Equals>::erase(const iterator& it)
+{
+   iterator next(it);
+   ++next;
+   eraseIndex(it.index());
+   return next;
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+bool
+HashTable<V, K, KeyOf, Hash, Equals>::erase(const K& k)
+{
+   unsigned long index = findIndex(k, _hash(k));
+   if (index == _capacity)
+      return false;
+   eraseIndex(index);
+   return true;
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+unsigned long
+HashTable<V, K, KeyOf, Hash, Equals>::maxLoad(unsigned long capacity)
+{ return capacity - capacity / 8; }
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+unsigned long
+HashTable<V, K, KeyOf, Hash, Equals>::findIndex(
+      const K& k, unsigned long long h) const
+{
+   if (!_capacity)
+      return 0;
+   // Groups are probed following triangular numbers, which visit every 
+   // group once when their number is a power of two
+   unsigned long groupMask = _capacity / HashTableGroup::WIDTH - 1;
+   unsigned long group = (unsigned long) (h >> 7) & groupMask;
+   for (unsigned long step = 1; ; step++)
+   {
+      unsigned long base = group * HashTableGroup::WIDTH;
+      HashTableGroup g(_ctrl + base);
+      HashTableBitMask m = g.match((signed char) (h & 0x7f));
+      for (; m; m.clearLowest())
+      {
+         unsigned long index = base + m.lowest();
+         if (_equals(KeyOf()(_slots[index]), k))
+            return index;
+      }
+      if (g.matchEmpty())
+         return _capacity;
+      group = (group + step) & groupMask;
+   }
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+unsigned long
+HashTable<V, K, KeyOf, Hash, Equals>::findInsertIndex(
+      unsigned long long h) const
+{
+   unsigned long groupMask = _capacity / HashTableGroup::WIDTH - 1;
+   unsigned long group = (unsigned long) (h >> 7) & groupMask;
+   for (unsigned long step = 1; ; step++)
+   {
+      unsigned long base = group * HashTableGroup::WIDTH;
+      HashTableBitMask m = HashTableGroup(_ctrl + base).matchEmptyOrDeleted();
+      if (m)
+         return base + m.lowest();
+      group = (group + step) & groupMask;
+   }
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+void
+HashTable<V, K, KeyOf, Hash, Equals>::eraseIndex(unsigned long index)
+{
+   _slots[index].~V();
+   _size--;
+   // If the group still has an empty slot no probe sequence has ever 
+   // gone through it, so the slot may be marked as empty instead of 
+   // leaving a tombstone
+   unsigned long base = index - index % HashTableGroup::WIDTH;
+   if (HashTableGroup(_ctrl + base).matchEmpty())
+   {
+      _ctrl[index] = HashTableGroup::EMPTY;
+      _growthLeft++;
+   }
+   else
+      _ctrl[index] = HashTableGroup::DELETED;
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+template <class ... Args>
+std::pair<typename HashTable<V, K, KeyOf, Hash, Equals>::iterator, bool>
+HashTable<V, K, KeyOf, Hash, Equals>::insertAt(
+      unsigned long index, unsigned long long h, Args&& ... args)
+{
+   new (_slots + index) V(std::forward<Args>(args)...);
+   if (_ctrl[index] == HashTableGroup::EMPTY)
+      _growthLeft--;
+   _ctrl[index] = (signed char) (h & 0x7f);
+   _size++;
+   return std::make_pair(iterator(_ctrl, _slots, _capacity, index), true);
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+void
+HashTable<V, K, KeyOf, Hash, Equals>::grow()
+{
+   // Drop the deleted slots if they take at least half of the load, or
+   // double the capacity otherwise
+   if (_capacity && _size <= maxLoad(_capacity) / 2)
+      rehash(_capacity);
+   else if (_capacity)
+      rehash(_capacity * 2);
+   else
+      rehash(HashTableGroup::WIDTH);
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+void
+HashTable<V, K, KeyOf, Hash, Equals>::rehash(unsigned long capacity)
+{
+   signed char* oldCtrl = _ctrl;
+   V* oldSlots = _slots;
+   unsigned long oldCapacity = _capacity;
+
+   _ctrl = new signed char[capacity];
+   _slots = static_cast<V*>(::operator new(capacity * sizeof(V)));
+   _capacity = capacity;
+   _growthLeft = maxLoad(capacity) - _size;
+   std::memset(_ctrl, HashTableGroup::EMPTY, capacity);
+
+   for (unsigned long i = 0; i < oldCapacity; i++)
+   {
+      if (oldCtrl[i] >= 0)
+      {
+         unsigned long index = findInsertIndex(
+               _hash(KeyOf()(oldSlots[i])));
+         new (_slots + index) V(std::move(oldSlots[i]));
+         _ctrl[index] = oldCtrl[i];
+         oldSlots[i].~V();
+      }
+   }
+   delete[] oldCtrl;
+   ::operator delete(oldSlots);
+}
+
+template <class V, class K, class KeyOf, class Hash, class Equals>
+void
+HashTable<V, K, KeyOf, Hash, Equals>::destroyAll()
+{
+   for (unsigned long i = 0; i < _capacity; i++)
+      if (_ctrl[i] >= 0)
+         _slots[i].~V();
+   delete[] _ctrl;
+   ::operator delete(_slots);
+   _ctrl = NULL;
+   _slots = NULL;
+   _capacity = 0;
+   _size = 0;
+   _growthLeft = 0;
+}
+
+}
+
+#endif
@@ -0,0 +1,311 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_HASH_TABLE_H
+#define KAREN_CORE_HASH_TABLE_H
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "KarenCore/first-class.h"
+#include "KarenCore/hash.h"
+#include "KarenCore/platform.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+   #define KAREN_HASH_TABLE_HAVE_SSE2
+   #include <emmintrin.h>
+#endif
+
+namespace karen {
+
+/**
+ * Hash table bit mask class. This class represents the set of slots of a
+ * HashTableGroup that matched some condition, as a bit mask that may be
+ * iterated from the lowest slot to the highest one.
+ */
+class HashTableBitMask
+{
+public:
+
+#ifdef KAREN_HASH_TABLE_HAVE_SSE2
+   typedef unsigned int Mask;
+#else
+   typedef unsigned long long Mask;
+#endif
+
+   inline HashTableBitMask(Mask mask) : _mask(mask) {}
+
+   /**
+    * Check whether any slot matched. 
+    */
+   inline operator bool () const
+   { return _mask != 0; }
+
+   /**
+    * Obtain the position in the group of the lowest matching slot.
+    */
+   inline unsigned int lowest() const;
+
+   /**
+    * Remove the lowest matching slot from the mask.
+    */
+   inline void clearLowest()
+   { _mask &= _mask - 1; }
+
+private:
+
+   Mask _mask;
+
+};
+
+/**
+ * Hash table group class. This class provides the probing operations over
+ * a group of consecutive control bytes of a HashTable. Each control byte
+ * is either EMPTY, DELETED or the seven lower bits of the hash of the 
+ * element stored in its slot. When SSE2 is available a group spans 16 
+ * control bytes that are matched at once with vector instructions; 
+ * otherwise it spans 8 bytes that are matched with word arithmetic.
+ */
+class HashTableGroup
+{
+public:
+
+   /**
+    * Control byte values for slots without element.
+    */
+   enum
+   {
+      EMPTY   = -128,
+      DELETED = -2,
+   };
+
+#ifdef KAREN_HASH_TABLE_HAVE_SSE2
+   enum { WIDTH = 16 };
+#else
+   enum { WIDTH = 8 };
+#endif
+
+   /**
+    * Load the group starting at given control byte.
+    */
+   inline HashTableGroup(const signed char* ctrl);
+
+   /**
+    * Match the slots whose control byte is given hash fragment.
+    */
+   inline HashTableBitMask match(signed char h2) const;
+
+   /**
+    * Match the empty slots.
+    */
+   inline HashTableBitMask matchEmpty() const;
+
+   /**
+    * Match the empty and deleted slots.
+    */
+   inline HashTableBitMask matchEmptyOrDeleted() const;
+
+private:
+
+#ifdef KAREN_HASH_TABLE_HAVE_SSE2
+   __m128i _ctrl;
+#else
+   unsigned long long _ctrl;
+#endif
+
+};
+
+/**
+ * Hash table iterator template class. This class provides a bidirectional,
+ * STL-compatible iterator over the occupied slots of a HashTable. It is
+ * instantiated with a const-qualified value type for constant iteration.
+ */
+template <class V>
+class HashTableIterator
+{
+public:
+
+   typedef std::bidirectional_iterator_tag iterator_category;
+   typedef typename std::remove_const<V>::type value_type;
+   typedef long difference_type;
+   typedef V* pointer;
+   typedef V& reference;
+
+   inline HashTableIterator();
+
+   inline HashTableIterator(const signed char* ctrl, 
+                            V* slots, 
+                            unsigned long capacity,
+                            unsigned long index);
+
+   /**
+    * Create a constant iterator from a non-constant one.
+    */
+   template <class Other>
+   inline HashTableIterator(const HashTableIterator<Other>& it);
+
+   inline V& operator * () const;
+
+   inline V* operator -> () const;
+
+   inline HashTableIterator& operator ++ ();
+
+   inline HashTableIterator operator ++ (int);
+
+   inline HashTableIterator& operator -- ();
+
+   inline HashTableIterator operator -- (int);
+
+   inline bool operator == (const HashTableIterator& it) const;
+
+   inline bool operator != (const HashTableIterator& it) const;
+
+   /**
+    * Obtain the index of the slot this iterator points to.
+    */
+   inline unsigned long index() const;
+
+private:
+
+   template <class Other>
+   friend class HashTableIterator;
+
+   const signed char*   _ctrl;
+   V*                   _slots;
+   unsigned long        _capacity;
+   unsigned long        _index;
+
+};
+
+/**
+ * Hash table template class. This class implements a flat, open-addressing
+ * hash table in the manner of Swiss tables. Elements are stored inline in
+ * a slot array, and a parallel array of one-byte control words records 
+ * which slots are used plus seven bits of their hash. Lookups probe whole
+ * groups of control bytes at once, so most of them touch one group and
+ * compare one key. Capacity is always a power of two and the table grows
+ * when 7/8 of the slots are used. 
+ *
+ * This is not aimed to be used directly but as the implementation of
+ * HashMap and HashSet. V is the type of the stored elements and K the
+ * type of their keys, which are obtained from the elements by KeyOf. 
+ */
+template <class V, class K, class KeyOf, class Hash, class Equals>
+class HashTable
+{
+public:
+
+   typedef HashTableIterator<V> iterator;
+   typedef HashTableIterator<const V> const_iterator;
+
+   inline HashTable(const Hash& hash = Hash(), 
+                    const Equals& equals = Equals());
+
+   inline HashTable(const HashTable& table);
+
+   inline ~HashTable();
+
+   inline HashTable& operator = (const HashTable& table);
+
+   inline unsigned long size() const;
+
+   inline unsigned long capacity() const;
+
+   inline void clear();
+
+   /**
+    * Ensure the table may hold given number of elements without growing.
+    */
+   inline void reserve(unsigned long size);
+
+   inline iterator begin();
+
+   inline iterator end();
+
+   inline const_iterator begin() const;
+
+   inline const_iterator end() const;
+
+   inline iterator find(const K& k);
+
+   inline const_iterator find(const K& k) const;
+
+   /**
+    * Insert an element with given key constructing it from given args if 
+    * there is no element with such key yet. It returns an iterator to the 
+    * element with that key and whether it was inserted. 
+    */
+   template <class ... Args>
+   inline std::pair<iterator, bool> emplace(const K& k, Args&& ... args);
+
+   /**
+    * Remove the element pointed by given iterator. It returns an iterator
+    * to the next element.
+    */
+   inline iterator erase(const iterator& it);
+
+   /**
+    * Remove the element with given key, if any. It returns whether some
+    * element was removed.
+    */
+   inline bool erase(const K& k);
+
+private:
+
+   signed char*   _ctrl;
+   V*             _slots;
+   unsigned long  _capacity;
+   unsigned long  _size;
+   unsigned long  _growthLeft;
+   Hash           _hash;
+   Equals         _equals;
+
+   inline static unsigned long maxLoad(unsigned long capacity);
+
+   inline unsigned long findIndex(const K& k, unsigned long long h) const;
+
+   inline unsigned long findInsertIndex(unsigned long long h) const;
+
+   template <class ... Args>
+   inline std::pair<iterator, bool> insertAt(unsigned long index,
+                                             unsigned long long h,
+                                             Args&& ... args);
+
+   inline void eraseIndex(unsigned long index);
+
+   inline void grow();
+
+   inline void rehash(unsigned long capacity);
+
+   inline void destroyAll();
+
+};
+
+}
+
+#include "KarenCore/hash-table-inl.h"
+
+#endif
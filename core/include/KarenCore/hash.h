@@ -0,0 +1,129 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_HASH_H
+#define KAREN_CORE_HASH_H
+
+#include <cstdint>
+#include <type_traits>
+
+#include "KarenCore/platform.h"
+#include "KarenCore/pointer.h"
+#include "KarenCore/string.h"
+
+namespace karen {
+
+/**
+ * Mix the bits of given value. This is the finalizer of MurmurHash3, 
+ * which spreads every input bit over the whole result. It is used by
+ * hash functors to produce values whose low and high bits are equally
+ * random, as required by HashTable.
+ */
+inline unsigned long long hashMix(unsigned long long x)
+{
+   x ^= x >> 33;
+   x *= 0xff51afd7ed558ccdULL;
+   x ^= x >> 33;
+   x *= 0xc4ceb53a185e9a87ULL;
+   x ^= x >> 33;
+   return x;
+}
+
+/**
+ * Default hash functor. This template class provides the hash function
+ * used by hashed collections when no other is given. It is specialized
+ * for integers, enumerations, pointers, smart pointers and strings. 
+ * Other types must either specialize it or provide their own functor 
+ * to the collection. 
+ */
+template <typename T, typename Enable = void>
+struct DefaultHash;
+
+/**
+ * Default hash functor for integer and enumeration types.
+ */
+template <typename T>
+struct DefaultHash<T, typename std::enable_if<
+      std::is_integral<T>::value || std::is_enum<T>::value>::type>
+{
+   inline unsigned long long operator() (T t) const
+   { return hashMix((unsigned long long) t); }
+};
+
+/**
+ * Default hash functor for raw pointers. Pointers are hashed by address.
+ */
+template <typename T>
+struct DefaultHash<T*, void>
+{
+   inline unsigned long long operator() (const T* t) const
+   { return hashMix((unsigned long long) reinterpret_cast<std::uintptr_t>(t)); }
+};
+
+/**
+ * Default hash functor for smart pointers. Pointers are hashed by the
+ * address of the referenced object.
+ */
+template <typename T, class Counting>
+struct DefaultHash<Ptr<T, Counting>, void>
+{
+   inline unsigned long long operator() (const Ptr<T, Counting>& t) const
+   { return DefaultHash<T*>()(static_cast<T*>(t)); }
+};
+
+/**
+ * Default hash functor for string views. Views are hashed with FNV-1a.
+ */
+template <typename CharType>
+struct DefaultHash<StringViewBase<CharType>, void>
+{
+   inline unsigned long long operator() (
+         const StringViewBase<CharType>& t) const
+   {
+      const CharType* str = t.data();
+      unsigned long len = t.length();
+      unsigned long long h = 0xcbf29ce484222325ULL;
+      for (unsigned long i = 0; i < len; i++)
+      {
+         h ^= (unsigned long long) str[i];
+         h *= 0x100000001b3ULL;
+      }
+      return hashMix(h);
+   }
+};
+
+/**
+ * Default hash functor for strings. Strings are hashed as the view of
+ * their characters, so a string and a view of it have the same hash.
+ */
+template <typename CharType>
+struct DefaultHash<StringBase<CharType>, void>
+{
+   inline unsigned long long operator() (const StringBase<CharType>& t) const
+   { return DefaultHash<StringViewBase<CharType> >()(t.view()); }
+};
+
+}
+
+#endif
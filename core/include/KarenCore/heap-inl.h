@@ -0,0 +1,461 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_HEAP_INL_H
+#define KAREN_CORE_HEAP_INL_H
+
+#include "KarenCore/heap.h"
+
+namespace karen {
+
+template <class T, class Compare, unsigned int Arity>
+DaryHeap<T, Compare, Arity>::DaryHeap(const Compare& cmp)
+ : _cmp(cmp)
+{
+}
+
+template <class T, class Compare, unsigned int Arity>
+DaryHeap<T, Compare, Arity>::DaryHeap(
+      const T* elems, unsigned long nelems, const Compare& cmp)
+ : _cmp(cmp)
+{ heapify(elems, nelems); }
+
+template <class T, class Compare, unsigned int Arity>
+unsigned long
+DaryHeap<T, Compare, Arity>::size() const
+{ return _heap.size(); }
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::clear()
+{
+   _heap.clear();
+   _handles.clear();
+   _positions.clear();
+   _freeHandles.clear();
+}
+
+template <class T, class Compare, unsigned int Arity>
+Iterator<const T>
+DaryHeap<T, Compare, Arity>::begin() const
+{
+   Ptr<AbstractIterator<const T> > it = new DaryHeapIterator(
+         *this, fastBegin(), fastEnd());
+   return Iterator<const T>(it);
+}
+
+template <class T, class Compare, unsigned int Arity>
+Iterator<const T>
+DaryHeap<T, Compare, Arity>::end() const
+{
+   Ptr<AbstractIterator<const T> > it = new DaryHeapIterator(
+         *this, fastEnd(), fastEnd());
+   return Iterator<const T>(it);
+}
+
+template <class T, class Compare, unsigned int Arity>
+Iterator<const T>
+DaryHeap<T, Compare, Arity>::begin()
+{ return static_cast<const DaryHeap*>(this)->begin(); }
+
+template <class T, class Compare, unsigned int Arity>
+Iterator<const T>
+DaryHeap<T, Compare, Arity>::end()
+{ return static_cast<const DaryHeap*>(this)->end(); }
+
+template <class T, class Compare, unsigned int Arity>
+Iterator<const T>
+DaryHeap<T, Compare, Arity>::rbegin() const
+{
+   Ptr<AbstractIterator<const T> > it = new DaryHeapReverseIterator(
+         *this, 
+         std::reverse_iterator<const T*>(fastEnd()), 
+         std::reverse_iterator<const T*>(fastBegin()));
+   return Iterator<const T>(it);
+}
+
+template <class T, class Compare, unsigned int Arity>
+Iterator<const T>
+DaryHeap<T, Compare, Arity>::rend() const
+{
+   Ptr<AbstractIterator<const T> > it = new DaryHeapReverseIterator(
+         *this, 
+         std::reverse_iterator<const T*>(fastBegin()), 
+         std::reverse_iterator<const T*>(fastBegin()));
+   return Iterator<const T>(it);
+}
+
+template <class T, class Compare, unsigned int Arity>
+Iterator<const T>
+DaryHeap<T, Compare, Arity>::rbegin()
+{ return static_cast<const DaryHeap*>(this)->rbegin(); }
+
+template <class T, class Compare, unsigned int Arity>
+Iterator<const T>
+DaryHeap<T, Compare, Arity>::rend()
+{ return static_cast<const DaryHeap*>(this)->rend(); }
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::remove(Iterator<const T>& it)
+{
+   Iterator<const T> itCopy = it;
+   DaryHeapIterator *nit = itCopy.template impl<DaryHeapIterator>();
+   DaryHeapReverseIterator *nrit = 
+         itCopy.template impl<DaryHeapReverseIterator>();
+   if (nit && (nit->collection() == this))
+   {
+      unsigned long pos = nit->impl() - data();
+      removeAt(pos);
+      Ptr<AbstractIterator<const T> > next = new DaryHeapIterator(
+            *this, fastBegin() + pos, fastEnd());
+      it = Iterator<const T>(next);
+   }
+   else if (nrit && (nrit->collection() == this))
+   {
+      unsigned long pos = (nrit->impl().base() - data()) - 1;
+      removeAt(pos);
+      Ptr<AbstractIterator<const T> > next = new DaryHeapReverseIterator(
+            *this, 
+            std::reverse_iterator<const T*>(fastBegin() + pos), 
+            std::reverse_iterator<const T*>(fastBegin()));
+      it = Iterator<const T>(next);
+   }
+   else
+      KAREN_THROW(InvalidInputException, 
+            "cannot remove element from heap from given iterator:"
+            " the iterator does not belongs to this collection");
+}
+
+template <class T, class Compare, unsigned int Arity>
+typename DaryHeap<T, Compare, Arity>::Handle
+DaryHeap<T, Compare, Arity>::insert(const T& t)
+{ return push(t); }
+
+template <class T, class Compare, unsigned int Arity>
+typename DaryHeap<T, Compare, Arity>::Handle
+DaryHeap<T, Compare, Arity>::insert(T&& t)
+{ return push(std::move(t)); }
+
+template <class T, class Compare, unsigned int Arity>
+template <class ... Args>
+typename DaryHeap<T, Compare, Arity>::Handle
+DaryHeap<T, Compare, Arity>::emplace(Args&& ... args)
+{
+   Handle h = newHandle();
+   _heap.emplace_back(std::forward<Args>(args)...);
+   _handles.push_back(h);
+   _positions[h] = _heap.size() - 1;
+   siftUp(_heap.size() - 1);
+   return h;
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::removeAll(const T& t)
+{
+   // Compact the remaining elements at the front of the array and then
+   // rebuild the heap from scratch, which is linear no matter how many
+   // elements are removed
+   unsigned long n = _heap.size();
+   unsigned long kept = 0;
+   for (unsigned long i = 0; i < n; i++)
+   {
+      if (!_cmp(_heap[i], t) && !_cmp(t, _heap[i]))
+      {
+         _positions[_handles[i]] = vacant();
+         _freeHandles.push_back(_handles[i]);
+      }
+      else
+      {
+         if (kept != i)
+            place(kept, std::move(_heap[i]), _handles[i]);
+         kept++;
+      }
+   }
+   if (kept == n)
+      return;
+   _heap.erase(_heap.begin() + kept, _heap.end());
+   _handles.resize(kept);
+   build();
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::heapify(const T* elems, unsigned long nelems)
+{
+   clear();
+   _heap.assign(elems, elems + nelems);
+   _handles.resize(nelems);
+   _positions.resize(nelems);
+   for (unsigned long i = 0; i < nelems; i++)
+   {
+      _handles[i] = i;
+      _positions[i] = i;
+   }
+   build();
+}
+
+template <class T, class Compare, unsigned int Arity>
+const T&
+DaryHeap<T, Compare, Arity>::last() const
+throw (NotFoundException)
+{
+   if (_heap.empty())
+      KAREN_THROW(NotFoundException, 
+            "cannot obtain last element of empty heap");
+   return _heap.front();
+}
+
+template <class T, class Compare, unsigned int Arity>
+T
+DaryHeap<T, Compare, Arity>::takeLast()
+throw (NotFoundException)
+{
+   if (_heap.empty())
+      KAREN_THROW(NotFoundException, 
+            "cannot take last element of empty heap");
+   // The top is removed right after being moved from, so the heap never 
+   // compares the moved-from element
+   T t(std::move(_heap.front()));
+   removeAt(0);
+   return t;
+}
+
+template <class T, class Compare, unsigned int Arity>
+bool
+DaryHeap<T, Compare, Arity>::contains(Handle h) const
+{ return h < _positions.size() && _positions[h] != vacant(); }
+
+template <class T, class Compare, unsigned int Arity>
+const T&
+DaryHeap<T, Compare, Arity>::get(Handle h) const
+throw (NotFoundException)
+{ return _heap[positionOf(h)]; }
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::update(Handle h, const T& t)
+throw (NotFoundException)
+{
+   unsigned long pos = positionOf(h);
+   _heap[pos] = t;
+   restore(pos);
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::update(Handle h, T&& t)
+throw (NotFoundException)
+{
+   unsigned long pos = positionOf(h);
+   _heap[pos] = std::move(t);
+   restore(pos);
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::decreaseKey(Handle h, const T& t)
+throw (NotFoundException, InvalidInputException)
+{
+   unsigned long pos = positionOf(h);
+   if (_cmp(_heap[pos], t))
+      KAREN_THROW(InvalidInputException, 
+            "cannot decrease key of heap element: "
+            "new value is greater than the former one");
+   _heap[pos] = t;
+   siftDown(pos);
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::increaseKey(Handle h, const T& t)
+throw (NotFoundException, InvalidInputException)
+{
+   unsigned long pos = positionOf(h);
+   if (_cmp(t, _heap[pos]))
+      KAREN_THROW(InvalidInputException, 
+            "cannot increase key of heap element: "
+            "new value is less than the former one");
+   _heap[pos] = t;
+   siftUp(pos);
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::remove(Handle h)
+throw (NotFoundException)
+{ removeAt(positionOf(h)); }
+
+template <class T, class Compare, unsigned int Arity>
+typename DaryHeap<T, Compare, Arity>::ConstFastIterator
+DaryHeap<T, Compare, Arity>::fastBegin() const
+{ return data(); }
+
+template <class T, class Compare, unsigned int Arity>
+typename DaryHeap<T, Compare, Arity>::ConstFastIterator
+DaryHeap<T, Compare, Arity>::fastEnd() const
+{ return data() + _heap.size(); }
+
+template <class T, class Compare, unsigned int Arity>
+FastRange<typename DaryHeap<T, Compare, Arity>::ConstFastIterator>
+DaryHeap<T, Compare, Arity>::fast() const
+{ return FastRange<ConstFastIterator>(fastBegin(), fastEnd()); }
+
+template <class T, class Compare, unsigned int Arity>
+const T*
+DaryHeap<T, Compare, Arity>::data() const
+{ return _heap.empty() ? NULL : &_heap.front(); }
+
+template <class T, class Compare, unsigned int Arity>
+typename DaryHeap<T, Compare, Arity>::Handle
+DaryHeap<T, Compare, Arity>::newHandle()
+{
+   if (_freeHandles.empty())
+   {
+      _positions.push_back(vacant());
+      return _positions.size() - 1;
+   }
+   Handle h = _freeHandles.back();
+   _freeHandles.pop_back();
+   return h;
+}
+
+template <class T, class Compare, unsigned int Arity>
+unsigned long
+DaryHeap<T, Compare, Arity>::positionOf(Handle h) const
+throw (NotFoundException)
+{
+   if (!contains(h))
+      KAREN_THROW(NotFoundException, 
+            "cannot find heap element for handle %lu", h);
+   return _positions[h];
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::place(unsigned long pos, T&& t, Handle h)
+{
+   _heap[pos] = std::move(t);
+   _handles[pos] = h;
+   _positions[h] = pos;
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::siftUp(unsigned long pos)
+{
+   // The element is kept aside while its ancestors are moved down into
+   // the hole, so each level costs a single move instead of a swap
+   T t(std::move(_heap[pos]));
+   Handle h = _handles[pos];
+   while (pos > 0)
+   {
+      unsigned long parent = (pos - 1) / Arity;
+      if (!_cmp(_heap[parent], t))
+         break;
+      place(pos, std::move(_heap[parent]), _handles[parent]);
+      pos = parent;
+   }
+   place(pos, std::move(t), h);
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::siftDown(unsigned long pos)
+{
+   unsigned long n = _heap.size();
+   T t(std::move(_heap[pos]));
+   Handle h = _handles[pos];
+   for (;;)
+   {
+      unsigned long first = pos * Arity + 1;
+      if (first >= n)
+         break;
+      unsigned long last = (first + Arity < n) ? first + Arity : n;
+      unsigned long greatest = first;
+      for (unsigned long child = first + 1; child < last; child++)
+         if (_cmp(_heap[greatest], _heap[child]))
+            greatest = child;
+      if (!_cmp(t, _heap[greatest]))
+         break;
+      place(pos, std::move(_heap[greatest]), _handles[greatest]);
+      pos = greatest;
+   }
+   place(pos, std::move(t), h);
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::restore(unsigned long pos)
+{
+   if (pos > 0 && _cmp(_heap[(pos - 1) / Arity], _heap[pos]))
+      siftUp(pos);
+   else
+      siftDown(pos);
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::removeAt(unsigned long pos)
+{
+   Handle h = _handles[pos];
+   unsigned long last = _heap.size() - 1;
+   if (pos != last)
+      place(pos, std::move(_heap[last]), _handles[last]);
+   _heap.pop_back();
+   _handles.pop_back();
+   _positions[h] = vacant();
+   _freeHandles.push_back(h);
+   if (pos != last)
+      restore(pos);
+}
+
+template <class T, class Compare, unsigned int Arity>
+void
+DaryHeap<T, Compare, Arity>::build()
+{
+   unsigned long n = _heap.size();
+   if (n < 2)
+      return;
+   for (unsigned long pos = (n - 2) / Arity + 1; pos > 0; pos--)
+      siftDown(pos - 1);
+}
+
+template <class T, class Compare, unsigned int Arity>
+template <class Value>
+typename DaryHeap<T, Compare, Arity>::Handle
+DaryHeap<T, Compare, Arity>::push(Value&& t)
+{
+   Handle h = newHandle();
+   _heap.push_back(std::forward<Value>(t));
+   _handles.push_back(h);
+   _positions[h] = _heap.size() - 1;
+   siftUp(_heap.size() - 1);
+   return h;
+}
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_HEAP_H
+#define KAREN_CORE_HEAP_H
+
+#include <vector>
+
+#include "KarenCore/collection.h"
+
+namespace karen {
+
+/**
+ * D-ary heap template class. This class implements a priority collection
+ * as an implicit Arity-ary heap stored in a contiguous array, so inserting
+ * and removing elements never allocates once the array has grown enough.
+ * The greatest element according to Compare is kept at the top of the 
+ * heap, which makes it a suitable backend for PriorityQueue.
+ *
+ * Each inserted element is identified by a handle that remains valid 
+ * until the element leaves the heap, no matter how it is moved around by
+ * later operations. Handles may be used to access, update or remove their
+ * elements in logarithmic time. Once an element is removed, its handle 
+ * may be reused for a new element. 
+ *
+ * Iterating the heap visits its elements in array order, which is not 
+ * sorted except for the top element, visited first by begin().
+ */
+template <class T, class Compare = DefaultLessThan<T>, unsigned int Arity = 4>
+class DaryHeap : public Collection<const T>
+{
+public:
+
+   /**
+    * Handle type. Handles are dense small integers, so they may be used
+    * as indices into arrays of data associated to the elements. 
+    */
+   typedef unsigned long Handle;
+
+   inline DaryHeap(const Compare& cmp = Compare());
+
+   /**
+    * Create a new heap from given array of elements. The heap is built
+    * in linear time. The element at position i of the array receives 
+    * handle i. 
+    */
+   inline DaryHeap(const T* elems, unsigned long nelems, 
+                   const Compare& cmp = Compare());
+
+   inline virtual unsigned long size() const;
+   
+   inline void clear();
+
+   inline virtual Iterator<const T> begin();
+   
+   inline virtual Iterator<const T> end();
+
+   inline virtual Iterator<const T> begin() const;
+   
+   inline virtual Iterator<const T> end() const;
+
+   inline virtual Iterator<const T> rbegin();
+   
+   inline virtual Iterator<const T> rend();
+
+   inline virtual Iterator<const T> rbegin() const;
+   
+   inline virtual Iterator<const T> rend() const;
+
+   /**
+    * Remove the element pointed by given iterator. Since the heap is 
+    * reorganized after the removal, the iterator is updated to the same
+    * array position but an iteration that removes elements may visit
+    * some of the remaining ones twice or skip them. 
+    */
+   inline void remove(Iterator<const T>& it);
+
+   /**
+    * Insert a new element in the heap, returning its handle. 
+    */
+   inline Handle insert(const T& t);
+
+   /**
+    * Insert a new element in the heap by moving it, returning its handle.
+    */
+   inline Handle insert(T&& t);
+
+   /**
+    * Insert a new element in the heap constructing it in place from 
+    * given arguments, returning its handle. 
+    */
+   template <class ... Args>
+   inline Handle emplace(Args&& ... args);
+
+   /**
+    * Remove all elements equivalent to given one according to Compare.
+    * This takes linear time. 
+    */
+   inline void removeAll(const T& t);
+
+   /**
+    * Replace the contents of the heap by given array of elements. The 
+    * heap is built in linear time. The element at position i of the
+    * array receives handle i. 
+    */
+   inline void heapify(const T* elems, unsigned long nelems);
+
+   /**
+    * Obtain the greatest element of the heap, or throw a NotFoundException
+    * if the heap is empty. 
+    */
+   inline const T& last() const throw (NotFoundException);
+
+   /**
+    * Remove the greatest element of the heap and return it, or throw a 
+    * NotFoundException if the heap is empty. The element is moved out of
+    * the heap rather than copied. 
+    */
+   inline T takeLast() throw (NotFoundException);
+
+   /**
+    * Check whether given handle identifies an element of the heap. 
+    */
+   inline bool contains(Handle h) const;
+
+   /**
+    * Obtain the element identified by given handle, or throw a 
+    * NotFoundException if there is no such element. 
+    */
+   inline const T& get(Handle h) const throw (NotFoundException);
+
+   /**
+    * Replace the element identified by given handle with a new value, or
+    * throw a NotFoundException if there is no such element. The new value
+    * may compare in any way with the former one. 
+    */
+   inline void update(Handle h, const T& t) throw (NotFoundException);
+
+   /**
+    * Replace the element identified by given handle by moving a new value,
+    * or throw a NotFoundException if there is no such element.
+    */
+   inline void update(Handle h, T&& t) throw (NotFoundException);
+
+   /**
+    * Replace the element identified by given handle with a value that is
+    * not greater than the former one. This is cheaper than update(), as
+    * the element only needs to be moved towards the bottom of the heap. 
+    * It throws a NotFoundException if there is no such element, or an 
+    * InvalidInputException if the new value is greater than the former 
+    * one. 
+    */
+   inline void decreaseKey(Handle h, const T& t) 
+         throw (NotFoundException, InvalidInputException);
+
+   /**
+    * Replace the element identified by given handle with a value that is
+    * not less than the former one, moving it towards the top of the heap.
+    * It throws a NotFoundException if there is no such element, or an 
+    * InvalidInputException if the new value is less than the former one.
+    */
+   inline void increaseKey(Handle h, const T& t) 
+         throw (NotFoundException, InvalidInputException);
+
+   /**
+    * Remove the element identified by given handle, or throw a 
+    * NotFoundException if there is no such element. 
+    */
+   inline void remove(Handle h) throw (NotFoundException);
+
+   /**
+    * Fast iterator type. See FastRange for details. Elements are visited
+    * in array order. 
+    */
+   typedef const T* ConstFastIterator;
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<ConstFastIterator> fast() const;
+
+private:
+
+   typedef IteratorImpl<T, DaryHeap, const T*> DaryHeapIterator;
+
+   typedef IteratorImpl<T, DaryHeap, 
+         std::reverse_iterator<const T*> > DaryHeapReverseIterator;
+
+   /**
+    * Value of the position table for handles not in use.
+    */
+   static inline unsigned long vacant()
+   { return ~0ul; }
+
+   std::vector<T>             _heap;
+   std::vector<Handle>        _handles;
+   std::vector<unsigned long> _positions;
+   std::vector<Handle>        _freeHandles;
+   Compare                    _cmp;
+
+   inline const T* data() const;
+
+   inline Handle newHandle();
+
+   inline unsigned long positionOf(Handle h) const 
+         throw (NotFoundException);
+
+   inline void place(unsigned long pos, T&& t, Handle h);
+
+   inline void siftUp(unsigned long pos);
+
+   inline void siftDown(unsigned long pos);
+
+   inline void restore(unsigned long pos);
+
+   inline void removeAt(unsigned long pos);
+
+   inline void build();
+
+   template <class Value>
+   inline Handle push(Value&& t);
+
+};
+
+}
+
+#include "KarenCore/heap-inl.h"
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_IO_ENGINE_POOL_H
+#define KAREN_CORE_IO_ENGINE_POOL_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "KarenCore/concurrent-queue.h"
+#include "KarenCore/io-engine.h"
+
+namespace karen {
+
+/**
+ * Thread pool I/O engine class. This class provides a portable 
+ * implementation of IoEngine. Submitted requests are performed by a pool
+ * of worker threads with the blocking readAt() and writeAt() methods of 
+ * the file, which do not share a file position. It should never been used
+ * directly. Use IoEngine::create() instead.
+ */
+class ThreadPoolIoEngine : public IoEngine
+{
+public:
+
+   /**
+    * Create a new engine with given options, starting its worker threads.
+    */
+   ThreadPoolIoEngine(const IoEngineOptions& options);
+
+   /**
+    * Complete the pending requests and stop the worker threads.
+    */
+   virtual ~ThreadPoolIoEngine();
+
+   inline virtual const char* name() const
+   { return "thread-pool"; }
+
+   virtual Ptr<AbstractFile> open(
+         const String& location, 
+         const FileOpenMode& mode) throw (IOException);
+
+   virtual void enqueue(const IoRequest& request) throw (IOException);
+
+   virtual unsigned int submit() throw (IOException);
+
+   virtual void drain() throw (IOException);
+
+   inline virtual void registerBuffers(const IoVec*, unsigned int) 
+         throw (IOException) {}
+
+   inline virtual void unregisterBuffers() throw (IOException) {}
+
+private:
+
+   ConcurrentQueue<IoRequest>    _submitted;
+   std::vector<IoRequest>        _queued;
+   std::vector<std::thread>      _workers;
+   std::mutex                    _mutex;
+   std::condition_variable       _cond;
+   unsigned int                  _queueDepth;
+   unsigned int                  _pending;
+
+   void work();
+
+   /* Must be called with the engine mutex held. */
+   unsigned int submitQueued();
+
+};
+
+}; // namespace karen
+
+#endif
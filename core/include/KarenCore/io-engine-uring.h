@@ -0,0 +1,144 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_IO_ENGINE_URING_H
+#define KAREN_CORE_IO_ENGINE_URING_H
+
+#include "KarenCore/platform.h"
+
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "KarenCore/io-engine.h"
+
+// Pre-declarations
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace karen {
+
+/**
+ * Linux io_uring I/O engine class. This class provides an implementation
+ * of IoEngine that passes requests to the kernel through the submission
+ * ring of an io_uring instance, and reaps their completions from its 
+ * completion ring in a dedicated thread. A whole batch of requests costs 
+ * a single system call. It should never been used directly. Use 
+ * IoEngine::create() instead.
+ */
+class UringIoEngine : public IoEngine
+{
+public:
+
+   /**
+    * Create a new engine with given options. If the kernel does not 
+    * support io_uring, a IOException is thrown. 
+    */
+   UringIoEngine(const IoEngineOptions& options) throw (IOException);
+
+   /**
+    * Complete the pending requests and release the rings.
+    */
+   virtual ~UringIoEngine();
+
+   inline virtual const char* name() const
+   { return "io_uring"; }
+
+   virtual Ptr<AbstractFile> open(
+         const String& location, 
+         const FileOpenMode& mode) throw (IOException);
+
+   virtual void enqueue(const IoRequest& request) throw (IOException);
+
+   virtual unsigned int submit() throw (IOException);
+
+   virtual void drain() throw (IOException);
+
+   virtual void registerBuffers(const IoVec* vecs, unsigned int count) 
+         throw (IOException);
+
+   virtual void unregisterBuffers() throw (IOException);
+
+private:
+
+   int                        _ring;
+   void*                      _sqRing;
+   unsigned long              _sqRingLength;
+   void*                      _cqRing;
+   unsigned long              _cqRingLength;
+   io_uring_sqe*              _sqes;
+   unsigned long              _sqesLength;
+
+   unsigned int*              _sqTail;
+   unsigned int               _sqLocalTail;
+   unsigned int               _sqMask;
+   unsigned int               _sqEntries;
+   unsigned int*              _sqArray;
+   unsigned int*              _cqHead;
+   unsigned int*              _cqTail;
+   unsigned int               _cqMask;
+   io_uring_cqe*              _cqes;
+
+   std::vector<IoRequest>     _slots;
+   std::vector<unsigned int>  _freeSlots;
+   std::vector<IoVec>         _buffers;
+   unsigned int               _queued;
+   unsigned int               _inFlight;
+   bool                       _timedWait;
+   bool                       _stopping;
+   int                        _wakeFd;
+   std::mutex                 _mutex;
+   std::condition_variable    _cond;
+   std::thread                _reaper;
+
+   // Lets the unit tests reach the engine internals.
+   friend struct UringIoEngineProbe;
+
+   UringIoEngine(const UringIoEngine&);
+   UringIoEngine& operator = (const UringIoEngine&);
+
+   void setup(unsigned int entries) throw (IOException);
+
+   void armWake() throw (IOException);
+
+   void release();
+
+   io_uring_sqe* nextSqe(std::unique_lock<std::mutex>& lock) 
+         throw (IOException);
+
+   unsigned int submitQueued() throw (IOException);
+
+   void awaitProgress(std::unique_lock<std::mutex>& lock);
+
+   void reap();
+
+};
+
+}; // namespace karen
+
+#endif
+#endif
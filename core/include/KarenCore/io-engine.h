@@ -0,0 +1,383 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_IO_ENGINE_H
+#define KAREN_CORE_IO_ENGINE_H
+
+#include <condition_variable>
+#include <mutex>
+
+#include "KarenCore/events.h"
+#include "KarenCore/exception.h"
+#include "KarenCore/file.h"
+#include "KarenCore/pointer.h"
+
+namespace karen {
+
+// Pre-declarations
+class IoCallback;
+
+/**
+ * I/O operation enumeration. 
+ */
+enum IoOperation
+{
+   IO_READ_OPERATION,
+   IO_WRITE_OPERATION,
+};
+
+/**
+ * I/O request. This struct describes an asynchronous read or write of a 
+ * range of a file opened by an I/O engine. 
+ */
+struct KAREN_EXPORT IoRequest
+{
+   IoOperation    operation;  //!< The operation to perform
+   AbstractFile*  file;       //!< The file, opened by the same engine
+   void*          data;       //!< Memory read into or written from
+   unsigned long  length;     //!< Number of bytes to transfer
+   unsigned long  offset;     //!< File offset of the range
+   IoCallback*    callback;   //!< Notified on completion; may be null
+   void*          userData;   //!< Opaque value for the callback
+};
+
+/**
+ * I/O completion. This struct describes the outcome of an I/O request. 
+ */
+struct KAREN_EXPORT IoCompletion
+{
+   IoRequest   request;    //!< The completed request
+   long        result;     //!< Bytes transferred, or minus the errno
+   
+   /**
+    * Check whether the request succeeded.
+    */
+   inline bool succeeded() const
+   { return result >= 0; }
+};
+
+/**
+ * I/O callback class. This abstract class provides the interface for an 
+ * object notified of the completion of I/O requests. Completions are 
+ * delivered from a thread owned by the I/O engine, so callbacks must be 
+ * thread-safe and return quickly.
+ */
+class KAREN_EXPORT IoCallback
+{
+public:
+
+   /**
+    * Virtual destructor.
+    */
+   inline virtual ~IoCallback() {}
+   
+   /**
+    * Callback invoked when an I/O request completes.
+    */
+   virtual void onIoCompletion(const IoCompletion& completion) = 0;
+
+};
+
+/**
+ * I/O completion event. This event is sent to the event channel given to
+ * an asynchronous request when it completes.
+ */
+KAREN_DECL_EVENT(IoCompletionEvent, IoCompletion completion);
+
+/**
+ * I/O future state. This class holds the completion an I/O future waits 
+ * for. It should never be used directly. Use IoFuture class instead.
+ */
+class KAREN_EXPORT IoFutureState
+{
+public:
+
+   inline IoFutureState() : _ready(false) {}
+
+   /**
+    * Store the completion and wake up the threads waiting for it.
+    */
+   void complete(const IoCompletion& completion);
+
+private:
+
+   friend class IoFuture;
+
+   mutable std::mutex               _mutex;
+   mutable std::condition_variable  _cond;
+   bool                             _ready;
+   IoCompletion                     _completion;
+
+};
+
+/**
+ * I/O future class. This class represents the completion of an 
+ * asynchronous request that has not necessarily happened yet. Copies of a
+ * future share its state, and they may be waited from any thread.
+ */
+class KAREN_EXPORT IoFuture
+{
+public:
+
+   /**
+    * Create a future for the completion of a request still to be 
+    * submitted.
+    */
+   inline IoFuture() : _state(new IoFutureState()) {}
+
+   /**
+    * Check whether the request has completed.
+    */
+   bool isReady() const;
+
+   /**
+    * Block until the request completes, and return its completion. The 
+    * request must have been submitted, or this never returns.
+    */
+   const IoCompletion& wait() const;
+
+   /**
+    * Block until the request completes or the given milliseconds elapse.
+    * It returns whether the request completed.
+    */
+   bool wait(unsigned long millis) const;
+
+private:
+
+   friend class AsyncFile;
+
+   AtomicPtr<IoFutureState> _state;
+
+};
+
+/**
+ * I/O engine options. This struct indicates how an I/O engine is created.
+ */
+struct KAREN_EXPORT IoEngineOptions
+{
+   unsigned int   queueDepth;       //!< Max requests submitted at once
+   unsigned int   workerThreads;    //!< Threads of the thread-pool engine
+   bool           forceThreadPool;  //!< Never use the kernel engine
+
+   IoEngineOptions() 
+    : queueDepth(128), workerThreads(4), forceThreadPool(false) {}
+};
+
+/**
+ * I/O engine class. This abstract class provides the interface for an
+ * engine that performs file reads and writes asynchronously. Requests are
+ * batched: they are queued by enqueue() and started together by submit(),
+ * which also happens when the queue is full. At most the configured queue
+ * depth of requests are pending at once; enqueuing more blocks until some
+ * of them complete. Completions are delivered to the request callbacks 
+ * from threads owned by the engine. Engines are created by create(), 
+ * which chooses the best backend for the platform.
+ */
+class KAREN_EXPORT IoEngine
+{
+public:
+
+   /**
+    * Create the best I/O engine for this platform with given options. On
+    * Linux, it is backed by io_uring when the kernel supports it. 
+    * Elsewhere, or if forceThreadPool is set, it is backed by a pool of 
+    * threads performing blocking positional I/O. 
+    */
+   static AtomicPtr<IoEngine> create(
+         const IoEngineOptions& options = IoEngineOptions());
+
+   /**
+    * Virtual destructor. Pending requests are completed before the engine
+    * is destroyed.
+    */
+   inline virtual ~IoEngine() {}
+
+   /**
+    * Obtain the name of the engine backend.
+    */
+   virtual const char* name() const = 0;
+
+   /**
+    * Open a file to perform asynchronous requests on it through this 
+    * engine. If the file cannot be opened, a IOException is thrown. The 
+    * returned file supports synchronous operations as well.
+    */
+   virtual Ptr<AbstractFile> open(
+         const String& location, 
+         const FileOpenMode& mode) throw (IOException) = 0;
+
+   /**
+    * Queue a request to be started on next submission. The file of the
+    * request must have been opened by this engine, and its memory must be 
+    * valid until completion. If the request cannot be queued, a 
+    * IOException is thrown.
+    */
+   virtual void enqueue(const IoRequest& request) throw (IOException) = 0;
+
+   /**
+    * Start the queued requests, returning how many of them were started.
+    * If they cannot be started, a IOException is thrown.
+    */
+   virtual unsigned int submit() throw (IOException) = 0;
+
+   /**
+    * Submit the queued requests and block until all the pending ones are
+    * completed and their callbacks have returned.
+    */
+   virtual void drain() throw (IOException) = 0;
+
+   /**
+    * Register memory regions to be used by requests, so the kernel may map
+    * them once instead of on each request. Requests whose memory lies 
+    * within a registered region benefit from it with no further action.
+    * A new registration replaces the previous one, and registering no
+    * regions unregisters them. Engines with no use for it accept it with 
+    * no effect. If the regions cannot be registered, a IOException is 
+    * thrown.
+    */
+   virtual void registerBuffers(const IoVec* vecs, unsigned int count) 
+         throw (IOException) = 0;
+
+   /**
+    * Unregister the memory regions registered by registerBuffers(). 
+    */
+   virtual void unregisterBuffers() throw (IOException) = 0;
+
+};
+
+/**
+ * Asynchronous file class. This class provides asynchronous positional 
+ * reads and writes on a file opened by an I/O engine. The completion of
+ * each request may be notified to a callback, waited through a future, or
+ * sent as a IoCompletionEvent to an event channel. In all cases, it is 
+ * notified from a thread owned by the engine. As engine requests, these 
+ * are batched, so they start when the engine submits them. The engine 
+ * must outlive the file.
+ */
+class KAREN_EXPORT AsyncFile
+{
+public:
+
+   /**
+    * Open the file at given location in given mode through given engine.
+    * If the file cannot be opened, a IOException is thrown.
+    */
+   AsyncFile(IoEngine& engine, 
+             const String& location, 
+             const FileOpenMode& mode) throw (IOException);
+
+   /**
+    * Obtain the I/O engine of this file.
+    */
+   inline IoEngine& engine()
+   { return _engine; }
+
+   /**
+    * Obtain the underlying file, for synchronous operations.
+    */
+   inline AbstractFile& file()
+   { return *_file; }
+
+   /**
+    * Obtain the size of the file. If it cannot be obtained, a IOException
+    * is thrown.
+    */
+   inline unsigned long size() const throw (IOException)
+   { return _file->size(); }
+
+   /**
+    * Read len bytes at given offset into dst, notifying callback on 
+    * completion. If the request cannot be queued, a IOException is thrown.
+    */
+   void read(void* dst, 
+             unsigned long len, 
+             unsigned long offset, 
+             IoCallback* callback, 
+             void* userData = NULL) throw (IOException);
+
+   /**
+    * Read len bytes at given offset into dst, returning a future for its
+    * completion. If the request cannot be queued, a IOException is thrown.
+    */
+   IoFuture read(void* dst, 
+                 unsigned long len, 
+                 unsigned long offset) throw (IOException);
+
+   /**
+    * Read len bytes at given offset into dst, sending a IoCompletionEvent
+    * to channel on completion. If the request cannot be queued, a 
+    * IOException is thrown.
+    */
+   void read(void* dst, 
+             unsigned long len, 
+             unsigned long offset, 
+             const EventChannel* channel, 
+             void* userData = NULL) throw (IOException);
+
+   /**
+    * Write len bytes from src at given offset, notifying callback on 
+    * completion. If the request cannot be queued, a IOException is thrown.
+    */
+   void write(const void* src, 
+              unsigned long len, 
+              unsigned long offset, 
+              IoCallback* callback, 
+              void* userData = NULL) throw (IOException);
+
+   /**
+    * Write len bytes from src at given offset, returning a future for its
+    * completion. If the request cannot be queued, a IOException is thrown.
+    */
+   IoFuture write(const void* src, 
+                  unsigned long len, 
+                  unsigned long offset) throw (IOException);
+
+   /**
+    * Write len bytes from src at given offset, sending a IoCompletionEvent
+    * to channel on completion. If the request cannot be queued, a 
+    * IOException is thrown.
+    */
+   void write(const void* src, 
+              unsigned long len, 
+              unsigned long offset, 
+              const EventChannel* channel, 
+              void* userData = NULL) throw (IOException);
+
+private:
+
+   IoEngine&         _engine;
+   Ptr<AbstractFile> _file;
+
+   void enqueue(IoOperation operation,
+                void* data, 
+                unsigned long len, 
+                unsigned long offset, 
+                IoCallback* callback, 
+                void* userData) throw (IOException);
+
+};
+
+}; // namespace karen
+
+#endif
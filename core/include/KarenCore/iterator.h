@@ -59,9 +59,11 @@ enum BeginAt
  * Abstract iterator base. This abstract class provides the base for
  * any iterator, including the common functionality of any iterator
  * for moving forwards and backwards and indicate whether it is null.
+ * Iterators are reference counted intrusively, so wrapping a new iterator
+ * implementation in a smart pointer takes a single allocation. 
  */
 template <class T>
-class AbstractIteratorBase
+class AbstractIteratorBase : public RefCounted<>
 {
 public:
 
@@ -253,6 +255,17 @@ public:
       return Iterator<const T>(it);
    }
    
+   /**
+    * Copy assignment operator. As the copy constructor does, it clones the
+    * implementation of the assigned iterator, so both are independent.
+    */
+   inline Iterator& operator = (const Iterator& it)
+   { 
+      if (this != &it)
+         _impl = it._impl.isNull() ? NULL : it._impl->clone(); 
+      return *this; 
+   }
+
    /**
     * Asignment operator.
     */
@@ -268,7 +281,7 @@ public:
    /**
     * Increment operator.
     */
-   inline Iterator& operator ++ (int n)
+   inline Iterator& operator ++ (int)
    { this->next(); return *this; }
    
    /**
@@ -280,7 +293,7 @@ public:
    /**
     * Decrement operator.
     */
-   inline Iterator& operator -- (int n)
+   inline Iterator& operator -- (int)
    { this->prev(); return *this; }
    
 private:
@@ -40,98 +40,102 @@ List<T>::removeAll(const T& t, Equals eq)
          this->remove(it);
 }
 
-template <class T>
-LinkedList<T>::LinkedList() : _impl(new std::list<T>()) {}
+template <class T, class Allocator>
+LinkedList<T, Allocator>::LinkedList() : _impl(new _Impl()) {}
 
-template <class T>
-LinkedList<T>::~LinkedList()
+template <class T, class Allocator>
+LinkedList<T, Allocator>::LinkedList(const Allocator& alloc)
+ : _impl(new _Impl(alloc)) {}
+
+template <class T, class Allocator>
+LinkedList<T, Allocator>::~LinkedList()
 { delete _impl; }
 
-template <class T>
+template <class T, class Allocator>
 unsigned long
-LinkedList<T>::size() const
+LinkedList<T, Allocator>::size() const
 { return _impl->size(); }
    
-template <class T>
+template <class T, class Allocator>
 void
-LinkedList<T>::clear()
+LinkedList<T, Allocator>::clear()
 { _impl->clear(); }
 
-template <class T>
+template <class T, class Allocator>
 Iterator<T>
-LinkedList<T>::begin()
+LinkedList<T, Allocator>::begin()
 {
    Ptr<AbstractIterator<T> > it = new LinkedListIterator(
          *this, _impl->begin(), _impl->end());
    return Iterator<T>(it);
 }
    
-template <class T>
+template <class T, class Allocator>
 Iterator<T>
-LinkedList<T>::end()
+LinkedList<T, Allocator>::end()
 {
    Ptr<AbstractIterator<T> > it = new LinkedListIterator(
          *this, _impl->end(), _impl->end());
    return Iterator<T>(it);
 }
    
-template <class T>
+template <class T, class Allocator>
 Iterator<const T>
-LinkedList<T>::begin() const
+LinkedList<T, Allocator>::begin() const
 {
    Ptr<AbstractIterator<const T> > it = new LinkedListIterator(
          *this, _impl->begin(), _impl->end());
    return Iterator<const T>(it);
 }
    
-template <class T>
+template <class T, class Allocator>
 Iterator<const T>
-LinkedList<T>::end() const
+LinkedList<T, Allocator>::end() const
 {
    Ptr<AbstractIterator<const T> > it = new LinkedListIterator(
          *this, _impl->end(), _impl->end());
    return Iterator<const T>(it);
 }
    
-template <class T>
+template <class T, class Allocator>
 Iterator<T>
-LinkedList<T>::rbegin()
+LinkedList<T, Allocator>::rbegin()
 {
    Ptr<AbstractIterator<T> > it = new LinkedListReverseIterator(
          *this, _impl->rbegin(), _impl->rend());
    return Iterator<T>(it);
 }
    
-template <class T>
+template <class T, class Allocator>
 Iterator<T>
-LinkedList<T>::rend()
+LinkedList<T, Allocator>::rend()
 {
    Ptr<AbstractIterator<T> > it = new LinkedListReverseIterator(
          *this, _impl->rend(), _impl->rend());
    return Iterator<T>(it);
 }
    
-template <class T>
+template <class T, class Allocator>
 Iterator<const T>
-LinkedList<T>::rbegin() const
+LinkedList<T, Allocator>::rbegin() const
 {
    Ptr<AbstractIterator<const T> > it = new LinkedListReverseIterator(
          *this, _impl->rbegin(), _impl->rend());
    return Iterator<const T>(it);
 }
    
-template <class T>
+template <class T, class Allocator>
 Iterator<const T>
-LinkedList<T>::rend() const
+LinkedList<T, Allocator>::rend() const
 {
    Ptr<AbstractIterator<const T> > it = new LinkedListReverseIterator(
          *this, _impl->rend(), _impl->rend());
    return Iterator<const T>(it);
 }
    
-template <class T>
+template <class T, class Allocator>
 void
-LinkedList<T>::remove(Iterator<T>& it)
+LinkedList<T, Allocator>::remove(Iterator<T>& it)
 {
    LinkedListIterator *nit = it.template impl<LinkedListIterator>();
    LinkedListReverseIterator *nrit = it.template impl<LinkedListReverseIterator>();
@@ -156,9 +160,9 @@ LinkedList<T>::remove(Iterator<T>& it)
             " the iterator does not belongs to this collection");
 }
    
-template <class T>
+template <class T, class Allocator>
 const T&
-LinkedList<T>::first() const 
+LinkedList<T, Allocator>::first() const 
 throw (NotFoundException)
 { 
    if (_impl->size() > 0)
@@ -168,9 +172,9 @@ throw (NotFoundException)
          "cannot fetch first element of linked list: list is empty");
 }
 
-template <class T>
+template <class T, class Allocator>
 const T&
-LinkedList<T>::last() const
+LinkedList<T, Allocator>::last() const
 throw (NotFoundException)
 {
    if (_impl->size() > 0)
@@ -179,20 +183,52 @@ throw (NotFoundException)
       KAREN_THROW(NotFoundException, 
          "cannot fetch last element of linked list: list is empty");
 }
+
+template <class T, class Allocator>
+const T*
+LinkedList<T, Allocator>::tryFirst() const
+{ return _impl->empty() ? NULL : &_impl->front(); }
+
+template <class T, class Allocator>
+const T*
+LinkedList<T, Allocator>::tryLast() const
+{ return _impl->empty() ? NULL : &_impl->back(); }
    
-template <class T>
+template <class T, class Allocator>
 void
-LinkedList<T>::insertFront(const T& t)
+LinkedList<T, Allocator>::insertFront(const T& t)
 { _impl->push_front(t); }
    
-template <class T>
+template <class T, class Allocator>
+void
+LinkedList<T, Allocator>::insertFront(T&& t)
+{ _impl->push_front(std::move(t)); }
+   
+template <class T, class Allocator>
 void
-LinkedList<T>::insertBack(const T& t)
+LinkedList<T, Allocator>::insertBack(const T& t)
 { _impl->push_back(t); }
+   
+template <class T, class Allocator>
+void
+LinkedList<T, Allocator>::insertBack(T&& t)
+{ _impl->push_back(std::move(t)); }
 
-template <class T>
+template <class T, class Allocator>
+template <class ... Args>
+void
+LinkedList<T, Allocator>::emplaceFront(Args&& ... args)
+{ _impl->emplace_front(std::forward<Args>(args)...); }
+
+template <class T, class Allocator>
+template <class ... Args>
+void
+LinkedList<T, Allocator>::emplaceBack(Args&& ... args)
+{ _impl->emplace_back(std::forward<Args>(args)...); }
+
+template <class T, class Allocator>
 void
-LinkedList<T>::insertBefore(const T& t, Iterator<T>& it)
+LinkedList<T, Allocator>::insertBefore(const T& t, Iterator<T>& it)
 throw (InvalidInputException)
 {
    LinkedListIterator *nit = it.template impl<LinkedListIterator>();
@@ -204,9 +240,9 @@ throw (InvalidInputException)
             " the iterator does not belongs to this collection");
 }
    
-template <class T>
+template <class T, class Allocator>
 void
-LinkedList<T>::insertAfter(const T& t, Iterator<T>& it)
+LinkedList<T, Allocator>::insertAfter(const T& t, Iterator<T>& it)
 throw (InvalidInputException)
 {
    Iterator<T> itc(it);
@@ -220,9 +256,9 @@ throw (InvalidInputException)
             " the iterator does not belongs to this collection");
 }
 
-template <class T>
+template <class T, class Allocator>
 void
-LinkedList<T>::removeFirst()
+LinkedList<T, Allocator>::removeFirst()
 throw (NotFoundException)
 {
    if (size() > 0)
@@ -232,9 +268,9 @@ throw (NotFoundException)
          "cannot remove first element of linked list: list is empty");
 }
 
-template <class T>
+template <class T, class Allocator>
 void
-LinkedList<T>::removeLast()
+LinkedList<T, Allocator>::removeLast()
 throw (NotFoundException)
 {
    if (size() > 0)
@@ -244,6 +280,68 @@ throw (NotFoundException)
          "cannot remove last element of linked list: list is empty");
 }
 
+template <class T, class Allocator>
+T
+LinkedList<T, Allocator>::takeFirst()
+throw (NotFoundException)
+{
+   if (size() > 0)
+   {
+      T t(std::move(_impl->front()));
+      _impl->pop_front();
+      return t;
+   }
+   else
+      KAREN_THROW(NotFoundException, 
+         "cannot take first element of linked list: list is empty");
+}
+
+template <class T, class Allocator>
+T
+LinkedList<T, Allocator>::takeLast()
+throw (NotFoundException)
+{
+   if (size() > 0)
+   {
+      T t(std::move(_impl->back()));
+      _impl->pop_back();
+      return t;
+   }
+   else
+      KAREN_THROW(NotFoundException, 
+         "cannot take last element of linked list: list is empty");
+}
+
+template <class T, class Allocator>
+typename LinkedList<T, Allocator>::FastIterator
+LinkedList<T, Allocator>::fastBegin()
+{ return _impl->begin(); }
+
+template <class T, class Allocator>
+typename LinkedList<T, Allocator>::FastIterator
+LinkedList<T, Allocator>::fastEnd()
+{ return _impl->end(); }
+
+template <class T, class Allocator>
+typename LinkedList<T, Allocator>::ConstFastIterator
+LinkedList<T, Allocator>::fastBegin() const
+{ return _impl->begin(); }
+
+template <class T, class Allocator>
+typename LinkedList<T, Allocator>::ConstFastIterator
+LinkedList<T, Allocator>::fastEnd() const
+{ return _impl->end(); }
+
+template <class T, class Allocator>
+FastRange<typename LinkedList<T, Allocator>::FastIterator>
+LinkedList<T, Allocator>::fast()
+{ return FastRange<FastIterator>(fastBegin(), fastEnd()); }
+
+template <class T, class Allocator>
+FastRange<typename LinkedList<T, Allocator>::ConstFastIterator>
+LinkedList<T, Allocator>::fast() const
+{ return FastRange<ConstFastIterator>(fastBegin(), fastEnd()); }
+
 }
 
 #endif
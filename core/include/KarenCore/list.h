@@ -51,17 +51,39 @@ public:
     * the list is empty.
     */
    virtual const T& last() const throw (NotFoundException) = 0;
+
+   /**
+    * Get a pointer to the first element of the list, or a null pointer if
+    * the list is empty. Unlike first(), this does not throw on empty lists.
+    */
+   virtual const T* tryFirst() const = 0;
+
+   /**
+    * Get a pointer to the last element of the list, or a null pointer if
+    * the list is empty. Unlike last(), this does not throw on empty lists.
+    */
+   virtual const T* tryLast() const = 0;
    
    /**
     * Insert a new element at list front.
     */
    virtual void insertFront(const T& t) = 0;
    
+   /**
+    * Insert a new element at list front by moving it.
+    */
+   virtual void insertFront(T&& t) = 0;
+   
    /**
     * Insert a new element at list back. 
     */
    virtual void insertBack(const T& t) = 0;
    
+   /**
+    * Insert a new element at list back by moving it. 
+    */
+   virtual void insertBack(T&& t) = 0;
+   
    /**
     * Insert a new element before that one pointed by given iterator.
     * It throws a InvalidInputException if given iterator is not valid.
@@ -87,6 +109,20 @@ public:
     * if the list is empty.
     */
    virtual void removeLast() throw (NotFoundException) = 0;
+
+   /**
+    * Remove the first element of the list and return it, or throw a
+    * NotFoundException if the list is empty. The element is moved out
+    * of the list rather than copied.
+    */
+   virtual T takeFirst() throw (NotFoundException) = 0;
+
+   /**
+    * Remove the last element of the list and return it, or throw a
+    * NotFoundException if the list is empty. The element is moved out
+    * of the list rather than copied.
+    */
+   virtual T takeLast() throw (NotFoundException) = 0;
    
    /**
     * Remove all ocurrences of given element from the list.
@@ -96,13 +132,24 @@ public:
 
 };
 
-template <class T>
+/**
+ * Linked list template class. This template class provides a list
+ * implemented as a doubly linked list, which nodes are obtained from
+ * given Allocator. 
+ */
+template <class T, class Allocator = std::allocator<T> >
 class LinkedList : public List<T>
 {
 public:
 
    inline LinkedList();
 
+   /**
+    * Create a new linked list which nodes are obtained from given
+    * allocator.
+    */
+   inline explicit LinkedList(const Allocator& alloc);
+
    inline virtual ~LinkedList();
 
    inline virtual unsigned long size() const;
@@ -130,10 +177,32 @@ public:
    inline virtual const T& first() const throw (NotFoundException);
 
    inline virtual const T& last() const throw (NotFoundException);
+
+   inline virtual const T* tryFirst() const;
+
+   inline virtual const T* tryLast() const;
    
    inline virtual void insertFront(const T& t);
    
+   inline virtual void insertFront(T&& t);
+   
    inline virtual void insertBack(const T& t);
+   
+   inline virtual void insertBack(T&& t);
+
+   /**
+    * Insert a new element at list front constructing it in place from
+    * given arguments.
+    */
+   template <class ... Args>
+   inline void emplaceFront(Args&& ... args);
+
+   /**
+    * Insert a new element at list back constructing it in place from
+    * given arguments.
+    */
+   template <class ... Args>
+   inline void emplaceBack(Args&& ... args);
 
    inline virtual void insertBefore(const T& t, Iterator<T>& it)
       throw (InvalidInputException);
@@ -145,9 +214,31 @@ public:
    
    inline virtual void removeLast() throw (NotFoundException);
 
+   inline virtual T takeFirst() throw (NotFoundException);
+
+   inline virtual T takeLast() throw (NotFoundException);
+
+   /**
+    * Fast iterator types. See FastRange for details.
+    */
+   typedef typename std::list<T, Allocator>::iterator FastIterator;
+   typedef typename std::list<T, Allocator>::const_iterator ConstFastIterator;
+
+   inline FastIterator fastBegin();
+
+   inline FastIterator fastEnd();
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<FastIterator> fast();
+
+   inline FastRange<ConstFastIterator> fast() const;
+
 private:
 
-   typedef std::list<T> _Impl;
+   typedef std::list<T, Allocator> _Impl;
 
    typedef IteratorImpl<T, LinkedList, 
          typename _Impl::iterator> LinkedListIterator;
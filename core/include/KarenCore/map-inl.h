@@ -25,6 +25,8 @@
 #ifndef KAREN_CORE_MAP_INL_H
 #define KAREN_CORE_MAP_INL_H
 
+#include <new>
+
 #include "KarenCore/map.h"
 
 namespace karen {
@@ -33,17 +35,12 @@ template <class K, class T>
 const T&
 Map<K, T>::operator[] (const K& k) const
 throw (NotFoundException)
-{
-}
+{ return this->get(k); }
 
 template <class K, class T>
 T&
 Map<K, T>::operator[] (const K& k)
-{
-   if (!this->hasKey(k))
-      this->put(k, T());
-   return this->get(k);
-}
+{ return getOrInsert(k); }
 
 template <class K, class T>
 void
@@ -51,38 +48,98 @@ Map<K, T>::put(const Tuple<const K, T>& value)
 { this->put(value.template get<0>(), value.template get<1>()); }
 
 template <class K, class T>
-TreeMap<K, T>::TreeMap(const Ptr<KeyComparator>& cmp)
-   : _impl(new _Impl(KeyCmp(cmp)))
-{}
+void
+Map<K, T>::put(Tuple<const K, T>&& value)
+{ 
+   this->put(value.template get<0>(), std::move(value.template get<1>())); 
+}
+
+template <class K, class T>
+template <class Function>
+T&
+Map<K, T>::computeIfAbsent(const K& k, Function f)
+{
+   FunctionMapValueFactory<T, Function> factory(f);
+   return this->computeIfAbsent(
+         k, static_cast<const MapValueFactory<T>&>(factory));
+}
+
+template <class K, class T>
+T&
+Map<K, T>::getOrInsert(const K& k)
+{
+   DefaultMapValueFactory<T> factory;
+   return this->computeIfAbsent(
+         k, static_cast<const MapValueFactory<T>&>(factory));
+}
+
+template <class K, class T>
+template <class U>
+TreeMapNode<K, T>::TreeMapNode(const K& k, U&& value)
+   : _probe(NULL)
+{ new (&_entry) Tuple<const K, T>(k, std::forward<U>(value)); }
+
+template <class K, class T>
+TreeMapNode<K, T>::TreeMapNode(const TreeMapNode& node)
+   : _probe(node._probe)
+{
+   if (!_probe)
+      new (&_entry) Tuple<const K, T>(node.entry());
+}
+
+template <class K, class T>
+TreeMapNode<K, T>::TreeMapNode(TreeMapNode&& node)
+   : _probe(node._probe)
+{
+   if (!_probe)
+      new (&_entry) Tuple<const K, T>(std::move(node.entry()));
+}
 
 template <class K, class T>
-TreeMap<K, T>::TreeMap(
+TreeMapNode<K, T>::~TreeMapNode()
+{
+   if (!_probe)
+      entry().~Tuple<const K, T>();
+}
+
+template <class K, class T, class Allocator>
+TreeMap<K, T, Allocator>::TreeMap(
+      const Ptr<KeyComparator>& cmp,
+      const Allocator& alloc)
+   : _impl(new _Impl(KeyCmp(cmp), NodeAllocator(alloc))), _cmp(cmp)
+{}
+
+template <class K, class T, class Allocator>
+TreeMap<K, T, Allocator>::TreeMap(
       const Tuple<const K, T>* elems, 
       unsigned long nelems, 
-      const Ptr<KeyComparator>& cmp)
-   : _impl(new _Impl(KeyCmp(cmp)))
+      const Ptr<KeyComparator>& cmp,
+      const Allocator& alloc)
+   : _impl(new _Impl(KeyCmp(cmp), NodeAllocator(alloc))), _cmp(cmp)
 {
+   // Hinting the end makes inserting sorted elements take constant time
    for (unsigned long i = 0; i < nelems; i++)
-      Map<K, T>::put(elems[i]);
+      _impl->emplace_hint(_impl->end(), 
+            elems[i].template get<0>(), elems[i].template get<1>());
 }
 
-template <class K, class T>
-TreeMap<K, T>::~TreeMap()
+template <class K, class T, class Allocator>
+TreeMap<K, T, Allocator>::~TreeMap()
 { delete _impl; }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 unsigned long
-TreeMap<K, T>::size() const
+TreeMap<K, T, Allocator>::size() const
 { return _impl->size(); }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 void
-TreeMap<K, T>::clear()
+TreeMap<K, T, Allocator>::clear()
 { _impl->clear(); }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 void
-TreeMap<K, T>::remove(Iterator<Tuple<const K, T> >& it)
+TreeMap<K, T, Allocator>::remove(Iterator<Tuple<const K, T> >& it)
 {
    Iterator<Tuple<const K, T>> itCopy = it;
    TreeMapIterator* nit = itCopy.template impl<TreeMapIterator>();
@@ -90,12 +147,12 @@ TreeMap<K, T>::remove(Iterator<Tuple<const K, T> >& it)
    if (nit && (nit->collection() == this))
    {
       it++;
-      _impl->erase(nit->impl());
+      _impl->erase(nit->impl().base());
    }
    else if (nrit && (nrit->collection() == this))
    {
       it++;
-      _impl->erase(--nrit->impl().base());
+      _impl->erase((--nrit->impl().base()).base());
    }
    else
       KAREN_THROW(InvalidInputException, 
@@ -103,123 +160,800 @@ TreeMap<K, T>::remove(Iterator<Tuple<const K, T> >& it)
             " the iterator does not belongs to this collection");
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 Iterator<Tuple<const K, T> >
-TreeMap<K, T>::begin()
+TreeMap<K, T, Allocator>::begin()
 {
    Ptr<AbstractIterator<Tuple<const K, T> > > it =
-         new TreeMapIterator(*this, _impl->begin(), _impl->end());
+         new TreeMapIterator(
+               *this, NodeIterator(_impl->begin()), NodeIterator(_impl->end()));
    return Iterator<Tuple<const K, T> >(it);
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 Iterator<Tuple<const K, T> >
-TreeMap<K, T>::end()
+TreeMap<K, T, Allocator>::end()
 {
    Ptr<AbstractIterator<Tuple<const K, T> > > it =
-         new TreeMapIterator(*this, _impl->end(), _impl->end());
+         new TreeMapIterator(
+               *this, NodeIterator(_impl->end()), NodeIterator(_impl->end()));
    return Iterator<Tuple<const K, T> >(it);
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 Iterator<const Tuple<const K, T> >
-TreeMap<K, T>::begin() const
+TreeMap<K, T, Allocator>::begin() const
 {
    Ptr<AbstractIterator<const Tuple<const K, T> > > it =
-         new TreeMapIterator(*this, _impl->begin(), _impl->end());
+         new TreeMapIterator(
+               *this, NodeIterator(_impl->begin()), NodeIterator(_impl->end()));
    return Iterator<const Tuple<const K, T> >(it);
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 Iterator<const Tuple<const K, T> >
-TreeMap<K, T>::end() const
+TreeMap<K, T, Allocator>::end() const
 {
    Ptr<AbstractIterator<const Tuple<const K, T> > > it =
-         new TreeMapIterator(*this, _impl->end(), _impl->end());
+         new TreeMapIterator(
+               *this, NodeIterator(_impl->end()), NodeIterator(_impl->end()));
    return Iterator<const Tuple<const K, T> >(it);
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 Iterator<Tuple<const K, T> >
-TreeMap<K, T>::rbegin()
+TreeMap<K, T, Allocator>::rbegin()
 {
+   typedef std::reverse_iterator<NodeIterator> ReverseIt;
    Ptr<AbstractIterator<Tuple<const K, T> > > it =
-         new TreeMapReverseIterator(*this, _impl->rbegin(), _impl->rend());
+         new TreeMapReverseIterator(*this, 
+               ReverseIt(NodeIterator(_impl->end())), 
+               ReverseIt(NodeIterator(_impl->begin())));
    return Iterator<Tuple<const K, T> >(it);
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 Iterator<Tuple<const K, T> >
-TreeMap<K, T>::rend()
+TreeMap<K, T, Allocator>::rend()
 {
+   typedef std::reverse_iterator<NodeIterator> ReverseIt;
    Ptr<AbstractIterator<Tuple<const K, T> > > it =
-         new TreeMapReverseIterator(*this, _impl->rend(), _impl->rend());
+         new TreeMapReverseIterator(*this, 
+               ReverseIt(NodeIterator(_impl->begin())), 
+               ReverseIt(NodeIterator(_impl->begin())));
    return Iterator<Tuple<const K, T> >(it);
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 Iterator<const Tuple<const K, T> >
-TreeMap<K, T>::rbegin() const
+TreeMap<K, T, Allocator>::rbegin() const
 {
+   typedef std::reverse_iterator<NodeIterator> ReverseIt;
    Ptr<AbstractIterator<const Tuple<const K, T> > > it =
-         new TreeMapReverseIterator(*this, _impl->rbegin(), _impl->rend());
+         new TreeMapReverseIterator(*this, 
+               ReverseIt(NodeIterator(_impl->end())), 
+               ReverseIt(NodeIterator(_impl->begin())));
    return Iterator<const Tuple<const K, T> >(it);
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 Iterator<const Tuple<const K, T> >
-TreeMap<K, T>::rend() const
+TreeMap<K, T, Allocator>::rend() const
 {
+   typedef std::reverse_iterator<NodeIterator> ReverseIt;
    Ptr<AbstractIterator<const Tuple<const K, T> > > it =
-         new TreeMapReverseIterator(*this, _impl->rend(), _impl->rend());
+         new TreeMapReverseIterator(*this, 
+               ReverseIt(NodeIterator(_impl->begin())), 
+               ReverseIt(NodeIterator(_impl->begin())));
    return Iterator<const Tuple<const K, T> >(it);
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 bool
-TreeMap<K, T>::hasKey(const K& k) const
-{ return _impl->find(Tuple<const K, T>(k, T())) != _impl->end(); }
+TreeMap<K, T, Allocator>::hasKey(const K& k) const
+{ return _impl->find(Node(k)) != _impl->end(); }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 Iterator<Tuple<const K, T>>
-TreeMap<K, T>::put(const K& k, const T& t)
+TreeMap<K, T, Allocator>::put(const K& k, const T& t)
 {
+   typename _Impl::iterator pos;
+   if (!findPosition(k, pos))
+      pos = _impl->emplace_hint(pos, k, t);
    Ptr<AbstractIterator<Tuple<const K, T> > > it = new TreeMapIterator(
-         *this, _impl->insert(Tuple<const K, T>(k, t)).first, _impl->end());
+         *this, NodeIterator(pos), NodeIterator(_impl->end()));
    return it;
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
+Iterator<Tuple<const K, T>>
+TreeMap<K, T, Allocator>::put(const K& k, T&& t)
+{
+   typename _Impl::iterator pos;
+   if (!findPosition(k, pos))
+      pos = _impl->emplace_hint(pos, k, std::move(t));
+   Ptr<AbstractIterator<Tuple<const K, T> > > it = new TreeMapIterator(
+         *this, NodeIterator(pos), NodeIterator(_impl->end()));
+   return it;
+}
+
+template <class K, class T, class Allocator>
+template <class ... Args>
+Iterator<Tuple<const K, T>>
+TreeMap<K, T, Allocator>::emplace(const K& k, Args&& ... args)
+{
+   typename _Impl::iterator pos;
+   if (!findPosition(k, pos))
+      pos = _impl->emplace_hint(pos, k, T(std::forward<Args>(args)...));
+   Ptr<AbstractIterator<Tuple<const K, T> > > it = new TreeMapIterator(
+         *this, NodeIterator(pos), NodeIterator(_impl->end()));
+   return it;
+}
+
+template <class K, class T, class Allocator>
 const T&
-TreeMap<K, T>::get(const K& k) const
+TreeMap<K, T, Allocator>::get(const K& k) const
 throw (NotFoundException)
 {
-   typename std::set<Tuple<const K, T>, KeyCmp>::const_iterator it = 
-         _impl->find(Tuple<const K, T>(k, T()));
+   typename _Impl::const_iterator it = _impl->find(Node(k));
    if (it != _impl->end())
-      return it->template get<1>();
+      return it->entry().template get<1>();
    else
       KAREN_THROW(NotFoundException,
          "cannot find element in tree map with such a key");
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
 T&
-TreeMap<K, T>::get(const K& k)
+TreeMap<K, T, Allocator>::get(const K& k)
 throw (NotFoundException)
 {
-   typename std::set<Tuple<const K, T>, KeyCmp>::iterator it = 
-         _impl->find(Tuple<const K, T>(k, T()));
+   typename _Impl::iterator it = _impl->find(Node(k));
    if (it != _impl->end())
-      return const_cast<T&>(it->template get<1>());
+      return it->entry().template get<1>();
    else
-      return put(k, T())->template get<1>();
+      KAREN_THROW(NotFoundException,
+         "cannot find element in tree map with such a key");
 }
 
-template <class K, class T>
+template <class K, class T, class Allocator>
+const T*
+TreeMap<K, T, Allocator>::tryGet(const K& k) const
+{ return const_cast<TreeMap<K, T, Allocator>*>(this)->tryGet(k); }
+
+template <class K, class T, class Allocator>
+T*
+TreeMap<K, T, Allocator>::tryGet(const K& k)
+{
+   typename _Impl::iterator it = _impl->find(Node(k));
+   return (it != _impl->end()) ? &it->entry().template get<1>() : NULL;
+}
+
+template <class K, class T, class Allocator>
+T&
+TreeMap<K, T, Allocator>::computeIfAbsent(const K& k, const MapValueFactory<T>& factory)
+{
+   typename _Impl::iterator pos;
+   if (!findPosition(k, pos))
+      pos = _impl->emplace_hint(
+            pos, k, typename Map<K, T>::DeferredValue(factory));
+   return pos->entry().template get<1>();
+}
+
+template <class K, class T, class Allocator>
+bool
+TreeMap<K, T, Allocator>::insertOrAssign(const K& k, const T& t)
+{
+   typename _Impl::iterator pos;
+   if (findPosition(k, pos))
+   {
+      pos->entry().template get<1>() = t;
+      return false;
+   }
+   _impl->emplace_hint(pos, k, t);
+   return true;
+}
+
+template <class K, class T, class Allocator>
+bool
+TreeMap<K, T, Allocator>::insertOrAssign(const K& k, T&& t)
+{
+   typename _Impl::iterator pos;
+   if (findPosition(k, pos))
+   {
+      pos->entry().template get<1>() = std::move(t);
+      return false;
+   }
+   _impl->emplace_hint(pos, k, std::move(t));
+   return true;
+}
+
+template <class K, class T, class Allocator>
+void
+TreeMap<K, T, Allocator>::remove(const K& k)
+{ _impl->erase(Node(k)); }
+
+template <class K, class T, class Allocator>
+bool
+TreeMap<K, T, Allocator>::findPosition(const K& k, typename _Impl::iterator& it) const
+{
+   it = _impl->lower_bound(Node(k));
+   return it != _impl->end() && !(*_cmp)(k, it->key());
+}
+
+template <class K, class T, class Allocator>
+typename TreeMap<K, T, Allocator>::ConstFastIterator
+TreeMap<K, T, Allocator>::fastBegin() const
+{ return ConstFastIterator(_impl->begin()); }
+
+template <class K, class T, class Allocator>
+typename TreeMap<K, T, Allocator>::ConstFastIterator
+TreeMap<K, T, Allocator>::fastEnd() const
+{ return ConstFastIterator(_impl->end()); }
+
+template <class K, class T, class Allocator>
+FastRange<typename TreeMap<K, T, Allocator>::ConstFastIterator>
+TreeMap<K, T, Allocator>::fast() const
+{ return FastRange<ConstFastIterator>(fastBegin(), fastEnd()); }
+
+template <class K, class T, class Hash, class KeyEquals>
+HashMap<K, T, Hash, KeyEquals>::HashMap(const Hash& hash, const KeyEquals& eq)
+   : _impl(hash, eq)
+{}
+
+template <class K, class T, class Hash, class KeyEquals>
+HashMap<K, T, Hash, KeyEquals>::HashMap(
+      const Tuple<const K, T>* elems, 
+      unsigned long nelems, 
+      const Hash& hash, 
+      const KeyEquals& eq)
+   : _impl(hash, eq)
+{
+   _impl.reserve(nelems);
+   for (unsigned long i = 0; i < nelems; i++)
+      Map<K, T>::put(elems[i]);
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+unsigned long
+HashMap<K, T, Hash, KeyEquals>::size() const
+{ return _impl.size(); }
+
+template <class K, class T, class Hash, class KeyEquals>
+void
+HashMap<K, T, Hash, KeyEquals>::clear()
+{ _impl.clear(); }
+
+template <class K, class T, class Hash, class KeyEquals>
+void
+HashMap<K, T, Hash, KeyEquals>::remove(Iterator<Tuple<const K, T> >& it)
+{
+   Iterator<Tuple<const K, T>> itCopy = it;
+   HashMapIterator* nit = itCopy.template impl<HashMapIterator>();
+   HashMapReverseIterator* nrit = 
+         itCopy.template impl<HashMapReverseIterator>();
+   if (nit && (nit->collection() == this))
+   {
+      it++;
+      _impl.erase(nit->impl());
+   }
+   else if (nrit && (nrit->collection() == this))
+   {
+      it++;
+      _impl.erase(--nrit->impl().base());
+   }
+   else
+      KAREN_THROW(InvalidInputException, 
+            "cannot remove element from hash map from given iterator:"
+            " the iterator does not belongs to this collection");
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+Iterator<Tuple<const K, T> >
+HashMap<K, T, Hash, KeyEquals>::begin()
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it =
+         new HashMapIterator(*this, _impl.begin(), _impl.end());
+   return Iterator<Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+Iterator<Tuple<const K, T> >
+HashMap<K, T, Hash, KeyEquals>::end()
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it =
+         new HashMapIterator(*this, _impl.end(), _impl.end());
+   return Iterator<Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+Iterator<const Tuple<const K, T> >
+HashMap<K, T, Hash, KeyEquals>::begin() const
+{
+   Ptr<AbstractIterator<const Tuple<const K, T> > > it =
+         new HashMapIterator(*this, _impl.begin(), _impl.end());
+   return Iterator<const Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+Iterator<const Tuple<const K, T> >
+HashMap<K, T, Hash, KeyEquals>::end() const
+{
+   Ptr<AbstractIterator<const Tuple<const K, T> > > it =
+         new HashMapIterator(*this, _impl.end(), _impl.end());
+   return Iterator<const Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+Iterator<Tuple<const K, T> >
+HashMap<K, T, Hash, KeyEquals>::rbegin()
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<Tuple<const K, T> > > it =
+         new HashMapReverseIterator(*this, ReverseIt(_impl.end()), ReverseIt(_impl.begin()));
+   return Iterator<Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+Iterator<Tuple<const K, T> >
+HashMap<K, T, Hash, KeyEquals>::rend()
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<Tuple<const K, T> > > it =
+         new HashMapReverseIterator(*this, ReverseIt(_impl.begin()), ReverseIt(_impl.begin()));
+   return Iterator<Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+Iterator<const Tuple<const K, T> >
+HashMap<K, T, Hash, KeyEquals>::rbegin() const
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<const Tuple<const K, T> > > it =
+         new HashMapReverseIterator(*this, ReverseIt(_impl.end()), ReverseIt(_impl.begin()));
+   return Iterator<const Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+Iterator<const Tuple<const K, T> >
+HashMap<K, T, Hash, KeyEquals>::rend() const
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<const Tuple<const K, T> > > it =
+         new HashMapReverseIterator(*this, ReverseIt(_impl.begin()), ReverseIt(_impl.begin()));
+   return Iterator<const Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+bool
+HashMap<K, T, Hash, KeyEquals>::hasKey(const K& k) const
+{ return _impl.find(k) != _impl.end(); }
+
+template <class K, class T, class Hash, class KeyEquals>
+Iterator<Tuple<const K, T>>
+HashMap<K, T, Hash, KeyEquals>::put(const K& k, const T& t)
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it = new HashMapIterator(
+         *this, _impl.emplace(k, k, t).first, _impl.end());
+   return it;
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+Iterator<Tuple<const K, T>>
+HashMap<K, T, Hash, KeyEquals>::put(const K& k, T&& t)
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it = new HashMapIterator(
+         *this, _impl.emplace(k, k, std::move(t)).first, _impl.end());
+   return it;
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+template <class ... Args>
+Iterator<Tuple<const K, T>>
+HashMap<K, T, Hash, KeyEquals>::emplace(const K& k, Args&& ... args)
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it = new HashMapIterator(
+         *this, 
+         _impl.emplace(k, k, T(std::forward<Args>(args)...)).first, 
+         _impl.end());
+   return it;
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+const T&
+HashMap<K, T, Hash, KeyEquals>::get(const K& k) const
+throw (NotFoundException)
+{
+   return const_cast<HashMap<K, T, Hash, KeyEquals>*>(this)->get(k);
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+T&
+HashMap<K, T, Hash, KeyEquals>::get(const K& k)
+throw (NotFoundException)
+{
+   typename _Impl::iterator it = _impl.find(k);
+   if (it != _impl.end())
+      return it->template get<1>();
+   else
+      KAREN_THROW(NotFoundException,
+         "cannot find element in hash map with such a key");
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+const T*
+HashMap<K, T, Hash, KeyEquals>::tryGet(const K& k) const
+{ return const_cast<HashMap<K, T, Hash, KeyEquals>*>(this)->tryGet(k); }
+
+template <class K, class T, class Hash, class KeyEquals>
+T*
+HashMap<K, T, Hash, KeyEquals>::tryGet(const K& k)
+{
+   typename _Impl::iterator it = _impl.find(k);
+   return (it != _impl.end()) ? &it->template get<1>() : NULL;
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+T&
+HashMap<K, T, Hash, KeyEquals>::computeIfAbsent(
+      const K& k, const MapValueFactory<T>& factory)
+{
+   return _impl.emplace(k, k, typename Map<K, T>::DeferredValue(factory))
+         .first->template get<1>();
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+bool
+HashMap<K, T, Hash, KeyEquals>::insertOrAssign(const K& k, const T& t)
+{
+   std::pair<typename _Impl::iterator, bool> res = _impl.emplace(k, k, t);
+   if (!res.second)
+      res.first->template get<1>() = t;
+   return res.second;
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+bool
+HashMap<K, T, Hash, KeyEquals>::insertOrAssign(const K& k, T&& t)
+{
+   // The element is only moved from when a new entry is created
+   std::pair<typename _Impl::iterator, bool> res = 
+         _impl.emplace(k, k, std::move(t));
+   if (!res.second)
+      res.first->template get<1>() = std::move(t);
+   return res.second;
+}
+
+template <class K, class T, class Hash, class KeyEquals>
+void
+HashMap<K, T, Hash, KeyEquals>::remove(const K& k)
+{ _impl.erase(k); }
+
+template <class K, class T, class Hash, class KeyEquals>
+unsigned long
+HashMap<K, T, Hash, KeyEquals>::capacity() const
+{ return _impl.capacity(); }
+
+template <class K, class T, class Hash, class KeyEquals>
+void
+HashMap<K, T, Hash, KeyEquals>::reserve(unsigned long size)
+{ _impl.reserve(size); }
+
+template <class K, class T, class Hash, class KeyEquals>
+typename HashMap<K, T, Hash, KeyEquals>::ConstFastIterator
+HashMap<K, T, Hash, KeyEquals>::fastBegin() const
+{ return _impl.begin(); }
+
+template <class K, class T, class Hash, class KeyEquals>
+typename HashMap<K, T, Hash, KeyEquals>::ConstFastIterator
+HashMap<K, T, Hash, KeyEquals>::fastEnd() const
+{ return _impl.end(); }
+
+template <class K, class T, class Hash, class KeyEquals>
+FastRange<typename HashMap<K, T, Hash, KeyEquals>::ConstFastIterator>
+HashMap<K, T, Hash, KeyEquals>::fast() const
+{ return FastRange<ConstFastIterator>(fastBegin(), fastEnd()); }
+
+template <class K, class T, class Compare>
+BTreeMap<K, T, Compare>::BTreeMap(const Compare& cmp)
+   : _impl(cmp)
+{}
+
+template <class K, class T, class Compare>
+BTreeMap<K, T, Compare>::BTreeMap(
+      const Tuple<const K, T>* elems, 
+      unsigned long nelems, 
+      const Compare& cmp)
+   : _impl(cmp)
+{
+   unsigned long i = 1;
+   while (i < nelems && cmp(elems[i - 1].template get<0>(), 
+                            elems[i].template get<0>()))
+      i++;
+   if (i >= nelems)
+      _impl.assignSorted(elems, elems + nelems);
+   else
+      for (i = 0; i < nelems; i++)
+         Map<K, T>::put(elems[i]);
+}
+
+template <class K, class T, class Compare>
+unsigned long
+BTreeMap<K, T, Compare>::size() const
+{ return _impl.size(); }
+
+template <class K, class T, class Compare>
+void
+BTreeMap<K, T, Compare>::clear()
+{ _impl.clear(); }
+
+template <class K, class T, class Compare>
+void
+BTreeMap<K, T, Compare>::remove(Iterator<Tuple<const K, T> >& it)
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Iterator<Tuple<const K, T>> itCopy = it;
+   BTreeMapIterator* nit = itCopy.template impl<BTreeMapIterator>();
+   BTreeMapReverseIterator* nrit = 
+         itCopy.template impl<BTreeMapReverseIterator>();
+
+   // Removing may move other entries, so the iterator is rebuilt
+   Ptr<AbstractIterator<Tuple<const K, T> > > next;
+   if (nit && (nit->collection() == this))
+      next = new BTreeMapIterator(
+            *this, _impl.erase(nit->impl()), _impl.end());
+   else if (nrit && (nrit->collection() == this))
+      next = new BTreeMapReverseIterator(
+            *this, 
+            ReverseIt(_impl.erase(--nrit->impl().base())), 
+            ReverseIt(_impl.begin()));
+   else
+      KAREN_THROW(InvalidInputException, 
+            "cannot remove element from b-tree map from given iterator:"
+            " the iterator does not belongs to this collection");
+   it = next;
+}
+
+template <class K, class T, class Compare>
+Iterator<Tuple<const K, T> >
+BTreeMap<K, T, Compare>::begin()
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it =
+         new BTreeMapIterator(*this, _impl.begin(), _impl.end());
+   return Iterator<Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Compare>
+Iterator<Tuple<const K, T> >
+BTreeMap<K, T, Compare>::end()
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it =
+         new BTreeMapIterator(*this, _impl.end(), _impl.end());
+   return Iterator<Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Compare>
+Iterator<const Tuple<const K, T> >
+BTreeMap<K, T, Compare>::begin() const
+{
+   Ptr<AbstractIterator<const Tuple<const K, T> > > it =
+         new BTreeMapIterator(*this, _impl.begin(), _impl.end());
+   return Iterator<const Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Compare>
+Iterator<const Tuple<const K, T> >
+BTreeMap<K, T, Compare>::end() const
+{
+   Ptr<AbstractIterator<const Tuple<const K, T> > > it =
+         new BTreeMapIterator(*this, _impl.end(), _impl.end());
+   return Iterator<const Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Compare>
+Iterator<Tuple<const K, T> >
+BTreeMap<K, T, Compare>::rbegin()
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<Tuple<const K, T> > > it =
+         new BTreeMapReverseIterator(*this, ReverseIt(_impl.end()), ReverseIt(_impl.begin()));
+   return Iterator<Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Compare>
+Iterator<Tuple<const K, T> >
+BTreeMap<K, T, Compare>::rend()
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<Tuple<const K, T> > > it =
+         new BTreeMapReverseIterator(*this, ReverseIt(_impl.begin()), ReverseIt(_impl.begin()));
+   return Iterator<Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Compare>
+Iterator<const Tuple<const K, T> >
+BTreeMap<K, T, Compare>::rbegin() const
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<const Tuple<const K, T> > > it =
+         new BTreeMapReverseIterator(*this, ReverseIt(_impl.end()), ReverseIt(_impl.begin()));
+   return Iterator<const Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Compare>
+Iterator<const Tuple<const K, T> >
+BTreeMap<K, T, Compare>::rend() const
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<const Tuple<const K, T> > > it =
+         new BTreeMapReverseIterator(*this, ReverseIt(_impl.begin()), ReverseIt(_impl.begin()));
+   return Iterator<const Tuple<const K, T> >(it);
+}
+
+template <class K, class T, class Compare>
+bool
+BTreeMap<K, T, Compare>::hasKey(const K& k) const
+{ return _impl.find(k) != _impl.end(); }
+
+template <class K, class T, class Compare>
+Iterator<Tuple<const K, T>>
+BTreeMap<K, T, Compare>::put(const K& k, const T& t)
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it = new BTreeMapIterator(
+         *this, _impl.emplace(k, k, t).first, _impl.end());
+   return it;
+}
+
+template <class K, class T, class Compare>
+Iterator<Tuple<const K, T>>
+BTreeMap<K, T, Compare>::put(const K& k, T&& t)
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it = new BTreeMapIterator(
+         *this, _impl.emplace(k, k, std::move(t)).first, _impl.end());
+   return it;
+}
+
+template <class K, class T, class Compare>
+template <class ... Args>
+Iterator<Tuple<const K, T>>
+BTreeMap<K, T, Compare>::emplace(const K& k, Args&& ... args)
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it = new BTreeMapIterator(
+         *this, 
+         _impl.emplace(k, k, T(std::forward<Args>(args)...)).first, 
+         _impl.end());
+   return it;
+}
+
+template <class K, class T, class Compare>
+const T&
+BTreeMap<K, T, Compare>::get(const K& k) const
+throw (NotFoundException)
+{
+   return const_cast<BTreeMap<K, T, Compare>*>(this)->get(k);
+}
+
+template <class K, class T, class Compare>
+T&
+BTreeMap<K, T, Compare>::get(const K& k)
+throw (NotFoundException)
+{
+   typename _Impl::iterator it = _impl.find(k);
+   if (it != _impl.end())
+      return it->template get<1>();
+   else
+      KAREN_THROW(NotFoundException,
+         "cannot find element in b-tree map with such a key");
+}
+
+template <class K, class T, class Compare>
+const T*
+BTreeMap<K, T, Compare>::tryGet(const K& k) const
+{ return const_cast<BTreeMap<K, T, Compare>*>(this)->tryGet(k); }
+
+template <class K, class T, class Compare>
+T*
+BTreeMap<K, T, Compare>::tryGet(const K& k)
+{
+   typename _Impl::iterator it = _impl.find(k);
+   return (it != _impl.end()) ? &it->template get<1>() : NULL;
+}
+
+template <class K, class T, class Compare>
+T&
+BTreeMap<K, T, Compare>::computeIfAbsent(
+      const K& k, const MapValueFactory<T>& factory)
+{
+   return _impl.emplace(k, k, typename Map<K, T>::DeferredValue(factory))
+         .first->template get<1>();
+}
+
+template <class K, class T, class Compare>
+bool
+BTreeMap<K, T, Compare>::insertOrAssign(const K& k, const T& t)
+{
+   std::pair<typename _Impl::iterator, bool> res = _impl.emplace(k, k, t);
+   if (!res.second)
+      res.first->template get<1>() = t;
+   return res.second;
+}
+
+template <class K, class T, class Compare>
+bool
+BTreeMap<K, T, Compare>::insertOrAssign(const K& k, T&& t)
+{
+   // The element is only moved from when a new entry is created
+   std::pair<typename _Impl::iterator, bool> res = 
+         _impl.emplace(k, k, std::move(t));
+   if (!res.second)
+      res.first->template get<1>() = std::move(t);
+   return res.second;
+}
+
+template <class K, class T, class Compare>
 void
-TreeMap<K, T>::remove(const K& k)
-{ _impl->erase(Tuple<const K, T>(k, T())); }
+BTreeMap<K, T, Compare>::remove(const K& k)
+{ _impl.erase(k); }
+
+template <class K, class T, class Compare>
+Iterator<Tuple<const K, T>>
+BTreeMap<K, T, Compare>::lowerBound(const K& k)
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it = new BTreeMapIterator(
+         *this, _impl.lowerBound(k), _impl.end());
+   return it;
+}
+
+template <class K, class T, class Compare>
+Iterator<const Tuple<const K, T>>
+BTreeMap<K, T, Compare>::lowerBound(const K& k) const
+{
+   Ptr<AbstractIterator<const Tuple<const K, T> > > it = new BTreeMapIterator(
+         *this, _impl.lowerBound(k), _impl.end());
+   return it;
+}
+
+template <class K, class T, class Compare>
+Iterator<Tuple<const K, T>>
+BTreeMap<K, T, Compare>::upperBound(const K& k)
+{
+   Ptr<AbstractIterator<Tuple<const K, T> > > it = new BTreeMapIterator(
+         *this, _impl.upperBound(k), _impl.end());
+   return it;
+}
+
+template <class K, class T, class Compare>
+Iterator<const Tuple<const K, T>>
+BTreeMap<K, T, Compare>::upperBound(const K& k) const
+{
+   Ptr<AbstractIterator<const Tuple<const K, T> > > it = new BTreeMapIterator(
+         *this, _impl.upperBound(k), _impl.end());
+   return it;
+}
+
+template <class K, class T, class Compare>
+typename BTreeMap<K, T, Compare>::ConstFastIterator
+BTreeMap<K, T, Compare>::fastBegin() const
+{ return _impl.begin(); }
+
+template <class K, class T, class Compare>
+typename BTreeMap<K, T, Compare>::ConstFastIterator
+BTreeMap<K, T, Compare>::fastEnd() const
+{ return _impl.end(); }
+
+template <class K, class T, class Compare>
+FastRange<typename BTreeMap<K, T, Compare>::ConstFastIterator>
+BTreeMap<K, T, Compare>::fast() const
+{ return FastRange<ConstFastIterator>(fastBegin(), fastEnd()); }
+
+template <class K, class T, class Compare>
+FastRange<typename BTreeMap<K, T, Compare>::ConstFastIterator>
+BTreeMap<K, T, Compare>::fastRange(const K& from, const K& to) const
+{
+   ConstFastIterator first = _impl.lowerBound(from);
+   ConstFastIterator last = _impl.lowerBound(to);
+   return FastRange<ConstFastIterator>(first, last);
+}
 
 }
 
@@ -25,14 +25,60 @@
 #ifndef KAREN_CORE_MAP_H
 #define KAREN_CORE_MAP_H
 
+#include <iterator>
 #include <map>
 #include <set>
+#include <type_traits>
 
+#include "KarenCore/btree.h"
 #include "KarenCore/collection.h"
+#include "KarenCore/hash-table.h"
 #include "KarenCore/pointer.h"
 
 namespace karen {
 
+/**
+ * Map value factory template class. This class provides the interface for
+ * the objects that build the value of a new map entry on demand. It is 
+ * passed to Map::computeIfAbsent(), so the value is only built when there
+ * is no entry with the given key.
+ */
+template <class T>
+struct MapValueFactory
+{
+   inline virtual ~MapValueFactory() {}
+
+   inline T operator() () const
+   { return this->create(); }
+
+   virtual T create() const = 0;
+};
+
+/**
+ * Default map value factory. It builds default-constructed values.
+ */
+template <class T>
+struct DefaultMapValueFactory : MapValueFactory<T>
+{
+   inline virtual T create() const
+   { return T(); }
+};
+
+/**
+ * Function map value factory. It builds values by calling a function
+ * object with no arguments, such as a lambda expression. 
+ */
+template <class T, class Function>
+struct FunctionMapValueFactory : MapValueFactory<T>
+{
+   Function function;
+
+   inline FunctionMapValueFactory(const Function& f) : function(f) {}
+
+   inline virtual T create() const
+   { return function(); }
+};
+
 /**
  * Map template class. This template class provides the interface for
  * a collection that behaves as a map or dictionary. 
@@ -50,7 +96,7 @@ public:
 
    /**
     * Array subscript operator. This returns the value for given key if exists
-    * or creates a new value and returns it otherwise.
+    * or creates a new value and returns it otherwise. See getOrInsert().
     */
    inline T& operator[] (const K& k);
 
@@ -63,11 +109,22 @@ public:
     * Put a new element in the map with given key. 
     */
    virtual Iterator<Tuple<const K, T>> put(const K& k, const T& t) = 0;
+
+   /**
+    * Put a new element in the map with given key by moving it. 
+    */
+   virtual Iterator<Tuple<const K, T>> put(const K& k, T&& t) = 0;
    
    /**
     * Put a new element in the map with given key from its wrapping tuple.
     */
    inline void put(const Tuple<const K, T>& value);
+   
+   /**
+    * Put a new element in the map with given key from its wrapping tuple,
+    * moving the element out of it.
+    */
+   inline void put(Tuple<const K, T>&& value);
 
    /**
     * Retrieve an element by its key, or throw a NotFoundException if 
@@ -81,26 +138,214 @@ public:
     */
    virtual T& get(const K& k) throw (NotFoundException) = 0;
    
+   /**
+    * Retrieve a pointer to the element with given key, or a null pointer 
+    * if there is no such key defined in the map. Unlike get(), this does
+    * not throw on undefined keys, which makes it cheaper when they are 
+    * expected. 
+    */
+   virtual const T* tryGet(const K& k) const = 0;
+   
+   /**
+    * Retrieve a pointer to the element with given key, or a null pointer 
+    * if there is no such key defined in the map. 
+    */
+   virtual T* tryGet(const K& k) = 0;
+
+   /**
+    * Retrieve the element with given key. If there is no such key, a new 
+    * entry is put with the element built by given factory, which is not
+    * called otherwise. The map is searched once. 
+    */
+   virtual T& computeIfAbsent(const K& k, 
+                              const MapValueFactory<T>& factory) = 0;
+
+   /**
+    * Retrieve the element with given key. If there is no such key, a new 
+    * entry is put with the element returned by given function object.
+    */
+   template <class Function>
+   inline T& computeIfAbsent(const K& k, Function f);
+
+   /**
+    * Retrieve the element with given key. If there is no such key, a new
+    * entry is put with a default-constructed element. 
+    */
+   inline T& getOrInsert(const K& k);
+
+   /**
+    * Put a new element in the map with given key, or assign it to the 
+    * element with that key if already defined. It returns whether a new
+    * entry was put. 
+    */
+   virtual bool insertOrAssign(const K& k, const T& t) = 0;
+
+   /**
+    * Put a new element in the map with given key by moving it, or move it
+    * to the element with that key if already defined. It returns whether 
+    * a new entry was put. 
+    */
+   virtual bool insertOrAssign(const K& k, T&& t) = 0;
+
    /**
     * Remove an elemenet by its key. If there is no entry with such key,
     * it has no effect. 
     */
    virtual void remove(const K& k) = 0;
+
+protected:
+
+   /*
+    * Value built by a factory when converted to T. Passing it to the 
+    * emplace operations of the implementations defers building the value 
+    * until they actually create a new entry. 
+    */
+   struct DeferredValue
+   {
+      const MapValueFactory<T>& factory;
+
+      inline DeferredValue(const MapValueFactory<T>& f) : factory(f) {}
+
+      inline operator T () const
+      { return factory.create(); }
+   };
    
 };
 
+/**
+ * Tree map node template class. This is the element type of the tree
+ * that implements a TreeMap. Nodes stored in the tree hold a map entry, 
+ * while the nodes used to search it only point to the key being looked 
+ * up, so lookups by key build no entry, nor any value.
+ */
 template <class K, class T>
+class TreeMapNode
+{
+public:
+
+   /**
+    * Create a search node for given key. 
+    */
+   inline explicit TreeMapNode(const K& k) : _probe(&k) {}
+
+   /**
+    * Create a node holding an entry with given key and value. 
+    */
+   template <class U>
+   inline TreeMapNode(const K& k, U&& value);
+
+   inline TreeMapNode(const TreeMapNode& node);
+
+   inline TreeMapNode(TreeMapNode&& node);
+
+   inline ~TreeMapNode();
+
+   inline const K& key() const
+   { return _probe ? *_probe : entry().template get<0>(); }
+
+   /**
+    * Obtain the entry held by this node. Entry values are not involved in
+    * ordering the tree, so they may be modified in place.
+    */
+   inline Tuple<const K, T>& entry() const
+   { return *reinterpret_cast<Tuple<const K, T>*>(&_entry); }
+
+private:
+
+   const K* _probe;
+   mutable typename std::aligned_storage<
+         sizeof(Tuple<const K, T>), 
+         std::alignment_of<Tuple<const K, T> >::value>::type _entry;
+
+   TreeMapNode& operator = (const TreeMapNode&);
+
+};
+
+/**
+ * Tree map node iterator template class. This class adapts an iterator 
+ * over the nodes of a TreeMap to one over their entries. It is 
+ * instantiated with a const-qualified entry type for constant iteration.
+ */
+template <class V, class NodeIterator>
+class TreeMapNodeIterator
+{
+public:
+
+   typedef std::bidirectional_iterator_tag iterator_category;
+   typedef typename std::remove_const<V>::type value_type;
+   typedef long difference_type;
+   typedef V* pointer;
+   typedef V& reference;
+
+   inline TreeMapNodeIterator() {}
+
+   inline explicit TreeMapNodeIterator(const NodeIterator& it) : _it(it) {}
+
+   /**
+    * Create a constant iterator from a non-constant one.
+    */
+   template <class Other, class OtherIterator>
+   inline TreeMapNodeIterator(
+         const TreeMapNodeIterator<Other, OtherIterator>& it)
+      : _it(it.base()) {}
+
+   inline V& operator * () const
+   { return _it->entry(); }
+
+   inline V* operator -> () const
+   { return &_it->entry(); }
+
+   inline TreeMapNodeIterator& operator ++ ()
+   { ++_it; return *this; }
+
+   inline TreeMapNodeIterator operator ++ (int)
+   { return TreeMapNodeIterator(_it++); }
+
+   inline TreeMapNodeIterator& operator -- ()
+   { --_it; return *this; }
+
+   inline TreeMapNodeIterator operator -- (int)
+   { return TreeMapNodeIterator(_it--); }
+
+   inline bool operator == (const TreeMapNodeIterator& it) const
+   { return _it == it._it; }
+
+   inline bool operator != (const TreeMapNodeIterator& it) const
+   { return _it != it._it; }
+
+   /**
+    * Obtain the adapted node iterator.
+    */
+   inline const NodeIterator& base() const
+   { return _it; }
+
+private:
+
+   NodeIterator _it;
+
+};
+
+/**
+ * Tree map template class. This class implements the Map interface by
+ * means of a balanced binary tree, which nodes are obtained from given
+ * Allocator. Entries are iterated in ascending key order.
+ */
+template <class K, 
+          class T, 
+          class Allocator = std::allocator<Tuple<const K, T> > >
 class TreeMap : public Map<K, T>
 {
 public:
 
    typedef BinaryPredicate<K, K> KeyComparator;
 
-   inline TreeMap(const Ptr<KeyComparator>& cmp = new LessThan<K, K>());
+   inline TreeMap(const Ptr<KeyComparator>& cmp = new LessThan<K, K>(),
+                  const Allocator& alloc = Allocator());
    
    inline TreeMap(const Tuple<const K, T>* elems, 
                   unsigned long nelems,
-                  const Ptr<KeyComparator>& cmp = new LessThan<K, K>());
+                  const Ptr<KeyComparator>& cmp = new LessThan<K, K>(),
+                  const Allocator& alloc = Allocator());
 
    inline ~TreeMap();
 
@@ -128,16 +373,42 @@ public:
 
    inline virtual bool hasKey(const K& k) const;
 
+   using Map<K, T>::put;
+
    inline virtual Iterator<Tuple<const K, T>> put(const K& k, const T& t);
+
+   inline virtual Iterator<Tuple<const K, T>> put(const K& k, T&& t);
+
+   /**
+    * Put a new element in the map with given key constructing it from 
+    * given arguments. The element is built once and moved into the map.
+    */
+   template <class ... Args>
+   inline Iterator<Tuple<const K, T>> emplace(const K& k, Args&& ... args);
    
    inline virtual const T& get(const K& k) const throw (NotFoundException);
    
    inline virtual T& get(const K& k) throw (NotFoundException);
+
+   inline virtual const T* tryGet(const K& k) const;
+
+   inline virtual T* tryGet(const K& k);
+
+   using Map<K, T>::computeIfAbsent;
+
+   inline virtual T& computeIfAbsent(const K& k, 
+                                     const MapValueFactory<T>& factory);
+
+   inline virtual bool insertOrAssign(const K& k, const T& t);
+
+   inline virtual bool insertOrAssign(const K& k, T&& t);
    
    inline virtual void remove(const K& k);
 
 private:
 
+   typedef TreeMapNode<K, T> Node;
+
    struct KeyCmp
    {
       Ptr<KeyComparator> cmp;
@@ -145,22 +416,311 @@ private:
       inline KeyCmp(const Ptr<KeyComparator>& c = new LessThan<K, K>()) 
          : cmp(c) {}
    
-      inline bool operator () (const Tuple<const K, T>& lhs, 
-                               const Tuple<const K, T>& rhs) const
-      { 
-         return (*cmp)(lhs.template get<0>(), rhs.template get<0>()); 
-      }
+      inline bool operator () (const Node& lhs, const Node& rhs) const
+      { return (*cmp)(lhs.key(), rhs.key()); }
    };
    
-   typedef std::set<Tuple<const K, T>, KeyCmp> _Impl;
+   typedef typename std::allocator_traits<Allocator>::template 
+         rebind_alloc<Node> NodeAllocator;
+
+   typedef std::set<Node, KeyCmp, NodeAllocator> _Impl;
+
+   typedef TreeMapNodeIterator<Tuple<const K, T>, 
+         typename _Impl::iterator> NodeIterator;
 
    typedef IteratorImpl<Tuple<const K, T>, TreeMap,
-         typename _Impl::iterator> TreeMapIterator;
+         NodeIterator> TreeMapIterator;
    
    typedef IteratorImpl<Tuple<const K, T>, TreeMap,
-         typename _Impl::reverse_iterator> TreeMapReverseIterator;
+         std::reverse_iterator<NodeIterator> > TreeMapReverseIterator;
    
    mutable _Impl* _impl;
+   Ptr<KeyComparator> _cmp;
+
+   /*
+    * Find the node with given key, or the position where it would be 
+    * inserted. It returns whether the key was found. 
+    */
+   inline bool findPosition(const K& k, typename _Impl::iterator& it) const;
+
+public:
+
+   /**
+    * Fast iterator type. See FastRange for details. Map entries are
+    * traversed as const tuples; use get() to update a value.
+    */
+   typedef TreeMapNodeIterator<const Tuple<const K, T>, 
+         typename _Impl::const_iterator> ConstFastIterator;
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<ConstFastIterator> fast() const;
+
+};
+
+/**
+ * Hash map template class. This class implements the Map interface by
+ * means of a HashTable, an open-addressing hash table with elements 
+ * stored inline. Lookups take constant time in average, at the cost of
+ * iterating the entries in no particular order. Keys are hashed by Hash
+ * and compared by KeyEquals; see DefaultHash for the supported key types.
+ * Iterators are invalidated when an entry is put into the map.
+ */
+template <class K, 
+          class T, 
+          class Hash = DefaultHash<K>, 
+          class KeyEquals = DefaultEquals<K> >
+class HashMap : public Map<K, T>
+{
+public:
+
+   inline HashMap(const Hash& hash = Hash(), 
+                  const KeyEquals& eq = KeyEquals());
+   
+   inline HashMap(const Tuple<const K, T>* elems, 
+                  unsigned long nelems,
+                  const Hash& hash = Hash(), 
+                  const KeyEquals& eq = KeyEquals());
+
+   inline virtual unsigned long size() const;
+   
+   inline virtual void clear();
+   
+   inline virtual void remove(Iterator<Tuple<const K, T> >& it);
+   
+   inline virtual Iterator<Tuple<const K, T> > begin();
+   
+   inline virtual Iterator<Tuple<const K, T> > end();
+
+   inline virtual Iterator<const Tuple<const K, T> > begin() const;
+   
+   inline virtual Iterator<const Tuple<const K, T> > end() const;
+
+   inline virtual Iterator<Tuple<const K, T> > rbegin();
+   
+   inline virtual Iterator<Tuple<const K, T> > rend();
+
+   inline virtual Iterator<const Tuple<const K, T> > rbegin() const;
+   
+   inline virtual Iterator<const Tuple<const K, T> > rend() const;
+
+   inline virtual bool hasKey(const K& k) const;
+
+   using Map<K, T>::put;
+
+   inline virtual Iterator<Tuple<const K, T>> put(const K& k, const T& t);
+
+   inline virtual Iterator<Tuple<const K, T>> put(const K& k, T&& t);
+
+   /**
+    * Put a new element in the map with given key constructing it from 
+    * given arguments. The element is built once and moved into the map.
+    */
+   template <class ... Args>
+   inline Iterator<Tuple<const K, T>> emplace(const K& k, Args&& ... args);
+   
+   inline virtual const T& get(const K& k) const throw (NotFoundException);
+   
+   inline virtual T& get(const K& k) throw (NotFoundException);
+
+   inline virtual const T* tryGet(const K& k) const;
+
+   inline virtual T* tryGet(const K& k);
+
+   using Map<K, T>::computeIfAbsent;
+
+   inline virtual T& computeIfAbsent(const K& k, 
+                                     const MapValueFactory<T>& factory);
+
+   inline virtual bool insertOrAssign(const K& k, const T& t);
+
+   inline virtual bool insertOrAssign(const K& k, T&& t);
+   
+   inline virtual void remove(const K& k);
+
+   /**
+    * Obtain the number of slots of the hash table. 
+    */
+   inline unsigned long capacity() const;
+
+   /**
+    * Ensure the map may hold given number of entries without growing.
+    */
+   inline void reserve(unsigned long size);
+
+private:
+
+   struct EntryKey
+   {
+      inline const K& operator () (const Tuple<const K, T>& entry) const
+      { return entry.template get<0>(); }
+   };
+
+   typedef HashTable<Tuple<const K, T>, K, EntryKey, Hash, KeyEquals> _Impl;
+
+   typedef IteratorImpl<Tuple<const K, T>, HashMap,
+         typename _Impl::iterator> HashMapIterator;
+   
+   typedef IteratorImpl<Tuple<const K, T>, HashMap,
+         std::reverse_iterator<typename _Impl::iterator> > 
+         HashMapReverseIterator;
+   
+   mutable _Impl _impl;
+
+public:
+
+   /**
+    * Fast iterator type. See FastRange for details. Map entries are
+    * traversed as const tuples; use get() to update a value.
+    */
+   typedef typename _Impl::const_iterator ConstFastIterator;
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<ConstFastIterator> fast() const;
+
+};
+
+/**
+ * B-tree map template class. This class implements the Map interface by
+ * means of a BTree, a B+tree whose leaves store tens of entries inline. 
+ * Compared to TreeMap, it performs one allocation every several entries 
+ * rather than one per entry, and both lookups and ordered scans touch
+ * far fewer cache lines. Keys are ordered by Compare. The map is built in
+ * linear time from an array of entries sorted by key. Iterators are 
+ * invalidated when an entry is put into or removed from the map.
+ */
+template <class K, class T, class Compare = DefaultLessThan<K> >
+class BTreeMap : public Map<K, T>
+{
+public:
+
+   inline BTreeMap(const Compare& cmp = Compare());
+   
+   /**
+    * Create a new map with given entries. If they are sorted by strictly
+    * ascending keys the map is built in linear time; otherwise they are
+    * put one by one. 
+    */
+   inline BTreeMap(const Tuple<const K, T>* elems, 
+                   unsigned long nelems,
+                   const Compare& cmp = Compare());
+
+   inline virtual unsigned long size() const;
+   
+   inline virtual void clear();
+   
+   inline virtual void remove(Iterator<Tuple<const K, T> >& it);
+   
+   inline virtual Iterator<Tuple<const K, T> > begin();
+   
+   inline virtual Iterator<Tuple<const K, T> > end();
+
+   inline virtual Iterator<const Tuple<const K, T> > begin() const;
+   
+   inline virtual Iterator<const Tuple<const K, T> > end() const;
+
+   inline virtual Iterator<Tuple<const K, T> > rbegin();
+   
+   inline virtual Iterator<Tuple<const K, T> > rend();
+
+   inline virtual Iterator<const Tuple<const K, T> > rbegin() const;
+   
+   inline virtual Iterator<const Tuple<const K, T> > rend() const;
+
+   inline virtual bool hasKey(const K& k) const;
+
+   using Map<K, T>::put;
+
+   inline virtual Iterator<Tuple<const K, T>> put(const K& k, const T& t);
+
+   inline virtual Iterator<Tuple<const K, T>> put(const K& k, T&& t);
+
+   /**
+    * Put a new element in the map with given key constructing it from 
+    * given arguments. The element is built once and moved into the map.
+    */
+   template <class ... Args>
+   inline Iterator<Tuple<const K, T>> emplace(const K& k, Args&& ... args);
+   
+   inline virtual const T& get(const K& k) const throw (NotFoundException);
+   
+   inline virtual T& get(const K& k) throw (NotFoundException);
+
+   inline virtual const T* tryGet(const K& k) const;
+
+   inline virtual T* tryGet(const K& k);
+
+   using Map<K, T>::computeIfAbsent;
+
+   inline virtual T& computeIfAbsent(const K& k, 
+                                     const MapValueFactory<T>& factory);
+
+   inline virtual bool insertOrAssign(const K& k, const T& t);
+
+   inline virtual bool insertOrAssign(const K& k, T&& t);
+   
+   inline virtual void remove(const K& k);
+
+   /**
+    * Obtain an iterator to the first entry whose key is not less than
+    * given one, or end() if there is no such entry.
+    */
+   inline Iterator<Tuple<const K, T>> lowerBound(const K& k);
+
+   inline Iterator<const Tuple<const K, T>> lowerBound(const K& k) const;
+
+   /**
+    * Obtain an iterator to the first entry whose key is greater than
+    * given one, or end() if there is no such entry.
+    */
+   inline Iterator<Tuple<const K, T>> upperBound(const K& k);
+
+   inline Iterator<const Tuple<const K, T>> upperBound(const K& k) const;
+
+private:
+
+   struct EntryKey
+   {
+      inline const K& operator () (const Tuple<const K, T>& entry) const
+      { return entry.template get<0>(); }
+   };
+
+   typedef BTree<Tuple<const K, T>, K, EntryKey, Compare> _Impl;
+
+   typedef IteratorImpl<Tuple<const K, T>, BTreeMap,
+         typename _Impl::iterator> BTreeMapIterator;
+   
+   typedef IteratorImpl<Tuple<const K, T>, BTreeMap,
+         std::reverse_iterator<typename _Impl::iterator> > 
+         BTreeMapReverseIterator;
+   
+   mutable _Impl _impl;
+
+public:
+
+   /**
+    * Fast iterator type. See FastRange for details. Map entries are
+    * traversed as const tuples; use get() to update a value.
+    */
+   typedef typename _Impl::const_iterator ConstFastIterator;
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<ConstFastIterator> fast() const;
+
+   /**
+    * Obtain a fast range over the entries whose keys are not less than 
+    * from and less than to, which must not be less than from.
+    */
+   inline FastRange<ConstFastIterator> fastRange(const K& from, 
+                                                 const K& to) const;
 
 };
 
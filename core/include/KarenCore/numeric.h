@@ -25,23 +25,92 @@
 #ifndef KAREN_CORE_NUMERIC_H
 #define KAREN_CORE_NUMERIC_H
 
-#include "KarenCore/string.h"
+#include "KarenCore/array.h"
 #include "KarenCore/exception.h"
+#include "KarenCore/string.h"
 
 namespace karen {
 
+/**
+ * Numeric parse error. This enumeration indicates why a parse of a
+ * number failed, if it did.
+ */
+enum ParseError
+{
+   PARSE_OK,               // The number was parsed
+   PARSE_INVALID,          // The input does not begin with a number
+   PARSE_OUT_OF_RANGE,     // The number is not representable
+};
+
+/**
+ * Numeric parse result. This struct provides the position the parse
+ * stopped at and its error, if any. 
+ */
+struct ParseResult
+{
+   const char* end;     // First character not consumed by the parse
+   ParseError  error;   // The parse error, or PARSE_OK
+
+   inline bool ok() const
+   { return error == PARSE_OK; }
+};
+
 class KAREN_EXPORT Integer
 {
 public:
 
+   /**
+    * Maximum number of characters written by format().
+    */
+   static const unsigned int FORMAT_LENGTH = 20;
+
    /**
     * Convert a string object into a long value. The string object is
-    * interpreted in the base specified as argument. If string value cannot
-    * be converted into long, a InvalidConversionException is raised. 
+    * interpreted in the base specified as argument. Leading whitespace,
+    * a sign and, in base 16, a 0x prefix are accepted, as well as base 0
+    * to detect the base from the prefix. If string value cannot be 
+    * converted into long, a InvalidConversionException is raised. 
     */
    static long toLong(const String &str, unsigned int base = 10) 
          throw (InvalidConversionException);
 
+   /**
+    * Parse a long value from the characters in [first, last) in given 
+    * base, from 2 to 36. The input must begin with the digits, optionally
+    * preceded by a minus sign; no whitespace, plus sign or prefix is 
+    * accepted. The parse stops at the first character that is not a digit.
+    * On error, value is not modified, and the end of the result is first
+    * if the input does not begin with a number. Neither memory is 
+    * allocated nor the locale is read.
+    */
+   static ParseResult parse(
+         const char* first, const char* last, long& value, 
+         unsigned int base = 10);
+
+   /**
+    * Parse a long value from given string view, as in the overload above.
+    */
+   static ParseResult parse(
+         const StringView& str, long& value, unsigned int base = 10);
+
+   /**
+    * Parse a list of long values delimited by given separator, appending
+    * them to given array. Whitespace around the values is skipped, and
+    * an empty or blank input is an empty list. On error, the values
+    * parsed so far remain appended and the result ends at the offending
+    * character.
+    */
+   static ParseResult parseList(
+         const StringView& str, Array<long>& values, char separator = ',',
+         unsigned int base = 10);
+
+   /**
+    * Write the decimal representation of given value into given buffer,
+    * which must have room for FORMAT_LENGTH characters. It returns the 
+    * number of characters written. No null character is appended. 
+    */
+   static unsigned int format(long value, char* buffer);
+
 };
 
 class KAREN_EXPORT Float
@@ -49,14 +118,63 @@ class KAREN_EXPORT Float
 public:
 
    /**
-    * Convert a string object into a long value. The string object is
-    * interpreted in the base specified as argument. If string value cannot
-    * be converted into long, a InvalidConversionException is raised. 
+    * Maximum number of characters written by format().
+    */
+   static const unsigned int FORMAT_LENGTH = 25;
+
+   /**
+    * Convert a string object into a double value. Leading whitespace and 
+    * a sign are accepted. If string value cannot be converted into double,
+    * a InvalidConversionException is raised. 
     */
    static double toDouble(const String &str) throw (InvalidConversionException);
 
+   /**
+    * Parse a double value from the characters in [first, last). The input
+    * must be a decimal number, optionally preceded by a minus sign and
+    * followed by an exponent, or one of inf, infinity or nan, ignoring
+    * case. The decimal point is always '.', whatever the locale. On error, 
+    * value is not modified, and the end of the result is first if the 
+    * input does not begin with a number. The result is correctly rounded.
+    */
+   static ParseResult parse(
+         const char* first, const char* last, double& value);
+
+   /**
+    * Parse a double value from given string view, as in the overload
+    * above.
+    */
+   static ParseResult parse(const StringView& str, double& value);
+
+   /**
+    * Parse a list of double values delimited by given separator, 
+    * appending them to given array, as Integer::parseList() does.
+    */
+   static ParseResult parseList(
+         const StringView& str, Array<double>& values, char separator = ',');
+
+   /**
+    * Write the shortest decimal representation of given value that parses
+    * back to the very same value into given buffer, which must have room 
+    * for FORMAT_LENGTH characters. Exponential notation is used for 
+    * values below 1e-6 or from 1e21 on. It returns the number of
+    * characters written. No null character is appended. 
+    */
+   static unsigned int format(double value, char* buffer);
+
+   /**
+    * Obtain the shortest decimal representation of given value that 
+    * parses back to the very same value, as written by format().
+    */
+   static String toString(double value);
+
 };
 
 }; // namespace karen
 
+using karen::Float;
+using karen::Integer;
+using karen::ParseError;
+using karen::ParseResult;
+
 #endif
@@ -26,6 +26,7 @@
 #define KAREN_CORE_PARSING_H
 
 #include "KarenCore/array.h"
+#include "KarenCore/simd.h"
 #include "KarenCore/string.h"
 
 namespace karen {
@@ -38,6 +39,214 @@ KAREN_EXPORT void tokenizeString(const String& str,
                                  Array<String>& tokens,
                                  char separator = ' '); 
 
+/**
+ * String view tokenizer. Tokenizes a string view, spliting it in views of
+ * its tokens by searching for certain separator. No character is copied,
+ * so the tokens are only valid as long as the tokenized characters are. 
+ */
+KAREN_EXPORT void tokenizeString(const StringView& str, 
+                                 Array<StringView>& tokens,
+                                 char separator = ' '); 
+
+/**
+ * Token span. This struct indicates the position and length of a token
+ * in the tokenized input. 
+ */
+struct TokenSpan
+{
+   unsigned long  offset;
+   unsigned long  length;
+};
+
+/**
+ * Tokenizer class. This class splits its input in tokens delimited by any
+ * character of a separator set. Tokens are obtained as views of the input,
+ * so no character is copied, and they are only valid as long as the input
+ * characters are. The input is classified in blocks of 64 bytes with the
+ * best SIMD kernel available when the tokenizer is created, which may
+ * be set with setSimdLevel(). 
+ *
+ * By default, consecutive separators are collapsed, so there are no empty
+ * tokens. Otherwise, each separator delimits a token as in CSV files. If
+ * a quote character is given, a token starting with it extends up to the
+ * next quote character regardless of separators, and the quotes are not
+ * part of the token. Any text following the closing quote up to the next 
+ * separator is a token on its own. Quote characters can't be escaped. 
+ */
+class KAREN_EXPORT Tokenizer
+{
+public:
+
+   /**
+    * Token iterator class. This class iterates lazily the tokens of an
+    * input, so each one is found when the iterator is incremented. The
+    * tokenizer must outlive its iterators. 
+    */
+   class KAREN_EXPORT TokenIterator
+   {
+   public:
+
+      /**
+       * Create a new null iterator, which is equal to Tokenizer::end().
+       */
+      inline TokenIterator() : _finished(true) {}
+
+      /**
+       * Check whether this iterator is beyond the last token.
+       */
+      inline bool isNull() const
+      { return _finished; }
+
+      inline const StringView& operator * () const
+      { return _token; }
+
+      inline const StringView* operator -> () const
+      { return &_token; }
+
+      inline TokenIterator& operator ++ ()
+      { advance(); return *this; }
+
+      inline bool operator == (const TokenIterator& it) const
+      { 
+         return (_finished || it._finished) ? _finished == it._finished :
+               _input == it._input && _pos == it._pos; 
+      }
+
+      inline bool operator != (const TokenIterator& it) const
+      { return !(*this == it); }
+
+   private:
+
+      friend class Tokenizer;
+
+      const Tokenizer*     _tokenizer;
+      const char*          _input;
+      unsigned long        _length;
+      unsigned long        _pos;
+      unsigned long        _blockStart;
+      unsigned long long   _separatorMask;
+      bool                 _finished;
+      StringView           _token;
+
+      TokenIterator(const Tokenizer& tokenizer, 
+                    const StringView& input,
+                    unsigned long pos = 0);
+
+      void advance();
+
+      void loadBlock(unsigned long pos);
+
+      unsigned long nextSeparator(unsigned long pos);
+
+      unsigned long nextNonSeparator(unsigned long pos);
+   };
+
+   /**
+    * Token range class. This class provides the begin() and end() 
+    * functions to iterate the tokens of an input using range-for loops.
+    */
+   class TokenRange
+   {
+   public:
+
+      inline TokenIterator begin() const
+      { return _tokenizer.begin(_input); }
+
+      inline TokenIterator end() const
+      { return TokenIterator(); }
+
+   private:
+
+      friend class Tokenizer;
+
+      const Tokenizer&  _tokenizer;
+      StringView        _input;
+
+      inline TokenRange(const Tokenizer& tokenizer, const StringView& input)
+       : _tokenizer(tokenizer), _input(input) {}
+   };
+
+   /**
+    * Create a new tokenizer for given separator set, optional quote
+    * character and empty token policy. 
+    */
+   Tokenizer(const StringView& separators = " ",
+             char quote = '\0',
+             bool skipEmpty = true);
+
+   /**
+    * Obtain an iterator to the first token of given input.
+    */
+   TokenIterator begin(const StringView& input) const;
+
+   /**
+    * Obtain an iterator beyond the last token of any input.
+    */
+   inline TokenIterator end() const
+   { return TokenIterator(); }
+
+   /**
+    * Obtain a range of the tokens of given input for range-for loops.
+    */
+   inline TokenRange tokens(const StringView& input) const
+   { return TokenRange(*this, input); }
+
+   /**
+    * Tokenize given input, replacing the contents of given array with its
+    * tokens. It returns the number of tokens. 
+    */
+   unsigned long tokenize(const StringView& input, 
+                          Array<StringView>& tokens) const;
+
+   /**
+    * Tokenize given input in batch mode, writing the spans of its tokens 
+    * in given preallocated array. It stops when maxSpans tokens are found,
+    * so the rest of the input must be tokenized with the overload taking
+    * an offset. It returns the number of spans written. 
+    */
+   unsigned long tokenize(const StringView& input,
+                          TokenSpan* spans,
+                          unsigned long maxSpans) const;
+
+   /**
+    * Tokenize given input in batch mode from given offset, writing the 
+    * spans of its tokens, relative to the start of the input, in given 
+    * preallocated array. It stops when maxSpans tokens are found, and 
+    * sets offset past the separator or quote that ends the last token, so 
+    * calling it again with the same input and offset resumes tokenizing.
+    * It returns the number of spans written, which is zero once the whole
+    * input is tokenized. 
+    */
+   unsigned long tokenize(const StringView& input,
+                          TokenSpan* spans,
+                          unsigned long maxSpans,
+                          unsigned long& offset) const;
+
+private:
+
+   friend struct TokenizerKernels;
+
+   enum { MAX_VECTOR_SEPARATORS = 8 };
+
+   typedef unsigned long long (*Classifier)(
+         const Tokenizer& tokenizer, const char* block);
+
+   char        _separators[MAX_VECTOR_SEPARATORS];
+   unsigned    _separatorCount;
+   bool        _isSeparator[256];
+   char        _quote;
+   char        _filler;
+   bool        _skipEmpty;
+   Classifier  _classify;
+
+   unsigned long tokenizeBlocks(const StringView& input,
+                                TokenSpan* spans,
+                                unsigned long maxSpans) const;
+};
+
 }; // namespace karen
 
+using karen::Tokenizer;
+using karen::TokenSpan;
+
 #endif
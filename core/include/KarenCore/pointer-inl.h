@@ -29,153 +29,182 @@
 
 namespace karen {
 
-template <typename T>
-Ptr<T>::Ptr() : _refc(NULL), _obj(NULL) {}
+template <typename T, class Counting>
+Ptr<T, Counting>::Ptr() : _refc(NULL), _obj(NULL) {}
 
-template <typename T>
-Ptr<T>::Ptr(T *value) : _refc(value ? new RefCounter(1) : NULL), _obj(value) {}
+template <typename T, class Counting>
+Ptr<T, Counting>::Ptr(T *value) 
+ : _refc(value ? refCountsOf(value, IsIntrusive()) : NULL), _obj(value) {}
 
-template <typename T>
-Ptr<T>::Ptr(const Ptr &p) { copy(p); }
+template <typename T, class Counting>
+Ptr<T, Counting>::Ptr(const Ptr &p) { copy(p); }
 
-template <typename T>
-Ptr<T>::Ptr(Ptr&& p) { move(p); }
+template <typename T, class Counting>
+Ptr<T, Counting>::Ptr(Ptr&& p) { move(p); }
 
-template <typename T>
+template <typename T, class Counting>
 template <class Other>
-Ptr<T>::Ptr(const Ptr<Other> &p) { copy(p); }
+Ptr<T, Counting>::Ptr(const Ptr<Other, Counting> &p) { copy(p); }
 
-template <typename T>
-Ptr<T>::~Ptr() { release(); }
+template <typename T, class Counting>
+Ptr<T, Counting>::~Ptr() { release(); }
 
-template <typename T>
-Ptr<T>&
-Ptr<T>::operator = (const Ptr &p)
+template <typename T, class Counting>
+Ptr<T, Counting>&
+Ptr<T, Counting>::operator = (const Ptr &p)
 { release(); copy(p); return *this; }
 
-template <typename T>
+template <typename T, class Counting>
 template <class Other>
-Ptr<T>&
-Ptr<T>::operator = (const Ptr<Other> &p)
+Ptr<T, Counting>&
+Ptr<T, Counting>::operator = (const Ptr<Other, Counting> &p)
 { release(); copy(p); return *this; }
 
-template <typename T>
+template <typename T, class Counting>
 template <class Other>
-Ptr<T>&
-Ptr<T>::operator = (Ptr<Other>&& p)
+Ptr<T, Counting>&
+Ptr<T, Counting>::operator = (Ptr<Other, Counting>&& p)
 { release(); move(p); return *this; }
 
-template <typename T>
+template <typename T, class Counting>
 template <class Other>
 bool
-Ptr<T>::operator == (const Ptr<Other> &p) const
+Ptr<T, Counting>::operator == (const Ptr<Other, Counting> &p) const
 { return this->_refc == p._refc; }
 
-template <typename T>
-Ptr<T>::operator T* () const { return _obj; }
+template <typename T, class Counting>
+Ptr<T, Counting>::operator T* () const { return _obj; }
 
-template <typename T>
-Ptr<T>::operator bool () const
+template <typename T, class Counting>
+Ptr<T, Counting>::operator bool () const
 { return isNotNull(); }
 
-template <typename T>
+template <typename T, class Counting>
 bool
-Ptr<T>::isNull() const
+Ptr<T, Counting>::isNull() const
 { return _refc == NULL; }
 
-template <typename T>
+template <typename T, class Counting>
 bool
-Ptr<T>::isNotNull() const
+Ptr<T, Counting>::isNotNull() const
 { return _refc != NULL; }
 
-template <typename T>
+template <typename T, class Counting>
 unsigned int
-Ptr<T>::count() const
-{ return _refc ? *_refc : 0; }
+Ptr<T, Counting>::count() const
+{ return _refc ? Counting::load(_refc->strong) : 0; }
 
-template <typename T>
+template <typename T, class Counting>
 T*
-Ptr<T>::operator -> () throw (NullPointerException)
+Ptr<T, Counting>::operator -> () throw (NullPointerException)
 { return safeObject(); }
 
-template <typename T>
+template <typename T, class Counting>
 const T*
-Ptr<T>::operator -> () const throw (NullPointerException)
+Ptr<T, Counting>::operator -> () const throw (NullPointerException)
 { return safeObject(); }
 
-template <typename T>
+template <typename T, class Counting>
 T&
-Ptr<T>::operator * () throw (NullPointerException)
+Ptr<T, Counting>::operator * () throw (NullPointerException)
 { return *safeObject(); }
 
-template <typename T>
+template <typename T, class Counting>
 const T&
-Ptr<T>::operator * () const throw (NullPointerException)
+Ptr<T, Counting>::operator * () const throw (NullPointerException)
 { return *safeObject(); }
 
-template <typename T>
+template <typename T, class Counting>
 template <class Other>
 bool
-Ptr<T>::isOfClass() const throw (NullPointerException)
-{ return dynamic_cast<Other*>(safeObject()) != NULL; }
+Ptr<T, Counting>::isOfClass() const throw (NullPointerException)
+{ return dynamic_cast<const Other*>(safeObject()) != NULL; }
 
-template <typename T>
+template <typename T, class Counting>
 template <class Other>
-Ptr<Other>
-Ptr<T>::dynCasting() throw (NullPointerException)
+Ptr<Other, Counting>
+Ptr<T, Counting>::dynCasting() throw (NullPointerException)
 {
    Other *cast = dynamic_cast<Other*>(safeObject());
-   Ptr<Other> result;
+   Ptr<Other, Counting> result;
    if (cast)
       result.uncheckedCopy(*this, cast);
    return result;
 }
 
-template <typename T>
+template <typename T, class Counting>
 template <class Other>
-Ptr<const Other>
-Ptr<T>::dynCasting() const throw (NullPointerException)
+Ptr<const Other, Counting>
+Ptr<T, Counting>::dynCasting() const throw (NullPointerException)
 {
    const Other *cast = dynamic_cast<const Other*>(safeObject());
-   Ptr<const Other> result;
+   Ptr<const Other, Counting> result;
    if (cast)
       result.uncheckedCopy(*this, cast);
    return result;
 }
 
-template <typename T>
+template <typename T, class Counting>
+template <class Obj>
+typename Ptr<T, Counting>::RefCounter*
+Ptr<T, Counting>::refCountsOf(Obj* value, std::true_type)
+{
+   RefCounter* refc = &static_cast<const RefCounted<Counting>*>(
+         value)->_refCounts;
+   Counting::increment(refc->strong);
+   return refc;
+}
+
+template <typename T, class Counting>
+template <class Obj>
+typename Ptr<T, Counting>::RefCounter*
+Ptr<T, Counting>::refCountsOf(Obj*, std::false_type)
+{ return new RefCounter(); }
+
+template <typename T, class Counting>
 void
-Ptr<T>::release()
+Ptr<T, Counting>::release()
 {
-   if (_refc)
+   if (_refc && Counting::decrement(_refc->strong))
    {
-      (*_refc)--;
-      if ((*_refc) == 0)
+      switch (_refc->storage)
       {
-         if (_obj)
+         case RefCounter::INTRUSIVE:
+            // The counts are deleted along with the object
             delete _obj;
-         delete _refc;
+            break;
+         case RefCounter::EMBEDDED:
+            // The block survives the object while weak pointers refer to it
+            _obj->~T();
+            if (Counting::decrement(_refc->weak))
+               RefCounter::dispose(_refc);
+            break;
+         default:
+            delete _obj;
+            if (Counting::decrement(_refc->weak))
+               RefCounter::dispose(_refc);
+            break;
       }
    }
    _refc = NULL;
    _obj = NULL;
 }
 
-template <typename T>
+template <typename T, class Counting>
 template <class Other>
 void
-Ptr<T>::copy(const Ptr<Other> &p)
+Ptr<T, Counting>::copy(const Ptr<Other, Counting> &p)
 {
    this->_refc = p._refc;
    this->_obj  = p._obj;
    if (this->_refc)
-      (*this->_refc)++;
+      Counting::increment(this->_refc->strong);
 }
 
-template <typename T>
+template <typename T, class Counting>
 template <class Other>
 void
-Ptr<T>::move(Ptr<Other>& p)
+Ptr<T, Counting>::move(Ptr<Other, Counting>& p)
 {
    this->_refc  = p._refc;
    this->_obj   = p._obj;
@@ -183,20 +212,20 @@ Ptr<T>::move(Ptr<Other>& p)
    p._obj       = NULL;
 }
 
-template <typename T>
+template <typename T, class Counting>
 template <class Other, class Obj>
 void
-Ptr<T>::uncheckedCopy(const Ptr<Other> &p, Obj *obj)
+Ptr<T, Counting>::uncheckedCopy(const Ptr<Other, Counting> &p, Obj *obj)
 {
    this->_refc = p._refc;
    this->_obj  = obj;
    if (this->_refc)
-      (*this->_refc)++;
+      Counting::increment(this->_refc->strong);
 }
 
-template <typename T>
+template <typename T, class Counting>
 T*
-Ptr<T>::safeObject() throw (NullPointerException)
+Ptr<T, Counting>::safeObject() throw (NullPointerException)
 {
    if (!_obj)
       KAREN_THROW(NullPointerException,
@@ -204,11 +233,184 @@ Ptr<T>::safeObject() throw (NullPointerException)
    return _obj;
 }
 
-template <typename T>
+template <typename T, class Counting>
 const T*
-Ptr<T>::safeObject() const throw (NullPointerException)
+Ptr<T, Counting>::safeObject() const throw (NullPointerException)
 { return ((Ptr*) this)->safeObject(); }
 
+/*
+ * Factory of objects which counts are embedded in the same block.
+ */
+template <class T, class Counting>
+struct PtrFactory<T, Counting, false>
+{
+   typedef PtrRefCounts<Counting> RefCounter;
+
+   struct Block
+   {
+      RefCounter counts;
+      typename std::aligned_storage<
+            sizeof(T), std::alignment_of<T>::value>::type object;
+   };
+
+   template <class... Args>
+   inline static Ptr<T, Counting> make(Args&&... args)
+   {
+      Block* block = static_cast<Block*>(::operator new(sizeof(Block)));
+      T* obj;
+      try
+      {
+         obj = new (&block->object) T(std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+         ::operator delete(block);
+         throw;
+      }
+      Ptr<T, Counting> p;
+      p._refc = new (&block->counts) RefCounter(RefCounter::EMBEDDED);
+      p._obj = obj;
+      return p;
+   }
+};
+
+/*
+ * Factory of intrusive counted objects, which need no extra block.
+ */
+template <class T, class Counting>
+struct PtrFactory<T, Counting, true>
+{
+   template <class... Args>
+   inline static Ptr<T, Counting> make(Args&&... args)
+   { return Ptr<T, Counting>(new T(std::forward<Args>(args)...)); }
+};
+
+template <class T, class Counting, class... Args>
+Ptr<T, Counting>
+makePtr(Args&&... args)
+{
+   return PtrFactory<T, Counting, 
+         std::is_base_of<RefCounted<Counting>, T>::value>::make(
+               std::forward<Args>(args)...);
+}
+
+template <typename T, class Counting>
+WeakPtr<T, Counting>::WeakPtr() : _refc(NULL), _obj(NULL) {}
+
+template <typename T, class Counting>
+template <class Other>
+WeakPtr<T, Counting>::WeakPtr(const Ptr<Other, Counting>& p)
+ : _refc(p._refc), _obj(p._obj)
+{
+   static_assert(!std::is_base_of<RefCounted<Counting>, Other>::value,
+                 "intrusive counted objects do not support weak pointers");
+   if (_refc)
+      Counting::increment(_refc->weak);
+}
+
+template <typename T, class Counting>
+WeakPtr<T, Counting>::WeakPtr(const WeakPtr& p)
+ : _refc(p._refc), _obj(p._obj)
+{
+   if (_refc)
+      Counting::increment(_refc->weak);
+}
+
+template <typename T, class Counting>
+WeakPtr<T, Counting>::WeakPtr(WeakPtr&& p)
+ : _refc(p._refc), _obj(p._obj)
+{
+   p._refc = NULL;
+   p._obj = NULL;
+}
+
+template <typename T, class Counting>
+template <class Other>
+WeakPtr<T, Counting>::WeakPtr(const WeakPtr<Other, Counting>& p)
+ : _refc(p._refc), _obj(p._obj)
+{
+   if (_refc)
+      Counting::increment(_refc->weak);
+}
+
+template <typename T, class Counting>
+WeakPtr<T, Counting>::~WeakPtr() { reset(); }
+
+template <typename T, class Counting>
+WeakPtr<T, Counting>&
+WeakPtr<T, Counting>::operator = (const WeakPtr& p)
+{
+   if (p._refc)
+      Counting::increment(p._refc->weak);
+   reset();
+   _refc = p._refc;
+   _obj = p._obj;
+   return *this;
+}
+
+template <typename T, class Counting>
+WeakPtr<T, Counting>&
+WeakPtr<T, Counting>::operator = (WeakPtr&& p)
+{
+   if (this != &p)
+   {
+      reset();
+      _refc = p._refc;
+      _obj = p._obj;
+      p._refc = NULL;
+      p._obj = NULL;
+   }
+   return *this;
+}
+
+template <typename T, class Counting>
+template <class Other>
+WeakPtr<T, Counting>&
+WeakPtr<T, Counting>::operator = (const Ptr<Other, Counting>& p)
+{
+   static_assert(!std::is_base_of<RefCounted<Counting>, Other>::value,
+                 "intrusive counted objects do not support weak pointers");
+   if (p._refc)
+      Counting::increment(p._refc->weak);
+   reset();
+   _refc = p._refc;
+   _obj = p._obj;
+   return *this;
+}
+
+template <typename T, class Counting>
+Ptr<T, Counting>
+WeakPtr<T, Counting>::lock() const
+{
+   Ptr<T, Counting> p;
+   if (_refc && Counting::incrementIfNotZero(_refc->strong))
+   {
+      p._refc = _refc;
+      p._obj = _obj;
+   }
+   return p;
+}
+
+template <typename T, class Counting>
+bool
+WeakPtr<T, Counting>::isExpired() const
+{ return count() == 0; }
+
+template <typename T, class Counting>
+unsigned int
+WeakPtr<T, Counting>::count() const
+{ return _refc ? Counting::load(_refc->strong) : 0; }
+
+template <typename T, class Counting>
+void
+WeakPtr<T, Counting>::reset()
+{
+   if (_refc && Counting::decrement(_refc->weak))
+      PtrRefCounts<Counting>::dispose(_refc);
+   _refc = NULL;
+   _obj = NULL;
+}
+
 }
 
 #endif
@@ -25,12 +25,156 @@
 #ifndef KAREN_CORE_POINTER_H
 #define KAREN_CORE_POINTER_H
 
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
 #include "KarenCore/platform.h"
 
 namespace karen {
 
 class NullPointerException;
 
+/**
+ * Single thread reference counting policy. This policy class counts the
+ * references of a smart pointer with plain integers. It is the cheapest 
+ * one, but smart pointers that share the same object must not be copied
+ * or destroyed by different threads at the same time. 
+ */
+struct SingleThreadCounting
+{
+   typedef unsigned int Counter;
+
+   inline static unsigned int load(const Counter& c)
+   { return c; }
+
+   inline static void increment(Counter& c)
+   { c++; }
+
+   /**
+    * Increment given counter unless it is zero. Returns whether it was
+    * incremented. 
+    */
+   inline static bool incrementIfNotZero(Counter& c)
+   { return c ? (c++, true) : false; }
+
+   /**
+    * Decrement given counter, returning whether it reached zero.
+    */
+   inline static bool decrement(Counter& c)
+   { return --c == 0; }
+};
+
+/**
+ * Atomic reference counting policy. This policy class counts the 
+ * references of a smart pointer with atomic integers, so smart pointers
+ * that share the same object may be copied and destroyed by different
+ * threads at the same time. Increments are relaxed, since a new reference
+ * is always obtained from an existing one, while the decrement that 
+ * releases the last reference synchronizes with all the former ones 
+ * before the object is deleted. 
+ */
+struct AtomicCounting
+{
+   typedef std::atomic<unsigned int> Counter;
+
+   inline static unsigned int load(const Counter& c)
+   { return c.load(std::memory_order_relaxed); }
+
+   inline static void increment(Counter& c)
+   { c.fetch_add(1, std::memory_order_relaxed); }
+
+   inline static bool incrementIfNotZero(Counter& c)
+   {
+      unsigned int n = c.load(std::memory_order_relaxed);
+      while (n)
+         if (c.compare_exchange_weak(n, n + 1, std::memory_order_relaxed))
+            return true;
+      return false;
+   }
+
+   inline static bool decrement(Counter& c)
+   { return c.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+};
+
+/**
+ * Reference counts of a smart pointer. It counts the strong references,
+ * held by Ptr objects, and the weak ones, held by WeakPtr objects. All
+ * the strong references count as a single weak one, so the counts are 
+ * released when both the object and its last weak reference are gone. 
+ */
+template <class Counting>
+struct PtrRefCounts
+{
+   /**
+    * Where the counts are stored. SEPARATE counts are allocated apart
+    * from the object, EMBEDDED ones share a single block with the object
+    * created by makePtr() and INTRUSIVE ones live inside a RefCounted 
+    * object, which is created with no strong references. 
+    */
+   enum Storage { SEPARATE, EMBEDDED, INTRUSIVE };
+
+   typename Counting::Counter strong;
+   typename Counting::Counter weak;
+   Storage storage;
+
+   inline PtrRefCounts(Storage s = SEPARATE)
+    : strong(s == INTRUSIVE ? 0 : 1), weak(1), storage(s) {}
+
+   /**
+    * Deallocate given counts once both the object and its last weak 
+    * reference are gone. 
+    */
+   inline static void dispose(PtrRefCounts* c)
+   {
+      if (c->storage == EMBEDDED)
+      {
+         c->~PtrRefCounts();
+         ::operator delete(c);
+      }
+      else
+         delete c;
+   }
+};
+
+/**
+ * Intrusive reference counted base class. Objects of classes that derive
+ * from it store their own reference counts, so smart pointers with the 
+ * same Counting policy don't allocate them apart. This also means that 
+ * a new smart pointer may be safely created from a raw pointer to an 
+ * object already managed by other ones. Intrusive counted objects do not
+ * support weak pointers, and they must not be shared by smart pointers 
+ * to bases that reach different RefCounted subobjects. 
+ */
+template <class Counting = SingleThreadCounting>
+class RefCounted
+{
+protected:
+
+   inline RefCounted() : _refCounts(PtrRefCounts<Counting>::INTRUSIVE) {}
+
+   /**
+    * Copy constructor. The copy is a new object with its own counts.
+    */
+   inline RefCounted(const RefCounted&)
+    : _refCounts(PtrRefCounts<Counting>::INTRUSIVE) {}
+
+   inline RefCounted& operator = (const RefCounted&) { return *this; }
+
+private:
+
+   template <class T, class OtherCounting> friend class Ptr;
+
+   mutable PtrRefCounts<Counting> _refCounts;
+};
+
+template <class T, class Counting, bool Intrusive>
+struct PtrFactory;
+
+template <class T, class Counting>
+class WeakPtr;
+
 /**
  * Smart pointer template class. This template class provides a 
  * count-reference smart pointer. It works like any other pointer type, 
@@ -39,8 +183,12 @@ class NullPointerException;
  * when all references to the object are lost. To create an smart pointer, 
  * just instantiate the template class with the pointed object as argument 
  * and, then, use other smart pointer or a real pointer to construct it.
+ *
+ * The Counting policy determines how references are counted. The default
+ * SingleThreadCounting policy is the cheapest one. Smart pointers shared
+ * among threads should use AtomicCounting instead, as AtomicPtr does. 
  */
-template <class T>
+template <class T, class Counting = SingleThreadCounting>
 class Ptr
 {
 public:
@@ -77,7 +225,7 @@ public:
     */
    //! Cast and copy constructor
    template <class Other>
-   Ptr(const Ptr<Other> &p);
+   Ptr(const Ptr<Other, Counting> &p);
    
    /**
     * Destructor. This destructor checks the count reference in order to 
@@ -101,7 +249,7 @@ public:
     * is set to null.
     */
    template <class Other>
-   Ptr& operator = (const Ptr<Other> &p);
+   Ptr& operator = (const Ptr<Other, Counting> &p);
 
    /**
     * Cast and move operator. This assign operator accepts a smart pointer
@@ -110,7 +258,7 @@ public:
     * is set to null.
     */
    template <class Other>
-   Ptr& operator = (Ptr<Other>&& p);
+   Ptr& operator = (Ptr<Other, Counting>&& p);
    
    /**
     * Compare operator. Two smart pointers are considered equal if they are
@@ -119,7 +267,7 @@ public:
     * compared. 
     */
    template <class Other>
-   bool operator == (const Ptr<Other> &p) const;
+   bool operator == (const Ptr<Other, Counting> &p) const;
    
    /**
     * Cast operator to raw pointer. This operator converts the smart pointer
@@ -195,7 +343,7 @@ public:
     * is null. If pointer is null, a NullPointerException is raised. 
     */
    template <class Other>
-   Ptr<Other> dynCasting() throw (NullPointerException);
+   Ptr<Other, Counting> dynCasting() throw (NullPointerException);
 
    /**
     * This function member performs a dynamic casting of the pointer. It
@@ -204,40 +352,150 @@ public:
     * is null. If pointer is null, a NullPointerException is raised. 
     */
    template <class Other>
-   Ptr<const Other> dynCasting() const throw (NullPointerException);
+   Ptr<const Other, Counting> dynCasting() const 
+         throw (NullPointerException);
 
    /* 
     * This friendship is established with the template class Ptr itself
     * and used to allow castings.
     */
-   template <class Other> friend class Ptr;   
+   template <class Other, class OtherCounting> friend class Ptr;   
+
+   template <class Other, class OtherCounting> friend class WeakPtr;
+
+   template <class Other, class OtherCounting, bool Intrusive> 
+   friend struct PtrFactory;
    
 private:
 
-   typedef unsigned int RefCounter;
+   typedef PtrRefCounts<Counting> RefCounter;
+
+   typedef std::is_base_of<RefCounted<Counting>, T> IsIntrusive;
 
    RefCounter *_refc;
    T *_obj;
    
+   template <class Obj>
+   static RefCounter* refCountsOf(Obj* value, std::true_type);
+
+   template <class Obj>
+   static RefCounter* refCountsOf(Obj* value, std::false_type);
+
    void release();
    
    template <class Other>
-   void copy(const Ptr<Other> &p);
+   void copy(const Ptr<Other, Counting> &p);
    
    template <class Other>
-   void move(Ptr<Other>& p);
+   void move(Ptr<Other, Counting>& p);
 
    template <class Other, class Obj>
-   void uncheckedCopy(const Ptr<Other> &p, Obj *obj);
+   void uncheckedCopy(const Ptr<Other, Counting> &p, Obj *obj);
 
    T *safeObject() throw (NullPointerException);
 
    const T *safeObject() const throw (NullPointerException);
 };
 
+/**
+ * Atomic smart pointer template. This is a smart pointer whose references
+ * may be copied and destroyed by different threads at the same time. 
+ */
+template <class T>
+using AtomicPtr = Ptr<T, AtomicCounting>;
+
+/**
+ * Create a new object of class T from given constructor arguments and
+ * return a smart pointer to it. The object and its reference counts are
+ * allocated in a single block, saving the extra allocation done when a
+ * smart pointer is constructed from a raw pointer. The memory is 
+ * deallocated once both the object and its last weak reference are gone. 
+ */
+template <class T, class Counting = SingleThreadCounting, class... Args>
+Ptr<T, Counting> makePtr(Args&&... args);
+
+/**
+ * Weak pointer template class. This template class provides a non-owning
+ * reference to an object managed by smart pointers. It does not keep the
+ * object alive: once the last smart pointer to it is gone, the object is
+ * deallocated and the weak pointer expires. To use the object, lock() the
+ * weak pointer to obtain a smart pointer that is null if it expired. This
+ * makes weak pointers suitable for caches that must not retain their
+ * entries. The Counting policy must match the one of the smart pointers.
+ */
+template <class T, class Counting = SingleThreadCounting>
+class WeakPtr
+{
+public:
+
+   /**
+    * Default constructor. It creates an expired weak pointer. 
+    */
+   WeakPtr();
+
+   /**
+    * Create a new weak pointer to the object of given smart pointer,
+    * which must not be a RefCounted object.
+    */
+   template <class Other>
+   WeakPtr(const Ptr<Other, Counting>& p);
+
+   WeakPtr(const WeakPtr& p);
+
+   WeakPtr(WeakPtr&& p);
+
+   template <class Other>
+   WeakPtr(const WeakPtr<Other, Counting>& p);
+
+   ~WeakPtr();
+
+   WeakPtr& operator = (const WeakPtr& p);
+
+   WeakPtr& operator = (WeakPtr&& p);
+
+   template <class Other>
+   WeakPtr& operator = (const Ptr<Other, Counting>& p);
+
+   /**
+    * Obtain a smart pointer to the referenced object, which is null if
+    * the object was already deallocated. 
+    */
+   Ptr<T, Counting> lock() const;
+
+   /**
+    * Check whether the referenced object was already deallocated. 
+    */
+   bool isExpired() const;
+
+   /**
+    * Obtain the number of smart pointers referencing the object, or 0 if
+    * it was already deallocated. 
+    */
+   unsigned int count() const;
+
+   /**
+    * Release the reference, making this weak pointer expired. 
+    */
+   void reset();
+
+   template <class Other, class OtherCounting> friend class WeakPtr;
+
+private:
+
+   typedef PtrRefCounts<Counting> RefCounter;
+
+   RefCounter *_refc;
+   T *_obj;
+
+};
+
 }
 
 using karen::Ptr;
+using karen::AtomicPtr;
+using karen::RefCounted;
+using karen::makePtr;
+using karen::WeakPtr;
 
 #include "KarenCore/exception.h"
 #include "KarenCore/pointer-inl.h"
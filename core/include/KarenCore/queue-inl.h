@@ -29,6 +29,61 @@
 
 namespace karen {
 
+template <class T, class Backend>
+unsigned long
+Queue<T, Backend>::size() const
+{ return this->_backend.size(); }
+   
+template <class T, class Backend>
+void
+Queue<T, Backend>::clear()
+{ this->_backend.clear(); }
+
+template <class T, class Backend>
+Iterator<T>
+Queue<T, Backend>::begin()
+{ return this->_backend.begin(); }
+   
+template <class T, class Backend>
+Iterator<T>
+Queue<T, Backend>::end()
+{ return this->_backend.end(); }
+   
+template <class T, class Backend>
+Iterator<const T>
+Queue<T, Backend>::begin() const
+{ return this->_backend.begin(); }
+   
+template <class T, class Backend>
+Iterator<const T>
+Queue<T, Backend>::end() const
+{ return this->_backend.end(); }
+   
+template <class T, class Backend>
+Iterator<T>
+Queue<T, Backend>::rbegin()
+{ return this->_backend.rbegin(); }
+   
+template <class T, class Backend>
+Iterator<T>
+Queue<T, Backend>::rend()
+{ return this->_backend.rend(); }
+   
+template <class T, class Backend>
+Iterator<const T>
+Queue<T, Backend>::rbegin() const
+{ return this->_backend.rbegin(); }
+   
+template <class T, class Backend>
+Iterator<const T>
+Queue<T, Backend>::rend() const
+{ return this->_backend.rend(); }
+   
+template <class T, class Backend>
+void
+Queue<T, Backend>::remove(Iterator<T>& it)
+{ this->_backend.remove(it); }
+
 template <class T, class Backend>
 const T&
 Queue<T, Backend>::head() const
@@ -38,23 +93,45 @@ throw (NotFoundException)
 template <class T, class Backend>
 void
 Queue<T, Backend>::put(const T& t)
-{ this->_backend.insertLast(t); }
+{ this->_backend.insertBack(t); }
+
+template <class T, class Backend>
+void
+Queue<T, Backend>::put(T&& t)
+{ this->_backend.insertBack(std::move(t)); }
+
+template <class T, class Backend>
+template <class ... Args>
+void
+Queue<T, Backend>::emplace(Args&& ... args)
+{ this->_backend.emplaceBack(std::forward<Args>(args)...); }
    
 template <class T, class Backend>
 T
 Queue<T, Backend>::poll()
 throw (NotFoundException)
-{
-   T t = this->_backend.first();
-   this->_backend.removeFirst();
-   return t;
-}
+{ return this->_backend.takeFirst(); }
 
 template <class T, class Backend>
 template <class Equals>
 void
 Queue<T, Backend>::removeAll(const T& t, Equals eq)
-{ this->_backend.template removeAll<Backend>(t, eq); }
+{ this->_backend.template removeAll<Equals>(t, eq); }
+
+template <class T, class Backend>
+typename Queue<T, Backend>::ConstFastIterator
+Queue<T, Backend>::fastBegin() const
+{ return this->_backend.fastBegin(); }
+
+template <class T, class Backend>
+typename Queue<T, Backend>::ConstFastIterator
+Queue<T, Backend>::fastEnd() const
+{ return this->_backend.fastEnd(); }
+
+template <class T, class Backend>
+FastRange<typename Queue<T, Backend>::ConstFastIterator>
+Queue<T, Backend>::fast() const
+{ return this->_backend.fast(); }
 
 template <class T, class Compare, class Backend>
 PriorityQueue<T, Compare, Backend>::PriorityQueue(const Compare& cmp)
@@ -119,28 +196,49 @@ PriorityQueue<T, Compare, Backend>::remove(Iterator<const T>& it)
 template <class T, class Compare, class Backend>
 const T&
 PriorityQueue<T, Compare, Backend>::head() const
-{ return *_backend.rbegin(); }
+{ return _backend.last(); }
 
 template <class T, class Compare, class Backend>
 void
 PriorityQueue<T, Compare, Backend>::put(const T& t)
 { _backend.insert(t); }
+
+template <class T, class Compare, class Backend>
+void
+PriorityQueue<T, Compare, Backend>::put(T&& t)
+{ _backend.insert(std::move(t)); }
+
+template <class T, class Compare, class Backend>
+template <class ... Args>
+void
+PriorityQueue<T, Compare, Backend>::emplace(Args&& ... args)
+{ _backend.emplace(std::forward<Args>(args)...); }
    
 template <class T, class Compare, class Backend>
 T
 PriorityQueue<T, Compare, Backend>::poll()
-{
-   T t = head();
-   Iterator<const T> it = _backend.rbegin();
-   _backend.remove(it);
-   return t;
-}
+{ return _backend.takeLast(); }
 
 template <class T, class Compare, class Backend>
 void
 PriorityQueue<T, Compare, Backend>::removeAll(const T& t)
 { this->_backend.removeAll(t); }
 
+template <class T, class Compare, class Backend>
+typename PriorityQueue<T, Compare, Backend>::ConstFastIterator
+PriorityQueue<T, Compare, Backend>::fastBegin() const
+{ return _backend.fastBegin(); }
+
+template <class T, class Compare, class Backend>
+typename PriorityQueue<T, Compare, Backend>::ConstFastIterator
+PriorityQueue<T, Compare, Backend>::fastEnd() const
+{ return _backend.fastEnd(); }
+
+template <class T, class Compare, class Backend>
+FastRange<typename PriorityQueue<T, Compare, Backend>::ConstFastIterator>
+PriorityQueue<T, Compare, Backend>::fast() const
+{ return _backend.fast(); }
+
 }
 
 #endif
@@ -26,7 +26,9 @@
 #define KAREN_CORE_QUEUE_H
 
 #include "KarenCore/collection.h"
+#include "KarenCore/heap.h"
 #include "KarenCore/list.h"
+#include "KarenCore/set.h"
 
 namespace karen {
 
@@ -39,6 +41,28 @@ class Queue : public CollectionAdaptor<T, Backend>
 {
 public:
 
+   inline virtual unsigned long size() const;
+   
+   inline void clear();
+
+   inline virtual Iterator<T> begin();
+   
+   inline virtual Iterator<T> end();
+
+   inline virtual Iterator<const T> begin() const;
+   
+   inline virtual Iterator<const T> end() const;
+
+   inline virtual Iterator<T> rbegin();
+   
+   inline virtual Iterator<T> rend();
+
+   inline virtual Iterator<const T> rbegin() const;
+   
+   inline virtual Iterator<const T> rend() const;
+
+   inline virtual void remove(Iterator<T>& it);
+
    /**
     * Obtain the head element of the queue, or throw a NotFoundException
     * if the queue is empty. 
@@ -49,10 +73,23 @@ public:
     * Puts a new element in the queue.
     */
    inline virtual void put(const T& t);
+
+   /**
+    * Puts a new element in the queue by moving it.
+    */
+   inline virtual void put(T&& t);
+
+   /**
+    * Puts a new element in the queue constructing it in place from 
+    * given arguments.
+    */
+   template <class ... Args>
+   inline void emplace(Args&& ... args);
    
    /**
     * Retrieves the next element of the queue and removes it, or throw a 
-    * NotFoundException if the queue is empty. 
+    * NotFoundException if the queue is empty. The element is moved out
+    * of the queue rather than copied.
     */
    inline virtual T poll() throw (NotFoundException);
 
@@ -62,8 +99,27 @@ public:
    template <class Equals>
    inline void removeAll(const T& t, Equals eq = Equals());
 
+   /**
+    * Fast iterator type. See FastRange for details.
+    */
+   typedef typename Backend::ConstFastIterator ConstFastIterator;
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<ConstFastIterator> fast() const;
+
 };
 
+/**
+ * Priority queue template class. The head of the queue is its greatest
+ * element according to Compare. The backend must provide last() and 
+ * takeLast() operations to obtain and remove its greatest element, as 
+ * TreeMultiset and DaryHeap do. The default TreeMultiset backend keeps 
+ * its elements sorted, while a DaryHeap backend avoids allocating on 
+ * each insertion and removal. 
+ */
 template <class T, 
           class Compare = DefaultLessThan<T>, 
           class Backend = TreeMultiset<T, Compare> >
@@ -98,7 +154,20 @@ public:
    inline virtual const T& head() const;
 
    inline virtual void put(const T& t);
+
+   inline virtual void put(T&& t);
+
+   /**
+    * Puts a new element in the queue constructing it in place from 
+    * given arguments.
+    */
+   template <class ... Args>
+   inline void emplace(Args&& ... args);
    
+   /**
+    * Retrieves the head element of the queue and removes it. The element
+    * is moved out of the queue rather than copied.
+    */
    inline virtual T poll();
 
    /**
@@ -106,6 +175,17 @@ public:
     */
    inline void removeAll(const T& t);
 
+   /**
+    * Fast iterator type. See FastRange for details.
+    */
+   typedef typename Backend::ConstFastIterator ConstFastIterator;
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<ConstFastIterator> fast() const;
+
 private:
 
    Backend _backend;
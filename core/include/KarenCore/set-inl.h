@@ -30,97 +30,98 @@
 namespace karen {
 
 
-template <class T, class Compare>
-TreeSet<T, Compare>::TreeSet(const Compare& cmp)
- : _impl(cmp)
+template <class T, class Compare, class Allocator>
+TreeSet<T, Compare, Allocator>::TreeSet(
+      const Compare& cmp, const Allocator& alloc)
+ : _impl(cmp, alloc)
 {
 }
 
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 unsigned long
-TreeSet<T, Compare>::size() const
+TreeSet<T, Compare, Allocator>::size() const
 { return _impl.size(); }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 void
-TreeSet<T, Compare>::clear()
+TreeSet<T, Compare, Allocator>::clear()
 { _impl.clear(); }
 
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeSet<T, Compare>::begin() const
+TreeSet<T, Compare, Allocator>::begin() const
 {
    Ptr<AbstractIterator<const T> > it = new TreeSetIterator(
          *this, _impl.begin(), _impl.end());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeSet<T, Compare>::end() const
+TreeSet<T, Compare, Allocator>::end() const
 {
    Ptr<AbstractIterator<const T> > it = new TreeSetIterator(
          *this, _impl.end(), _impl.end());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeSet<T, Compare>::begin()
+TreeSet<T, Compare, Allocator>::begin()
 {
    Ptr<AbstractIterator<const T> > it = new TreeSetIterator(
          *this, _impl.begin(), _impl.end());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeSet<T, Compare>::end()
+TreeSet<T, Compare, Allocator>::end()
 {
    Ptr<AbstractIterator<const T> > it = new TreeSetIterator(
          *this, _impl.end(), _impl.end());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeSet<T, Compare>::rbegin() const
+TreeSet<T, Compare, Allocator>::rbegin() const
 {
    Ptr<AbstractIterator<const T> > it = new TreeSetReverseIterator(
          *this, _impl.rbegin(), _impl.rend());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeSet<T, Compare>::rend() const
+TreeSet<T, Compare, Allocator>::rend() const
 {
    Ptr<AbstractIterator<const T> > it = new TreeSetReverseIterator(
          *this, _impl.rend(), _impl.rend());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeSet<T, Compare>::rbegin()
+TreeSet<T, Compare, Allocator>::rbegin()
 {
    Ptr<AbstractIterator<const T> > it = new TreeSetReverseIterator(
          *this, _impl.rbegin(), _impl.rend());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeSet<T, Compare>::rend()
+TreeSet<T, Compare, Allocator>::rend()
 {
    Ptr<AbstractIterator<const T> > it = new TreeSetReverseIterator(
          *this, _impl.rend(), _impl.rend());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 void
-TreeSet<T, Compare>::remove(Iterator<const T>& it)
+TreeSet<T, Compare, Allocator>::remove(Iterator<const T>& it)
 {
    Iterator<const T> itCopy = it;
    TreeSetIterator *nit = itCopy.template impl<TreeSetIterator>();
@@ -141,111 +142,154 @@ TreeSet<T, Compare>::remove(Iterator<const T>& it)
             " the iterator does not belongs to this collection");
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeSet<T, Compare>::insert(const T& t)
+TreeSet<T, Compare, Allocator>::insert(const T& t)
 {
    Ptr<AbstractIterator<const T> > it = new TreeSetIterator(
          *this, _impl.insert(t).first, _impl.end());
    return Iterator<const T>(it);
 }
+
+template <class T, class Compare, class Allocator>
+Iterator<const T>
+TreeSet<T, Compare, Allocator>::insert(T&& t)
+{
+   Ptr<AbstractIterator<const T> > it = new TreeSetIterator(
+         *this, _impl.insert(std::move(t)).first, _impl.end());
+   return Iterator<const T>(it);
+}
+
+template <class T, class Compare, class Allocator>
+template <class ... Args>
+Iterator<const T>
+TreeSet<T, Compare, Allocator>::emplace(Args&& ... args)
+{
+   Ptr<AbstractIterator<const T> > it = new TreeSetIterator(
+         *this, _impl.emplace(std::forward<Args>(args)...).first, _impl.end());
+   return Iterator<const T>(it);
+}
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 void
-TreeSet<T, Compare>::removeAll(const T& t)
+TreeSet<T, Compare, Allocator>::removeAll(const T& t)
 { _impl.erase(t); }
 
-template <class T, class Compare>
-TreeMultiset<T, Compare>::TreeMultiset(const Compare& cmp)
- : _impl(cmp)
+template <class T, class Compare, class Allocator>
+const T*
+TreeSet<T, Compare, Allocator>::find(const T& t) const
+{
+   typename _Impl::const_iterator it = _impl.find(t);
+   return it == _impl.end() ? NULL : &*it;
+}
+
+template <class T, class Compare, class Allocator>
+typename TreeSet<T, Compare, Allocator>::ConstFastIterator
+TreeSet<T, Compare, Allocator>::fastBegin() const
+{ return _impl.begin(); }
+
+template <class T, class Compare, class Allocator>
+typename TreeSet<T, Compare, Allocator>::ConstFastIterator
+TreeSet<T, Compare, Allocator>::fastEnd() const
+{ return _impl.end(); }
+
+template <class T, class Compare, class Allocator>
+FastRange<typename TreeSet<T, Compare, Allocator>::ConstFastIterator>
+TreeSet<T, Compare, Allocator>::fast() const
+{ return FastRange<ConstFastIterator>(fastBegin(), fastEnd()); }
+
+template <class T, class Compare, class Allocator>
+TreeMultiset<T, Compare, Allocator>::TreeMultiset(
+      const Compare& cmp, const Allocator& alloc)
+ : _impl(cmp, alloc)
 {
 }
 
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 unsigned long
-TreeMultiset<T, Compare>::size() const
+TreeMultiset<T, Compare, Allocator>::size() const
 { return _impl.size(); }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 void
-TreeMultiset<T, Compare>::clear()
+TreeMultiset<T, Compare, Allocator>::clear()
 { _impl.clear(); }
 
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeMultiset<T, Compare>::begin() const
+TreeMultiset<T, Compare, Allocator>::begin() const
 {
    Ptr<AbstractIterator<const T> > it = new TreeMultisetIterator(
          *this, _impl.begin(), _impl.end());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeMultiset<T, Compare>::end() const
+TreeMultiset<T, Compare, Allocator>::end() const
 {
    Ptr<AbstractIterator<const T> > it = new TreeMultisetIterator(
          *this, _impl.end(), _impl.end());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeMultiset<T, Compare>::begin()
+TreeMultiset<T, Compare, Allocator>::begin()
 {
    Ptr<AbstractIterator<const T> > it = new TreeMultisetIterator(
          *this, _impl.begin(), _impl.end());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeMultiset<T, Compare>::end()
+TreeMultiset<T, Compare, Allocator>::end()
 {
    Ptr<AbstractIterator<const T> > it = new TreeMultisetIterator(
          *this, _impl.end(), _impl.end());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeMultiset<T, Compare>::rbegin() const
+TreeMultiset<T, Compare, Allocator>::rbegin() const
 {
    Ptr<AbstractIterator<const T> > it = new TreeMultisetReverseIterator(
          *this, _impl.rbegin(), _impl.rend());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeMultiset<T, Compare>::rend() const
+TreeMultiset<T, Compare, Allocator>::rend() const
 {
    Ptr<AbstractIterator<const T> > it = new TreeMultisetReverseIterator(
          *this, _impl.rend(), _impl.rend());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeMultiset<T, Compare>::rbegin()
+TreeMultiset<T, Compare, Allocator>::rbegin()
 {
    Ptr<AbstractIterator<const T> > it = new TreeMultisetReverseIterator(
          *this, _impl.rbegin(), _impl.rend());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeMultiset<T, Compare>::rend()
+TreeMultiset<T, Compare, Allocator>::rend()
 {
    Ptr<AbstractIterator<const T> > it = new TreeMultisetReverseIterator(
          *this, _impl.rend(), _impl.rend());
    return Iterator<const T>(it);
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 void
-TreeMultiset<T, Compare>::remove(Iterator<const T>& it)
+TreeMultiset<T, Compare, Allocator>::remove(Iterator<const T>& it)
 {
    Iterator<const T> itCopy = it;
    TreeMultisetIterator *nit = 
@@ -268,20 +312,271 @@ TreeMultiset<T, Compare>::remove(Iterator<const T>& it)
             " the iterator does not belongs to this collection");
 }
    
-template <class T, class Compare>
+template <class T, class Compare, class Allocator>
 Iterator<const T>
-TreeMultiset<T, Compare>::insert(const T& t)
+TreeMultiset<T, Compare, Allocator>::insert(const T& t)
 {
    Ptr<AbstractIterator<const T> > it = new TreeMultisetIterator(
          *this, _impl.insert(t), _impl.end());
    return Iterator<const T>(it);
 }
+
+template <class T, class Compare, class Allocator>
+Iterator<const T>
+TreeMultiset<T, Compare, Allocator>::insert(T&& t)
+{
+   Ptr<AbstractIterator<const T> > it = new TreeMultisetIterator(
+         *this, _impl.insert(std::move(t)), _impl.end());
+   return Iterator<const T>(it);
+}
+
+template <class T, class Compare, class Allocator>
+template <class ... Args>
+Iterator<const T>
+TreeMultiset<T, Compare, Allocator>::emplace(Args&& ... args)
+{
+   Ptr<AbstractIterator<const T> > it = new TreeMultisetIterator(
+         *this, _impl.emplace(std::forward<Args>(args)...), _impl.end());
+   return Iterator<const T>(it);
+}
+   
+template <class T, class Compare, class Allocator>
+void
+TreeMultiset<T, Compare, Allocator>::removeAll(const T& t)
+{ _impl.erase(t); }
+
+template <class T, class Compare, class Allocator>
+const T*
+TreeMultiset<T, Compare, Allocator>::find(const T& t) const
+{
+   typename _Impl::const_iterator it = _impl.find(t);
+   return it == _impl.end() ? NULL : &*it;
+}
+
+template <class T, class Compare, class Allocator>
+const T&
+TreeMultiset<T, Compare, Allocator>::last() const
+throw (NotFoundException)
+{
+   if (_impl.empty())
+      KAREN_THROW(NotFoundException, 
+            "cannot obtain last element of empty tree set");
+   return *_impl.rbegin();
+}
+
+template <class T, class Compare, class Allocator>
+T
+TreeMultiset<T, Compare, Allocator>::takeLast()
+throw (NotFoundException)
+{
+   if (_impl.empty())
+      KAREN_THROW(NotFoundException, 
+            "cannot take last element of empty tree set");
+   typename _Impl::iterator it = --_impl.end();
+   // The element is erased right after being moved from, so the set 
+   // never compares the moved-from element
+   T t(std::move(const_cast<T&>(*it)));
+   _impl.erase(it);
+   return t;
+}
+
+template <class T, class Compare, class Allocator>
+typename TreeMultiset<T, Compare, Allocator>::ConstFastIterator
+TreeMultiset<T, Compare, Allocator>::fastBegin() const
+{ return _impl.begin(); }
+
+template <class T, class Compare, class Allocator>
+typename TreeMultiset<T, Compare, Allocator>::ConstFastIterator
+TreeMultiset<T, Compare, Allocator>::fastEnd() const
+{ return _impl.end(); }
+
+template <class T, class Compare, class Allocator>
+FastRange<typename TreeMultiset<T, Compare, Allocator>::ConstFastIterator>
+TreeMultiset<T, Compare, Allocator>::fast() const
+{ return FastRange<ConstFastIterator>(fastBegin(), fastEnd()); }
+
+template <class T, class Hash, class Equals>
+HashSet<T, Hash, Equals>::HashSet(const Hash& hash, const Equals& eq)
+ : _impl(hash, eq)
+{
+}
+
+template <class T, class Hash, class Equals>
+unsigned long
+HashSet<T, Hash, Equals>::size() const
+{ return _impl.size(); }
+   
+template <class T, class Hash, class Equals>
+void
+HashSet<T, Hash, Equals>::clear()
+{ _impl.clear(); }
+   
+template <class T, class Hash, class Equals>
+Iterator<const T>
+HashSet<T, Hash, Equals>::begin() const
+{
+   Ptr<AbstractIterator<const T> > it = new HashSetIterator(
+         *this, _impl.begin(), _impl.end());
+   return Iterator<const T>(it);
+}
+   
+template <class T, class Hash, class Equals>
+Iterator<const T>
+HashSet<T, Hash, Equals>::end() const
+{
+   Ptr<AbstractIterator<const T> > it = new HashSetIterator(
+         *this, _impl.end(), _impl.end());
+   return Iterator<const T>(it);
+}
+   
+template <class T, class Hash, class Equals>
+Iterator<const T>
+HashSet<T, Hash, Equals>::begin()
+{
+   Ptr<AbstractIterator<const T> > it = new HashSetIterator(
+         *this, _impl.begin(), _impl.end());
+   return Iterator<const T>(it);
+}
+   
+template <class T, class Hash, class Equals>
+Iterator<const T>
+HashSet<T, Hash, Equals>::end()
+{
+   Ptr<AbstractIterator<const T> > it = new HashSetIterator(
+         *this, _impl.end(), _impl.end());
+   return Iterator<const T>(it);
+}
    
-template <class T, class Compare>
+template <class T, class Hash, class Equals>
+Iterator<const T>
+HashSet<T, Hash, Equals>::rbegin() const
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<const T> > it = new HashSetReverseIterator(
+         *this, ReverseIt(_impl.end()), ReverseIt(_impl.begin()));
+   return Iterator<const T>(it);
+}
+   
+template <class T, class Hash, class Equals>
+Iterator<const T>
+HashSet<T, Hash, Equals>::rend() const
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<const T> > it = new HashSetReverseIterator(
+         *this, ReverseIt(_impl.begin()), ReverseIt(_impl.begin()));
+   return Iterator<const T>(it);
+}
+   
+template <class T, class Hash, class Equals>
+Iterator<const T>
+HashSet<T, Hash, Equals>::rbegin()
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<const T> > it = new HashSetReverseIterator(
+         *this, ReverseIt(_impl.end()), ReverseIt(_impl.begin()));
+   return Iterator<const T>(it);
+}
+   
+template <class T, class Hash, class Equals>
+Iterator<const T>
+HashSet<T, Hash, Equals>::rend()
+{
+   typedef std::reverse_iterator<typename _Impl::iterator> ReverseIt;
+   Ptr<AbstractIterator<const T> > it = new HashSetReverseIterator(
+         *this, ReverseIt(_impl.begin()), ReverseIt(_impl.begin()));
+   return Iterator<const T>(it);
+}
+   
+template <class T, class Hash, class Equals>
 void
-TreeMultiset<T, Compare>::removeAll(const T& t)
+HashSet<T, Hash, Equals>::remove(Iterator<const T>& it)
+{
+   Iterator<const T> itCopy = it;
+   HashSetIterator *nit = itCopy.template impl<HashSetIterator>();
+   HashSetReverseIterator *nrit = 
+         itCopy.template impl<HashSetReverseIterator>();
+   if (nit && (nit->collection() == this))   
+   {
+      it++;
+      _impl.erase(nit->impl());
+   }
+   else if (nrit && (nrit->collection() == this))
+   {
+      it++;
+      _impl.erase(--nrit->impl().base());
+   }
+   else
+      KAREN_THROW(InvalidInputException, 
+            "cannot remove element from hash set from given iterator:"
+            " the iterator does not belongs to this collection");
+}
+   
+template <class T, class Hash, class Equals>
+Iterator<const T>
+HashSet<T, Hash, Equals>::insert(const T& t)
+{
+   Ptr<AbstractIterator<const T> > it = new HashSetIterator(
+         *this, _impl.emplace(t, t).first, _impl.end());
+   return Iterator<const T>(it);
+}
+
+template <class T, class Hash, class Equals>
+Iterator<const T>
+HashSet<T, Hash, Equals>::insert(T&& t)
+{
+   Ptr<AbstractIterator<const T> > it = new HashSetIterator(
+         *this, _impl.emplace(t, std::move(t)).first, _impl.end());
+   return Iterator<const T>(it);
+}
+
+template <class T, class Hash, class Equals>
+template <class ... Args>
+Iterator<const T>
+HashSet<T, Hash, Equals>::emplace(Args&& ... args)
+{ return insert(T(std::forward<Args>(args)...)); }
+   
+template <class T, class Hash, class Equals>
+void
+HashSet<T, Hash, Equals>::removeAll(const T& t)
 { _impl.erase(t); }
 
+template <class T, class Hash, class Equals>
+bool
+HashSet<T, Hash, Equals>::contains(const T& t) const
+{ return _impl.find(t) != _impl.end(); }
+
+template <class T, class Hash, class Equals>
+const T*
+HashSet<T, Hash, Equals>::find(const T& t) const
+{
+   typename _Impl::const_iterator it = _impl.find(t);
+   return it == _impl.end() ? NULL : &*it;
+}
+
+template <class T, class Hash, class Equals>
+unsigned long
+HashSet<T, Hash, Equals>::capacity() const
+{ return _impl.capacity(); }
+
+template <class T, class Hash, class Equals>
+void
+HashSet<T, Hash, Equals>::reserve(unsigned long size)
+{ _impl.reserve(size); }
+
+template <class T, class Hash, class Equals>
+typename HashSet<T, Hash, Equals>::ConstFastIterator
+HashSet<T, Hash, Equals>::fastBegin() const
+{ return _impl.begin(); }
+
+template <class T, class Hash, class Equals>
+typename HashSet<T, Hash, Equals>::ConstFastIterator
+HashSet<T, Hash, Equals>::fastEnd() const
+{ return _impl.end(); }
+
+template <class T, class Hash, class Equals>
+FastRange<typename HashSet<T, Hash, Equals>::ConstFastIterator>
+HashSet<T, Hash, Equals>::fast() const
+{ return FastRange<ConstFastIterator>(fastBegin(), fastEnd()); }
 
 }
 
@@ -26,6 +26,7 @@
 #define KAREN_CORE_SET_H
 
 #include "KarenCore/collection.h"
+#include "KarenCore/hash-table.h"
 
 #include <set>
 
@@ -45,20 +46,35 @@ public:
     * newly inserted element. 
     */
    virtual Iterator<const T> insert(const T& t) = 0;
+
+   /**
+    * Inserts a new element in the set by moving it. It returns an 
+    * iterator to the newly inserted element. 
+    */
+   virtual Iterator<const T> insert(T&& t) = 0;
    
    /**
     * Removes all ocurrences of given element (if any). 
     */
    virtual void removeAll(const T& t) = 0;
+
+   /**
+    * Obtain a pointer to the element of the set equal to given one, or a
+    * null pointer if there is no such element.
+    */
+   virtual const T* find(const T& t) const = 0;
    
 };
 
-template <class T, class Compare = DefaultLessThan<T> >
+template <class T, 
+          class Compare = DefaultLessThan<T>,
+          class Allocator = std::allocator<T> >
 class TreeSet : public Set<T>
 {
 public:
 
-   inline TreeSet(const Compare& cmp = Compare());
+   inline TreeSet(const Compare& cmp = Compare(),
+                  const Allocator& alloc = Allocator());
 
    inline virtual unsigned long size() const;
    
@@ -83,12 +99,35 @@ public:
    inline void remove(Iterator<const T>& it);
 
    inline Iterator<const T> insert(const T& t);
+
+   inline Iterator<const T> insert(T&& t);
+
+   /**
+    * Inserts a new element in the set constructing it in place from 
+    * given arguments. It returns an iterator to the inserted element. 
+    */
+   template <class ... Args>
+   inline Iterator<const T> emplace(Args&& ... args);
    
    inline void removeAll(const T& t);
 
+   inline virtual const T* find(const T& t) const;
+
+   /**
+    * Fast iterator type. See FastRange for details.
+    */
+   typedef typename std::set<T, Compare, Allocator>::const_iterator
+         ConstFastIterator;
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<ConstFastIterator> fast() const;
+
 private:
 
-   typedef std::set<T, Compare> _Impl;
+   typedef std::set<T, Compare, Allocator> _Impl;
 
    typedef IteratorImpl<T, TreeSet, 
          typename _Impl::iterator> TreeSetIterator;
@@ -100,12 +139,15 @@ private:
    
 };
 
-template <class T, class Compare = DefaultLessThan<T> >
+template <class T, 
+          class Compare = DefaultLessThan<T>,
+          class Allocator = std::allocator<T> >
 class TreeMultiset : public Set<T>
 {
 public:
 
-   inline TreeMultiset(const Compare& cmp = Compare());
+   inline TreeMultiset(const Compare& cmp = Compare(),
+                       const Allocator& alloc = Allocator());
 
    inline virtual unsigned long size() const;
    
@@ -130,12 +172,48 @@ public:
    inline void remove(Iterator<const T>& it);
 
    inline Iterator<const T> insert(const T& t);
+
+   inline Iterator<const T> insert(T&& t);
+
+   /**
+    * Inserts a new element in the set constructing it in place from 
+    * given arguments. It returns an iterator to the inserted element. 
+    */
+   template <class ... Args>
+   inline Iterator<const T> emplace(Args&& ... args);
    
    inline void removeAll(const T& t);
 
+   inline virtual const T* find(const T& t) const;
+
+   /**
+    * Obtain the greatest element of the set, or throw a NotFoundException
+    * if the set is empty. 
+    */
+   inline const T& last() const throw (NotFoundException);
+
+   /**
+    * Remove the greatest element of the set and return it, or throw a 
+    * NotFoundException if the set is empty. The element is moved out of
+    * the set rather than copied. 
+    */
+   inline T takeLast() throw (NotFoundException);
+
+   /**
+    * Fast iterator type. See FastRange for details.
+    */
+   typedef typename std::multiset<T, Compare, Allocator>::const_iterator
+         ConstFastIterator;
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<ConstFastIterator> fast() const;
+
 private:
 
-   typedef std::multiset<T, Compare> _Impl;
+   typedef std::multiset<T, Compare, Allocator> _Impl;
 
    typedef IteratorImpl<T, TreeMultiset, 
          typename _Impl::iterator> TreeMultisetIterator;
@@ -147,6 +225,110 @@ private:
    
 };
 
+/**
+ * Hash set template class. This class implements the Set interface by
+ * means of a HashTable, an open-addressing hash table with elements 
+ * stored inline. Lookups take constant time in average, at the cost of
+ * iterating the elements in no particular order. Elements are hashed by
+ * Hash and compared by Equals; see DefaultHash for the supported types.
+ * Iterators are invalidated when an element is inserted into the set.
+ */
+template <class T, 
+          class Hash = DefaultHash<T>, 
+          class Equals = DefaultEquals<T> >
+class HashSet : public Set<T>
+{
+public:
+
+   inline HashSet(const Hash& hash = Hash(), const Equals& eq = Equals());
+
+   inline virtual unsigned long size() const;
+   
+   inline void clear();
+
+   inline virtual Iterator<const T> begin();
+   
+   inline virtual Iterator<const T> end();
+
+   inline virtual Iterator<const T> begin() const;
+   
+   inline virtual Iterator<const T> end() const;
+
+   inline virtual Iterator<const T> rbegin();
+   
+   inline virtual Iterator<const T> rend();
+
+   inline virtual Iterator<const T> rbegin() const;
+   
+   inline virtual Iterator<const T> rend() const;
+
+   inline void remove(Iterator<const T>& it);
+
+   inline Iterator<const T> insert(const T& t);
+
+   inline Iterator<const T> insert(T&& t);
+
+   /**
+    * Inserts a new element in the set constructing it from given 
+    * arguments. It returns an iterator to the inserted element. 
+    */
+   template <class ... Args>
+   inline Iterator<const T> emplace(Args&& ... args);
+   
+   inline void removeAll(const T& t);
+
+   inline virtual const T* find(const T& t) const;
+
+   /**
+    * Check whether given element belongs to this set. Unlike 
+    * hasElement(), this performs a hash lookup. 
+    */
+   inline bool contains(const T& t) const;
+
+   /**
+    * Obtain the number of slots of the hash table. 
+    */
+   inline unsigned long capacity() const;
+
+   /**
+    * Ensure the set may hold given number of elements without growing.
+    */
+   inline void reserve(unsigned long size);
+
+private:
+
+   struct ElementKey
+   {
+      inline const T& operator () (const T& t) const
+      { return t; }
+   };
+
+   typedef HashTable<T, T, ElementKey, Hash, Equals> _Impl;
+
+   typedef IteratorImpl<T, HashSet, 
+         typename _Impl::iterator> HashSetIterator;
+   
+   typedef IteratorImpl<T, HashSet,
+         std::reverse_iterator<typename _Impl::iterator> > 
+         HashSetReverseIterator;
+   
+   mutable _Impl _impl;
+
+public:
+
+   /**
+    * Fast iterator type. See FastRange for details.
+    */
+   typedef typename _Impl::const_iterator ConstFastIterator;
+
+   inline ConstFastIterator fastBegin() const;
+
+   inline ConstFastIterator fastEnd() const;
+
+   inline FastRange<ConstFastIterator> fast() const;
+
+};
+
 }
 
 #include "KarenCore/set-inl.h"
@@ -0,0 +1,104 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_SIMD_H
+#define KAREN_CORE_SIMD_H
+
+#include "KarenCore/platform.h"
+
+/* Check whether x86 SIMD kernels may be built with target attributes. */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (KAREN_COMPILER == KAREN_COMPILER_GCC || \
+     KAREN_COMPILER == KAREN_COMPILER_CLANG)
+   #define KAREN_SIMD_X86
+#endif
+
+namespace karen {
+
+/**
+ * SIMD instruction set level. Each level includes the previous ones. 
+ */
+enum SimdLevel
+{
+   SIMD_SCALAR,
+   SIMD_SSE2,
+   SIMD_AVX2,
+};
+
+/**
+ * Obtain the highest SIMD level supported by the running CPU. 
+ */
+KAREN_EXPORT SimdLevel detectSimdLevel();
+
+/**
+ * Obtain the SIMD level used to choose the kernels of vectorized
+ * operations. It is the detected level unless set otherwise. 
+ */
+KAREN_EXPORT SimdLevel simdLevel();
+
+/**
+ * Set the SIMD level used to choose the kernels of vectorized operations.
+ * Levels above the detected one are lowered to it. This is mostly useful
+ * to test or benchmark the fallback kernels. Objects that already chose
+ * their kernels are not affected. 
+ */
+KAREN_EXPORT void setSimdLevel(SimdLevel level);
+
+/**
+ * Find the last occurrence of given byte in given bytes. It returns a
+ * pointer to the byte found, or a null pointer if there is none. 
+ */
+KAREN_EXPORT const char* simdFindLastByte(
+      const char* str, unsigned long len, char c);
+
+/**
+ * Find the first occurrence of given pattern in given bytes. It returns
+ * a pointer to the first byte of the occurrence, or a null pointer if 
+ * there is none. An empty pattern is found at the beginning. 
+ */
+KAREN_EXPORT const char* simdFindBytes(
+      const char* str, unsigned long len, 
+      const char* pattern, unsigned long patternLen);
+
+/**
+ * Convert given bytes to lower case into given destination, which may be
+ * the source itself. Only ASCII letters are converted, as the C locale
+ * does. 
+ */
+KAREN_EXPORT void simdToLowerCase(
+      char* dst, const char* src, unsigned long len);
+
+/**
+ * Convert given bytes to upper case into given destination, which may be
+ * the source itself. Only ASCII letters are converted, as the C locale
+ * does. 
+ */
+KAREN_EXPORT void simdToUpperCase(
+      char* dst, const char* src, unsigned long len);
+
+}; // namespace karen
+
+using karen::SimdLevel;
+
+#endif
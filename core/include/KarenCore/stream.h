@@ -37,6 +37,11 @@ class KAREN_EXPORT InputStream
 {
 public:
 
+   /**
+    * Virtual destructor.
+    */
+   inline virtual ~InputStream() {}
+
    /**
     * Read one element of template class T from the stream. If the element
     * cannot be read, a IOException is thrown.
@@ -45,20 +50,27 @@ public:
    T read() throw (IOException)
    {
       UInt8 dat[sizeof(T)];
-      UInt8* ptr = dat;
-      unsigned long left = sizeof(T), nread;
-      
-      while (left && (nread = readBytes(ptr, left)))
-      {
-         ptr += nread;
-         left -= nread;
-      }
-      if (left)
+      if (readFully(dat, sizeof(T)) < sizeof(T))
          KAREN_THROW(IOException, 
             "cannot read element from input stream: no more bytes left in device");
       return *((T*) dat);
    }
 
+   /**
+    * Read count elements of template class T from the stream and store them
+    * in dst. The elements are read with as few calls to readBytes() as the
+    * stream allows instead of one per element. If the elements cannot be 
+    * read, a IOException is thrown.
+    */
+   template <class T>
+   void readArray(T* dst, unsigned long count) throw (IOException)
+   {
+      if (readFully(dst, count * sizeof(T)) < count * sizeof(T))
+         KAREN_THROW(IOException, 
+            "cannot read %d elements from input stream: "
+            "no more bytes left in device", count);
+   }
+
    /**
     * Read len bytes from stream and store them in dst, returning the number
     * of bytes read or zero if there is no more data. If stream source
@@ -67,6 +79,22 @@ public:
    virtual unsigned long readBytes(void* dst, unsigned long len) 
          throw (IOException) = 0;
 
+   /**
+    * Skip the next len bytes of the stream, returning the number of bytes
+    * actually skipped. This is less than len only if the stream has no more
+    * data. The default implementation reads and discards the bytes. If 
+    * stream source cannot be read, a IOException is thrown.
+    */
+   virtual unsigned long skip(unsigned long len) throw (IOException);
+
+protected:
+
+   /**
+    * Read len bytes into dst, calling readBytes() until they are all read
+    * or there is no more data. It returns the number of bytes read.
+    */
+   unsigned long readFully(void* dst, unsigned long len) throw (IOException);
+
 };
 
 /**
@@ -77,6 +105,11 @@ class KAREN_EXPORT OutputStream
 {
 public:
 
+   /**
+    * Virtual destructor.
+    */
+   inline virtual ~OutputStream() {}
+
    /**
     * Write one element of template class T to the stream. If there was a 
     * problem while writing, a IOException is thrown.
@@ -84,18 +117,26 @@ public:
    template <class T>
    void write(const T& data) throw (IOException)
    {
-      UInt8* ptr = (UInt8*) &data;
-      unsigned long left = sizeof(T), nwrite;
-      while (left && (nwrite = writeBytes(ptr, left)))
-      {
-         ptr += nwrite;
-         left -= nwrite;
-      }
-      if (left)
+      if (writeFully(&data, sizeof(T)) < sizeof(T))
          KAREN_THROW(IOException,
             "cannot write element into stream: no more space left in device");
    }
 
+   /**
+    * Write count elements of template class T stored in src to the stream.
+    * The elements are written with as few calls to writeBytes() as the
+    * stream allows instead of one per element. If there was a problem 
+    * while writing, a IOException is thrown.
+    */
+   template <class T>
+   void writeArray(const T* src, unsigned long count) throw (IOException)
+   {
+      if (writeFully(src, count * sizeof(T)) < count * sizeof(T))
+         KAREN_THROW(IOException,
+            "cannot write %d elements into stream: "
+            "no more space left in device", count);
+   }
+
    /**
     * Write len bytes stored in data to this stream and return the number of
     * bytes actually written. If there was a problem while writing, a 
@@ -104,6 +145,165 @@ public:
    virtual unsigned long writeBytes(const void* data, unsigned long len) 
       throw (IOException) = 0;
 
+   /**
+    * Flush the stream, passing any bytes it retains down to its device. 
+    * The default implementation does nothing. If there was a problem while
+    * writing, a IOException is thrown.
+    */
+   inline virtual void flush() throw (IOException) {}
+
+protected:
+
+   /**
+    * Write len bytes from data, calling writeBytes() until they are all
+    * written or the device accepts no more. It returns the number of bytes
+    * written.
+    */
+   unsigned long writeFully(const void* data, unsigned long len) 
+         throw (IOException);
+
+};
+
+/**
+ * Buffered input stream class. This class decorates an input stream with
+ * a read buffer, so reading small elements from it costs a memory copy 
+ * instead of a call to the source stream. The source is read in chunks as
+ * large as the buffer, and reads larger than the buffer bypass it. Besides,
+ * the buffer allows to peek the next bytes of the stream without consuming
+ * them. The source stream is not owned by the buffered stream and it must
+ * outlive it.
+ */
+class KAREN_EXPORT BufferedInputStream : public InputStream
+{
+public:
+
+   static const unsigned long DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+   /**
+    * Create a new buffered stream that reads from source using a buffer
+    * of given size.
+    */
+   BufferedInputStream(InputStream* source, 
+                       unsigned long bufferSize = DEFAULT_BUFFER_SIZE);
+
+   virtual ~BufferedInputStream();
+
+   /**
+    * Obtain the size of the buffer.
+    */
+   inline unsigned long bufferSize() const
+   { return _capacity; }
+
+   /**
+    * Obtain the number of bytes in the buffer not consumed yet.
+    */
+   inline unsigned long bytesBuffered() const
+   { return _end - _begin; }
+
+   /**
+    * Peek one element of template class T from the stream. The element is
+    * returned without being consumed, so the next read returns it again. If
+    * the element cannot be read, a IOException is thrown.
+    */
+   template <class T>
+   T peek() throw (IOException)
+   {
+      UInt8 dat[sizeof(T)];
+      if (peekBytes(dat, sizeof(T)) < sizeof(T))
+         KAREN_THROW(IOException, 
+            "cannot peek element from input stream: "
+            "no more bytes left in device");
+      return *((T*) dat);
+   }
+
+   /**
+    * Copy the next len bytes of the stream into dst without consuming them.
+    * It returns the number of bytes copied, that is less than len only if
+    * the stream has no more data. If len is larger than the buffer size, a
+    * InvalidInputException is thrown. If stream source cannot be read, a 
+    * IOException is thrown.
+    */
+   unsigned long peekBytes(void* dst, unsigned long len) 
+         throw (IOException, InvalidInputException);
+
+   virtual unsigned long readBytes(void* dst, unsigned long len) 
+         throw (IOException);
+
+   virtual unsigned long skip(unsigned long len) throw (IOException);
+
+private:
+
+   InputStream*   _source;
+   UInt8*         _data;
+   unsigned long  _capacity;
+   unsigned long  _begin;
+   unsigned long  _end;
+
+   BufferedInputStream(const BufferedInputStream&);
+   BufferedInputStream& operator = (const BufferedInputStream&);
+
+   bool fill(unsigned long len) throw (IOException);
+
+};
+
+/**
+ * Buffered output stream class. This class decorates an output stream with
+ * a write buffer, so writing small elements to it costs a memory copy
+ * instead of a call to the target stream. The buffer is written to the 
+ * target when it is full, when flush() is invoked and when the stream is
+ * destroyed. Errors writing the buffer on destruction cannot be reported,
+ * so flush() should be invoked before when they matter. Writes larger than
+ * the buffer bypass it. The target stream is not owned by the buffered 
+ * stream and it must outlive it.
+ */
+class KAREN_EXPORT BufferedOutputStream : public OutputStream
+{
+public:
+
+   static const unsigned long DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+   /**
+    * Create a new buffered stream that writes to target using a buffer
+    * of given size.
+    */
+   BufferedOutputStream(OutputStream* target,
+                        unsigned long bufferSize = DEFAULT_BUFFER_SIZE);
+
+   virtual ~BufferedOutputStream();
+
+   /**
+    * Obtain the size of the buffer.
+    */
+   inline unsigned long bufferSize() const
+   { return _capacity; }
+
+   /**
+    * Obtain the number of bytes in the buffer not written to target yet.
+    */
+   inline unsigned long bytesBuffered() const
+   { return _length; }
+
+   virtual unsigned long writeBytes(const void* data, unsigned long len) 
+      throw (IOException);
+
+   /**
+    * Write the buffered bytes to the target stream and flush it. If there
+    * was a problem while writing, a IOException is thrown.
+    */
+   virtual void flush() throw (IOException);
+
+private:
+
+   OutputStream*  _target;
+   UInt8*         _data;
+   unsigned long  _capacity;
+   unsigned long  _length;
+
+   BufferedOutputStream(const BufferedOutputStream&);
+   BufferedOutputStream& operator = (const BufferedOutputStream&);
+
+   void drain() throw (IOException);
+
 };
 
 }; // namespace karen
@@ -27,12 +27,13 @@
 
 #include "KarenCore/iterator.h"
 #include "KarenCore/pointer.h"
+#include "KarenCore/simd.h"
 #include "KarenCore/string.h"
 #include "KarenCore/types.h"
 
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
-#include <sstream>
 
 namespace karen {
 
@@ -95,6 +96,62 @@ private:
 
 };
 
+/*
+ * Character kernels of strings. The generic ones work for any character
+ * type, while the overloads for char use the SIMD kernels. 
+ */
+template <typename CharType>
+inline const CharType*
+findLastCharacter(const CharType* str, unsigned long len, CharType c)
+{
+   while (len--)
+      if (str[len] == c)
+         return str + len;
+   return NULL;
+}
+
+inline const char*
+findLastCharacter(const char* str, unsigned long len, char c)
+{ return simdFindLastByte(str, len, c); }
+
+template <typename CharType>
+inline const CharType*
+findCharacters(const CharType* str, unsigned long len, 
+               const CharType* pattern, unsigned long patternLen)
+{
+   const CharType* p = std::search(str, str + len, pattern, pattern + patternLen);
+   return (p != str + len || !patternLen) ? p : NULL;
+}
+
+inline const char*
+findCharacters(const char* str, unsigned long len,
+               const char* pattern, unsigned long patternLen)
+{ return simdFindBytes(str, len, pattern, patternLen); }
+
+template <typename CharType>
+inline void
+lowerCaseCharacters(CharType* str, unsigned long len)
+{
+   for (unsigned long i = 0; i < len; i++)
+      str[i] = tolower(str[i]);
+}
+
+inline void
+lowerCaseCharacters(char* str, unsigned long len)
+{ simdToLowerCase(str, str, len); }
+
+template <typename CharType>
+inline void
+upperCaseCharacters(CharType* str, unsigned long len)
+{
+   for (unsigned long i = 0; i < len; i++)
+      str[i] = toupper(str[i]);
+}
+
+inline void
+upperCaseCharacters(char* str, unsigned long len)
+{ simdToUpperCase(str, str, len); }
+
 #ifndef MAX_FORMAT_LENGTH
 #define MAX_FORMAT_LENGTH 10240
 #endif
@@ -105,6 +162,12 @@ StringBase<CharType>::StringBase() : _base() {}
 template <typename CharType>
 StringBase<CharType>::StringBase(const StringBase& str) : _base(str._base) {}
 
+template <typename CharType>
+StringBase<CharType>::StringBase(StringBase&& str)
+throw ()
+   : _base(std::move(str._base)) 
+{}
+
 template <typename CharType>
 StringBase<CharType>::StringBase(const CharType* str) : _base(str) {}
 
@@ -115,6 +178,10 @@ StringBase<CharType>::StringBase(const CharType* str, unsigned long strLen)
 template <typename CharType>
 StringBase<CharType>::StringBase(const std::string& str) : _base(str) {}
 
+template <typename CharType>
+StringBase<CharType>::StringBase(const StringViewBase<CharType>& str)
+   : _base(str.data(), str.length()) {}
+
 template <typename CharType>
 StringBase<CharType>::~StringBase() {}
 
@@ -126,6 +193,11 @@ template <typename CharType>
 StringBase<CharType>::operator const std::basic_string<CharType>& () const
 { return _base; }
 
+template <typename CharType>
+StringViewBase<CharType>
+StringBase<CharType>::view() const
+{ return StringViewBase<CharType>(_base.data(), _base.length()); }
+
 template <typename CharType>
 typename StringBase<CharType>::Length
 StringBase<CharType>::length() const { return _base.length(); }
@@ -140,13 +212,13 @@ StringBase<CharType>::clear() { _base.clear(); }
 
 template <typename CharType>
 bool
-StringBase<CharType>::startsWith(const StringBase& str) const
-{ return head(str.length()) == str; }
+StringBase<CharType>::startsWith(const StringViewBase<CharType>& str) const
+{ return view().startsWith(str); }
 
 template <typename CharType>
 bool
-StringBase<CharType>::endsWith(const StringBase& str) const
-{ return tail(str.length()) == str; }
+StringBase<CharType>::endsWith(const StringViewBase<CharType>& str) const
+{ return view().endsWith(str); }
 
 template <typename CharType>
 typename StringBase<CharType>::Position
@@ -159,10 +231,13 @@ StringBase<CharType>::findChar(CharType elem, Position pos) const
 template <typename CharType>
 typename StringBase<CharType>::Position
 StringBase<CharType>::reverseFindChar(CharType elem, Position pos) const
-{ 
-   size_t p = pos.isNull() ? _base.rfind(elem) : _base.rfind(elem, pos); 
-   return (p == std::string::npos) ? Position() : Position(p); 
-}
+{ return view().reverseFindChar(elem, pos); }
+
+template <typename CharType>
+typename StringBase<CharType>::Position
+StringBase<CharType>::find(
+      const StringViewBase<CharType>& str, Position pos) const
+{ return view().find(str, pos); }
 
 template <typename CharType>
 StringBase<CharType>&
@@ -202,6 +277,21 @@ StringBase<CharType>::tail(Length len) const
    return (len < l) ? slice(l - len, len) : *this;
 }
 
+template <typename CharType>
+StringViewBase<CharType>
+StringBase<CharType>::sliceView(Position pos, Length len) const
+{ return view().slice(pos, len); }
+
+template <typename CharType>
+StringViewBase<CharType>
+StringBase<CharType>::headView(Length len) const
+{ return view().head(len); }
+
+template <typename CharType>
+StringViewBase<CharType>
+StringBase<CharType>::tailView(Length len) const
+{ return view().tail(len); }
+
 template <typename CharType>
 StringBase<CharType>&
 StringBase<CharType>::removeSlice(Position pos, Length len)
@@ -226,37 +316,64 @@ StringBase<CharType>::removeFromTail(Length len)
 
 template <typename CharType>
 StringBase<CharType>
-StringBase<CharType>::removeHead(const StringBase& str) const
+StringBase<CharType>::removeHead(const StringViewBase<CharType>& str) const
 { return startsWith(str) ? tail(length() - str.length()) : *this; }
 
 template <typename CharType>
 StringBase<CharType>
-StringBase<CharType>::removeTail(const StringBase& str) const
+StringBase<CharType>::removeTail(const StringViewBase<CharType>& str) const
 { return endsWith(str) ? head(length() - str.length()) : *this; }
 
+template <typename CharType>
+StringViewBase<CharType>
+StringBase<CharType>::removeHeadView(const StringViewBase<CharType>& str) const
+{ return view().removeHead(str); }
+
+template <typename CharType>
+StringViewBase<CharType>
+StringBase<CharType>::removeTailView(const StringViewBase<CharType>& str) const
+{ return view().removeTail(str); }
+
 template <typename CharType>
 StringBase<CharType>
 StringBase<CharType>::capitalize() const
-{ std::string r(_base); if (r.length() > 0) r[0] = toupper(r[0]); return r; }
+{ return StringBase(*this).capitalizeInPlace(); }
+
+template <typename CharType>
+StringBase<CharType>&
+StringBase<CharType>::capitalizeInPlace()
+{
+   if (!_base.empty())
+      upperCaseCharacters(&_base[0], 1);
+   return *this;
+}
 
 template <typename CharType>
 StringBase<CharType>
 StringBase<CharType>::toLowerCase() const
-{ 
-   std::string r(_base); 
-   for (unsigned int i = 0; i < r.length(); i++)
-      r[i] = tolower(r[i]);
-   return r;
+{ return StringBase(*this).toLowerCaseInPlace(); }
+
+template <typename CharType>
+StringBase<CharType>&
+StringBase<CharType>::toLowerCaseInPlace()
+{
+   if (!_base.empty())
+      lowerCaseCharacters(&_base[0], _base.length());
+   return *this;
 }
 
 template <typename CharType>
 StringBase<CharType>
 StringBase<CharType>::toUpperCase() const
-{ 
-   std::string r(_base); 
-   for (unsigned int i = 0; i < r.length(); i++)
-      r[i] = toupper(r[i]);
-   return r;
+{ return StringBase(*this).toUpperCaseInPlace(); }
+
+template <typename CharType>
+StringBase<CharType>&
+StringBase<CharType>::toUpperCaseInPlace()
+{
+   if (!_base.empty())
+      upperCaseCharacters(&_base[0], _base.length());
+   return *this;
 }
 
 template <typename CharType>
@@ -264,6 +381,12 @@ StringBase<CharType>&
 StringBase<CharType>::operator = (const StringBase& str)
 { _base = str._base; return *this; }
 
+template <typename CharType>
+StringBase<CharType>&
+StringBase<CharType>::operator = (StringBase&& str)
+throw ()
+{ _base = std::move(str._base); return *this; }
+
 template <typename CharType>
 StringBase<CharType>
 StringBase<CharType>::operator + (const StringBase& str) const
@@ -279,6 +402,11 @@ bool
 StringBase<CharType>::operator == (const CharType* str) const
 { return _base == str; }
 
+template <typename CharType>
+bool
+StringBase<CharType>::operator == (const StringViewBase<CharType>& str) const
+{ return view() == str; }
+
 template <typename CharType>
 bool
 StringBase<CharType>::operator != (const StringBase& str) const
@@ -289,6 +417,11 @@ bool
 StringBase<CharType>::operator != (const CharType* str) const
 { return _base != str; }
 
+template <typename CharType>
+bool
+StringBase<CharType>::operator != (const StringViewBase<CharType>& str) const
+{ return view() != str; }
+
 template <typename CharType>
 bool
 StringBase<CharType>::operator < (const StringBase &str) const
@@ -352,9 +485,18 @@ template <typename CharType>
 StringBase<CharType>
 StringBase<CharType>::fromLong(long num)
 {
-   std::stringstream s;
-   s << num;
-   return StringBase(s.str());
+   CharType digits[24];
+   CharType* end = digits + 24;
+   CharType* begin = end;
+   unsigned long magnitude = num < 0 ? 0UL - (unsigned long) num : num;
+   do
+   {
+      *--begin = (CharType) ('0' + magnitude % 10);
+      magnitude /= 10;
+   } while (magnitude);
+   if (num < 0)
+      *--begin = '-';
+   return StringBase(begin, end - begin);
 }
 
 template <typename CharType>
@@ -411,6 +553,87 @@ StringBase<CharType>::end() const
    return Iterator<const CharType>(it);
 }
 
+template <typename CharType>
+StringViewBase<CharType>::StringViewBase(const StringBase<CharType>& str)
+ : _str(str), _len(str.length())
+{}
+
+template <typename CharType>
+bool
+StringViewBase<CharType>::startsWith(const StringViewBase& str) const
+{ return head(str._len) == str; }
+
+template <typename CharType>
+bool
+StringViewBase<CharType>::endsWith(const StringViewBase& str) const
+{ return tail(str._len) == str; }
+
+template <typename CharType>
+typename StringViewBase<CharType>::Position
+StringViewBase<CharType>::findChar(CharType elem, Position pos) const
+{
+   Length from = pos.isNull() ? 0 : (Length) pos;
+   if (from >= _len)
+      return Position();
+   const CharType* p = 
+         std::char_traits<CharType>::find(_str + from, _len - from, elem);
+   return p ? Position(p - _str) : Position();
+}
+
+template <typename CharType>
+typename StringViewBase<CharType>::Position
+StringViewBase<CharType>::reverseFindChar(CharType elem, Position pos) const
+{
+   Length len = (pos.isNull() || (Length) pos >= _len) ? _len : pos + 1;
+   const CharType* p = findLastCharacter(_str, len, elem);
+   return p ? Position(p - _str) : Position();
+}
+
+template <typename CharType>
+typename StringViewBase<CharType>::Position
+StringViewBase<CharType>::find(const StringViewBase& str, Position pos) const
+{
+   Length from = pos.isNull() ? 0 : (Length) pos;
+   if (from > _len)
+      return Position();
+   const CharType* p = 
+         findCharacters(_str + from, _len - from, str._str, str._len);
+   return p ? Position(p - _str) : Position();
+}
+
+template <typename CharType>
+StringViewBase<CharType>
+StringViewBase<CharType>::slice(Position pos, Length len) const
+{
+   if (pos >= _len)
+      return StringViewBase();
+   Length avail = _len - pos;
+   return StringViewBase(_str + pos, (len < avail) ? len : avail);
+}
+
+template <typename CharType>
+int
+StringViewBase<CharType>::compare(const StringViewBase& str) const
+{
+   Length len = (_len < str._len) ? _len : str._len;
+   int c = len ? std::char_traits<CharType>::compare(_str, str._str, len) : 0;
+   if (c)
+      return c;
+   return (_len < str._len) ? -1 : (_len > str._len) ? 1 : 0;
+}
+
+template <typename CharType>
+const CharType&
+StringViewBase<CharType>::operator [] (const Position& pos) const
+{
+   if (pos < _len)
+      return _str[pos];
+   else
+      KAREN_THROW(OutOfBoundsException, 
+         "attempt of accessing string view element at position %lu; "
+         "view length is %lu", (unsigned long) pos, _len);
+}
+
 }; // namespace karen
 
 #endif
@@ -39,6 +39,9 @@ class Iterator;
 template <class T>
 class ConstIterator;
 
+template <typename CharType>
+class StringViewBase;
+
 /**
  * String class. This class provides an abstraction for a string of
  * characters or bytes. It is based on STL string class as base, including
@@ -92,6 +95,12 @@ public:
     */
    StringBase(const StringBase& str);
    
+   /**
+    * Move constructor. This creates a new string by taking the contents
+    * of the one passed as argument, which is left empty.
+    */
+   StringBase(StringBase&& str) throw ();
+   
    /**
     * Value constructor. This creates a new string from given null-terminated
     * char pointer. 
@@ -109,6 +118,12 @@ public:
     * object. 
     */
    StringBase(const std::string& str);
+
+   /**
+    * Value constructor. This creates a new string by copying the characters
+    * referenced by given view. 
+    */
+   explicit StringBase(const StringViewBase<CharType>& str);
    
    /**
     * Virtual destructor.     
@@ -124,6 +139,12 @@ public:
     * Cast operator to STL string.
     */
    operator const std::basic_string<CharType>& () const;
+
+   /**
+    * Obtain a view of the whole string. The view is invalidated when this
+    * string is modified or destroyed. 
+    */
+   StringViewBase<CharType> view() const;
    
    /**
     * Return the length of the string. 
@@ -144,12 +165,12 @@ public:
    /**
     * Check whether this string starts with given one passed as argument.
     */
-   bool startsWith(const StringBase& str) const;
+   bool startsWith(const StringViewBase<CharType>& str) const;
    
    /**
     * Check whether this string ends with given one passed as argument.
     */
-   bool endsWith(const StringBase& str) const;
+   bool endsWith(const StringViewBase<CharType>& str) const;
    
    /**
     * Find given character CharType in this string. If not found, the
@@ -162,6 +183,13 @@ public:
     * to head). If not found, the nullable CharType has a null value. 
     */
    Position reverseFindChar(CharType elem, Position pos = Position()) const;
+
+   /**
+    * Find given string in this string, starting at given position if any.
+    * If not found, the returned position has a null value. 
+    */
+   Position find(const StringViewBase<CharType>& str, 
+                 Position pos = Position()) const;
    
    /**
     * Append a determined count of a character to the end of the string.
@@ -199,6 +227,22 @@ public:
     * Return the string tail by given length.
     */
    StringBase tail(Length len) const;
+
+   /**
+    * Return a view of the string slice by given position and length. 
+    * Unlike slice(), this doesn't copy any character. 
+    */
+   StringViewBase<CharType> sliceView(Position pos, Length len) const;
+
+   /**
+    * Return a view of the string head by given length.
+    */
+   StringViewBase<CharType> headView(Length len) const;
+
+   /**
+    * Return a view of the string tail by given length.
+    */
+   StringViewBase<CharType> tailView(Length len) const;
    
    /**
     * Remove given slice from this string.
@@ -220,35 +264,72 @@ public:
     * if it matches with this string head. If it doesn't match, returns a
     * this string unaltered. 
     */
-   StringBase removeHead(const StringBase& str) const;
+   StringBase removeHead(const StringViewBase<CharType>& str) const;
    
    /**
     * Return the string resulting from removing the tail passed as argument
     * if it matches with this string tail. If it doesn't match, returns a
     * this string unaltered. 
     */
-   StringBase removeTail(const StringBase& str) const;
+   StringBase removeTail(const StringViewBase<CharType>& str) const;
+
+   /**
+    * Return a view of the string resulting from removing the head passed
+    * as argument if it matches with this string head. If it doesn't match,
+    * returns a view of the whole string. 
+    */
+   StringViewBase<CharType> removeHeadView(
+         const StringViewBase<CharType>& str) const;
+
+   /**
+    * Return a view of the string resulting from removing the tail passed
+    * as argument if it matches with this string tail. If it doesn't match,
+    * returns a view of the whole string. 
+    */
+   StringViewBase<CharType> removeTailView(
+         const StringViewBase<CharType>& str) const;
    
    /**
     * Capitalize the string, converting the first symbol to upper case if
     * possible.
     */
    StringBase capitalize() const;
+
+   /**
+    * Capitalize this string in place, converting the first symbol to 
+    * upper case if possible. 
+    */
+   StringBase& capitalizeInPlace();
    
    /**
     * Return a lower case copy of this string. 
     */
    StringBase toLowerCase() const;
+
+   /**
+    * Convert this string to lower case in place. 
+    */
+   StringBase& toLowerCaseInPlace();
    
    /**
     * Return a upper case copy of this string. 
     */
    StringBase toUpperCase() const;
+
+   /**
+    * Convert this string to upper case in place. 
+    */
+   StringBase& toUpperCaseInPlace();
    
    /**
     * Assign operator.
     */
    StringBase& operator = (const StringBase& str);
+
+   /**
+    * Move assignment operator.
+    */
+   StringBase& operator = (StringBase&& str) throw ();
    
    /**
     * Add operator. This add operator return a string resulting of
@@ -265,6 +346,11 @@ public:
     * Equals to operator.
     */
    bool operator == (const CharType* str) const;
+
+   /**
+    * Equals to operator.
+    */
+   bool operator == (const StringViewBase<CharType>& str) const;
    
    /**
     * Not equals to operator.
@@ -275,6 +361,11 @@ public:
     * Not equals to operator.
     */
    bool operator != (const CharType* str) const;
+
+   /**
+    * Not equals to operator.
+    */
+   bool operator != (const StringViewBase<CharType>& str) const;
    
    /**
     * Less than operator.
@@ -334,6 +425,184 @@ private:
 
 };
 
+/**
+ * String view class. This class provides a read-only view of a sequence of
+ * characters owned by someone else, such as a string or a buffer. It only
+ * keeps a pointer and a length, so it can be created, copied and sliced
+ * without allocating memory. The view is not null-terminated, and it must
+ * not outlive the characters it refers to. 
+ */
+template <typename CharType>
+class StringViewBase
+{
+public:
+
+   /**
+    * Position data type. See StringBase::Position for details. 
+    */
+   typedef typename StringBase<CharType>::Position Position;
+
+   /**
+    * Length data type. See StringBase::Length for details. 
+    */
+   typedef typename StringBase<CharType>::Length Length;
+
+   /**
+    * Default constructor. This creates a new zero-length view.
+    */
+   inline StringViewBase() : _str(NULL), _len(0) {}
+
+   /**
+    * Value constructor. This creates a new view of given null-terminated
+    * char pointer. 
+    */
+   inline StringViewBase(const CharType* str)
+    : _str(str), _len(std::char_traits<CharType>::length(str)) {}
+
+   /**
+    * Value constructor. This creates a new view of given char array and
+    * given array length. 
+    */
+   inline StringViewBase(const CharType* str, Length len)
+    : _str(str), _len(len) {}
+
+   /**
+    * Value constructor. This creates a new view of given string. 
+    */
+   inline StringViewBase(const StringBase<CharType>& str);
+
+   /**
+    * Obtain a pointer to the first character of the view. 
+    */
+   inline const CharType* data() const
+   { return _str; }
+
+   /**
+    * Return the length of the view. 
+    */
+   inline Length length() const
+   { return _len; }
+
+   /**
+    * Indicate whether view is empty (zero-length).
+    */
+   inline bool isEmpty() const
+   { return _len == 0; }
+
+   /**
+    * Check whether this view starts with given one passed as argument.
+    */
+   inline bool startsWith(const StringViewBase& str) const;
+
+   /**
+    * Check whether this view ends with given one passed as argument.
+    */
+   inline bool endsWith(const StringViewBase& str) const;
+
+   /**
+    * Find given character in this view. If not found, the returned
+    * position has a null value. 
+    */
+   inline Position findChar(CharType elem, Position pos = Position()) const;
+
+   /**
+    * Find given character in this view in reverse way (from tail to head).
+    * If not found, the returned position has a null value. 
+    */
+   inline Position reverseFindChar(
+         CharType elem, Position pos = Position()) const;
+
+   /**
+    * Find given view in this view, starting at given position if any. If
+    * not found, the returned position has a null value. 
+    */
+   inline Position find(const StringViewBase& str, 
+                        Position pos = Position()) const;
+
+   /**
+    * Return the view slice by given position and length.
+    */
+   inline StringViewBase slice(Position pos, Length len) const;
+
+   /**
+    * Return the view head by given length.
+    */
+   inline StringViewBase head(Length len) const
+   { return slice(0, len); }
+
+   /**
+    * Return the view tail by given length.
+    */
+   inline StringViewBase tail(Length len) const
+   { return (len < _len) ? slice(_len - len, len) : *this; }
+
+   /**
+    * Return the view resulting from removing the head passed as argument
+    * if it matches with this view head. If it doesn't match, returns this
+    * view unaltered. 
+    */
+   inline StringViewBase removeHead(const StringViewBase& str) const
+   { return startsWith(str) ? tail(_len - str._len) : *this; }
+
+   /**
+    * Return the view resulting from removing the tail passed as argument
+    * if it matches with this view tail. If it doesn't match, returns this
+    * view unaltered. 
+    */
+   inline StringViewBase removeTail(const StringViewBase& str) const
+   { return endsWith(str) ? head(_len - str._len) : *this; }
+
+   /**
+    * Compare this view with given one. It returns a negative value, zero
+    * or a positive value if this view is lexicographically lower than,
+    * equal to or greater than given one. 
+    */
+   inline int compare(const StringViewBase& str) const;
+
+   inline bool operator == (const StringViewBase& str) const
+   { return _len == str._len && compare(str) == 0; }
+
+   inline bool operator != (const StringViewBase& str) const
+   { return !(*this == str); }
+
+   inline bool operator < (const StringViewBase& str) const
+   { return compare(str) < 0; }
+
+   inline bool operator > (const StringViewBase& str) const
+   { return compare(str) > 0; }
+
+   inline bool operator <= (const StringViewBase& str) const
+   { return compare(str) <= 0; }
+
+   inline bool operator >= (const StringViewBase& str) const
+   { return compare(str) >= 0; }
+
+   /**
+    * Index operator. If given position is not valid for this view, a
+    * OutOfBoundsException is raised. 
+    */
+   inline const CharType& operator [] (const Position& pos) const;
+
+   /**
+    * Obtain a pointer to the first character of the view, so it may be
+    * iterated with range-for loops. 
+    */
+   inline const CharType* begin() const
+   { return _str; }
+
+   /**
+    * Obtain a pointer beyond the last character of the view.
+    */
+   inline const CharType* end() const
+   { return _str + _len; }
+
+private:
+
+   const CharType*   _str;
+   Length            _len;
+
+};
+
 #if KAREN_COMPILER == KAREN_COMPILER_MSVC
 template class KAREN_EXPORT std::allocator<char>;
 template class KAREN_EXPORT std::basic_string<char>;
@@ -342,9 +611,12 @@ template class KAREN_EXPORT StringBase<char>;
 
 typedef StringBase<char> String;
 
+typedef StringViewBase<char> StringView;
+
 }; // namespace karen
 
 using ::karen::String;
+using ::karen::StringView;
 
 #include "KarenCore/string-inl.h"
 
@@ -31,6 +31,7 @@
 #include "KarenCore/string.h"
 #include "KarenCore/exception.h"
 #include "KarenCore/first-class.h"
+#include "KarenCore/format.h"
 #include "KarenCore/types.h"
 
 namespace karen {
@@ -76,37 +77,15 @@ public:
    { return Test::assert<T>(NotEquals<T, T>(), expected, actual); }
 };
 
-template <>
+template <typename T>
 void
-Test::assert<int>(const BinaryPredicate<int, int>& predicate,
-                  const int& expected, const int& actual)
-{
-   if (!predicate(expected, actual))
-      KAREN_THROW(::karen::InvalidAssertionException,
-         "assertion failed: expected '%d' %s '%d'",
-         expected, (const char*) predicate, actual);
-}
-
-template <>
-void
-Test::assert<float>(const BinaryPredicate<float, float>& predicate,
-                    const float& expected, const float& actual)
-{
-   if (!predicate(expected, actual))
-      KAREN_THROW(::karen::InvalidAssertionException,
-         "assertion failed: expected '%f' %s '%f'",
-         expected, (const char*) predicate, actual);
-}
-
-template <>
-void
-Test::assert<String>(const BinaryPredicate<String, String>& predicate,
-                     const String& expected, const String& actual)
+Test::assert(const BinaryPredicate<T, T>& predicate,
+             const T& expected, const T& actual)
 {
    if (!predicate(expected, actual))
       KAREN_THROW(::karen::InvalidAssertionException,
          "assertion failed: expected '%s' %s '%s'",
-         (const char*) expected, (const char*) predicate, (const char*) actual);
+         expected, (const char*) predicate, actual);
 }
 
 enum TestResultStatus
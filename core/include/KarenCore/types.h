@@ -25,6 +25,7 @@
 #ifndef KAREN_CORE_TYPES_H
 #define KAREN_CORE_TYPES_H
 
+#include <type_traits>
 #include <utility>
 
 namespace karen {
@@ -105,10 +106,12 @@ public:
    
    inline Tuple<T1>(const T1& elem) : _elem(elem) {}
 
+   inline Tuple<T1>(T1&& elem) : _elem(std::move(elem)) {}
+
 private:
    
-   template <int id, class ... _T>
-   friend class Tuple<_T...>::_ElementAccessor;
+   template <class ... _T>
+   friend class Tuple;
    
    T1 _elem;
    
@@ -235,10 +238,34 @@ public:
     */
    inline Tuple(const Tuple<T1, T...>& t) : Tuple<T...>(t), _elem(t._elem) {}
 
+   /**
+    * Create a new tuple with given elements, moving those passed as 
+    * rvalues instead of copying them.
+    */
+   template <class U1, class ... U, class = typename std::enable_if<
+         sizeof...(U) == sizeof...(T)>::type>
+   inline Tuple(U1&& elem, U&& ... t) :
+      Tuple<T...>(std::forward<U>(t)...),
+      _elem(std::forward<U1>(elem))
+   {}
+
+   /**
+    * Create a new tuple by moving the elements of that one passed as 
+    * argument.
+    */
+   inline Tuple(Tuple<T1, T...>&& t) : 
+      Tuple<T...>(std::move(t)), 
+      _elem(std::move(t._elem)) 
+   {}
+
+   inline Tuple& operator = (const Tuple<T1, T...>& t) = default;
+
+   inline Tuple& operator = (Tuple<T1, T...>&& t) = default;
+
 private:
       
-   template <int id, class ... _T>
-   friend class Tuple<_T...>::_ElementAccessor;
+   template <class ... _T>
+   friend class Tuple;
 
    T1 _elem;
 
@@ -274,6 +301,10 @@ public:
    
    inline Tuple(const T1& t1, const T2& t2) : _t1(t1), _t2(t2) {}
 
+   template <class U1, class U2>
+   inline Tuple(U1&& t1, U2&& t2) : 
+      _t1(std::forward<U1>(t1)), _t2(std::forward<U2>(t2)) {}
+
    /**
     * Obtain the n-th element of the tuple detemined by template parameter
     * id. 
@@ -0,0 +1,83 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include "KarenCore/allocator.h"
+
+namespace karen {
+
+Arena::Arena(unsigned long chunkSize)
+ : _chunks(NULL), _cursor(NULL), _limit(NULL), 
+   _chunkSize(chunkSize), _allocatedBytes(0)
+{
+}
+
+Arena::~Arena()
+{ release(); }
+
+void
+Arena::release()
+{
+   while (_chunks)
+   {
+      Chunk* next = _chunks->next;
+      ::operator delete(_chunks);
+      _chunks = next;
+   }
+   _cursor = _limit = NULL;
+   _allocatedBytes = 0;
+}
+
+void*
+Arena::allocateFromNewChunk(unsigned long size, unsigned long alignment)
+{
+   unsigned long header = sizeof(Chunk) + alignment - 1;
+   if (size + header > _chunkSize / 4)
+   {
+      // Large blocks take a chunk of their own, keeping the current one
+      Chunk* chunk = static_cast<Chunk*>(::operator new(size + header));
+      if (_chunks)
+      {
+         chunk->next = _chunks->next;
+         _chunks->next = chunk;
+      }
+      else
+      {
+         chunk->next = NULL;
+         _chunks = chunk;
+      }
+      std::uintptr_t data = reinterpret_cast<std::uintptr_t>(chunk + 1);
+      _allocatedBytes += size;
+      return reinterpret_cast<void*>(
+            (data + alignment - 1) & ~(std::uintptr_t) (alignment - 1));
+   }
+
+   Chunk* chunk = static_cast<Chunk*>(::operator new(_chunkSize));
+   chunk->next = _chunks;
+   _chunks = chunk;
+   _cursor = reinterpret_cast<char*>(chunk + 1);
+   _limit = reinterpret_cast<char*>(chunk) + _chunkSize;
+   return allocate(size, alignment);
+}
+
+}; // namespace karen
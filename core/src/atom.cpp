@@ -0,0 +1,116 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ---------------------------------------------------------------------
+ */
+
+#include "KarenCore/atom.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace karen {
+
+namespace {
+
+/*
+ * The table is split in shards chosen by the string hash, each with its
+ * own lock, so threads interning different strings rarely contend.
+ */
+const unsigned SHARD_BITS = 4;
+const unsigned SHARD_COUNT = 1 << SHARD_BITS;
+
+struct Shard
+{
+   std::mutex                          lock;
+   HashMap<StringView, const void*>    entries;
+};
+
+struct AtomTable
+{
+   Shard                               shards[SHARD_COUNT];
+   std::atomic<unsigned long>          size;
+   std::atomic<unsigned long long>     lookups;
+   std::atomic<unsigned long long>     hits;
+
+   inline AtomTable() : size(0), lookups(0), hits(0) {}
+};
+
+AtomTable&
+atomTable()
+{
+   // Never destroyed, since atoms may be used by static objects
+   static AtomTable* table = new AtomTable();
+   return *table;
+}
+
+}; // anonymous namespace
+
+Atom::Atom(const StringView& str) : _entry(intern(str)) {}
+
+Atom::Atom(const char* str) : _entry(intern(str)) {}
+
+Atom::Atom(const String& str) : _entry(intern(str.view())) {}
+
+AtomStats
+Atom::stats()
+{
+   AtomTable& table = atomTable();
+   AtomStats stats;
+   stats.size = table.size.load(std::memory_order_relaxed);
+   stats.lookups = table.lookups.load(std::memory_order_relaxed);
+   stats.hits = table.hits.load(std::memory_order_relaxed);
+   return stats;
+}
+
+const Atom::Entry*
+Atom::emptyEntry()
+{
+   static const Entry* entry = intern(StringView("", 0));
+   return entry;
+}
+
+const Atom::Entry*
+Atom::intern(const StringView& str)
+{
+   AtomTable& table = atomTable();
+   unsigned long long hash = DefaultHash<StringView>()(str);
+   Shard& shard = table.shards[hash >> (64 - SHARD_BITS)];
+   table.lookups.fetch_add(1, std::memory_order_relaxed);
+
+   std::lock_guard<std::mutex> guard(shard.lock);
+   const void* const* found = shard.entries.tryGet(str);
+   if (found)
+   {
+      table.hits.fetch_add(1, std::memory_order_relaxed);
+      return static_cast<const Entry*>(*found);
+   }
+
+   // The key views the string of the entry, which is never released
+   Entry* entry = new Entry();
+   entry->str = String(str);
+   entry->hash = hash;
+   shard.entries.put(entry->str.view(), entry);
+   table.size.fetch_add(1, std::memory_order_relaxed);
+   return entry;
+}
+
+}; // namespace karen
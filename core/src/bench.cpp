@@ -0,0 +1,244 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include "KarenCore/bench.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace karen {
+
+std::atomic<unsigned long> Benchmark::_allocationCount(0);
+std::atomic<unsigned long> Benchmark::_eventCount(0);
+const void* volatile Benchmark::_sink = NULL;
+
+BenchmarkSuite* BenchmarkSuite::_suites[KAREN_MAX_BENCHMARK_SUITES];
+unsigned int BenchmarkSuite::_nextSuite = 0;
+
+double
+Benchmark::measure(
+      unsigned long iterations, 
+      unsigned long& allocs,
+      unsigned long& events)
+{
+   _allocsAtStart = _allocationCount.load(std::memory_order_relaxed);
+   _eventsAtStart = _eventCount.load(std::memory_order_relaxed);
+   _counter.start();
+   run(iterations);
+   double elapsed = _counter.stop();
+   allocs = 
+         _allocationCount.load(std::memory_order_relaxed) - _allocsAtStart;
+   events = _eventCount.load(std::memory_order_relaxed) - _eventsAtStart;
+   return elapsed;
+}
+
+void
+Benchmark::resetMeasurement()
+{
+   if (_counter.isRunning())
+      _counter.stop();
+   _allocsAtStart = _allocationCount.load(std::memory_order_relaxed);
+   _eventsAtStart = _eventCount.load(std::memory_order_relaxed);
+   _counter.start();
+}
+
+BenchmarkSuite::BenchmarkSuite(const String& name)
+ : _name(name), _nextBenchmark(0)
+{
+   if (_nextSuite < KAREN_MAX_BENCHMARK_SUITES)
+      _suites[_nextSuite++] = this;
+}
+
+BenchmarkSuite::~BenchmarkSuite()
+{
+   for (unsigned int i = 0; i < _nextBenchmark; i++)
+      delete _benchmarks[i];
+}
+
+static double
+percentile(const std::vector<double>& sorted, double pct)
+{
+   unsigned long rank = (unsigned long) (pct / 100.0 * sorted.size());
+   return sorted[std::min(rank, (unsigned long) sorted.size() - 1)];
+}
+
+unsigned int
+BenchmarkSuite::run(
+      BenchmarkReporter& reporter,
+      const BenchmarkOptions& options)
+{
+   bool begun = false;
+   unsigned int count = 0;
+   for (unsigned int i = 0; i < _nextBenchmark; i++)
+   {
+      Benchmark* bench = _benchmarks[i];
+      String fullName = _name + "." + bench->name;
+      if (!options.filter.isEmpty() && 
+          ((const std::string&) fullName).find(
+               (const std::string&) options.filter) == std::string::npos)
+         continue;
+      if (!begun)
+      {
+         reporter.beginBenchmarkSuite(_name);
+         begun = true;
+      }
+
+      // Calibrate the number of iterations of each sample.
+      unsigned long iterations = 1, allocs, events;
+      double elapsed = bench->measure(iterations, allocs, events);
+      while (elapsed < options.minSampleTime && iterations < 1000000000ul)
+      {
+         unsigned long factor = (elapsed > 0.0) ?
+            (unsigned long) (options.minSampleTime / elapsed * 1.2) + 1 : 10;
+         iterations *= std::min(std::max(factor, 2ul), 10ul);
+         elapsed = bench->measure(iterations, allocs, events);
+      }
+
+      std::vector<double> nsPerOp;
+      double total = 0.0;
+      unsigned long totalAllocs = 0, totalEvents = 0;
+      for (unsigned int s = 0; s < options.samples; s++)
+      {
+         elapsed = bench->measure(iterations, allocs, events);
+         nsPerOp.push_back(elapsed * 1000000.0 / iterations);
+         total += elapsed;
+         totalAllocs += allocs;
+         totalEvents += events;
+      }
+      std::sort(nsPerOp.begin(), nsPerOp.end());
+
+      BenchmarkResult result;
+      result.benchmark = bench;
+      result.iterations = iterations;
+      result.samples = options.samples;
+      result.nsPerOp = total * 1000000.0 / (iterations * options.samples);
+      result.p50 = percentile(nsPerOp, 50.0);
+      result.p90 = percentile(nsPerOp, 90.0);
+      result.p99 = percentile(nsPerOp, 99.0);
+      result.allocsPerOp = 
+            (double) totalAllocs / (iterations * options.samples);
+      result.eventsPerOp = 
+            (double) totalEvents / (iterations * options.samples);
+      reporter.reportResult(result);
+      count++;
+   }
+   if (begun)
+      reporter.endBenchmarkSuite();
+   return count;
+}
+
+unsigned int
+BenchmarkSuite::runAll(
+      BenchmarkReporter& reporter,
+      const BenchmarkOptions& options)
+{
+   unsigned int count = 0;
+   reporter.beginReport();
+   for (unsigned int i = 0; i < _nextSuite; i++)
+      count += _suites[i]->run(reporter, options);
+   reporter.endReport();
+   return count;
+}
+
+void
+BenchmarkSuite::addBenchmark(Benchmark* benchmark)
+{
+   if (_nextBenchmark < KAREN_MAX_BENCHMARKS_PER_SUITE)
+      _benchmarks[_nextBenchmark++] = benchmark;
+   else
+      delete benchmark;
+}
+
+void
+CsvBenchmarkReporter::beginReport()
+{
+   std::cout << 
+      "suite,benchmark,iterations,samples,ns_per_op,p50,p90,p99,"
+      "allocs_per_op,events_per_op" << std::endl;
+}
+
+void
+CsvBenchmarkReporter::endReport()
+{}
+
+void
+CsvBenchmarkReporter::beginBenchmarkSuite(const String& suiteName)
+{ _suiteName = suiteName; }
+
+void
+CsvBenchmarkReporter::endBenchmarkSuite()
+{}
+
+void
+CsvBenchmarkReporter::reportResult(const BenchmarkResult& result)
+{
+   std::cout << String::format("%s,%s,%lu,%u,%.3f,%.3f,%.3f,%.3f,%.4f,%.4f",
+         (const char*) _suiteName,
+         (const char*) result.benchmark->name,
+         result.iterations, result.samples, result.nsPerOp,
+         result.p50, result.p90, result.p99, result.allocsPerOp,
+         result.eventsPerOp) << std::endl;
+}
+
+void
+JsonBenchmarkReporter::beginReport()
+{ std::cout << "{\"suites\":["; }
+
+void
+JsonBenchmarkReporter::endReport()
+{ std::cout << "]}" << std::endl; }
+
+void
+JsonBenchmarkReporter::beginBenchmarkSuite(const String& suiteName)
+{
+   if (!_firstSuite)
+      std::cout << ",";
+   std::cout << String::format("\n{\"name\":\"%s\",\"benchmarks\":[", 
+         (const char*) suiteName);
+   _firstSuite = false;
+   _firstResult = true;
+}
+
+void
+JsonBenchmarkReporter::endBenchmarkSuite()
+{ std::cout << "]}"; }
+
+void
+JsonBenchmarkReporter::reportResult(const BenchmarkResult& result)
+{
+   if (!_firstResult)
+      std::cout << ",";
+   std::cout << String::format(
+         "\n {\"name\":\"%s\",\"iterations\":%lu,\"samples\":%u,"
+         "\"ns_per_op\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,"
+         "\"allocs_per_op\":%.4f,\"events_per_op\":%.4f}",
+         (const char*) result.benchmark->name,
+         result.iterations, result.samples, result.nsPerOp,
+         result.p50, result.p90, result.p99, result.allocsPerOp,
+         result.eventsPerOp);
+   _firstResult = false;
+}
+
+}; // namespace karen
@@ -0,0 +1,484 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "KarenCore/buffer-pool.h"
+
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+#include <sys/mman.h>
+#endif
+#if defined(KAREN_PLATFORM_IS_WIN32)
+#include <malloc.h>
+#endif
+
+namespace karen {
+
+namespace {
+
+/*
+ * Serializes the thread caches flushed at thread exit against the pools
+ * being destroyed. Never destroyed, since threads may exit after statics 
+ * are destroyed.
+ */
+std::mutex&
+registryMutex()
+{
+   static std::mutex* mutex = new std::mutex();
+   return *mutex;
+}
+
+std::atomic<unsigned long> nextPoolId(1);
+
+inline bool
+isPowerOfTwo(unsigned long n)
+{ return n && !(n & (n - 1)); }
+
+void*
+alignedAllocate(unsigned long length, unsigned long alignment)
+{
+   void* block = NULL;
+#if defined(KAREN_PLATFORM_IS_WIN32)
+   block = ::_aligned_malloc(length, alignment);
+#else
+   if (alignment < sizeof(void*))
+      alignment = sizeof(void*);
+   if (::posix_memalign(&block, alignment, length))
+      block = NULL;
+#endif
+   if (!block)
+      throw std::bad_alloc();
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX && defined(MADV_HUGEPAGE)
+   if (alignment >= BufferPool::HUGE_PAGE_ALIGNMENT && 
+       length >= BufferPool::HUGE_PAGE_ALIGNMENT)
+      ::madvise(block, length, MADV_HUGEPAGE);
+#endif
+   return block;
+}
+
+void
+alignedFree(void* block)
+{
+#if defined(KAREN_PLATFORM_IS_WIN32)
+   ::_aligned_free(block);
+#else
+   ::free(block);
+#endif
+}
+
+}; // anonymous namespace
+
+const unsigned long BufferPool::CACHE_LINE_ALIGNMENT;
+const unsigned long BufferPool::PAGE_ALIGNMENT;
+const unsigned long BufferPool::HUGE_PAGE_ALIGNMENT;
+const unsigned long BufferPool::MIN_CLASS_LENGTH;
+const unsigned long BufferPool::DEFAULT_MAX_CLASS_LENGTH;
+
+/*
+ * Thread cache of free blocks for a pool. Its counters are only written by
+ * the owner thread, but they are read by any thread obtaining statistics.
+ */
+struct BufferPool::ThreadCache
+{
+   BufferPool*                pool; // NULL once the pool is destroyed
+   FreeList                   lists[MAX_CLASSES];
+   std::atomic<unsigned long> hits;
+   std::atomic<unsigned long> misses;
+
+   inline ThreadCache(BufferPool* p) : pool(p), hits(0), misses(0)
+   {
+      for (unsigned int i = 0; i < MAX_CLASSES; i++)
+      {
+         lists[i].head = NULL;
+         lists[i].count = 0;
+      }
+   }
+};
+
+/*
+ * Caches of the pools used by a thread. It is trivially destructible, so 
+ * pools may be used by static objects destroyed after thread exit. The
+ * table is closed once it is flushed at thread exit, and from then on the
+ * thread uses the shared lists.
+ */
+struct BufferPool::ThreadCacheTable
+{
+   enum { CAPACITY = 8 };
+
+   struct Entry
+   {
+      unsigned long  poolId;
+      ThreadCache*   cache;
+   };
+
+   Entry          entries[CAPACITY];
+   unsigned int   count;
+   bool           closed;
+   bool           flusherRegistered;
+};
+
+struct BufferPool::ThreadCacheFlusher
+{
+   ~ThreadCacheFlusher();
+};
+
+BufferPool::ThreadCacheFlusher::~ThreadCacheFlusher()
+{
+   ThreadCacheTable& table = threadCacheTable();
+   std::lock_guard<std::mutex> registry(registryMutex());
+   for (unsigned int i = 0; i < table.count; i++)
+   {
+      ThreadCache* cache = table.entries[i].cache;
+      if (cache->pool)
+         cache->pool->retire(*cache);
+      delete cache;
+   }
+   table.count = 0;
+   table.closed = true;
+}
+
+BufferPool&
+BufferPool::defaultPool()
+{
+   static BufferPool* pool = new BufferPool();
+   return *pool;
+}
+
+unsigned long
+BufferPool::classLength(unsigned long length)
+{
+   unsigned int index = classIndex(length);
+   return (index < MAX_CLASSES) ? (MIN_CLASS_LENGTH << index) : length;
+}
+
+BufferPool::BufferPool(unsigned long alignment, unsigned long maxClassLength)
+throw (InvalidInputException)
+ : _id(nextPoolId++), _alignment(alignment), 
+   _maxClassLength(maxClassLength), _nclasses(0), 
+   _hits(0), _misses(0), _systemBytes(0)
+{
+   if (!isPowerOfTwo(alignment))
+      KAREN_THROW(InvalidInputException,
+         "cannot create buffer pool: alignment %d is not a power of two",
+         alignment);
+   unsigned int maxIndex = classIndex(maxClassLength);
+   if (!isPowerOfTwo(maxClassLength) || maxClassLength < MIN_CLASS_LENGTH || 
+       maxIndex >= MAX_CLASSES)
+      KAREN_THROW(InvalidInputException,
+         "cannot create buffer pool: invalid max class length %d",
+         maxClassLength);
+   _nclasses = maxIndex + 1;
+   for (unsigned int i = 0; i < MAX_CLASSES; i++)
+   {
+      _shared[i].head = NULL;
+      _shared[i].count = 0;
+   }
+}
+
+BufferPool::~BufferPool()
+{
+   std::lock_guard<std::mutex> registry(registryMutex());
+   std::lock_guard<std::mutex> lock(_mutex);
+   for (unsigned int c = 0; c < _caches.size(); c++)
+   {
+      ThreadCache* cache = _caches[c];
+      for (unsigned int i = 0; i < _nclasses; i++)
+         while (cache->lists[i].head)
+         {
+            Block* block = cache->lists[i].head;
+            cache->lists[i].head = block->next;
+            freeBlock(block, MIN_CLASS_LENGTH << i);
+         }
+      // The owner thread deletes the cache once it finds it orphaned
+      cache->pool = NULL;
+   }
+   for (unsigned int i = 0; i < _nclasses; i++)
+      while (_shared[i].head)
+      {
+         Block* block = _shared[i].head;
+         _shared[i].head = block->next;
+         freeBlock(block, MIN_CLASS_LENGTH << i);
+      }
+}
+
+void*
+BufferPool::acquire(unsigned long length)
+{
+   unsigned int index = classIndex(length);
+   if (index >= _nclasses)
+   {
+      _misses++;
+      return allocateBlock(length);
+   }
+
+   ThreadCache* cache = threadCache();
+   if (cache)
+   {
+      FreeList& list = cache->lists[index];
+      if (!list.head)
+         refill(*cache, index);
+      if (list.head)
+      {
+         Block* block = list.head;
+         list.head = block->next;
+         list.count--;
+         cache->hits.store(
+               cache->hits.load(std::memory_order_relaxed) + 1, 
+               std::memory_order_relaxed);
+         return block;
+      }
+      cache->misses.store(
+            cache->misses.load(std::memory_order_relaxed) + 1, 
+            std::memory_order_relaxed);
+   }
+   else
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         FreeList& list = _shared[index];
+         if (list.head)
+         {
+            Block* block = list.head;
+            list.head = block->next;
+            list.count--;
+            _hits++;
+            return block;
+         }
+      }
+      _misses++;
+   }
+   return allocateBlock(MIN_CLASS_LENGTH << index);
+}
+
+void
+BufferPool::release(void* data, unsigned long length)
+{
+   if (!data)
+      return;
+   unsigned int index = classIndex(length);
+   if (index >= _nclasses)
+   {
+      freeBlock(data, length);
+      return;
+   }
+
+   Block* block = static_cast<Block*>(data);
+   ThreadCache* cache = threadCache();
+   if (cache)
+   {
+      FreeList& list = cache->lists[index];
+      block->next = list.head;
+      list.head = block;
+      unsigned long capacity = cacheCapacity(index);
+      if (++list.count > capacity)
+         drain(*cache, index, list.count - capacity / 2);
+      return;
+   }
+   std::lock_guard<std::mutex> lock(_mutex);
+   block->next = _shared[index].head;
+   _shared[index].head = block;
+   _shared[index].count++;
+}
+
+void
+BufferPool::trim()
+{
+   ThreadCache* cache = threadCache();
+   if (cache)
+      for (unsigned int i = 0; i < _nclasses; i++)
+         drain(*cache, i, cache->lists[i].count);
+
+   std::lock_guard<std::mutex> lock(_mutex);
+   for (unsigned int i = 0; i < _nclasses; i++)
+   {
+      while (_shared[i].head)
+      {
+         Block* block = _shared[i].head;
+         _shared[i].head = block->next;
+         freeBlock(block, MIN_CLASS_LENGTH << i);
+      }
+      _shared[i].count = 0;
+   }
+}
+
+BufferPoolStatistics
+BufferPool::statistics() const
+{
+   BufferPoolStatistics stats;
+   std::lock_guard<std::mutex> lock(_mutex);
+   stats.hits = _hits;
+   stats.misses = _misses;
+   for (unsigned int c = 0; c < _caches.size(); c++)
+   {
+      stats.hits += _caches[c]->hits.load(std::memory_order_relaxed);
+      stats.misses += _caches[c]->misses.load(std::memory_order_relaxed);
+   }
+   stats.systemBytes = _systemBytes;
+   return stats;
+}
+
+unsigned int
+BufferPool::classIndex(unsigned long length)
+{
+   unsigned int index = 0;
+   unsigned long n = MIN_CLASS_LENGTH;
+   while (n < length && index < MAX_CLASSES)
+   {
+      n <<= 1;
+      index++;
+   }
+   return index;
+}
+
+BufferPool::ThreadCacheTable&
+BufferPool::threadCacheTable()
+{
+   static thread_local ThreadCacheTable table;
+   return table;
+}
+
+BufferPool::ThreadCache*
+BufferPool::threadCache()
+{
+   ThreadCacheTable& table = threadCacheTable();
+   for (unsigned int i = 0; i < table.count; i++)
+      if (table.entries[i].poolId == _id)
+         return table.entries[i].cache;
+   if (table.closed)
+      return NULL;
+   if (!table.flusherRegistered)
+   {
+      // Flush the caches to their pools when this thread exits
+      static thread_local ThreadCacheFlusher flusher;
+      (void) flusher;
+      table.flusherRegistered = true;
+   }
+
+   std::lock_guard<std::mutex> registry(registryMutex());
+   // Make room by dropping the caches of destroyed pools
+   unsigned int count = 0;
+   for (unsigned int i = 0; i < table.count; i++)
+   {
+      if (table.entries[i].cache->pool)
+         table.entries[count++] = table.entries[i];
+      else
+         delete table.entries[i].cache;
+   }
+   table.count = count;
+   if (count == ThreadCacheTable::CAPACITY)
+      return NULL;
+
+   ThreadCache* cache = new ThreadCache(this);
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _caches.push_back(cache);
+   }
+   table.entries[count].poolId = _id;
+   table.entries[count].cache = cache;
+   table.count++;
+   return cache;
+}
+
+unsigned long
+BufferPool::cacheCapacity(unsigned int index) const
+{
+   unsigned long nblocks = CACHE_CLASS_BYTES / (MIN_CLASS_LENGTH << index);
+   if (nblocks > CACHE_CLASS_BLOCKS)
+      return CACHE_CLASS_BLOCKS;
+   return nblocks ? nblocks : 1;
+}
+
+void*
+BufferPool::allocateBlock(unsigned long length)
+{
+   void* block = alignedAllocate(length, _alignment);
+   _systemBytes += length;
+   return block;
+}
+
+void
+BufferPool::freeBlock(void* block, unsigned long length)
+{
+   alignedFree(block);
+   _systemBytes -= length;
+}
+
+void
+BufferPool::refill(ThreadCache& cache, unsigned int index)
+{
+   unsigned long nblocks = cacheCapacity(index) / 2;
+   if (!nblocks)
+      nblocks = 1;
+   FreeList& list = cache.lists[index];
+   FreeList& shared = _shared[index];
+   std::lock_guard<std::mutex> lock(_mutex);
+   while (shared.head && nblocks--)
+   {
+      Block* block = shared.head;
+      shared.head = block->next;
+      shared.count--;
+      block->next = list.head;
+      list.head = block;
+      list.count++;
+   }
+}
+
+void
+BufferPool::drain(ThreadCache& cache, unsigned int index, unsigned long nblocks)
+{
+   if (!nblocks)
+      return;
+   FreeList& list = cache.lists[index];
+   Block* first = list.head;
+   Block* last = first;
+   for (unsigned long i = 1; i < nblocks; i++)
+      last = last->next;
+   list.head = last->next;
+   list.count -= nblocks;
+
+   std::lock_guard<std::mutex> lock(_mutex);
+   last->next = _shared[index].head;
+   _shared[index].head = first;
+   _shared[index].count += nblocks;
+}
+
+void
+BufferPool::retire(ThreadCache& cache)
+{
+   for (unsigned int i = 0; i < _nclasses; i++)
+      drain(cache, i, cache.lists[i].count);
+
+   std::lock_guard<std::mutex> lock(_mutex);
+   _hits += cache.hits.load(std::memory_order_relaxed);
+   _misses += cache.misses.load(std::memory_order_relaxed);
+   for (unsigned int c = 0; c < _caches.size(); c++)
+      if (_caches[c] == &cache)
+      {
+         _caches.erase(_caches.begin() + c);
+         break;
+      }
+}
+
+}; // namespace karen
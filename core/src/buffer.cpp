@@ -25,42 +25,64 @@
 #include <cstring>
 
 #include "KarenCore/buffer.h"
+#include "KarenCore/buffer-pool.h"
 
 namespace karen {
 
 Buffer::Buffer(unsigned long length)
- : _length(length), _data(new UInt8[length]), _dirty(false)
+ : _length(length), _data(new UInt8[length]), _dirty(false), 
+   _owned(true), _releaser(NULL)
 {
 }
 
 Buffer::Buffer(void* data, unsigned long length)
- : _length(length), _data((UInt8*) data), _dirty(false)
+ : _length(length), _data((UInt8*) data), _dirty(false), 
+   _owned(true), _releaser(NULL)
+{
+}
+
+Buffer::Buffer(void* data, unsigned long length, BufferReleaser* releaser)
+ : _length(length), _data((UInt8*) data), _dirty(false), 
+   _owned(false), _releaser(releaser)
+{
+}
+
+Buffer::Buffer(BufferPool& pool, unsigned long length)
+ : _length(length), _data((UInt8*) pool.acquire(length)), _dirty(false), 
+   _owned(false), _releaser(&pool)
 {
 }
 
 Buffer::Buffer(const Buffer& buf)
- : _length(buf._length), _data(new UInt8[buf._length]), _dirty(false)
+ : _length(buf._length), _data(new UInt8[buf._length]), _dirty(false),
+   _owned(true), _releaser(NULL)
 {
    memcpy(_data, buf._data, _length);
 }
 
 Buffer::Buffer(Buffer&& buf)
- : _length(buf._length), _dirty(false), _data(buf._data)
+ : _length(buf._length), _data(buf._data), _dirty(false), 
+   _owned(buf._owned), _releaser(buf._releaser)
 {
    buf._data = NULL;
 }
 
 Buffer::~Buffer()
-{ if (_data) delete _data; }
+{ release(); }
 
 Buffer&
 Buffer::operator = (const Buffer& buf)
 {
-   if (_data) delete _data;
+   if (this == &buf)
+      return *this;
+   release();
    
    _length  = buf._length;
-   _data    = buf._data;
+   _data    = new UInt8[buf._length];
    _dirty   = false;
+   _owned   = true;
+   _releaser = NULL;
+   memcpy(_data, buf._data, _length);
    
    return *this;
 }
@@ -68,11 +90,15 @@ Buffer::operator = (const Buffer& buf)
 Buffer&
 Buffer::operator = (Buffer&& buf)
 {
-   if (_data) delete _data;
+   if (this == &buf)
+      return *this;
+   release();
    
    _length  = buf._length;
    _data    = buf._data;
    _dirty   = false;
+   _owned   = buf._owned;
+   _releaser = buf._releaser;
    
    buf._data = NULL;
    
@@ -120,6 +146,18 @@ throw (OutOfBoundsException)
    _dirty = true;
 }
 
+void
+Buffer::release()
+{
+   if (!_data)
+      return;
+   if (_owned)
+      delete [] _data;
+   else if (_releaser)
+      _releaser->releaseBuffer(_data, _length);
+   _data = NULL;
+}
+
 unsigned long
 BufferInputStream::readBytes(void* data, unsigned long len)
 throw (IOException)
@@ -132,6 +170,17 @@ throw (IOException)
    return len;
 }
 
+unsigned long
+BufferInputStream::skip(unsigned long len)
+throw (IOException)
+{
+   unsigned long left = bytesLeftToRead();
+   if (left < len)
+      len = left;
+   _index += len;
+   return len;
+}
+
 unsigned long
 BufferOutputStream::writeBytes(const void* data, unsigned long len)
 throw (IOException)
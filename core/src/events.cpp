@@ -34,11 +34,8 @@ LocalEventChannel::~LocalEventChannel()
 void
 LocalEventChannel::sendEvent(const Event& ev)
 {
-   for (auto it = _eventSubscribers.begin(),
-        end = _eventSubscribers.end(); it != end; it++)
-   {
-      (*it)->invoke(ev);
-   }
+   for (auto& subscriber : _eventSubscribers.fast())
+      subscriber->invoke(ev);
 }
 
 }
@@ -22,16 +22,56 @@
  * ---------------------------------------------------------------------
  */
 
+#include <cstring>
+
 #include "KarenCore/exception.h"
 #include "KarenCore/string.h"
 
 namespace karen {
 
+String
+ExceptionCause::format() const
+{
+   if (!_format)
+      return String();
+
+   FormatArg args[MAX_ARGS];
+   for (unsigned int i = 0; i < _nargs; i++)
+   {
+      args[i] = _args[i];
+      if (args[i].kind == FormatArg::TEXT)
+         args[i].text.str = _text + _textOffsets[i];
+   }
+   StringBuilder out;
+   out.appendFormatArgs(_format, args, _nargs);
+   return out.toString();
+}
+
+void
+ExceptionCause::append(const FormatArg& arg)
+{
+   _args[_nargs] = arg;
+   if (arg.kind == FormatArg::TEXT)
+   {
+      unsigned long len = arg.text.len;
+      if (len > TEXT_CAPACITY - _textLength)
+         len = TEXT_CAPACITY - _textLength;
+      if (len)
+         memcpy(_text + _textLength, arg.text.str, len);
+      _textOffsets[_nargs] = _textLength;
+      _args[_nargs].text.str = nullptr;
+      _args[_nargs].text.len = len;
+      _textLength += len;
+   }
+   _nargs++;
+}
+
 Exception::Exception(
    const String& cause, 
    const String& sourceFile,
    long sourceLine,
    Exception* nestedException)
+ : _lazyCause(nullptr)
 {
    this->init(cause, sourceFile, sourceLine, nestedException);
 }
@@ -40,6 +80,7 @@ Exception::Exception(
    const String& cause,
    const String& sourceFile,
    long sourceLine) 
+ : _lazyCause(nullptr)
 {
    this->init(cause, sourceFile, sourceLine, nullptr);
 }
@@ -47,15 +88,60 @@ Exception::Exception(
 Exception::Exception(
    const String& cause,
    Exception* nestedException) 
+ : _lazyCause(nullptr)
 {
    this->init(cause, "unknown file", -1, nestedException);
 }
 
+Exception::Exception(
+   const ExceptionCause& cause,
+   const char* sourceFile,
+   long sourceLine,
+   Exception* nestedException)
+ : _lazyCause(cause),
+   _cause(nullptr),
+   _sourceFile(sourceFile),
+   _sourceFileCopy(nullptr),
+   _sourceLine(sourceLine),
+   _nestedException(nestedException)
+{
+   if (nestedException)
+      _cause = new String(
+            cause.format() + "\n" + nestedException->cause());
+}
+
+Exception::Exception(const Exception& e)
+ : std::exception(e), _lazyCause(e._lazyCause)
+{
+   copy(e);
+}
+
+Exception&
+Exception::operator = (const Exception& e)
+{
+   if (this != &e)
+   {
+      delete _cause;
+      delete _sourceFileCopy;
+      _lazyCause = e._lazyCause;
+      copy(e);
+   }
+   return *this;
+}
+
 Exception::~Exception()
 throw ()
 {
    delete _cause;
-   delete _sourceFile;
+   delete _sourceFileCopy;
+}
+
+const String&
+Exception::cause() const
+{
+   if (!_cause)
+      _cause = new String(_lazyCause.format());
+   return *_cause;
 }
 
 void Exception::init(const String &cause,
@@ -65,9 +151,22 @@ void Exception::init(const String &cause,
 {
    _cause = new String(
             nestedException ? cause + "\n" + nestedException->cause() : cause);
-   _sourceFile = new String(sourceFile);
+   _sourceFileCopy = new String(sourceFile);
+   _sourceFile = *_sourceFileCopy;
    _sourceLine = sourceLine;
    _nestedException = nestedException;
 }
 
+void
+Exception::copy(const Exception& e)
+{
+   _cause = e._cause ? new String(*e._cause) : nullptr;
+   _sourceFileCopy = 
+         e._sourceFileCopy ? new String(*e._sourceFileCopy) : nullptr;
+   _sourceFile = 
+         _sourceFileCopy ? (const char*) *_sourceFileCopy : e._sourceFile;
+   _sourceLine = e._sourceLine;
+   _nestedException = e._nestedException;
+}
+
 };
@@ -34,10 +34,203 @@
 #include <errno.h>
 #include <string.h>
 #include <dirent.h>
+#include <sys/mman.h>
 #include <sys/stat.h>    
+#include <sys/uio.h>
+
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+#include <sys/syscall.h>
+#endif
 
 namespace karen {
 
+namespace {
+
+const unsigned int IOVEC_BATCH = 64;
+
+typedef ssize_t (*VectoredTransfer)(int, const struct iovec*, int);
+
+/*
+ * Transfer the regions described by vecs through readv() or writev(), in
+ * batches of IOVEC_BATCH regions so any count fits in the system limit. It
+ * stops at the first batch transferred partially, and returns the number 
+ * of bytes transferred or -1 on error.
+ */
+ssize_t
+transferVectors(
+      int fd, 
+      const IoVec* vecs, 
+      unsigned int count, 
+      VectoredTransfer transfer)
+{
+   struct iovec iov[IOVEC_BATCH];
+   ssize_t total = 0;
+   while (count)
+   {
+      unsigned int n = (count < IOVEC_BATCH) ? count : IOVEC_BATCH;
+      size_t expected = 0;
+      for (unsigned int i = 0; i < n; i++)
+      {
+         iov[i].iov_base = vecs[i].data;
+         iov[i].iov_len = vecs[i].length;
+         expected += vecs[i].length;
+      }
+      ssize_t ntrans = transfer(fd, iov, n);
+      if (ntrans < 0)
+         return -1;
+      total += ntrans;
+      if ((size_t) ntrans < expected)
+         break;
+      vecs += n;
+      count -= n;
+   }
+   return total;
+}
+
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+
+/*
+ * Obtain the POSIX file behind given file, unwrapping it if it is a File. 
+ * It returns NULL if the file is not a POSIX file. 
+ */
+PosixFile*
+posixFile(AbstractFile& file)
+{
+   File* wrapper = dynamic_cast<File*>(&file);
+   if (wrapper)
+      return posixFile(wrapper->delegate());
+   return dynamic_cast<PosixFile*>(&file);
+}
+
+/* 
+ * The largest count the kernel transfers in a single call. 
+ */
+const unsigned long MAX_KERNEL_TRANSFER = 0x7ffff000;
+
+/*
+ * Whether given error reports that the kernel cannot transfer between the
+ * files with the failed call, so another method must be tried.
+ */
+bool
+isUnsupportedTransfer(int error)
+{
+   return error == ENOSYS || error == EXDEV || error == EINVAL || 
+          error == EOPNOTSUPP || error == EBADF;
+}
+
+/*
+ * Kernel-side transfer methods. Each one moves the bytes of the range from
+ * ndone on, adding the bytes moved to ndone. It returns true once the 
+ * range is complete or the end of the input is reached, and false if the
+ * kernel cannot carry on with the remaining bytes.
+ */
+bool
+copyFileRange(
+      int in, 
+      unsigned long inOffset, 
+      int out, 
+      unsigned long outOffset, 
+      unsigned long len, 
+      unsigned long& ndone) 
+throw (IOException)
+{
+#ifdef SYS_copy_file_range
+   while (ndone < len)
+   {
+      loff_t inOff = inOffset + ndone;
+      loff_t outOff = outOffset + ndone;
+      unsigned long left = len - ndone;
+      long n = ::syscall(SYS_copy_file_range, in, &inOff, out, &outOff, 
+            left < MAX_KERNEL_TRANSFER ? left : MAX_KERNEL_TRANSFER, 0);
+      if (n < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         if (isUnsupportedTransfer(errno))
+            return false;
+         KAREN_THROW(IOException, 
+            "cannot copy file range at offset %lu: %s", 
+            inOffset + ndone, strerror(errno));
+      }
+      if (!n)
+         break;
+      ndone += n;
+   }
+   return true;
+#else
+   return false;
+#endif
+}
+
+bool
+spliceFile(
+      int in, 
+      unsigned long inOffset, 
+      int out, 
+      unsigned long outOffset, 
+      unsigned long len, 
+      unsigned long& ndone) 
+throw (IOException)
+{
+   /* Both ends are addressed by offset, so no file position is touched. */
+   int pipefd[2];
+   if (::pipe2(pipefd, O_CLOEXEC) < 0)
+      return false;
+   bool complete = true;
+   int error = 0;
+   while (complete && !error && ndone < len)
+   {
+      loff_t inOff = inOffset + ndone;
+      unsigned long left = len - ndone;
+      ssize_t nin = ::splice(in, &inOff, pipefd[1], NULL, 
+            left < MAX_KERNEL_TRANSFER ? left : MAX_KERNEL_TRANSFER, 
+            SPLICE_F_MOVE);
+      if (nin < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         if (isUnsupportedTransfer(errno))
+            complete = false;
+         else
+            error = errno;
+         break;
+      }
+      if (!nin)
+         break;
+      while (nin > 0)
+      {
+         loff_t outOff = outOffset + ndone;
+         ssize_t nout = ::splice(pipefd[0], NULL, out, &outOff, nin, 
+               SPLICE_F_MOVE);
+         if (nout < 0 && errno == EINTR)
+            continue;
+         if (nout <= 0)
+         {
+            /* Bytes left in the pipe are dropped with it; the remaining
+               range is resumed from ndone by the caller. */
+            if (nout < 0 && !isUnsupportedTransfer(errno))
+               error = errno;
+            else
+               complete = false;
+            break;
+         }
+         ndone += nout;
+         nin -= nout;
+      }
+   }
+   ::close(pipefd[0]);
+   ::close(pipefd[1]);
+   if (error)
+      KAREN_THROW(IOException, 
+         "cannot splice file at offset %lu: %s", 
+         inOffset + ndone, strerror(error));
+   return complete;
+}
+
+#endif
+
+}; // anonymous namespace
+
 PosixFile::PosixFile(const String& location, 
                      const FileOpenMode& mode) 
 throw (IOException)
@@ -90,6 +283,295 @@ throw (IOException)
       return (unsigned long) nwrite;
 }
 
+unsigned long
+PosixFile::readAt(void* dest, unsigned long nbytes, unsigned long offset) 
+throw (IOException)
+{
+   UInt8* ptr = (UInt8*) dest;
+   unsigned long left = nbytes;
+   while (left)
+   {
+      ssize_t nread = ::pread(_fd, ptr, left, offset);
+      if (nread < 0)
+         KAREN_THROW(IOException, 
+            "cannot read bytes from file at offset %lu: %s", 
+            offset, strerror(errno));
+      if (!nread)
+         break;
+      ptr += nread;
+      left -= nread;
+      offset += nread;
+   }
+   return nbytes - left;
+}
+
+unsigned long
+PosixFile::writeAt(
+      const void* src, 
+      unsigned long nbytes, 
+      unsigned long offset) 
+throw (IOException)
+{
+   const UInt8* ptr = (const UInt8*) src;
+   unsigned long left = nbytes;
+   while (left)
+   {
+      ssize_t nwrite = ::pwrite(_fd, ptr, left, offset);
+      if (nwrite < 0)
+         KAREN_THROW(IOException, 
+            "cannot write to file at offset %lu: %s", 
+            offset, strerror(errno));
+      if (!nwrite)
+         break;
+      ptr += nwrite;
+      left -= nwrite;
+      offset += nwrite;
+   }
+   return nbytes - left;
+}
+
+unsigned long
+PosixFile::readv(const IoVec* vecs, unsigned int count) 
+throw (IOException)
+{
+   ssize_t nread = transferVectors(_fd, vecs, count, ::readv);
+   if (nread < 0)
+      KAREN_THROW(IOException, 
+         "cannot read bytes from file: %s", strerror(errno));
+   return (unsigned long) nread;
+}
+
+unsigned long
+PosixFile::writev(const IoVec* vecs, unsigned int count) 
+throw (IOException)
+{
+   ssize_t nwrite = transferVectors(_fd, vecs, count, ::writev);
+   if (nwrite < 0)
+      KAREN_THROW(IOException, "cannot write to file: %s", strerror(errno));
+   return (unsigned long) nwrite;
+}
+
+unsigned long
+PosixFile::size() const
+throw (IOException)
+{
+   struct stat st;
+   if (::fstat(_fd, &st) < 0)
+      KAREN_THROW(IOException, 
+         "cannot obtain size of file: %s", strerror(errno));
+   return (unsigned long) st.st_size;
+}
+
+unsigned long
+PosixFile::seek(long offset, SeekOrigin origin)
+throw (IOException)
+{
+   int whence = SEEK_SET;
+   switch (origin)
+   {
+      case SEEK_FROM_BEGIN:   whence = SEEK_SET; break;
+      case SEEK_FROM_CURRENT: whence = SEEK_CUR; break;
+      case SEEK_FROM_END:     whence = SEEK_END; break;
+   }
+   off_t pos = ::lseek(_fd, offset, whence);
+   if (pos < 0)
+      KAREN_THROW(IOException, 
+         "cannot seek file to offset %ld: %s", offset, strerror(errno));
+   return (unsigned long) pos;
+}
+
+unsigned long
+PosixFile::tell() const
+throw (IOException)
+{
+   off_t pos = ::lseek(_fd, 0, SEEK_CUR);
+   if (pos < 0)
+      KAREN_THROW(IOException, 
+         "cannot obtain file position: %s", strerror(errno));
+   return (unsigned long) pos;
+}
+
+void
+PosixFile::advise(
+      FileAccessAdvice advice, 
+      unsigned long offset,
+      unsigned long len)
+throw (IOException)
+{
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+   int flag = POSIX_FADV_NORMAL;
+   switch (advice)
+   {
+      case NORMAL_ACCESS:     flag = POSIX_FADV_NORMAL; break;
+      case SEQUENTIAL_ACCESS: flag = POSIX_FADV_SEQUENTIAL; break;
+      case RANDOM_ACCESS:     flag = POSIX_FADV_RANDOM; break;
+      case WILL_NEED_ACCESS:  flag = POSIX_FADV_WILLNEED; break;
+      case DONT_NEED_ACCESS:  flag = POSIX_FADV_DONTNEED; break;
+   }
+   int error = ::posix_fadvise(_fd, offset, len, flag);
+   if (error)
+      KAREN_THROW(IOException, 
+         "cannot advise file access: %s", strerror(error));
+#elif KAREN_PLATFORM == KAREN_PLATFORM_OSX
+   // OS X only supports read-ahead advices. 
+   if (advice != WILL_NEED_ACCESS)
+      return;
+   struct radvisory ra;
+   ra.ra_offset = offset;
+   ra.ra_count = len ? len : size() - offset;
+   if (::fcntl(_fd, F_RDADVISE, &ra) < 0)
+      KAREN_THROW(IOException, 
+         "cannot advise file access: %s", strerror(errno));
+#endif
+}
+
+PosixMappedFile::PosixMappedFile(const String& location, 
+                                 FileMappingMode mode) 
+throw (IOException)
+ : _fd(-1), _mode(mode), _view(NULL, 0, NULL)
+{
+   int flags = (mode == READ_WRITE_MAPPING) ? (O_RDWR | O_CREAT) : O_RDONLY;
+   _fd = ::open(location, flags, S_IRUSR | S_IWUSR);
+   if (_fd < 0)
+      KAREN_THROW(IOException, "cannot open file %s; %s",
+            (const char *) location, strerror(errno));
+
+   struct stat st;
+   try
+   {
+      if (::fstat(_fd, &st) < 0)
+         KAREN_THROW(IOException, "cannot obtain size of file %s; %s",
+               (const char *) location, strerror(errno));
+      map(st.st_size);
+   }
+   catch (IOException&)
+   {
+      ::close(_fd);
+      throw;
+   }
+}
+
+PosixMappedFile::~PosixMappedFile()
+{
+   unmap();
+   ::close(_fd);
+}
+
+void
+PosixMappedFile::advise(
+      FileAccessAdvice advice, 
+      unsigned long offset,
+      unsigned long len)
+throw (IOException)
+{
+   pageRange(offset, len);
+   if (!len)
+      return;
+   int flag = MADV_NORMAL;
+   switch (advice)
+   {
+      case NORMAL_ACCESS:     flag = MADV_NORMAL; break;
+      case SEQUENTIAL_ACCESS: flag = MADV_SEQUENTIAL; break;
+      case RANDOM_ACCESS:     flag = MADV_RANDOM; break;
+      case WILL_NEED_ACCESS:  flag = MADV_WILLNEED; break;
+      case DONT_NEED_ACCESS:  flag = MADV_DONTNEED; break;
+   }
+   if (::madvise((UInt8*) (void*) _view + offset, len, flag) < 0)
+      KAREN_THROW(IOException, "cannot advise mapped file access: %s", 
+            strerror(errno));
+}
+
+void
+PosixMappedFile::sync(
+      unsigned long offset, 
+      unsigned long len, 
+      bool wait)
+throw (IOException)
+{
+   if (_mode != READ_WRITE_MAPPING)
+      return;
+   pageRange(offset, len);
+   if (!len)
+      return;
+   if (::msync((UInt8*) (void*) _view + offset, len, 
+               wait ? MS_SYNC : MS_ASYNC) < 0)
+      KAREN_THROW(IOException, "cannot sync mapped file: %s", 
+            strerror(errno));
+}
+
+void
+PosixMappedFile::resize(unsigned long length)
+throw (IOException, InvalidStateException)
+{
+   if (_mode != READ_WRITE_MAPPING)
+      KAREN_THROW(InvalidStateException, 
+         "cannot resize mapped file: not mapped for reading and writing");
+   if (::ftruncate(_fd, length) < 0)
+      KAREN_THROW(IOException, "cannot resize mapped file: %s", 
+            strerror(errno));
+
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+   // Linux may grow the mapping in place, or move its pages otherwise.
+   if (_view.length() && length)
+   {
+      void* addr = ::mremap(_view, _view.length(), length, MREMAP_MAYMOVE);
+      if (addr == MAP_FAILED)
+      {
+         int error = errno;
+         unmap();
+         KAREN_THROW(IOException, "cannot remap file: %s", strerror(error));
+      }
+      _view = Buffer(addr, length, NULL);
+      return;
+   }
+#endif
+   unmap();
+   map(length);
+}
+
+void
+PosixMappedFile::map(unsigned long length)
+throw (IOException)
+{
+   void* addr = NULL;
+   if (length)
+   {
+      int prot = PROT_READ;
+      if (_mode != READ_ONLY_MAPPING)
+         prot |= PROT_WRITE;
+      int flags = (_mode == COPY_ON_WRITE_MAPPING) ? MAP_PRIVATE : MAP_SHARED;
+      addr = ::mmap(NULL, length, prot, flags, _fd, 0);
+      if (addr == MAP_FAILED)
+         KAREN_THROW(IOException, "cannot map file: %s", strerror(errno));
+   }
+   _view = Buffer(addr, length, NULL);
+}
+
+void
+PosixMappedFile::unmap()
+{
+   if (_view.length())
+      ::munmap(_view, _view.length());
+   _view = Buffer(NULL, 0, NULL);
+}
+
+void
+PosixMappedFile::pageRange(unsigned long& offset, unsigned long& len) const
+{
+   unsigned long length = _view.length();
+   if (offset > length)
+      offset = length;
+   if (!len || len > length - offset)
+      len = length - offset;
+   if (!len)
+      return;
+   // Page-align the range start as madvise() and msync() require.
+   unsigned long page = ::sysconf(_SC_PAGESIZE);
+   unsigned long start = offset & ~(page - 1);
+   len += offset - start;
+   offset = start;
+}
+
 Ptr<AbstractFile> 
 PosixFileFactory::createFile(
          const String& location, 
@@ -99,6 +581,41 @@ throw (IOException)
    return new PosixFile(location, mode);
 }
 
+Ptr<AbstractMappedFile> 
+PosixFileFactory::createMappedFile(
+         const String& location, 
+         FileMappingMode mode) 
+throw (IOException)
+{
+   return new PosixMappedFile(location, mode);
+}
+
+unsigned long
+PosixFileFactory::transfer(
+      AbstractFile& src, 
+      unsigned long srcOffset,
+      AbstractFile& dst, 
+      unsigned long dstOffset,
+      unsigned long len)
+throw (IOException)
+{
+   unsigned long ndone = 0;
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+   PosixFile* in = posixFile(src);
+   PosixFile* out = posixFile(dst);
+   if (in && out)
+   {
+      int infd = in->descriptor();
+      int outfd = out->descriptor();
+      if (copyFileRange(infd, srcOffset, outfd, dstOffset, len, ndone) ||
+          spliceFile(infd, srcOffset, outfd, dstOffset, len, ndone))
+         return ndone;
+   }
+#endif
+   return ndone + FileFactory::transfer(
+         src, srcOffset + ndone, dst, dstOffset + ndone, len - ndone);
+}
+
 }; // namespace karen
 
 #endif
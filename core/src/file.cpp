@@ -51,6 +51,85 @@ throw (IOException, InvalidStateException)
    _impl = factory->createFile(location, mode);
 }
 
+unsigned long
+File::copyFile(const String& from, const String& to)
+throw (IOException, InvalidStateException)
+{
+   File src(from, FileOpenMode::READ_ONLY_MODE);
+   File dst(to, FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+   return transfer(src, dst, 0, src.size());
+}
+
+unsigned long
+File::transfer(
+      AbstractFile& src, 
+      unsigned long srcOffset,
+      AbstractFile& dst, 
+      unsigned long dstOffset,
+      unsigned long len)
+throw (IOException, InvalidStateException)
+{
+   Ptr<FileFactory> factory = FileFactory::getActiveFileFactory();
+   if (factory.isNull())
+      KAREN_THROW(InvalidStateException, 
+         "cannot transfer file bytes: no active file factory");
+   return factory->transfer(src, srcOffset, dst, dstOffset, len);
+}
+
+MappedFile::MappedFile(const String& location, FileMappingMode mode)
+throw (IOException, InvalidStateException)
+ : _impl(NULL)
+{
+   Ptr<FileFactory> factory = FileFactory::getActiveFileFactory();
+   if (factory.isNull())
+      KAREN_THROW(InvalidStateException, 
+         "cannot instantiate MappedFile class: no active file factory");
+   _impl = factory->createMappedFile(location, mode);
+}
+
+const unsigned long FileFactory::TRANSFER_BLOCK_LENGTH;
+
+unsigned long
+FileFactory::transfer(
+      AbstractFile& src, 
+      unsigned long srcOffset,
+      AbstractFile& dst, 
+      unsigned long dstOffset,
+      unsigned long len)
+throw (IOException)
+{
+   if (!len)
+      return 0;
+   Buffer block(len < TRANSFER_BLOCK_LENGTH ? len : TRANSFER_BLOCK_LENGTH);
+   UInt8* data = (UInt8*) (void*) block;
+   unsigned long ndone = 0;
+   while (ndone < len)
+   {
+      unsigned long left = len - ndone;
+      unsigned long nread = src.readAt(
+            data, 
+            left < block.length() ? left : block.length(), 
+            srcOffset + ndone);
+      if (!nread)
+         break;
+      unsigned long nwritten = 0;
+      while (nwritten < nread)
+      {
+         unsigned long n = dst.writeAt(
+               data + nwritten, 
+               nread - nwritten, 
+               dstOffset + ndone + nwritten);
+         if (!n)
+            KAREN_THROW(IOException, 
+               "cannot transfer file bytes: no byte written at offset %lu", 
+               dstOffset + ndone + nwritten);
+         nwritten += n;
+      }
+      ndone += nread;
+   }
+   return ndone;
+}
+
 }; // namespace karen
 
 #if defined(KAREN_PLATFORM_IS_POSIX)
@@ -0,0 +1,399 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include "KarenCore/format.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include "KarenCore/numeric.h"
+#include "KarenCore/string.h"
+
+namespace karen {
+
+namespace {
+
+/*
+ * Conversion specification, as in %-08.3f.
+ */
+struct ConversionSpec
+{
+   bool     leftAlign;
+   bool     zeroPad;
+   bool     plusSign;
+   bool     spaceSign;
+   bool     alternate;
+   unsigned width;
+   int      precision;
+   char     conversion;
+};
+
+/*
+ * Parse the conversion specification after a percent sign. It returns the
+ * position past it, or a null pointer if the format ends before the
+ * conversion character. 
+ */
+const char*
+parseSpec(const char* p, ConversionSpec& spec)
+{
+   spec.leftAlign = spec.zeroPad = spec.plusSign = false;
+   spec.spaceSign = spec.alternate = false;
+   spec.width = 0;
+   spec.precision = -1;
+   for (;; p++)
+   {
+      if (*p == '-')
+         spec.leftAlign = true;
+      else if (*p == '0')
+         spec.zeroPad = true;
+      else if (*p == '+')
+         spec.plusSign = true;
+      else if (*p == ' ')
+         spec.spaceSign = true;
+      else if (*p == '#')
+         spec.alternate = true;
+      else
+         break;
+   }
+   for (; *p >= '0' && *p <= '9'; p++)
+      spec.width = spec.width < 1000 ? spec.width * 10 + (*p - '0') : 1000;
+   if (*p == '.')
+   {
+      spec.precision = 0;
+      for (p++; *p >= '0' && *p <= '9'; p++)
+         if (spec.precision < 1000)
+            spec.precision = spec.precision * 10 + (*p - '0');
+   }
+   while (*p && std::strchr("hlLqjzt", *p))
+      p++;
+   if (!*p)
+      return nullptr;
+   spec.conversion = *p;
+   return p + 1;
+}
+
+/*
+ * Append given body padded to the width of given spec. Zero padding, if
+ * allowed, goes after the given number of prefix characters, as the sign.
+ */
+void
+appendPadded(
+      StringBuilder& out, const ConversionSpec& spec, 
+      const char* body, unsigned long len, 
+      bool zeroPadding = false, unsigned long prefixLen = 0)
+{
+   unsigned long padding = spec.width > len ? spec.width - len : 0;
+   if (!padding)
+      out.append(body, len);
+   else if (spec.leftAlign)
+      out.append(body, len).append(' ', padding);
+   else if (zeroPadding && spec.zeroPad)
+      out.append(body, prefixLen).append('0', padding).append(
+            body + prefixLen, len - prefixLen);
+   else
+      out.append(' ', padding).append(body, len);
+}
+
+void
+appendInteger(
+      StringBuilder& out, const ConversionSpec& spec, 
+      unsigned long long magnitude, bool negative)
+{
+   unsigned base = 10;
+   const char* digits = "0123456789abcdef";
+   if (spec.conversion == 'x' || spec.conversion == 'p')
+      base = 16;
+   else if (spec.conversion == 'X')
+   {
+      base = 16;
+      digits = "0123456789ABCDEF";
+   }
+   else if (spec.conversion == 'o')
+      base = 8;
+
+   char buffer[96];
+   char* end = buffer + sizeof(buffer);
+   char* p = end;
+   bool zero = !magnitude;
+   // As printf does, a zero value with zero precision has no digits
+   if (!zero || spec.precision)
+      do
+      {
+         *--p = digits[magnitude % base];
+         magnitude /= base;
+      } while (magnitude);
+   for (int i = end - p; i < spec.precision && p > buffer + 3; i++)
+      *--p = '0';
+   if (spec.alternate && base == 8 && (p == end || *p != '0'))
+      *--p = '0';
+   unsigned long prefixLen = 0;
+   if (base == 16 && (spec.conversion == 'p' || (spec.alternate && !zero)))
+   {
+      *--p = spec.conversion == 'X' ? 'X' : 'x';
+      *--p = '0';
+      prefixLen = 2;
+   }
+   // As printf does, the sign flags only apply to signed conversions and
+   // pointers
+   bool signedConversion = spec.conversion == 'd' || 
+         spec.conversion == 'i' || spec.conversion == 'p';
+   if (negative || (signedConversion && (spec.plusSign || spec.spaceSign)))
+   {
+      *--p = negative ? '-' : spec.plusSign ? '+' : ' ';
+      prefixLen++;
+   }
+   appendPadded(out, spec, p, end - p, spec.precision < 0, prefixLen);
+}
+
+void
+appendFloating(StringBuilder& out, const ConversionSpec& spec, double d)
+{
+   char buffer[512];
+   unsigned long len;
+   if (spec.conversion == 's')
+      len = Float::format(d, buffer);
+   else
+   {
+      // The width is applied on the result, and the precision bounded to
+      // keep it in the buffer. Without precision the conversion's own
+      // default applies, which for %a is the exact representation
+      char format[16];
+      char* f = format;
+      *f++ = '%';
+      if (spec.plusSign)
+         *f++ = '+';
+      if (spec.spaceSign)
+         *f++ = ' ';
+      if (spec.alternate)
+         *f++ = '#';
+      if (spec.precision >= 0)
+      {
+         *f++ = '.';
+         *f++ = '*';
+      }
+      *f++ = spec.conversion;
+      *f = '\0';
+      int res = spec.precision < 0 ?
+            std::snprintf(buffer, sizeof(buffer), format, d) :
+            std::snprintf(buffer, sizeof(buffer), format, 
+                  spec.precision > 100 ? 100 : spec.precision, d);
+      len = res < 0 ? 0 : res;
+   }
+   unsigned long prefixLen = 
+         len && (*buffer == '-' || *buffer == '+' || *buffer == ' ');
+   // Zero padding of hexadecimal floats goes after the 0x prefix
+   if ((spec.conversion == 'a' || spec.conversion == 'A') && 
+       len >= prefixLen + 2 && buffer[prefixLen] == '0')
+      prefixLen += 2;
+   appendPadded(out, spec, buffer, len, std::isfinite(d), prefixLen);
+}
+
+void
+appendArg(StringBuilder& out, const ConversionSpec& spec, const FormatArg& arg)
+{
+   switch (spec.conversion)
+   {
+      case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+         if (arg.kind == FormatArg::SIGNED || arg.kind == FormatArg::CHARACTER)
+         {
+            if (spec.conversion == 'x' || spec.conversion == 'X' || 
+                spec.conversion == 'o')
+               appendInteger(out, spec, (unsigned long long) arg.s, false);
+            else
+               appendInteger(out, spec, arg.s < 0 ? 
+                     0ULL - (unsigned long long) arg.s : arg.s, arg.s < 0);
+            return;
+         }
+         if (arg.kind == FormatArg::UNSIGNED || arg.kind == FormatArg::BOOLEAN)
+         {
+            appendInteger(out, spec, arg.u, false);
+            return;
+         }
+         break;
+      case 'c':
+         if (arg.kind == FormatArg::SIGNED || arg.kind == FormatArg::CHARACTER || 
+             arg.kind == FormatArg::UNSIGNED)
+         {
+            char c = (char) arg.s;
+            appendPadded(out, spec, &c, 1);
+            return;
+         }
+         break;
+      case 'e': case 'E': case 'f': case 'F': 
+      case 'g': case 'G': case 'a': case 'A':
+         if (arg.kind == FormatArg::FLOATING)
+            appendFloating(out, spec, arg.d);
+         else if (arg.kind == FormatArg::SIGNED)
+            appendFloating(out, spec, (double) arg.s);
+         else if (arg.kind == FormatArg::UNSIGNED)
+            appendFloating(out, spec, (double) arg.u);
+         else
+            break;
+         return;
+      case 'p':
+         if (arg.kind == FormatArg::POINTER || arg.kind == FormatArg::TEXT)
+         {
+            appendInteger(out, spec, (unsigned long long) 
+                  (arg.kind == FormatArg::POINTER ? arg.p : arg.text.str), 
+                  false);
+            return;
+         }
+         break;
+   }
+
+   // Any other conversion prints the argument as %s does
+   ConversionSpec natural = spec;
+   natural.conversion = 's';
+   switch (arg.kind)
+   {
+      case FormatArg::NONE:
+         break;
+      case FormatArg::SIGNED:
+         natural.conversion = 'd';
+         natural.precision = -1;
+         appendInteger(out, natural, arg.s < 0 ? 
+               0ULL - (unsigned long long) arg.s : arg.s, arg.s < 0);
+         break;
+      case FormatArg::UNSIGNED:
+         natural.conversion = 'd';
+         natural.precision = -1;
+         appendInteger(out, natural, arg.u, false);
+         break;
+      case FormatArg::FLOATING:
+         appendFloating(out, natural, arg.d);
+         break;
+      case FormatArg::CHARACTER:
+      {
+         char c = (char) arg.s;
+         appendPadded(out, spec, &c, 1);
+         break;
+      }
+      case FormatArg::BOOLEAN:
+         appendPadded(out, spec, arg.u ? "true" : "false", arg.u ? 4 : 5);
+         break;
+      case FormatArg::TEXT:
+         appendPadded(out, spec, arg.text.str, 
+               spec.precision >= 0 && (unsigned long) spec.precision < 
+                  arg.text.len ? spec.precision : arg.text.len);
+         break;
+      case FormatArg::POINTER:
+         natural.conversion = 'p';
+         natural.precision = -1;
+         appendInteger(out, natural, (unsigned long long) arg.p, false);
+         break;
+   }
+}
+
+}; // anonymous namespace
+
+FormatArg::FormatArg(const String& str) : kind(TEXT)
+{ setText(str, str.length()); }
+
+FormatArg::FormatArg(const StringView& str) : kind(TEXT)
+{ setText(str.data(), str.length()); }
+
+StringBuilder::~StringBuilder()
+{
+   if (_data != _inline)
+      delete [] _data;
+}
+
+StringBuilder&
+StringBuilder::append(char c, unsigned long count)
+{
+   if (_length + count > _capacity)
+      grow(_length + count);
+   std::memset(_data + _length, c, count);
+   _length += count;
+   _data[_length] = '\0';
+   return *this;
+}
+
+StringBuilder&
+StringBuilder::append(const StringView& str)
+{ return append(str.data(), str.length()); }
+
+StringBuilder&
+StringBuilder::appendFormatArgs(
+      const char* format, const FormatArg* args, unsigned int nargs)
+{
+   unsigned int next = 0;
+   const char* p = format;
+   while (*p)
+   {
+      const char* percent = std::strchr(p, '%');
+      if (!percent)
+      {
+         append(p);
+         break;
+      }
+      append(p, percent - p);
+      if (percent[1] == '%')
+      {
+         append('%');
+         p = percent + 2;
+         continue;
+      }
+
+      ConversionSpec spec;
+      p = parseSpec(percent + 1, spec);
+      if (!p)
+      {
+         append(percent);
+         break;
+      }
+      if (next >= nargs || !std::strchr("diuxXocsfFeEgGaAp", spec.conversion))
+      {
+         // Conversions without argument are kept verbatim
+         append(percent, p - percent);
+         continue;
+      }
+      appendArg(*this, spec, args[next++]);
+   }
+   return *this;
+}
+
+StringView
+StringBuilder::view() const
+{ return StringView(_data, _length); }
+
+String
+StringBuilder::toString() const
+{ return String(_data, _length); }
+
+void
+StringBuilder::grow(unsigned long capacity)
+{
+   unsigned long newCapacity = _capacity * 2 + 1;
+   if (newCapacity < capacity)
+      newCapacity = capacity;
+   char* data = new char[newCapacity + 1];
+   std::memcpy(data, _data, _length + 1);
+   if (_data != _inline)
+      delete [] _data;
+   _data = data;
+   _capacity = newCapacity;
+}
+
+}; // namespace karen
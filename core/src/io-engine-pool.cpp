@@ -0,0 +1,202 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <cerrno>
+
+#include "KarenCore/io-engine-pool.h"
+
+#if defined(KAREN_PLATFORM_IS_POSIX)
+   #include <unistd.h>
+   #include "KarenCore/file-posix.h"
+#endif
+
+namespace karen {
+
+namespace {
+
+/*
+ * Perform given request. It returns the bytes transferred, or minus the
+ * errno as the io_uring engine does. Files with no descriptor report any
+ * failure as an I/O error.
+ */
+long
+perform(const IoRequest& req)
+{
+   bool read = (req.operation == IO_READ_OPERATION);
+#if defined(KAREN_PLATFORM_IS_POSIX)
+   PosixFile* posix = dynamic_cast<PosixFile*>(req.file);
+   File* file = dynamic_cast<File*>(req.file);
+   if (!posix && file)
+      posix = dynamic_cast<PosixFile*>(&file->delegate());
+   if (posix)
+   {
+      UInt8* ptr = (UInt8*) req.data;
+      unsigned long left = req.length;
+      unsigned long offset = req.offset;
+      while (left)
+      {
+         ssize_t n = read ? 
+               ::pread(posix->descriptor(), ptr, left, offset) :
+               ::pwrite(posix->descriptor(), ptr, left, offset);
+         if (n < 0 && errno == EINTR)
+            continue;
+         if (n < 0)
+            return -errno;
+         if (!n)
+            break;
+         ptr += n;
+         left -= n;
+         offset += n;
+      }
+      return req.length - left;
+   }
+#endif
+   try
+   {
+      return read ? 
+            req.file->readAt(req.data, req.length, req.offset) :
+            req.file->writeAt(req.data, req.length, req.offset);
+   }
+   catch (IOException&)
+   {
+      return -EIO;
+   }
+}
+
+}; // anonymous namespace
+
+ThreadPoolIoEngine::ThreadPoolIoEngine(const IoEngineOptions& options)
+ : _submitted(options.queueDepth ? options.queueDepth : 1),
+   _queueDepth(options.queueDepth ? options.queueDepth : 1),
+   _pending(0)
+{
+   unsigned int nworkers = options.workerThreads ? options.workerThreads : 1;
+   for (unsigned int i = 0; i < nworkers; i++)
+      _workers.push_back(std::thread(&ThreadPoolIoEngine::work, this));
+}
+
+ThreadPoolIoEngine::~ThreadPoolIoEngine()
+{
+   try
+   {
+      drain();
+   }
+   catch (IOException&)
+   {
+   }
+
+   // A request with no file tells a worker to finish.
+   IoRequest stop = IoRequest();
+   for (unsigned int i = 0; i < _workers.size(); i++)
+      _submitted.put(stop);
+   for (unsigned int i = 0; i < _workers.size(); i++)
+      _workers[i].join();
+}
+
+Ptr<AbstractFile>
+ThreadPoolIoEngine::open(
+      const String& location, 
+      const FileOpenMode& mode)
+throw (IOException)
+{
+   try
+   {
+      return new File(location, mode);
+   }
+   catch (InvalidStateException& e)
+   {
+      KAREN_THROW_NESTED(IOException, e, 
+         "cannot open file %s for asynchronous I/O", location);
+   }
+}
+
+void
+ThreadPoolIoEngine::enqueue(const IoRequest& request)
+throw (IOException)
+{
+   std::unique_lock<std::mutex> lock(_mutex);
+   while (_pending >= _queueDepth)
+   {
+      if (!_queued.empty())
+         submitQueued();
+      else
+         _cond.wait(lock);
+   }
+   _queued.push_back(request);
+   _pending++;
+}
+
+unsigned int
+ThreadPoolIoEngine::submit()
+throw (IOException)
+{
+   std::unique_lock<std::mutex> lock(_mutex);
+   return submitQueued();
+}
+
+void
+ThreadPoolIoEngine::drain()
+throw (IOException)
+{
+   std::unique_lock<std::mutex> lock(_mutex);
+   submitQueued();
+   while (_pending)
+      _cond.wait(lock);
+}
+
+unsigned int
+ThreadPoolIoEngine::submitQueued()
+{
+   std::vector<IoRequest> batch;
+   batch.swap(_queued);
+   if (batch.empty())
+      return 0;
+   // At most queueDepth requests are pending, so the queue has room.
+   unsigned long n = _submitted.putAll(&batch[0], batch.size());
+   for (; n < batch.size(); n++)
+      _submitted.put(batch[n]);
+   return batch.size();
+}
+
+void
+ThreadPoolIoEngine::work()
+{
+   for (;;)
+   {
+      IoCompletion completion;
+      completion.request = _submitted.poll();
+      const IoRequest& req = completion.request;
+      if (!req.file)
+         return;
+      completion.result = perform(req);
+      if (req.callback)
+         req.callback->onIoCompletion(completion);
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      _pending--;
+      _cond.notify_all();
+   }
+}
+
+}; // namespace karen
@@ -0,0 +1,516 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include "KarenCore/io-engine-uring.h"
+
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <poll.h>
+#include <linux/io_uring.h>
+#ifdef IORING_FEAT_EXT_ARG
+#include <linux/time_types.h>
+#endif
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "KarenCore/file-posix.h"
+
+namespace karen {
+
+namespace {
+
+/*
+ * User data of the poll request on the wake event, which completes when 
+ * the reaper must finish. Other requests carry their slot index plus one.
+ */
+const __u64 WAKE_USER_DATA = 0;
+
+/*
+ * The kernel may transfer fewer bytes than requested, but never more than
+ * this in a single request.
+ */
+const unsigned long MAX_REQUEST_LENGTH = 0x7ffff000;
+
+/*
+ * Interval to retry the submission of entries the kernel could not take
+ * because it was short of resources.
+ */
+const std::chrono::milliseconds SUBMIT_RETRY_INTERVAL(1);
+
+/*
+ * Interval the reaper waits for completions before checking whether the
+ * engine is stopping, if the kernel supports timed waits.
+ */
+const long REAP_WAIT_NSECS = 100000000;
+
+inline int
+uringSetup(unsigned int entries, io_uring_params* params)
+{ return ::syscall(__NR_io_uring_setup, entries, params); }
+
+inline int
+uringEnter(int ring, unsigned int submit, unsigned int wait, unsigned int flags)
+{ return ::syscall(__NR_io_uring_enter, ring, submit, wait, flags, NULL, 0); }
+
+/*
+ * Wait for at least one completion, or until the reap wait interval
+ * elapses if timed is true.
+ */
+inline int
+uringWait(int ring, bool timed)
+{
+#ifdef IORING_FEAT_EXT_ARG
+   if (timed)
+   {
+      __kernel_timespec ts = { 0, REAP_WAIT_NSECS };
+      io_uring_getevents_arg arg;
+      memset(&arg, 0, sizeof(arg));
+      arg.ts = (__u64) &ts;
+      return ::syscall(__NR_io_uring_enter, ring, 0, 1, 
+            IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, 
+            &arg, sizeof(arg));
+   }
+#endif
+   return uringEnter(ring, 0, 1, IORING_ENTER_GETEVENTS);
+}
+
+inline int
+uringRegister(int ring, unsigned int opcode, const void* arg, unsigned int n)
+{ return ::syscall(__NR_io_uring_register, ring, opcode, arg, n); }
+
+template <typename T>
+inline T*
+ringField(void* ring, unsigned int offset)
+{ return (T*) ((UInt8*) ring + offset); }
+
+// The rings are shared with the kernel, which reads and writes their 
+// indices concurrently.
+inline unsigned int
+loadAcquire(const unsigned int* index)
+{ return __atomic_load_n(index, __ATOMIC_ACQUIRE); }
+
+inline void
+storeRelease(unsigned int* index, unsigned int value)
+{ __atomic_store_n(index, value, __ATOMIC_RELEASE); }
+
+}; // anonymous namespace
+
+UringIoEngine::UringIoEngine(const IoEngineOptions& options)
+throw (IOException)
+ : _ring(-1),
+   _sqRing(NULL), _sqRingLength(0), 
+   _cqRing(NULL), _cqRingLength(0),
+   _sqes(NULL), _sqesLength(0),
+   _queued(0), _inFlight(0),
+   _timedWait(false), _stopping(false),
+   _wakeFd(-1)
+{
+   setup(options.queueDepth ? options.queueDepth : 1);
+   armWake();
+
+   // No more requests than completion entries are in flight at once, so
+   // the completion ring never overflows.
+   unsigned int nslots = _cqMask + 1;
+   _slots.resize(nslots);
+   _freeSlots.reserve(nslots);
+   for (unsigned int i = nslots; i > 0; i--)
+      _freeSlots.push_back(i - 1);
+
+   _reaper = std::thread(&UringIoEngine::reap, this);
+}
+
+UringIoEngine::~UringIoEngine()
+{
+   try
+   {
+      drain();
+   }
+   catch (IOException&)
+   {
+   }
+
+   // The reaper waits for completions in the kernel, possibly without a
+   // timeout. The poll request armed on construction completes as soon as
+   // the wake event is signalled, so shutdown needs no submission.
+   std::unique_lock<std::mutex> lock(_mutex);
+   _stopping = true;
+   UInt64 one = 1;
+   while (::write(_wakeFd, &one, sizeof(one)) < 0 && errno == EINTR);
+   lock.unlock();
+   if (_reaper.joinable())
+      _reaper.join();
+   release();
+}
+
+Ptr<AbstractFile>
+UringIoEngine::open(
+      const String& location, 
+      const FileOpenMode& mode)
+throw (IOException)
+{
+   return new PosixFile(location, mode);
+}
+
+void
+UringIoEngine::enqueue(const IoRequest& request)
+throw (IOException)
+{
+   PosixFile* file = dynamic_cast<PosixFile*>(request.file);
+   if (!file)
+      KAREN_THROW(IOException, 
+         "cannot enqueue I/O request: file not opened by io_uring engine");
+
+   std::unique_lock<std::mutex> lock(_mutex);
+   while (_freeSlots.empty())
+   {
+      if (!_queued || !submitQueued())
+         awaitProgress(lock);
+   }
+   unsigned int slot = _freeSlots.back();
+   io_uring_sqe* sqe = nextSqe(lock);
+   _freeSlots.pop_back();
+   _slots[slot] = request;
+
+   bool read = (request.operation == IO_READ_OPERATION);
+   sqe->opcode = read ? IORING_OP_READ : IORING_OP_WRITE;
+   sqe->fd = file->descriptor();
+   sqe->addr = (__u64) request.data;
+   sqe->len = (request.length < MAX_REQUEST_LENGTH) ? 
+         request.length : MAX_REQUEST_LENGTH;
+   sqe->off = request.offset;
+   sqe->user_data = slot + 1;
+   for (unsigned int i = 0; i < _buffers.size(); i++)
+   {
+      UInt8* begin = (UInt8*) _buffers[i].data;
+      UInt8* data = (UInt8*) request.data;
+      if (data >= begin && 
+          data + sqe->len <= begin + _buffers[i].length)
+      {
+         sqe->opcode = read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+         sqe->buf_index = i;
+         break;
+      }
+   }
+}
+
+unsigned int
+UringIoEngine::submit()
+throw (IOException)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+   return submitQueued();
+}
+
+void
+UringIoEngine::drain()
+throw (IOException)
+{
+   std::unique_lock<std::mutex> lock(_mutex);
+   submitQueued();
+   while (_inFlight || _queued)
+   {
+      if (!_queued || !submitQueued())
+         awaitProgress(lock);
+   }
+}
+
+void
+UringIoEngine::registerBuffers(const IoVec* vecs, unsigned int count)
+throw (IOException)
+{
+   unregisterBuffers();
+   if (!count)
+      return;
+   std::vector<struct iovec> iov(count);
+   for (unsigned int i = 0; i < count; i++)
+   {
+      iov[i].iov_base = vecs[i].data;
+      iov[i].iov_len = vecs[i].length;
+   }
+   std::lock_guard<std::mutex> lock(_mutex);
+   if (uringRegister(_ring, IORING_REGISTER_BUFFERS, &iov[0], count) < 0)
+      KAREN_THROW(IOException, 
+         "cannot register I/O buffers: %s", strerror(errno));
+   _buffers.assign(vecs, vecs + count);
+}
+
+void
+UringIoEngine::unregisterBuffers()
+throw (IOException)
+{
+   // Requests using the registered buffers must complete before.
+   drain();
+   std::lock_guard<std::mutex> lock(_mutex);
+   if (_buffers.empty())
+      return;
+   if (uringRegister(_ring, IORING_UNREGISTER_BUFFERS, NULL, 0) < 0)
+      KAREN_THROW(IOException, 
+         "cannot unregister I/O buffers: %s", strerror(errno));
+   _buffers.clear();
+}
+
+void
+UringIoEngine::setup(unsigned int entries)
+throw (IOException)
+{
+   io_uring_params params;
+   memset(&params, 0, sizeof(params));
+   _ring = uringSetup(entries, &params);
+   if (_ring < 0)
+      KAREN_THROW(IOException, "cannot set up io_uring: %s", strerror(errno));
+   // Plain read and write operations came with this feature, in Linux 5.6.
+   if (!(params.features & IORING_FEAT_RW_CUR_POS))
+   {
+      release();
+      KAREN_THROW(IOException, 
+         "cannot set up io_uring: kernel lacks read and write operations");
+   }
+
+   _sqRingLength = params.sq_off.array + params.sq_entries * sizeof(__u32);
+   _cqRingLength = 
+         params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+   bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+   if (single && _cqRingLength > _sqRingLength)
+      _sqRingLength = _cqRingLength;
+   _sqesLength = params.sq_entries * sizeof(io_uring_sqe);
+
+   void* sqRing = ::mmap(NULL, _sqRingLength, PROT_READ | PROT_WRITE, 
+         MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQ_RING);
+   _sqRing = (sqRing == MAP_FAILED) ? NULL : sqRing;
+   if (single)
+      _cqRing = _sqRing;
+   else if (_sqRing)
+   {
+      void* cqRing = ::mmap(NULL, _cqRingLength, PROT_READ | PROT_WRITE, 
+            MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_CQ_RING);
+      _cqRing = (cqRing == MAP_FAILED) ? NULL : cqRing;
+   }
+   if (_cqRing)
+   {
+      void* sqes = ::mmap(NULL, _sqesLength, PROT_READ | PROT_WRITE, 
+            MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQES);
+      _sqes = (sqes == MAP_FAILED) ? NULL : (io_uring_sqe*) sqes;
+   }
+   if (!_sqes)
+   {
+      int error = errno;
+      release();
+      KAREN_THROW(IOException, "cannot map io_uring: %s", strerror(error));
+   }
+
+   _sqTail = ringField<unsigned int>(_sqRing, params.sq_off.tail);
+   _sqLocalTail = *_sqTail;
+   _sqMask = *ringField<unsigned int>(_sqRing, params.sq_off.ring_mask);
+   _sqEntries = params.sq_entries;
+   _sqArray = ringField<unsigned int>(_sqRing, params.sq_off.array);
+   _cqHead = ringField<unsigned int>(_cqRing, params.cq_off.head);
+   _cqTail = ringField<unsigned int>(_cqRing, params.cq_off.tail);
+   _cqMask = *ringField<unsigned int>(_cqRing, params.cq_off.ring_mask);
+   _cqes = ringField<io_uring_cqe>(_cqRing, params.cq_off.cqes);
+#ifdef IORING_FEAT_EXT_ARG
+   _timedWait = params.features & IORING_FEAT_EXT_ARG;
+#endif
+}
+
+void
+UringIoEngine::armWake()
+throw (IOException)
+{
+   _wakeFd = ::eventfd(0, EFD_CLOEXEC);
+   if (_wakeFd < 0)
+   {
+      int error = errno;
+      release();
+      KAREN_THROW(IOException, 
+         "cannot create io_uring wake event: %s", strerror(error));
+   }
+   std::unique_lock<std::mutex> lock(_mutex);
+   try
+   {
+      io_uring_sqe* sqe = nextSqe(lock);
+      sqe->opcode = IORING_OP_POLL_ADD;
+      sqe->fd = _wakeFd;
+      sqe->poll_events = POLLIN;
+      sqe->user_data = WAKE_USER_DATA;
+      if (!submitQueued())
+         KAREN_THROW(IOException, 
+            "cannot arm io_uring wake event: %s", strerror(errno));
+   }
+   catch (IOException&)
+   {
+      lock.unlock();
+      release();
+      throw;
+   }
+   // The poll request stays in flight until shutdown, and it is not 
+   // waited for by drain().
+   _inFlight--;
+}
+
+void
+UringIoEngine::release()
+{
+   if (_sqes)
+      ::munmap(_sqes, _sqesLength);
+   if (_cqRing && _cqRing != _sqRing)
+      ::munmap(_cqRing, _cqRingLength);
+   if (_sqRing)
+      ::munmap(_sqRing, _sqRingLength);
+   if (_ring >= 0)
+      ::close(_ring);
+   if (_wakeFd >= 0)
+      ::close(_wakeFd);
+   _sqes = NULL;
+   _cqRing = _sqRing = NULL;
+   _ring = -1;
+   _wakeFd = -1;
+}
+
+io_uring_sqe*
+UringIoEngine::nextSqe(std::unique_lock<std::mutex>& lock)
+throw (IOException)
+{
+   // The submission ring is full of queued entries, or of entries the
+   // kernel could not take yet because it is short of resources.
+   while (_queued == _sqEntries)
+   {
+      if (!submitQueued())
+         awaitProgress(lock);
+   }
+   // Entries are published by submitQueued() only, so the tail seen by the
+   // kernel lags behind the local one.
+   unsigned int index = _sqLocalTail++ & _sqMask;
+   io_uring_sqe* sqe = &_sqes[index];
+   memset(sqe, 0, sizeof(io_uring_sqe));
+   _sqArray[index] = index;
+   _queued++;
+   return sqe;
+}
+
+unsigned int
+UringIoEngine::submitQueued()
+throw (IOException)
+{
+   if (!_queued)
+      return 0;
+   storeRelease(_sqTail, _sqLocalTail);
+   int nsubmit;
+   do
+      nsubmit = uringEnter(_ring, _queued, 0, 0);
+   while (nsubmit < 0 && errno == EINTR);
+   if (nsubmit < 0)
+   {
+      if (errno == EAGAIN || errno == EBUSY)
+         return 0;
+      KAREN_THROW(IOException, 
+         "cannot submit I/O requests: %s", strerror(errno));
+   }
+   _queued -= nsubmit;
+   _inFlight += nsubmit;
+   return nsubmit;
+}
+
+void
+UringIoEngine::awaitProgress(std::unique_lock<std::mutex>& lock)
+{
+   // Queued entries may be waiting for kernel resources rather than for
+   // the reaper, so they are retried after a while.
+   if (_queued)
+      _cond.wait_for(lock, SUBMIT_RETRY_INTERVAL);
+   else
+      _cond.wait(lock);
+}
+
+void
+UringIoEngine::reap()
+{
+   std::vector<IoCompletion> done;
+   done.reserve(_slots.size());
+   bool stop = false;
+   while (!stop)
+   {
+      unsigned int head = *_cqHead;
+      unsigned int tail = loadAcquire(_cqTail);
+      if (head == tail)
+      {
+         bool timed;
+         {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stopping && !_inFlight)
+               break;
+            timed = _timedWait;
+         }
+         uringWait(_ring, timed);
+         continue;
+      }
+
+      /*
+       * Completed requests are collected under the engine mutex. The 
+       * kernel already orders the submitter's writes before the CQE, but
+       * taking the lock makes that ordering visible to the language 
+       * memory model as well (and to race detectors).
+       */
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         for (; head != tail; head++)
+         {
+            const io_uring_cqe& cqe = _cqes[head & _cqMask];
+            if (cqe.user_data == WAKE_USER_DATA)
+            {
+               stop = true;
+               continue;
+            }
+            unsigned int slot = cqe.user_data - 1;
+            IoCompletion completion;
+            completion.request = _slots[slot];
+            completion.result = cqe.res;
+            done.push_back(completion);
+            _freeSlots.push_back(slot);
+         }
+         storeRelease(_cqHead, tail);
+      }
+
+      for (unsigned int i = 0; i < done.size(); i++)
+      {
+         IoCallback* callback = done[i].request.callback;
+         if (callback)
+            callback->onIoCompletion(done[i]);
+      }
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      _inFlight -= done.size();
+      done.clear();
+      _cond.notify_all();
+   }
+}
+
+}; // namespace karen
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <chrono>
+
+#include "KarenCore/io-engine.h"
+#include "KarenCore/io-engine-pool.h"
+#include "KarenCore/io-engine-uring.h"
+
+namespace karen {
+
+namespace {
+
+/*
+ * Callback completing a future. It keeps the future state alive until the
+ * request completes, and deletes itself after that.
+ */
+struct FutureCallback : IoCallback
+{
+   AtomicPtr<IoFutureState> state;
+
+   FutureCallback(const AtomicPtr<IoFutureState>& state) : state(state) {}
+
+   virtual void onIoCompletion(const IoCompletion& completion)
+   {
+      state->complete(completion);
+      delete this;
+   }
+};
+
+/*
+ * Callback sending the completion to an event channel. It deletes itself
+ * after that.
+ */
+struct ChannelCallback : IoCallback
+{
+   const EventChannel* channel;
+
+   ChannelCallback(const EventChannel* channel) : channel(channel) {}
+
+   virtual void onIoCompletion(const IoCompletion& completion)
+   {
+      IoCompletionEvent ev;
+      ev.completion = completion;
+      try
+      {
+         channel->sendEvent(ev);
+      }
+      catch (IOException&)
+      {
+         // No one to report to from an engine thread.
+      }
+      delete this;
+   }
+};
+
+}; // anonymous namespace
+
+void
+IoFutureState::complete(const IoCompletion& completion)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+   _completion = completion;
+   _ready = true;
+   _cond.notify_all();
+}
+
+bool
+IoFuture::isReady() const
+{
+   std::lock_guard<std::mutex> lock(_state->_mutex);
+   return _state->_ready;
+}
+
+const IoCompletion&
+IoFuture::wait() const
+{
+   std::unique_lock<std::mutex> lock(_state->_mutex);
+   while (!_state->_ready)
+      _state->_cond.wait(lock);
+   return _state->_completion;
+}
+
+bool
+IoFuture::wait(unsigned long millis) const
+{
+   std::unique_lock<std::mutex> lock(_state->_mutex);
+   std::chrono::steady_clock::time_point deadline = 
+         std::chrono::steady_clock::now() + std::chrono::milliseconds(millis);
+   while (!_state->_ready)
+      if (_state->_cond.wait_until(lock, deadline) == std::cv_status::timeout)
+         return _state->_ready;
+   return true;
+}
+
+AtomicPtr<IoEngine>
+IoEngine::create(const IoEngineOptions& options)
+{
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+   if (!options.forceThreadPool)
+   {
+      try
+      {
+         return AtomicPtr<IoEngine>(new UringIoEngine(options));
+      }
+      catch (IOException&)
+      {
+         // The kernel lacks io_uring, or forbids it; use the pool.
+      }
+   }
+#endif
+   return AtomicPtr<IoEngine>(new ThreadPoolIoEngine(options));
+}
+
+AsyncFile::AsyncFile(
+      IoEngine& engine, 
+      const String& location, 
+      const FileOpenMode& mode)
+throw (IOException)
+ : _engine(engine), _file(engine.open(location, mode))
+{
+}
+
+void
+AsyncFile::read(
+      void* dst, 
+      unsigned long len, 
+      unsigned long offset, 
+      IoCallback* callback, 
+      void* userData)
+throw (IOException)
+{ enqueue(IO_READ_OPERATION, dst, len, offset, callback, userData); }
+
+IoFuture
+AsyncFile::read(void* dst, unsigned long len, unsigned long offset)
+throw (IOException)
+{
+   IoFuture future;
+   FutureCallback* callback = new FutureCallback(future._state);
+   try
+   {
+      enqueue(IO_READ_OPERATION, dst, len, offset, callback, NULL);
+   }
+   catch (IOException&)
+   {
+      delete callback;
+      throw;
+   }
+   return future;
+}
+
+void
+AsyncFile::read(
+      void* dst, 
+      unsigned long len, 
+      unsigned long offset, 
+      const EventChannel* channel, 
+      void* userData)
+throw (IOException)
+{
+   ChannelCallback* callback = new ChannelCallback(channel);
+   try
+   {
+      enqueue(IO_READ_OPERATION, dst, len, offset, callback, userData);
+   }
+   catch (IOException&)
+   {
+      delete callback;
+      throw;
+   }
+}
+
+void
+AsyncFile::write(
+      const void* src, 
+      unsigned long len, 
+      unsigned long offset, 
+      IoCallback* callback, 
+      void* userData)
+throw (IOException)
+{ 
+   enqueue(IO_WRITE_OPERATION, (void*) src, len, offset, callback, userData);
+}
+
+IoFuture
+AsyncFile::write(const void* src, unsigned long len, unsigned long offset)
+throw (IOException)
+{
+   IoFuture future;
+   FutureCallback* callback = new FutureCallback(future._state);
+   try
+   {
+      enqueue(IO_WRITE_OPERATION, (void*) src, len, offset, callback, NULL);
+   }
+   catch (IOException&)
+   {
+      delete callback;
+      throw;
+   }
+   return future;
+}
+
+void
+AsyncFile::write(
+      const void* src, 
+      unsigned long len, 
+      unsigned long offset, 
+      const EventChannel* channel, 
+      void* userData)
+throw (IOException)
+{
+   ChannelCallback* callback = new ChannelCallback(channel);
+   try
+   {
+      enqueue(IO_WRITE_OPERATION, (void*) src, len, offset, callback, userData);
+   }
+   catch (IOException&)
+   {
+      delete callback;
+      throw;
+   }
+}
+
+void
+AsyncFile::enqueue(
+      IoOperation operation,
+      void* data, 
+      unsigned long len, 
+      unsigned long offset, 
+      IoCallback* callback, 
+      void* userData)
+throw (IOException)
+{
+   IoRequest request;
+   request.operation = operation;
+   request.file = _file;
+   request.data = data;
+   request.length = len;
+   request.offset = offset;
+   request.callback = callback;
+   request.userData = userData;
+   _engine.enqueue(request);
+}
+
+}; // namespace karen
@@ -24,34 +24,983 @@
 
 #include "KarenCore/numeric.h"
 
-#include <cerrno>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
-#include <sstream>
+#include <cstring>
+
+/* Eight digits are handled at once in a 64-bit word where supported. */
+#if KAREN_ENDIANNESS == KAREN_LITTLE_ENDIAN
+   #define KAREN_NUMERIC_SWAR
+#endif
 
 namespace karen {
 
+const unsigned int Integer::FORMAT_LENGTH;
+const unsigned int Float::FORMAT_LENGTH;
+
+namespace {
+
+const std::uint64_t POWERS_OF_TEN[20] =
+{
+   1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+   10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+   100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+   100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+   100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+const double EXACT_POWERS_OF_TEN[23] =
+{
+   1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+const char DIGIT_PAIRS[] =
+   "00010203040506070809101112131415161718192021222324252627282930313233"
+   "34353637383940414243444546474849505152535455565758596061626364656667"
+   "6869707172737475767778798081828384858687888990919293949596979899";
+
+inline bool
+isDigit(char c)
+{ return (unsigned char) (c - '0') < 10; }
+
+inline bool
+isBlank(char c)
+{ return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+inline unsigned
+digitValue(char c)
+{
+   if (c >= '0' && c <= '9')
+      return c - '0';
+   if (c >= 'a' && c <= 'z')
+      return c - 'a' + 10;
+   if (c >= 'A' && c <= 'Z')
+      return c - 'A' + 10;
+   return 36;
+}
+
+#ifdef KAREN_NUMERIC_SWAR
+
+/*
+ * Load the eight characters at given position in a word whose least
+ * significant byte is the first character. Characters past the end are
+ * loaded as null characters.
+ */
+inline std::uint64_t
+loadWord(const char* p, const char* last)
+{
+   std::uint64_t word = 0;
+   std::memcpy(&word, p, last - p < 8 ? last - p : 8);
+   return word;
+}
+
+/*
+ * Count the decimal digits at the beginning of given word, replacing 
+ * each digit character by its value. 
+ */
+inline unsigned
+leadingDigits(std::uint64_t& word)
+{
+   word ^= 0x3030303030303030ULL;
+   std::uint64_t nonDigits = (((word & 0x7F7F7F7F7F7F7F7FULL) + 
+         0x7676767676767676ULL) | word) & 0x8080808080808080ULL;
+   if (!nonDigits)
+      return 8;
+#if KAREN_COMPILER == KAREN_COMPILER_GCC || \
+    KAREN_COMPILER == KAREN_COMPILER_CLANG
+   return __builtin_ctzll(nonDigits) >> 3;
+#else
+   unsigned count = 0;
+   for (; !(nonDigits & 0x80); nonDigits >>= 8)
+      count++;
+   return count;
+#endif
+}
+
+/*
+ * Obtain the value of the given count of leading digit values in given 
+ * word, combining pairs of digits, then pairs of pairs and so on.
+ */
+inline std::uint64_t
+wordValue(std::uint64_t word, unsigned count)
+{
+   word <<= 8 * (8 - count);
+   word = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FFULL;
+   word = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFFULL;
+   return (word * 10000 + (word >> 32)) & 0xFFFFFFFFULL;
+}
+
+#endif
+
+/*
+ * Accumulate the decimal digits at given position into given value,
+ * setting overflow if it doesn't fit in 64 bits. It returns the position
+ * past the digits. 
+ */
+const char*
+accumulateDecimal(
+      const char* p, const char* last, std::uint64_t& value, bool& overflow)
+{
+#ifdef KAREN_NUMERIC_SWAR
+   while (p < last)
+   {
+      std::uint64_t word = loadWord(p, last);
+      unsigned count = leadingDigits(word);
+      if (!count)
+         break;
+      std::uint64_t chunk = wordValue(word, count);
+      if (value >= POWERS_OF_TEN[11] && 
+          value > (UINT64_MAX - chunk) / POWERS_OF_TEN[count])
+         overflow = true;
+      value = value * POWERS_OF_TEN[count] + chunk;
+      p += count;
+      if (count < 8)
+         break;
+   }
+#else
+   for (; p < last && isDigit(*p); p++)
+   {
+      unsigned digit = *p - '0';
+      if (value > (UINT64_MAX - digit) / 10)
+         overflow = true;
+      value = value * 10 + digit;
+   }
+#endif
+   return p;
+}
+
+/*
+ * Accumulate the digits in given base at given position into given
+ * value, as accumulateDecimal() does.
+ */
+const char*
+accumulateDigits(
+      const char* p, const char* last, unsigned base,
+      std::uint64_t& value, bool& overflow)
+{
+   if (base == 10)
+      return accumulateDecimal(p, last, value, overflow);
+   for (; p < last; p++)
+   {
+      unsigned digit = digitValue(*p);
+      if (digit >= base)
+         break;
+      if (value > (UINT64_MAX - digit) / base)
+         overflow = true;
+      value = value * base + digit;
+   }
+   return p;
+}
+
+/*
+ * Parse the magnitude of a long value, after its sign. 
+ */
+ParseResult
+parseLongMagnitude(
+      const char* first, const char* last, bool negative, 
+      unsigned int base, long& value)
+{
+   std::uint64_t magnitude = 0;
+   bool overflow = false;
+   const char* end = (base < 2 || base > 36) ? 
+         first : accumulateDigits(first, last, base, magnitude, overflow);
+   if (end == first)
+      return { first, PARSE_INVALID };
+   std::uint64_t limit = negative ? 
+         (std::uint64_t) LONG_MAX + 1 : (std::uint64_t) LONG_MAX;
+   if (overflow || magnitude > limit)
+      return { end, PARSE_OUT_OF_RANGE };
+   value = negative ? -(long) (magnitude - 1) - 1 : (long) magnitude;
+   return { end, PARSE_OK };
+}
+
+/*
+ * Significand of a decimal number, with at most 19 significant digits.
+ * The digits beyond them are dropped, which makes the significand 
+ * inexact if any of them is not zero. 
+ */
+struct Significand
+{
+   std::uint64_t  digits;
+   int            dropped;
+   bool           inexact;
+};
+
+/*
+ * Accumulate the decimal digits at given position into given significand.
+ * It returns the position past the digits.
+ */
+const char*
+accumulateSignificand(const char* p, const char* last, Significand& sig)
+{
+#ifdef KAREN_NUMERIC_SWAR
+   while (p < last)
+   {
+      std::uint64_t word = loadWord(p, last);
+      unsigned count = leadingDigits(word);
+      if (!count)
+         break;
+      if (sig.digits < POWERS_OF_TEN[19 - count])
+      {
+         sig.digits = sig.digits * POWERS_OF_TEN[count] + 
+               wordValue(word, count);
+         p += count;
+      }
+      else
+      {
+         for (const char* end = p + count; p < end; p++)
+         {
+            if (sig.digits < POWERS_OF_TEN[18])
+               sig.digits = sig.digits * 10 + (*p - '0');
+            else
+            {
+               sig.dropped++;
+               sig.inexact = sig.inexact || *p != '0';
+            }
+         }
+      }
+      if (count < 8)
+         break;
+   }
+#else
+   for (; p < last && isDigit(*p); p++)
+   {
+      if (sig.digits < POWERS_OF_TEN[18])
+         sig.digits = sig.digits * 10 + (*p - '0');
+      else
+      {
+         sig.dropped++;
+         sig.inexact = sig.inexact || *p != '0';
+      }
+   }
+#endif
+   return p;
+}
+
+/*
+ * Check whether given characters begin with given lower case word,
+ * ignoring case. 
+ */
+inline bool
+startsWithWord(const char* p, const char* last, const char* word)
+{
+   unsigned long len = std::strlen(word);
+   if ((unsigned long) (last - p) < len)
+      return false;
+   for (unsigned long i = 0; i < len; i++)
+      if (std::tolower((unsigned char) p[i]) != word[i])
+         return false;
+   return true;
+}
+
+/*
+ * Convert the decimal number in [first, last), with the given number of
+ * fraction digits and exponent, to the correctly rounded double. The
+ * digits are passed to strtod() without decimal point, so the locale 
+ * doesn't matter. Beyond the 780 significant digits that may affect the
+ * rounding, the digits are replaced by a single non-zero digit if any of
+ * them is not zero. 
+ */
+double
+convertDecimal(const char* first, const char* last, long exponent)
+{
+   const int MAX_DIGITS = 780;
+   char buffer[MAX_DIGITS + 32];
+   char* out = buffer;
+   bool sticky = false;
+   for (const char* p = first; p < last; p++)
+   {
+      if (*p == '.')
+         continue;
+      if (*p == '0' && out == buffer)
+         continue;
+      if (out < buffer + MAX_DIGITS)
+         *out++ = *p;
+      else
+      {
+         sticky = sticky || *p != '0';
+         exponent++;
+      }
+   }
+   if (sticky)
+   {
+      *out++ = '1';
+      exponent--;
+   }
+   if (out == buffer)
+      return 0.0;
+   *out++ = 'e';
+   std::snprintf(out, 24, "%ld", exponent);
+   return std::strtod(buffer, NULL);
+}
+
+/*
+ * Shortest round-trip formatting of doubles, after the Ryu algorithm by
+ * Ulf Adams. The 128-bit multipliers of its tables are computed on first
+ * use from powers of five, rather than compiled in. 
+ */
+const int DOUBLE_MANTISSA_BITS = 52;
+const int DOUBLE_BIAS = 1023;
+const unsigned POW5_INV_BITCOUNT = 125;
+const unsigned POW5_BITCOUNT = 125;
+const unsigned POW5_INV_TABLE_SIZE = 342;
+const unsigned POW5_TABLE_SIZE = 326;
+
+inline unsigned
+pow5Bits(unsigned e)
+{ return ((e * 1217359) >> 19) + 1; }
+
+inline unsigned
+log10Pow2(unsigned e)
+{ return (e * 78913) >> 18; }
+
+inline unsigned
+log10Pow5(unsigned e)
+{ return (e * 732923) >> 20; }
+
+inline bool
+multipleOfPowerOf5(std::uint64_t value, unsigned p)
+{
+   unsigned count = 0;
+   for (; value % 5 == 0; value /= 5)
+      count++;
+   return count >= p;
+}
+
+inline bool
+multipleOfPowerOf2(std::uint64_t value, unsigned p)
+{ return (value & ((1ULL << p) - 1)) == 0; }
+
+/*
+ * Obtain 128 bits of a number of little endian 32-bit limbs, from the
+ * given bit on. 
+ */
+void
+extractBits(
+      const std::uint32_t* limbs, unsigned count, unsigned bit, 
+      std::uint64_t* result)
+{
+   std::uint64_t words[4];
+   for (unsigned w = 0; w < 4; w++)
+   {
+      unsigned index = bit / 32 + w;
+      std::uint64_t low = index < count ? limbs[index] : 0;
+      std::uint64_t high = index + 1 < count ? limbs[index + 1] : 0;
+      words[w] = (((high << 32) | low) >> (bit % 32)) & 0xFFFFFFFFULL;
+   }
+   result[0] = words[0] | (words[1] << 32);
+   result[1] = words[2] | (words[3] << 32);
+}
+
+struct Pow5Tables
+{
+   // floor(2^(pow5Bits(q) + 124) / 5^q) + 1
+   std::uint64_t inverse[POW5_INV_TABLE_SIZE][2];
+   
+   // 5^i scaled to 125 bits
+   std::uint64_t direct[POW5_TABLE_SIZE][2];
+
+   Pow5Tables()
+   {
+      // 2^1024 divided by 5 once per entry, since floors of floors 
+      // divide exactly
+      const unsigned INV_LIMBS = 33;
+      std::uint32_t num[INV_LIMBS] = { 0 };
+      num[INV_LIMBS - 1] = 1;
+      for (unsigned q = 0; q < POW5_INV_TABLE_SIZE; q++)
+      {
+         extractBits(num, INV_LIMBS, 1024 - pow5Bits(q) - 124, inverse[q]);
+         if (!++inverse[q][0])
+            ++inverse[q][1];
+         std::uint64_t rem = 0;
+         for (unsigned i = INV_LIMBS; i-- > 0; )
+         {
+            std::uint64_t cur = (rem << 32) | num[i];
+            num[i] = (std::uint32_t) (cur / 5);
+            rem = cur % 5;
+         }
+      }
+
+      const unsigned POW_LIMBS = 26;
+      std::uint32_t pow[POW_LIMBS] = { 1 };
+      for (unsigned i = 0; i < POW5_TABLE_SIZE; i++)
+      {
+         unsigned bits = pow5Bits(i);
+         if (bits > POW5_BITCOUNT)
+            extractBits(pow, POW_LIMBS, bits - POW5_BITCOUNT, direct[i]);
+         else
+         {
+            unsigned shift = POW5_BITCOUNT - bits;
+            extractBits(pow, POW_LIMBS, 0, direct[i]);
+            if (shift >= 64)
+            {
+               direct[i][1] = direct[i][0] << (shift - 64);
+               direct[i][0] = 0;
+            }
+            else if (shift)
+            {
+               direct[i][1] = (direct[i][1] << shift) | 
+                     (direct[i][0] >> (64 - shift));
+               direct[i][0] <<= shift;
+            }
+         }
+         std::uint64_t carry = 0;
+         for (unsigned l = 0; l < POW_LIMBS; l++)
+         {
+            std::uint64_t cur = (std::uint64_t) pow[l] * 5 + carry;
+            pow[l] = (std::uint32_t) cur;
+            carry = cur >> 32;
+         }
+      }
+   }
+};
+
+const Pow5Tables&
+pow5Tables()
+{
+   static const Pow5Tables tables;
+   return tables;
+}
+
+/*
+ * Multiply given 64-bit value by given 128-bit multiplier and shift the
+ * product right by given amount, which is at least 64.
+ */
+inline std::uint64_t
+mulShift64(std::uint64_t m, const std::uint64_t* mul, unsigned shift)
+{
+#if defined(__SIZEOF_INT128__)
+   typedef unsigned __int128 UInt128;
+   UInt128 low = (UInt128) m * mul[0];
+   UInt128 high = (UInt128) m * mul[1];
+   return (std::uint64_t) (((low >> 64) + high) >> (shift - 64));
+#else
+   std::uint64_t m0 = m & 0xFFFFFFFFULL, m1 = m >> 32;
+   std::uint64_t result[3] = { 0, 0, 0 };
+   for (unsigned w = 0; w < 2; w++)
+   {
+      std::uint64_t x0 = mul[w] & 0xFFFFFFFFULL, x1 = mul[w] >> 32;
+      std::uint64_t p00 = m0 * x0, p01 = m0 * x1;
+      std::uint64_t p10 = m1 * x0, p11 = m1 * x1;
+      std::uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFFULL) + 
+            (p10 & 0xFFFFFFFFULL);
+      std::uint64_t lo = (mid << 32) | (p00 & 0xFFFFFFFFULL);
+      std::uint64_t hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+      result[w] += lo;
+      if (result[w] < lo)
+         hi++;
+      result[w + 1] += hi;
+   }
+   shift -= 64;
+   if (!shift)
+      return result[1];
+   return (result[2] << (64 - shift)) | (result[1] >> shift);
+#endif
+}
+
+/*
+ * Decimal representation of a double as digits * 10^exponent.
+ */
+struct DecimalDouble
+{
+   std::uint64_t  digits;
+   int            exponent;
+};
+
+/*
+ * Obtain the shortest decimal representation within the rounding interval
+ * of the finite non-zero double with given IEEE mantissa and exponent.
+ */
+DecimalDouble
+shortestDecimal(std::uint64_t ieeeMantissa, unsigned ieeeExponent)
+{
+   int e2;
+   std::uint64_t m2;
+   if (ieeeExponent == 0)
+   {
+      e2 = 1 - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+      m2 = ieeeMantissa;
+   }
+   else
+   {
+      e2 = (int) ieeeExponent - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+      m2 = (1ULL << DOUBLE_MANTISSA_BITS) | ieeeMantissa;
+   }
+   bool acceptBounds = (m2 & 1) == 0;
+
+   // Compute the interval bounds and the value scaled to a power of ten
+   std::uint64_t mv = 4 * m2;
+   unsigned mmShift = ieeeMantissa != 0 || ieeeExponent <= 1;
+   std::uint64_t vr, vp, vm;
+   int e10;
+   bool vmIsTrailingZeros = false, vrIsTrailingZeros = false;
+   const Pow5Tables& tables = pow5Tables();
+   if (e2 >= 0)
+   {
+      unsigned q = log10Pow2(e2) - (e2 > 3);
+      e10 = q;
+      unsigned k = POW5_INV_BITCOUNT + pow5Bits(q) - 1;
+      unsigned i = -e2 + q + k;
+      vr = mulShift64(mv, tables.inverse[q], i);
+      vp = mulShift64(mv + 2, tables.inverse[q], i);
+      vm = mulShift64(mv - 1 - mmShift, tables.inverse[q], i);
+      if (q <= 21)
+      {
+         if (mv % 5 == 0)
+            vrIsTrailingZeros = multipleOfPowerOf5(mv, q);
+         else if (acceptBounds)
+            vmIsTrailingZeros = multipleOfPowerOf5(mv - 1 - mmShift, q);
+         else
+            vp -= multipleOfPowerOf5(mv + 2, q);
+      }
+   }
+   else
+   {
+      unsigned q = log10Pow5(-e2) - (-e2 > 1);
+      e10 = q + e2;
+      unsigned i = -e2 - q;
+      int k = pow5Bits(i) - POW5_BITCOUNT;
+      unsigned j = q - k;
+      vr = mulShift64(mv, tables.direct[i], j);
+      vp = mulShift64(mv + 2, tables.direct[i], j);
+      vm = mulShift64(mv - 1 - mmShift, tables.direct[i], j);
+      if (q <= 1)
+      {
+         vrIsTrailingZeros = true;
+         if (acceptBounds)
+            vmIsTrailingZeros = mmShift == 1;
+         else
+            --vp;
+      }
+      else if (q < 63)
+         vrIsTrailingZeros = multipleOfPowerOf2(mv, q);
+   }
+
+   // Remove the digits shared by the whole interval
+   int removed = 0;
+   unsigned lastRemovedDigit = 0;
+   std::uint64_t output;
+   if (vmIsTrailingZeros || vrIsTrailingZeros)
+   {
+      while (vp / 10 > vm / 10)
+      {
+         vmIsTrailingZeros = vmIsTrailingZeros && vm % 10 == 0;
+         vrIsTrailingZeros = vrIsTrailingZeros && lastRemovedDigit == 0;
+         lastRemovedDigit = vr % 10;
+         vr /= 10;
+         vp /= 10;
+         vm /= 10;
+         removed++;
+      }
+      if (vmIsTrailingZeros)
+      {
+         while (vm % 10 == 0)
+         {
+            vrIsTrailingZeros = vrIsTrailingZeros && lastRemovedDigit == 0;
+            lastRemovedDigit = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+         }
+      }
+      // Round half to even if the exact value ends in 5
+      if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0)
+         lastRemovedDigit = 4;
+      output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) ||
+                     lastRemovedDigit >= 5);
+   }
+   else
+   {
+      bool roundUp = false;
+      if (vp / 100 > vm / 100)
+      {
+         roundUp = vr % 100 >= 50;
+         vr /= 100;
+         vp /= 100;
+         vm /= 100;
+         removed += 2;
+      }
+      while (vp / 10 > vm / 10)
+      {
+         roundUp = vr % 10 >= 5;
+         vr /= 10;
+         vp /= 10;
+         vm /= 10;
+         removed++;
+      }
+      output = vr + (vr == vm || roundUp);
+   }
+   DecimalDouble result = { output, e10 + removed };
+   return result;
+}
+
+/*
+ * Write the decimal digits of given value backwards, ending at given 
+ * position. It returns the position of the first digit. 
+ */
+char*
+writeDigitsBackwards(std::uint64_t value, char* end)
+{
+   while (value >= 100)
+   {
+      unsigned pair = (unsigned) (value % 100) * 2;
+      value /= 100;
+      *--end = DIGIT_PAIRS[pair + 1];
+      *--end = DIGIT_PAIRS[pair];
+   }
+   if (value >= 10)
+   {
+      *--end = DIGIT_PAIRS[value * 2 + 1];
+      *--end = DIGIT_PAIRS[value * 2];
+   }
+   else
+      *--end = (char) ('0' + value);
+   return end;
+}
+
+inline char*
+writeChars(char* out, char c, int count)
+{
+   for (; count > 0; count--)
+      *out++ = c;
+   return out;
+}
+
+/*
+ * Functors to parse a value of a list.
+ */
+struct LongParser
+{
+   unsigned int base;
+
+   inline ParseResult operator () (
+         const char* first, const char* last, long& value) const
+   { return Integer::parse(first, last, value, base); }
+};
+
+struct DoubleParser
+{
+   inline ParseResult operator () (
+         const char* first, const char* last, double& value) const
+   { return Float::parse(first, last, value); }
+};
+
+template <class T, class Parser>
+ParseResult
+parseValueList(
+      const StringView& str, Array<T>& values, char separator, 
+      const Parser& parser)
+{
+   const char* p = str.begin();
+   const char* last = str.end();
+   while (p < last && isBlank(*p))
+      p++;
+   while (p < last)
+   {
+      T value;
+      ParseResult res = parser(p, last, value);
+      if (!res.ok())
+         return res;
+      values.append(value);
+      p = res.end;
+      while (p < last && isBlank(*p))
+         p++;
+      if (p == last)
+         break;
+      if (*p == separator)
+      {
+         p++;
+         while (p < last && isBlank(*p))
+            p++;
+         if (p == last)
+            return { p, PARSE_INVALID };
+      }
+      else if (!isBlank(separator) || p == res.end)
+         return { p, PARSE_INVALID };
+   }
+   return { p, PARSE_OK };
+}
+
+}; // anonymous namespace
+
 long
 Integer::toLong(const String &str, unsigned int base)
 throw (InvalidConversionException)
 {
-   char *end;
-   long l = strtol(str, &end, base);
-   if ((*end != '\0') || (!l && (errno == EINVAL)))
+   const char* p = str;
+   const char* last = p + str.length();
+   while (p < last && std::isspace((unsigned char) *p))
+      p++;
+   bool negative = p < last && *p == '-';
+   if (p < last && (*p == '-' || *p == '+'))
+      p++;
+   if ((base == 0 || base == 16) && last - p > 2 && p[0] == '0' && 
+       (p[1] == 'x' || p[1] == 'X') && std::isxdigit((unsigned char) p[2]))
+   {
+      p += 2;
+      base = 16;
+   }
+   else if (base == 0)
+      base = (p < last && *p == '0') ? 8 : 10;
+
+   long l = 0;
+   ParseResult res = parseLongMagnitude(p, last, negative, base, l);
+   if (res.error == PARSE_OUT_OF_RANGE)
+      KAREN_THROW(InvalidConversionException, 
+      "cannot convert string %s to long: out of range", (const char*) str);
+   if (!res.ok() || res.end != last)
       KAREN_THROW(InvalidConversionException, 
       "cannot convert string %s to long", (const char*) str);
    return l;
 }
 
+ParseResult
+Integer::parse(
+      const char* first, const char* last, long& value, unsigned int base)
+{
+   bool negative = first < last && *first == '-';
+   ParseResult res = parseLongMagnitude(
+         first + negative, last, negative, base, value);
+   if (res.error == PARSE_INVALID)
+      res.end = first;
+   return res;
+}
+
+ParseResult
+Integer::parse(const StringView& str, long& value, unsigned int base)
+{ return parse(str.begin(), str.end(), value, base); }
+
+ParseResult
+Integer::parseList(
+      const StringView& str, Array<long>& values, char separator,
+      unsigned int base)
+{
+   LongParser parser = { base };
+   return parseValueList(str, values, separator, parser);
+}
+
+unsigned int
+Integer::format(long value, char* buffer)
+{
+   char digits[FORMAT_LENGTH];
+   char* end = digits + FORMAT_LENGTH;
+   char* begin = writeDigitsBackwards(value < 0 ? 
+         0ULL - (std::uint64_t) value : (std::uint64_t) value, end);
+   if (value < 0)
+      *--begin = '-';
+   std::memcpy(buffer, begin, end - begin);
+   return end - begin;
+}
+
 double
 Float::toDouble(const String &str)
 throw (InvalidConversionException)
 {
-   char *end;
-   double d = strtod(str, &end);
-   if ((*end != '\0') || (!d && (errno == EINVAL)))
+   const char* p = str;
+   const char* last = p + str.length();
+   while (p < last && std::isspace((unsigned char) *p))
+      p++;
+   if (p + 1 < last && *p == '+' && p[1] != '-')
+      p++;
+   double d = 0.0;
+   ParseResult res = parse(p, last, d);
+   if (res.error == PARSE_OUT_OF_RANGE)
+      KAREN_THROW(InvalidConversionException, 
+      "cannot convert string %s to double: out of range", (const char*) str);
+   if (!res.ok() || res.end != last)
       KAREN_THROW(InvalidConversionException, 
       "cannot convert string %s to double", (const char*) str);
    return d;
 }
 
+ParseResult
+Float::parse(const char* first, const char* last, double& value)
+{
+   const char* p = first;
+   bool negative = p < last && *p == '-';
+   if (negative)
+      p++;
+   if (p < last && !isDigit(*p) && *p != '.')
+   {
+      if (startsWithWord(p, last, "nan"))
+      {
+         value = negative ? -NAN : NAN;
+         return { p + 3, PARSE_OK };
+      }
+      if (startsWithWord(p, last, "inf"))
+      {
+         value = negative ? -HUGE_VAL : HUGE_VAL;
+         return { p + (startsWithWord(p, last, "infinity") ? 8 : 3), 
+                  PARSE_OK };
+      }
+      return { first, PARSE_INVALID };
+   }
+
+   // Scan the significand digits, dropping those beyond the 19th
+   Significand sig = { 0, 0, false };
+   const char* digits = p;
+   p = accumulateSignificand(p, last, sig);
+   bool hasDigits = p != digits;
+   long exponent = sig.dropped;
+   long fractionDigits = 0;
+   if (p < last && *p == '.')
+   {
+      const char* fraction = ++p;
+      sig.dropped = 0;
+      p = accumulateSignificand(p, last, sig);
+      fractionDigits = p - fraction;
+      exponent -= fractionDigits - sig.dropped;
+      hasDigits = hasDigits || p != fraction;
+   }
+   if (!hasDigits)
+      return { first, PARSE_INVALID };
+   const char* digitsEnd = p;
+
+   // Scan the exponent, if any, saturating it far beyond the range
+   long explicitExponent = 0;
+   if (p + 1 < last && (*p == 'e' || *p == 'E'))
+   {
+      const char* q = p + 1;
+      bool negativeExponent = *q == '-';
+      if (*q == '-' || *q == '+')
+         q++;
+      if (q < last && isDigit(*q))
+      {
+         for (; q < last && isDigit(*q); q++)
+            if (explicitExponent < 100000)
+               explicitExponent = explicitExponent * 10 + (*q - '0');
+         if (negativeExponent)
+            explicitExponent = -explicitExponent;
+         p = q;
+      }
+   }
+   exponent += explicitExponent;
+
+   // Products and quotients of exact doubles are correctly rounded, so
+   // exact significands with small exponents take no further work
+   double d;
+   if (!sig.digits)
+      d = 0.0;
+   else if (!sig.inexact && sig.digits <= (1ULL << 53) && 
+            exponent >= -22 && exponent <= 22)
+   {
+      d = (double) sig.digits;
+      if (exponent < 0)
+         d /= EXACT_POWERS_OF_TEN[-exponent];
+      else
+         d *= EXACT_POWERS_OF_TEN[exponent];
+   }
+   else if (!sig.inexact && exponent > 22 && exponent <= 22 + 15 &&
+            sig.digits <= (1ULL << 53) / POWERS_OF_TEN[exponent - 22])
+      d = (double) (sig.digits * POWERS_OF_TEN[exponent - 22]) * 1e22;
+   else
+   {
+      d = convertDecimal(digits, digitsEnd, explicitExponent - fractionDigits);
+      if (std::isinf(d) || d == 0.0)
+         return { p, PARSE_OUT_OF_RANGE };
+   }
+   value = negative ? -d : d;
+   return { p, PARSE_OK };
+}
+
+ParseResult
+Float::parse(const StringView& str, double& value)
+{ return parse(str.begin(), str.end(), value); }
+
+ParseResult
+Float::parseList(
+      const StringView& str, Array<double>& values, char separator)
+{
+   DoubleParser parser;
+   return parseValueList(str, values, separator, parser);
+}
+
+unsigned int
+Float::format(double value, char* buffer)
+{
+   std::uint64_t bits;
+   std::memcpy(&bits, &value, sizeof(bits));
+   std::uint64_t ieeeMantissa = bits & ((1ULL << DOUBLE_MANTISSA_BITS) - 1);
+   unsigned ieeeExponent = (unsigned) (bits >> DOUBLE_MANTISSA_BITS) & 0x7FF;
+   char* out = buffer;
+   if (ieeeExponent == 0x7FF && ieeeMantissa)
+   {
+      std::memcpy(out, "nan", 3);
+      return 3;
+   }
+   if (bits >> 63)
+      *out++ = '-';
+   if (ieeeExponent == 0x7FF)
+   {
+      std::memcpy(out, "inf", 3);
+      return out + 3 - buffer;
+   }
+   if (!ieeeExponent && !ieeeMantissa)
+   {
+      *out++ = '0';
+      return out - buffer;
+   }
+
+   DecimalDouble decimal = shortestDecimal(ieeeMantissa, ieeeExponent);
+   char digits[20];
+   char* digitsEnd = digits + sizeof(digits);
+   char* digitsBegin = writeDigitsBackwards(decimal.digits, digitsEnd);
+   int length = digitsEnd - digitsBegin;
+   int point = decimal.exponent + length;
+   if (point >= -5 && point <= 21)
+   {
+      if (point <= 0)
+      {
+         *out++ = '0';
+         *out++ = '.';
+         out = writeChars(out, '0', -point);
+         std::memcpy(out, digitsBegin, length);
+         out += length;
+      }
+      else if (point >= length)
+      {
+         std::memcpy(out, digitsBegin, length);
+         out = writeChars(out + length, '0', point - length);
+      }
+      else
+      {
+         std::memcpy(out, digitsBegin, point);
+         out[point] = '.';
+         std::memcpy(out + point + 1, digitsBegin + point, length - point);
+         out += length + 1;
+      }
+   }
+   else
+   {
+      *out++ = *digitsBegin;
+      if (length > 1)
+      {
+         *out++ = '.';
+         std::memcpy(out, digitsBegin + 1, length - 1);
+         out += length - 1;
+      }
+      *out++ = 'e';
+      *out++ = point > 0 ? '+' : '-';
+      char exponent[4];
+      char* exponentBegin = writeDigitsBackwards(
+            point > 0 ? point - 1 : 1 - point, exponent + 4);
+      std::memcpy(out, exponentBegin, exponent + 4 - exponentBegin);
+      out += exponent + 4 - exponentBegin;
+   }
+   return out - buffer;
+}
+
+String
+Float::toString(double value)
+{
+   char buffer[FORMAT_LENGTH];
+   return String(buffer, format(value, buffer));
+}
+
 }; // namespace karen
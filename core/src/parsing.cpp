@@ -24,41 +24,373 @@
 
 #include "KarenCore/parsing.h"
 
+#include <cstring>
+
+#ifdef KAREN_SIMD_X86
+#include <immintrin.h>
+#endif
+
 namespace karen {
 
-void
-tokenizeString(
-      const String& str, 
-      Array<String>& tokens,
-      char separator)
+namespace {
+
+const unsigned long BLOCK_SIZE = 64;
+
+inline unsigned long
+countTrailingZeros(unsigned long long mask)
+{
+#if KAREN_COMPILER == KAREN_COMPILER_GCC || \
+    KAREN_COMPILER == KAREN_COMPILER_CLANG
+   return __builtin_ctzll(mask);
+#else
+   unsigned long n = 0;
+   while (!(mask & 1))
+   {
+      mask >>= 1;
+      n++;
+   }
+   return n;
+#endif
+}
+
+}; // anonymous namespace
+
+/*
+ * Kernels that classify a block of 64 bytes, returning a mask whose bit i
+ * is set if the byte i of the block is a separator. 
+ */
+struct TokenizerKernels
+{
+   static unsigned long long
+   classifyScalar(const Tokenizer& tokenizer, const char* block)
+   {
+      unsigned long long mask = 0;
+      for (unsigned long i = 0; i < BLOCK_SIZE; i++)
+         if (tokenizer._isSeparator[(unsigned char) block[i]])
+            mask |= 1ULL << i;
+      return mask;
+   }
+
+#ifdef KAREN_SIMD_X86
+   __attribute__((target("sse2")))
+   static unsigned long long
+   classifySse2(const Tokenizer& tokenizer, const char* block)
+   {
+      unsigned long long mask = 0;
+      for (unsigned long i = 0; i < BLOCK_SIZE; i += 16)
+      {
+         __m128i bytes = _mm_loadu_si128((const __m128i*) (block + i));
+         __m128i matches = _mm_setzero_si128();
+         for (unsigned j = 0; j < tokenizer._separatorCount; j++)
+            matches = _mm_or_si128(matches, _mm_cmpeq_epi8(
+                  bytes, _mm_set1_epi8(tokenizer._separators[j])));
+         mask |= (unsigned long long) 
+               (unsigned) _mm_movemask_epi8(matches) << i;
+      }
+      return mask;
+   }
+
+   __attribute__((target("avx2")))
+   static unsigned long long
+   classifyAvx2(const Tokenizer& tokenizer, const char* block)
+   {
+      unsigned long long mask = 0;
+      for (unsigned long i = 0; i < BLOCK_SIZE; i += 32)
+      {
+         __m256i bytes = _mm256_loadu_si256((const __m256i*) (block + i));
+         __m256i matches = _mm256_setzero_si256();
+         for (unsigned j = 0; j < tokenizer._separatorCount; j++)
+            matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(
+                  bytes, _mm256_set1_epi8(tokenizer._separators[j])));
+         mask |= (unsigned long long) 
+               (unsigned) _mm256_movemask_epi8(matches) << i;
+      }
+      return mask;
+   }
+#endif
+};
+
+Tokenizer::Tokenizer(const StringView& separators, char quote, bool skipEmpty)
+ : _separatorCount(0), _quote(quote), _filler(0), _skipEmpty(skipEmpty),
+   _classify(&TokenizerKernels::classifyScalar)
+{
+   std::memset(_isSeparator, 0, sizeof(_isSeparator));
+   for (const char c : separators)
+   {
+      if (_isSeparator[(unsigned char) c])
+         continue;
+      _isSeparator[(unsigned char) c] = true;
+      if (_separatorCount < MAX_VECTOR_SEPARATORS)
+         _separators[_separatorCount] = c;
+      _separatorCount++;
+   }
+
+   // Pad incomplete blocks with a byte that is not a separator
+   while (_isSeparator[(unsigned char) _filler] && 
+          (unsigned char) _filler < 255)
+      _filler++;
+
+#ifdef KAREN_SIMD_X86
+   if (_separatorCount <= MAX_VECTOR_SEPARATORS)
+   {
+      SimdLevel level = simdLevel();
+      if (level >= SIMD_AVX2)
+         _classify = &TokenizerKernels::classifyAvx2;
+      else if (level >= SIMD_SSE2)
+         _classify = &TokenizerKernels::classifySse2;
+   }
+#endif
+}
+
+Tokenizer::TokenIterator
+Tokenizer::begin(const StringView& input) const
+{
+   return TokenIterator(*this, input);
+}
+
+unsigned long
+Tokenizer::tokenize(const StringView& input, Array<StringView>& tokens) const
 {
    tokens.clear();
-   if (!str.isEmpty())
-   {
-      const char *p = str, *b;
-      int c;
-      while (p && (*p != '\0'))
-      {      
-         // Ignore leading separators.
-         while (*p == separator)
-            p++;
-         
-         // Read characters until end of word
-         b = p;
-         c = 0;
-         while (*p != separator && *p != '\0')
+   for (TokenIterator it = begin(input); !it.isNull(); ++it)
+      tokens.append(*it);
+   return tokens.size();
+}
+
+unsigned long
+Tokenizer::tokenize(
+      const StringView& input,
+      TokenSpan* spans,
+      unsigned long maxSpans) const
+{
+   unsigned long offset = 0;
+   return tokenize(input, spans, maxSpans, offset);
+}
+
+unsigned long
+Tokenizer::tokenize(
+      const StringView& input,
+      TokenSpan* spans,
+      unsigned long maxSpans,
+      unsigned long& offset) const
+{
+   unsigned long count = 0, length = input.length();
+   if (!maxSpans || offset > length)
+      return 0;
+   if (_skipEmpty && !_quote)
+   {
+      // Separators are collapsed, so the rest is tokenized on its own
+      count = tokenizeBlocks(
+            StringView(input.data() + offset, length - offset), 
+            spans, maxSpans);
+      for (unsigned long i = 0; i < count; i++)
+         spans[i].offset += offset;
+      offset = (count == maxSpans) ? 
+            spans[count - 1].offset + spans[count - 1].length + 1 : 
+            length + 1;
+      return count;
+   }
+
+   TokenIterator it(*this, input, offset);
+   for (; !it.isNull(); ++it)
+   {
+      spans[count].offset = it->data() - input.data();
+      spans[count].length = it->length();
+      if (++count == maxSpans)
+         break;
+   }
+   // The iterator position is past the end of the last token
+   offset = it.isNull() ? length + 1 : it._pos;
+   return count;
+}
+
+unsigned long
+Tokenizer::tokenizeBlocks(
+      const StringView& input,
+      TokenSpan* spans,
+      unsigned long maxSpans) const
+{
+   const char* data = input.data();
+   unsigned long length = input.length(), count = 0, tokenStart = 0;
+   unsigned long long previousSeparator = 1;
+   bool open = false;
+   for (unsigned long blockStart = 0; blockStart < length; 
+        blockStart += BLOCK_SIZE)
+   {
+      unsigned long long separators;
+      if (blockStart + BLOCK_SIZE <= length)
+         separators = _classify(*this, data + blockStart);
+      else
+      {
+         // The bytes beyond the input are taken as separators
+         char block[BLOCK_SIZE];
+         std::memset(block, _filler, BLOCK_SIZE);
+         std::memcpy(block, data + blockStart, length - blockStart);
+         separators = _classify(*this, block) | 
+               (~0ULL << (length - blockStart));
+      }
+
+      // Tokens start after a separator and end before one
+      unsigned long long shifted = (separators << 1) | previousSeparator;
+      unsigned long long starts = ~separators & shifted;
+      unsigned long long ends = separators & ~shifted;
+      previousSeparator = separators >> (BLOCK_SIZE - 1);
+      for (;;)
+      {
+         if (!open)
          {
-            c++;
-            p++;
+            if (!starts)
+               break;
+            tokenStart = blockStart + countTrailingZeros(starts);
+            starts &= starts - 1;
+            open = true;
          }
+         else
+         {
+            if (!ends)
+               break;
+            unsigned long end = blockStart + countTrailingZeros(ends);
+            ends &= ends - 1;
+            spans[count].offset = tokenStart;
+            spans[count].length = end - tokenStart;
+            open = false;
+            if (++count == maxSpans)
+               return count;
+         }
+      }
+   }
+   if (open)
+   {
+      spans[count].offset = tokenStart;
+      spans[count].length = length - tokenStart;
+      count++;
+   }
+   return count;
+}
+
+Tokenizer::TokenIterator::TokenIterator(
+      const Tokenizer& tokenizer,
+      const StringView& input,
+      unsigned long pos)
+ : _tokenizer(&tokenizer), _input(input.data()), _length(input.length()),
+   _pos(pos), _blockStart(0), _separatorMask(0), 
+   _finished(!_length || pos > _length)
+{
+   if (!_finished)
+   {
+      loadBlock(pos);
+      advance();
+   }
+}
 
-         // Ignore rest of spaces.
-         while (p && (*p == separator))
-            p++;
+void
+Tokenizer::TokenIterator::advance()
+{
+   unsigned long start = _tokenizer->_skipEmpty ? 
+         nextNonSeparator(_pos) : _pos;
+   if (start > _length || (_tokenizer->_skipEmpty && start == _length))
+   {
+      _finished = true;
+      return;
+   }
 
-         tokens.append(String(b, c));
+   unsigned long end;
+   char quote = _tokenizer->_quote;
+   if (quote && start < _length && _input[start] == quote)
+   {
+      const char* close = std::char_traits<char>::find(
+            _input + start + 1, _length - start - 1, quote);
+      unsigned long closePos = close ? close - _input : _length;
+      _token = StringView(_input + start + 1, closePos - start - 1);
+      end = (closePos < _length) ? closePos + 1 : _length;
+      if (end < _length && 
+          !_tokenizer->_isSeparator[(unsigned char) _input[end]])
+      {
+         // Text following the closing quote starts a new token
+         _pos = end;
+         return;
       }
    }
+   else
+   {
+      end = nextSeparator(start);
+      _token = StringView(_input + start, end - start);
+   }
+
+   // Skip the separator that ends the token, if any
+   _pos = end + 1;
+}
+
+void
+Tokenizer::TokenIterator::loadBlock(unsigned long pos)
+{
+   _blockStart = pos & ~(BLOCK_SIZE - 1);
+   if (_blockStart + BLOCK_SIZE <= _length)
+      _separatorMask = _tokenizer->_classify(*_tokenizer, _input + _blockStart);
+   else
+   {
+      char block[BLOCK_SIZE];
+      std::memset(block, _tokenizer->_filler, BLOCK_SIZE);
+      std::memcpy(block, _input + _blockStart, _length - _blockStart);
+      _separatorMask = _tokenizer->_classify(*_tokenizer, block);
+   }
+}
+
+unsigned long
+Tokenizer::TokenIterator::nextSeparator(unsigned long pos)
+{
+   while (pos < _length)
+   {
+      if (pos - _blockStart >= BLOCK_SIZE)
+         loadBlock(pos);
+      unsigned long long mask = 
+            _separatorMask & (~0ULL << (pos - _blockStart));
+      if (mask)
+         return _blockStart + countTrailingZeros(mask);
+      pos = _blockStart + BLOCK_SIZE;
+   }
+   return _length;
+}
+
+unsigned long
+Tokenizer::TokenIterator::nextNonSeparator(unsigned long pos)
+{
+   while (pos < _length)
+   {
+      if (pos - _blockStart >= BLOCK_SIZE)
+         loadBlock(pos);
+      unsigned long long mask = 
+            ~_separatorMask & (~0ULL << (pos - _blockStart));
+      if (mask)
+      {
+         unsigned long next = _blockStart + countTrailingZeros(mask);
+         return (next < _length) ? next : _length;
+      }
+      pos = _blockStart + BLOCK_SIZE;
+   }
+   return _length;
+}
+
+void
+tokenizeString(
+      const String& str, 
+      Array<String>& tokens,
+      char separator)
+{
+   Tokenizer tokenizer(StringView(&separator, 1));
+   tokens.clear();
+   for (const StringView& token : tokenizer.tokens(str))
+      tokens.append(String(token));
+}
+
+void
+tokenizeString(
+      const StringView& str, 
+      Array<StringView>& tokens,
+      char separator)
+{
+   Tokenizer tokenizer(StringView(&separator, 1));
+   tokenizer.tokenize(str, tokens);
 }
 
 }; // namespace karen
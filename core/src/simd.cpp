@@ -0,0 +1,318 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include "KarenCore/simd.h"
+
+#include <atomic>
+#include <cstring>
+
+#ifdef KAREN_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace karen {
+
+namespace {
+
+SimdLevel
+probeSimdLevel()
+{
+#ifdef KAREN_SIMD_X86
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+      return SIMD_AVX2;
+   if (__builtin_cpu_supports("sse2"))
+      return SIMD_SSE2;
+#endif
+   return SIMD_SCALAR;
+}
+
+std::atomic<int>&
+activeSimdLevel()
+{
+   static std::atomic<int> level(detectSimdLevel());
+   return level;
+}
+
+const char*
+findLastByteScalar(const char* str, unsigned long len, char c)
+{
+   while (len--)
+      if (str[len] == c)
+         return str + len;
+   return NULL;
+}
+
+const char*
+findBytesScalar(
+      const char* str, unsigned long len, 
+      const char* pattern, unsigned long patternLen)
+{
+   if (patternLen > len)
+      return NULL;
+   const char* end = str + len - patternLen + 1;
+   for (const char* p = str; p < end; p++)
+   {
+      p = static_cast<const char*>(std::memchr(p, pattern[0], end - p));
+      if (!p)
+         return NULL;
+      if (!std::memcmp(p + 1, pattern + 1, patternLen - 1))
+         return p;
+   }
+   return NULL;
+}
+
+inline void
+convertCaseScalar(char* dst, const char* src, unsigned long len, 
+                  char first, char last)
+{
+   for (unsigned long i = 0; i < len; i++)
+   {
+      char c = src[i];
+      dst[i] = (c >= first && c <= last) ? c ^ 0x20 : c;
+   }
+}
+
+#ifdef KAREN_SIMD_X86
+
+inline unsigned long
+highestBit(unsigned mask)
+{ return 31 - __builtin_clz(mask); }
+
+__attribute__((target("sse2")))
+const char*
+findLastByteSse2(const char* str, unsigned long len, char c)
+{
+   __m128i needle = _mm_set1_epi8(c);
+   while (len >= 16)
+   {
+      len -= 16;
+      unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(needle,
+            _mm_loadu_si128((const __m128i*) (str + len))));
+      if (mask)
+         return str + len + highestBit(mask);
+   }
+   return findLastByteScalar(str, len, c);
+}
+
+__attribute__((target("avx2")))
+const char*
+findLastByteAvx2(const char* str, unsigned long len, char c)
+{
+   __m256i needle = _mm256_set1_epi8(c);
+   while (len >= 32)
+   {
+      len -= 32;
+      unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(needle,
+            _mm256_loadu_si256((const __m256i*) (str + len))));
+      if (mask)
+         return str + len + highestBit(mask);
+   }
+   return findLastByteSse2(str, len, c);
+}
+
+/*
+ * Substring search filtering the candidate positions by their first and
+ * last bytes, so the pattern is only compared where both match. 
+ */
+__attribute__((target("sse2")))
+const char*
+findBytesSse2(
+      const char* str, unsigned long len, 
+      const char* pattern, unsigned long patternLen)
+{
+   __m128i first = _mm_set1_epi8(pattern[0]);
+   __m128i last = _mm_set1_epi8(pattern[patternLen - 1]);
+   unsigned long i = 0;
+   for (; i + patternLen - 1 + 16 <= len; i += 16)
+   {
+      __m128i head = _mm_loadu_si128((const __m128i*) (str + i));
+      __m128i tail = _mm_loadu_si128(
+            (const __m128i*) (str + i + patternLen - 1));
+      unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+      while (mask)
+      {
+         unsigned long pos = i + __builtin_ctz(mask);
+         if (!std::memcmp(str + pos + 1, pattern + 1, patternLen - 2))
+            return str + pos;
+         mask &= mask - 1;
+      }
+   }
+   return findBytesScalar(str + i, len - i, pattern, patternLen);
+}
+
+__attribute__((target("avx2")))
+const char*
+findBytesAvx2(
+      const char* str, unsigned long len, 
+      const char* pattern, unsigned long patternLen)
+{
+   __m256i first = _mm256_set1_epi8(pattern[0]);
+   __m256i last = _mm256_set1_epi8(pattern[patternLen - 1]);
+   unsigned long i = 0;
+   for (; i + patternLen - 1 + 32 <= len; i += 32)
+   {
+      __m256i head = _mm256_loadu_si256((const __m256i*) (str + i));
+      __m256i tail = _mm256_loadu_si256(
+            (const __m256i*) (str + i + patternLen - 1));
+      unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+      while (mask)
+      {
+         unsigned long pos = i + __builtin_ctz(mask);
+         if (!std::memcmp(str + pos + 1, pattern + 1, patternLen - 2))
+            return str + pos;
+         mask &= mask - 1;
+      }
+   }
+   return findBytesSse2(str + i, len - i, pattern, patternLen);
+}
+
+__attribute__((target("sse2")))
+void
+convertCaseSse2(char* dst, const char* src, unsigned long len, 
+                char first, char last)
+{
+   __m128i below = _mm_set1_epi8(first - 1);
+   __m128i above = _mm_set1_epi8(last + 1);
+   __m128i flip = _mm_set1_epi8(0x20);
+   unsigned long i = 0;
+   for (; i + 16 <= len; i += 16)
+   {
+      __m128i bytes = _mm_loadu_si128((const __m128i*) (src + i));
+      __m128i letters = _mm_and_si128(
+            _mm_cmpgt_epi8(bytes, below), _mm_cmplt_epi8(bytes, above));
+      _mm_storeu_si128((__m128i*) (dst + i), 
+            _mm_xor_si128(bytes, _mm_and_si128(letters, flip)));
+   }
+   convertCaseScalar(dst + i, src + i, len - i, first, last);
+}
+
+__attribute__((target("avx2")))
+void
+convertCaseAvx2(char* dst, const char* src, unsigned long len, 
+                char first, char last)
+{
+   __m256i below = _mm256_set1_epi8(first - 1);
+   __m256i above = _mm256_set1_epi8(last + 1);
+   __m256i flip = _mm256_set1_epi8(0x20);
+   unsigned long i = 0;
+   for (; i + 32 <= len; i += 32)
+   {
+      __m256i bytes = _mm256_loadu_si256((const __m256i*) (src + i));
+      __m256i letters = _mm256_and_si256(
+            _mm256_cmpgt_epi8(bytes, below), _mm256_cmpgt_epi8(above, bytes));
+      _mm256_storeu_si256((__m256i*) (dst + i), 
+            _mm256_xor_si256(bytes, _mm256_and_si256(letters, flip)));
+   }
+   convertCaseSse2(dst + i, src + i, len - i, first, last);
+}
+
+#endif
+
+void
+convertCase(char* dst, const char* src, unsigned long len, 
+            char first, char last)
+{
+#ifdef KAREN_SIMD_X86
+   SimdLevel level = simdLevel();
+   if (level >= SIMD_AVX2)
+      return convertCaseAvx2(dst, src, len, first, last);
+   if (level >= SIMD_SSE2)
+      return convertCaseSse2(dst, src, len, first, last);
+#endif
+   convertCaseScalar(dst, src, len, first, last);
+}
+
+}; // anonymous namespace
+
+SimdLevel
+detectSimdLevel()
+{
+   static const SimdLevel level = probeSimdLevel();
+   return level;
+}
+
+SimdLevel
+simdLevel()
+{
+   return SimdLevel(activeSimdLevel().load(std::memory_order_relaxed));
+}
+
+void
+setSimdLevel(SimdLevel level)
+{
+   if (level > detectSimdLevel())
+      level = detectSimdLevel();
+   activeSimdLevel().store(level, std::memory_order_relaxed);
+}
+
+const char*
+simdFindLastByte(const char* str, unsigned long len, char c)
+{
+#ifdef KAREN_SIMD_X86
+   SimdLevel level = simdLevel();
+   if (level >= SIMD_AVX2)
+      return findLastByteAvx2(str, len, c);
+   if (level >= SIMD_SSE2)
+      return findLastByteSse2(str, len, c);
+#endif
+   return findLastByteScalar(str, len, c);
+}
+
+const char*
+simdFindBytes(
+      const char* str, unsigned long len, 
+      const char* pattern, unsigned long patternLen)
+{
+   if (!patternLen)
+      return str;
+   if (patternLen > len)
+      return NULL;
+   if (patternLen == 1)
+      return static_cast<const char*>(std::memchr(str, pattern[0], len));
+#ifdef KAREN_SIMD_X86
+   SimdLevel level = simdLevel();
+   if (level >= SIMD_AVX2)
+      return findBytesAvx2(str, len, pattern, patternLen);
+   if (level >= SIMD_SSE2)
+      return findBytesSse2(str, len, pattern, patternLen);
+#endif
+   return findBytesScalar(str, len, pattern, patternLen);
+}
+
+void
+simdToLowerCase(char* dst, const char* src, unsigned long len)
+{
+   convertCase(dst, src, len, 'A', 'Z');
+}
+
+void
+simdToUpperCase(char* dst, const char* src, unsigned long len)
+{
+   convertCase(dst, src, len, 'a', 'z');
+}
+
+}; // namespace karen
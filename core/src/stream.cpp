@@ -0,0 +1,226 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <cstring>
+
+#include "KarenCore/stream.h"
+
+namespace karen {
+
+unsigned long
+InputStream::skip(unsigned long len)
+throw (IOException)
+{
+   UInt8 discard[512];
+   unsigned long left = len, nread = 1;
+   while (left && nread)
+   {
+      nread = readBytes(discard, left < sizeof(discard) ? left : sizeof(discard));
+      left -= nread;
+   }
+   return len - left;
+}
+
+unsigned long
+InputStream::readFully(void* dst, unsigned long len)
+throw (IOException)
+{
+   UInt8* ptr = (UInt8*) dst;
+   unsigned long left = len, nread;
+   while (left && (nread = readBytes(ptr, left)))
+   {
+      ptr += nread;
+      left -= nread;
+   }
+   return len - left;
+}
+
+unsigned long
+OutputStream::writeFully(const void* data, unsigned long len)
+throw (IOException)
+{
+   const UInt8* ptr = (const UInt8*) data;
+   unsigned long left = len, nwrite;
+   while (left && (nwrite = writeBytes(ptr, left)))
+   {
+      ptr += nwrite;
+      left -= nwrite;
+   }
+   return len - left;
+}
+
+BufferedInputStream::BufferedInputStream(
+      InputStream* source, 
+      unsigned long bufferSize)
+ : _source(source), 
+   _data(new UInt8[bufferSize ? bufferSize : 1]), 
+   _capacity(bufferSize ? bufferSize : 1),
+   _begin(0), 
+   _end(0)
+{
+}
+
+BufferedInputStream::~BufferedInputStream()
+{ delete [] _data; }
+
+unsigned long
+BufferedInputStream::peekBytes(void* dst, unsigned long len)
+throw (IOException, InvalidInputException)
+{
+   if (len > _capacity)
+      KAREN_THROW(InvalidInputException, 
+         "cannot peek %d bytes from stream: buffer size is %d", 
+         len, _capacity);
+   fill(len);
+   unsigned long available = bytesBuffered();
+   if (len > available)
+      len = available;
+   memcpy(dst, _data + _begin, len);
+   return len;
+}
+
+unsigned long
+BufferedInputStream::readBytes(void* dst, unsigned long len)
+throw (IOException)
+{
+   if (_begin == _end)
+   {
+      // Reads as large as the buffer gain nothing from copying through it.
+      if (len >= _capacity)
+         return _source->readBytes(dst, len);
+      if (!fill(1))
+         return 0;
+   }
+   unsigned long available = bytesBuffered();
+   if (len > available)
+      len = available;
+   memcpy(dst, _data + _begin, len);
+   _begin += len;
+   return len;
+}
+
+unsigned long
+BufferedInputStream::skip(unsigned long len)
+throw (IOException)
+{
+   unsigned long available = bytesBuffered();
+   if (len <= available)
+   {
+      _begin += len;
+      return len;
+   }
+   _begin = _end = 0;
+   return available + _source->skip(len - available);
+}
+
+bool
+BufferedInputStream::fill(unsigned long len)
+throw (IOException)
+{
+   if (bytesBuffered() >= len)
+      return true;
+   if (_begin)
+   {
+      memmove(_data, _data + _begin, _end - _begin);
+      _end -= _begin;
+      _begin = 0;
+   }
+   while (_end < len)
+   {
+      unsigned long nread = _source->readBytes(_data + _end, _capacity - _end);
+      if (!nread)
+         return false;
+      _end += nread;
+   }
+   return true;
+}
+
+BufferedOutputStream::BufferedOutputStream(
+      OutputStream* target,
+      unsigned long bufferSize)
+ : _target(target),
+   _data(new UInt8[bufferSize ? bufferSize : 1]), 
+   _capacity(bufferSize ? bufferSize : 1),
+   _length(0)
+{
+}
+
+BufferedOutputStream::~BufferedOutputStream()
+{
+   try
+   {
+      drain();
+   }
+   catch (IOException&)
+   {
+      // Destructors cannot report errors; flush() must be used for that.
+   }
+   delete [] _data;
+}
+
+unsigned long
+BufferedOutputStream::writeBytes(const void* data, unsigned long len)
+throw (IOException)
+{
+   if (len > _capacity - _length)
+   {
+      drain();
+      // Writes as large as the buffer gain nothing from copying through it.
+      if (len >= _capacity)
+         return _target->writeBytes(data, len);
+   }
+   memcpy(_data + _length, data, len);
+   _length += len;
+   return len;
+}
+
+void
+BufferedOutputStream::flush()
+throw (IOException)
+{
+   drain();
+   _target->flush();
+}
+
+void
+BufferedOutputStream::drain()
+throw (IOException)
+{
+   unsigned long written = 0, nwrite = 1;
+   while (written < _length && nwrite)
+   {
+      nwrite = _target->writeBytes(_data + written, _length - written);
+      written += nwrite;
+   }
+   if (written < _length)
+   {
+      memmove(_data, _data + written, _length - written);
+      _length -= written;
+      KAREN_THROW(IOException, 
+         "cannot flush buffered stream: no more space left in device");
+   }
+   _length = 0;
+}
+
+}; // namespace karen
@@ -31,8 +31,7 @@ namespace karen {
 void
 Test::assertionFailed(const String& cause)
 {
-   KAREN_THROW(::karen::InvalidAssertionException,
-         (const char*) cause);
+   KAREN_THROW(::karen::InvalidAssertionException, "%s", cause);
 }
 
 UnitTest::UnitTest(const String& name) : _name(name), _nextTest(0) {}
@@ -84,16 +83,22 @@ UnitTest::run(
       catch (Exception& e)
       {
          if (reporter)
-            reporter->endUnitTest(TEST_RESULT_FAILED, String::format(
-                  "unexpected exception: %s", (const char*) e.cause()));
+         {
+            StringBuilder cause;
+            KAREN_FORMAT(cause, "unexpected exception: %s", e.cause());
+            reporter->endUnitTest(TEST_RESULT_FAILED, cause.toString());
+         }
          if (testResults)
             testResults[i].status = TEST_RESULT_FAILED;
       }
       catch (std::exception& e)
       {
          if (reporter)
-            reporter->endUnitTest(TEST_RESULT_FAILED, String::format(
-                  "unexpected exception: %s", e.what()));
+         {
+            StringBuilder cause;
+            KAREN_FORMAT(cause, "unexpected exception: %s", e.what());
+            reporter->endUnitTest(TEST_RESULT_FAILED, cause.toString());
+         }
          if (testResults)
             testResults[i].status = TEST_RESULT_FAILED;
       }
@@ -122,9 +127,9 @@ void
 StdOutUnitTestReporter::beginUnitTestSuite(
       const String& suiteName)
 { 
-   std::cerr << 
-      String::format("Running test suite %s", (const char*) suiteName) << 
-      std::endl;
+   StringBuilder line;
+   KAREN_FORMAT(line, "Running test suite %s", suiteName);
+   std::cerr << line.data() << std::endl;
 }
 
 void
@@ -132,15 +137,19 @@ StdOutUnitTestReporter::endUnitTestSuite(
       unsigned int success, 
       unsigned int tests)
 { 
-   std::cerr << 
-      String::format("Test suite done (passed %i of %i)", success, tests) <<
-      std::endl;
+   StringBuilder line;
+   KAREN_FORMAT(line, "Test suite done (passed %u of %u)", success, tests);
+   std::cerr << line.data() << std::endl;
 }
    
 void
 StdOutUnitTestReporter::beginUnitTest(
       const String& testName)
-{ std::cerr << String::format("   Testing %s... ", (const char*) testName); }
+{
+   StringBuilder line;
+   KAREN_FORMAT(line, "   Testing %s... ", testName);
+   std::cerr << line.data();
+}
 
 void
 StdOutUnitTestReporter::endUnitTest(
@@ -157,7 +166,7 @@ StdOutUnitTestReporter::endUnitTest(
          std::cerr << "FAILED"; break;
    }
    if (!info.isNull())
-      std::cerr << String::format(": %s", (const char*) (const String&) info);
+      std::cerr << ": " << (const char*) (const String&) info;
    std::cerr << std::endl;
 }
 
@@ -131,7 +131,7 @@ public:
 
    inline virtual bool isRunning() const
    {
-      return (_startTime.tv_sec && _startTime.tv_usec);
+      return (_startTime.tv_sec || _startTime.tv_usec);
    }
    
 private:
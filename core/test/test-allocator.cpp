@@ -0,0 +1,257 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <KarenCore/allocator.h>
+#include <KarenCore/array.h>
+#include <KarenCore/list.h>
+#include <KarenCore/map.h>
+#include <KarenCore/set.h>
+#include <KarenCore/test.h>
+
+using namespace karen;
+
+typedef Tuple<const int, int> IntEntry;
+
+static bool
+isAligned(const void* p, unsigned long alignment)
+{ return reinterpret_cast<std::uintptr_t>(p) % alignment == 0; }
+
+KAREN_BEGIN_UNIT_TEST(PoolAllocatorTestSuite);
+
+   KAREN_DECL_TEST(reuseDeallocatedBlock,
+   {
+      PoolAllocator<long> alloc;
+      long* p = alloc.allocate(1);
+      *p = 7;
+      alloc.deallocate(p, 1);
+      long* q = alloc.allocate(1);
+      assertTrue(p == q);
+      assertTrue(isAligned(q, std::alignment_of<long>::value));
+      alloc.deallocate(q, 1);
+   });
+
+   KAREN_DECL_TEST(allocateSeveralObjects,
+   {
+      PoolAllocator<int> alloc;
+      int* p = alloc.allocate(100);
+      for (int i = 0; i < 100; i++)
+         p[i] = i;
+      assertEquals(99, p[99]);
+      alloc.deallocate(p, 100);
+   });
+
+   KAREN_DECL_TEST(allocateMoreThanCacheCapacity,
+   {
+      PoolAllocator<double> alloc;
+      std::vector<double*> blocks;
+      for (int i = 0; i < 2000; i++)
+      {
+         blocks.push_back(alloc.allocate(1));
+         *blocks.back() = i;
+      }
+      for (int i = 0; i < 2000; i++)
+         assertEquals(i, (int) *blocks[i]);
+      for (int i = 0; i < 2000; i++)
+         alloc.deallocate(blocks[i], 1);
+   });
+
+   KAREN_DECL_TEST(useWithLinkedList,
+   {
+      LinkedList<int, PoolAllocator<int> > l;
+      for (int i = 0; i < 1000; i++)
+         l.insertBack(i);
+      l.removeFirst();
+      l.removeLast();
+      assertEquals<int>(998, l.size());
+      assertEquals(1, l.first());
+      assertEquals(998, l.last());
+   });
+
+   KAREN_DECL_TEST(useWithTreeMap,
+   {
+      TreeMap<int, int, PoolAllocator<IntEntry> > m;
+      for (int i = 0; i < 1000; i++)
+         m.put(i, i * 2);
+      for (int i = 0; i < 1000; i += 2)
+         m.remove(i);
+      assertEquals<int>(500, m.size());
+      assertEquals(14, m.get(7));
+      assertFalse(m.hasKey(8));
+   });
+
+   KAREN_DECL_TEST(useWithSets,
+   {
+      TreeSet<int, DefaultLessThan<int>, PoolAllocator<int> > s;
+      TreeMultiset<int, DefaultLessThan<int>, PoolAllocator<int> > ms;
+      for (int i = 0; i < 100; i++)
+      {
+         s.insert(i % 10);
+         ms.insert(i % 10);
+      }
+      assertEquals<int>(10, s.size());
+      assertEquals<int>(100, ms.size());
+      assertEquals(9, ms.takeLast());
+   });
+
+   KAREN_DECL_TEST(deallocateFromOtherThread,
+   {
+      std::vector<int*> blocks(5000);
+      std::thread producer([&blocks]()
+      {
+         PoolAllocator<int> alloc;
+         for (unsigned int i = 0; i < blocks.size(); i++)
+         {
+            blocks[i] = alloc.allocate(1);
+            *blocks[i] = i;
+         }
+      });
+      producer.join();
+      int errors = 0;
+      std::thread consumer([&blocks, &errors]()
+      {
+         PoolAllocator<int> alloc;
+         for (unsigned int i = 0; i < blocks.size(); i++)
+         {
+            if (*blocks[i] != (int) i)
+               errors++;
+            alloc.deallocate(blocks[i], 1);
+         }
+      });
+      consumer.join();
+      assertEquals(0, errors);
+   });
+
+   KAREN_DECL_TEST(allocateFromManyThreads,
+   {
+      std::vector<std::thread> threads;
+      std::vector<int> errors(4, 0);
+      for (int t = 0; t < 4; t++)
+         threads.push_back(std::thread([t, &errors]()
+         {
+            for (int round = 0; round < 20; round++)
+            {
+               LinkedList<int, PoolAllocator<int> > l;
+               for (int i = 0; i < 1000; i++)
+                  l.insertBack(t * 1000 + i);
+               int expected = t * 1000;
+               for (auto it = l.fastBegin(); it != l.fastEnd(); ++it)
+                  if (*it != expected++)
+                     errors[t]++;
+            }
+         }));
+      for (auto& t : threads)
+         t.join();
+      for (int t = 0; t < 4; t++)
+         assertEquals(0, errors[t]);
+   });
+
+KAREN_END_UNIT_TEST(PoolAllocatorTestSuite);
+
+KAREN_BEGIN_UNIT_TEST(ArenaTestSuite);
+
+   KAREN_DECL_TEST(allocateAlignedBlocks,
+   {
+      Arena arena;
+      void* p1 = arena.allocate(1, 1);
+      void* p2 = arena.allocate(8, 8);
+      void* p3 = arena.allocate(3, 64);
+      void* p4 = arena.allocate(16);
+      assertTrue(p1 != p2);
+      assertTrue(isAligned(p2, 8));
+      assertTrue(isAligned(p3, 64));
+      assertTrue(isAligned(p4, std::alignment_of<std::max_align_t>::value));
+      assertEquals<int>(28, arena.allocatedBytes());
+   });
+
+   KAREN_DECL_TEST(allocateBeyondChunkSize,
+   {
+      Arena arena(256);
+      char* small = static_cast<char*>(arena.allocate(16));
+      char* large = static_cast<char*>(arena.allocate(4096));
+      for (int i = 0; i < 4096; i++)
+         large[i] = 'x';
+      char* next = static_cast<char*>(arena.allocate(16));
+      assertTrue(next == small + 16);
+      for (int i = 0; i < 100; i++)
+         arena.allocate(16);
+      assertEquals<int>(16 * 102 + 4096, arena.allocatedBytes());
+   });
+
+   KAREN_DECL_TEST(releaseArena,
+   {
+      Arena arena(1024);
+      for (int i = 0; i < 1000; i++)
+         arena.allocate(10);
+      arena.release();
+      assertEquals<int>(0, arena.allocatedBytes());
+      int* p = static_cast<int*>(arena.allocate(sizeof(int)));
+      *p = 3;
+      assertEquals(3, *p);
+   });
+
+   KAREN_DECL_TEST(useWithCollections,
+   {
+      Arena arena;
+      {
+         TreeMap<int, int, ArenaAllocator<IntEntry> > m(
+               new LessThan<int, int>(), ArenaAllocator<IntEntry>(arena));
+         DynArray<int, ArenaAllocator<int> > a((ArenaAllocator<int>(arena)));
+         LinkedList<int, ArenaAllocator<int> > l((ArenaAllocator<int>(arena)));
+         for (int i = 0; i < 100; i++)
+         {
+            m.put(i, -i);
+            a.append(i);
+            l.insertFront(i);
+         }
+         assertEquals(-42, m.get(42));
+         assertEquals(42, a.get(42));
+         assertEquals(99, l.first());
+      }
+      assertTrue(arena.allocatedBytes() > 100 * sizeof(IntEntry));
+   });
+
+   KAREN_DECL_TEST(compareArenaAllocators,
+   {
+      Arena a1, a2;
+      ArenaAllocator<int> alloc1(a1);
+      ArenaAllocator<long> alloc2(a1);
+      ArenaAllocator<int> alloc3(a2);
+      assertTrue(alloc1 == alloc2);
+      assertTrue(alloc1 != alloc3);
+   });
+
+KAREN_END_UNIT_TEST(ArenaTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   PoolAllocatorTestSuite poolSuite;
+   poolSuite.run(&rep, NULL, 0);
+   ArenaTestSuite arenaSuite;
+   arenaSuite.run(&rep, NULL, 0);
+}
@@ -26,6 +26,8 @@
 #include <KarenCore/parsing.h>
 #include <KarenCore/test.h>
 
+#include "test-tracked.h"
+
 using namespace karen;
 
 KAREN_BEGIN_UNIT_TEST(ArrayTestSuite);
@@ -94,6 +96,176 @@ KAREN_BEGIN_UNIT_TEST(ArrayTestSuite);
          assertEquals(*it, raw[i++]);
    });
 
+   KAREN_DECL_TEST(shouldReserveCapacity,
+   {
+      DynArray<int> a;
+      a.reserve(100);
+      assertTrue(a.capacity() >= 100);
+      assertEquals<int>(0, a.size());
+   });
+
+   KAREN_DECL_TEST(shouldCopyArray,
+   {
+      int raw[] = { 10, 11, 12, 13, 14, 15 };
+      DynArray<int> a(raw, 6);
+      DynArray<int> b(a);
+      b[0] = 20;
+      assertEquals<int>(6, b.size());
+      assertEquals(10, a[0]);
+      assertEquals(20, b[0]);
+   });
+
+   KAREN_DECL_TEST(shouldKeepSmallArrayInline,
+   {
+      SmallDynArray<int, 4> a;
+      for (int i = 0; i < 4; i++)
+         a.append(10 + i);
+      assertTrue(a.isInline());
+      assertEquals<int>(4, a.capacity());
+      for (int i = 0; i < 4; i++)
+         assertEquals(10 + i, a[i]);
+   });
+
+   KAREN_DECL_TEST(shouldSpillSmallArrayToHeap,
+   {
+      SmallDynArray<String, 2> a;
+      for (int i = 0; i < 10; i++)
+         a.append(String::format("%d", i));
+      assertFalse(a.isInline());
+      assertEquals<int>(10, a.size());
+      for (int i = 0; i < 10; i++)
+         assertEquals(String::format("%d", i), a[i]);
+      a.resize(2);
+      a.shrinkToFit();
+      assertTrue(a.isInline());
+      assertEquals(String("1"), a[1]);
+   });
+
+   KAREN_DECL_TEST(shouldAppendOwnElementToSmallArray,
+   {
+      SmallDynArray<String, 1> a;
+      a.append("foo");
+      a.append(a[0]);
+      assertEquals<int>(2, a.size());
+      assertEquals(String("foo"), a[1]);
+   });
+
+   KAREN_DECL_TEST(shouldCopySmallArray,
+   {
+      int raw[] = { 10, 11, 12, 13, 14, 15 };
+      SmallDynArray<int, 4> a(raw, 6);
+      SmallDynArray<int, 4> b(a);
+      SmallDynArray<int, 4> c;
+      c = b;
+      assertEquals<int>(6, c.size());
+      for (unsigned int i = 0; i < c.size(); i++)
+         assertEquals(raw[i], c[i]);
+   });
+
+   KAREN_DECL_TEST(shouldRemoveFromSmallArray,
+   {
+      int raw[] = { 10, 11, 12, 13, 14, 15 };
+      SmallDynArray<int, 8> a(raw, 6);
+      Iterator<int> it = a.begin();
+      it++;
+      a.remove(it);
+      assertEquals(12, *it);
+      Iterator<int> rit = a.rbegin();
+      a.remove(rit);
+      assertEquals(14, *rit);
+      assertEquals<int>(4, a.size());
+      int expected[] = { 10, 12, 13, 14 };
+      int i = 0;
+      for (Iterator<int> it = a.begin(), end = a.end(); it != end; it++)
+         assertEquals(expected[i++], *it);
+   });
+
+   KAREN_DECL_TEST(shouldNotIndexSmallArrayOutOfBounds,
+   {
+      SmallDynArray<int, 4> a(2);
+      try
+      {
+         a[2];
+         assertionFailed("expected exception not raised");
+      }
+      catch (OutOfBoundsException&) {}
+   });
+
+   KAREN_DECL_TEST(shouldMoveElementsWithoutCopying,
+   {
+      trackedCopies = 0;
+      DynArray<Tracked> a;
+      SmallDynArray<Tracked, 2> b;
+      for (int i = 0; i < 8; i++)
+      {
+         Tracked t(i);
+         a.append(std::move(t));
+         b.emplaceBack(i);
+      }
+      a.set(Tracked(20), 0);
+      b.set(Tracked(20), 0);
+      assertEquals(0, trackedCopies);
+      assertEquals(20, a[0].value);
+      assertEquals(20, b[0].value);
+      assertEquals(7, b[7].value);
+   });
+
+   KAREN_DECL_TEST(shouldMoveSmallArrayWithoutCopying,
+   {
+      trackedCopies = 0;
+      SmallDynArray<Tracked, 4> inl;
+      SmallDynArray<Tracked, 4> spilled;
+      for (int i = 0; i < 8; i++)
+      {
+         if (i < 3)
+            inl.emplaceBack(i);
+         spilled.emplaceBack(i);
+      }
+      const Tracked* block = &spilled[0];
+      SmallDynArray<Tracked, 4> a(std::move(inl));
+      SmallDynArray<Tracked, 4> b(std::move(spilled));
+      assertEquals(0, trackedCopies);
+      assertTrue(a.isInline());
+      assertEquals<int>(3, a.size());
+      assertEquals(2, a[2].value);
+      assertTrue(block == &b[0]);
+      assertEquals<int>(8, b.size());
+      assertTrue(inl.isInline() && inl.size() == 0);
+      assertTrue(spilled.isInline() && spilled.size() == 0);
+
+      b = std::move(a);
+      a = std::move(b);
+      assertEquals(0, trackedCopies);
+      assertEquals<int>(3, a.size());
+      assertEquals(1, a[1].value);
+      assertTrue(b.isInline() && b.size() == 0);
+   });
+
+   KAREN_DECL_TEST(shouldEmplaceBack,
+   {
+      DynArray<String> a;
+      a.emplaceBack("xxxyz", 3);
+      assertEquals<int>(1, a.size());
+      assertEquals(String("xxx"), a[0]);
+   });
+
+   KAREN_DECL_TEST(shouldTryGetWithoutThrowing,
+   {
+      int raw[] = { 10, 11, 12 };
+      DynArray<int> a(raw, 3);
+      SmallDynArray<int, 2> b;
+      b.append(20);
+      b.append(21);
+      b.append(22);
+      assertEquals(11, *a.tryGet(1));
+      assertTrue(a.tryGet(3) == NULL);
+      assertEquals(22, *b.tryGet(2));
+      assertTrue(b.tryGet(3) == NULL);
+      *b.tryGet(0) = 30;
+      const Array<int>& c = b;
+      assertEquals(30, *c.tryGet(0));
+   });
+
 #ifdef KAREN_CXX11_HAVE_RANGE_FOR
    KAREN_DECL_TEST(shouldIterateArrayUsingForRange,
    {
@@ -0,0 +1,132 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ---------------------------------------------------------------------
+ */
+
+#include <thread>
+#include <vector>
+
+#include <KarenCore/array.h>
+#include <KarenCore/atom.h>
+#include <KarenCore/hash.h>
+#include <KarenCore/map.h>
+#include <KarenCore/test.h>
+
+using namespace karen;
+
+KAREN_BEGIN_UNIT_TEST(AtomTestSuite);
+
+   KAREN_DECL_TEST(internEqualStrings,
+   {
+      Atom a("screen-width");
+      Atom b(String("screen-width").view());
+      Atom c("screen-height");
+      assertTrue(a == b);
+      assertTrue(a != c);
+      assertTrue(&a.str() == &b.str());
+      assertEquals(String("screen-width"), a.str());
+      assertEquals<int>(12, a.length());
+   });
+
+   KAREN_DECL_TEST(internEmptyString,
+   {
+      Atom empty;
+      assertTrue(empty == Atom(""));
+      assertTrue(empty != Atom("x"));
+      assertEquals<int>(0, empty.length());
+      assertEquals(String(""), empty.str());
+   });
+
+   KAREN_DECL_TEST(cacheStringHash,
+   {
+      Atom a("fullscreen");
+      assertTrue(a.hash() == DefaultHash<String>()(String("fullscreen")));
+      assertTrue(DefaultHash<Atom>()(a) == a.hash());
+   });
+
+   KAREN_DECL_TEST(orderByString,
+   {
+      Atom a("alpha");
+      Atom b("beta");
+      assertTrue(a < b);
+      assertFalse(b < a);
+      assertFalse(a < Atom("alpha"));
+   });
+
+   KAREN_DECL_TEST(useAtomsAsMapKeys,
+   {
+      AtomMap<int> map;
+      map.put(Atom("one"), 1);
+      map.put(Atom("two"), 2);
+      map[Atom("one")] = 11;
+      assertEquals<int>(2, map.size());
+      assertEquals<int>(11, map[Atom("one")]);
+      assertEquals<int>(2, map[Atom("two")]);
+      assertTrue(map.tryGet(Atom("three")) == NULL);
+   });
+
+   KAREN_DECL_TEST(countLookupsAndHits,
+   {
+      AtomStats before = Atom::stats();
+      Atom a("count-lookups-and-hits");
+      Atom b("count-lookups-and-hits");
+      AtomStats after = Atom::stats();
+      assertEquals<int>(before.size + 1, after.size);
+      assertEquals<int>(before.lookups + 2, after.lookups);
+      assertEquals<int>(before.hits + 1, after.hits);
+      assertTrue(after.hitRate() > 0.0 && after.hitRate() <= 1.0);
+      assertTrue(a == b);
+   });
+
+   KAREN_DECL_TEST(internFromManyThreads,
+   {
+      const int threadCount = 8;
+      const int atomCount = 500;
+      std::vector<DynArray<Atom>> atoms(threadCount);
+      std::vector<std::thread> threads;
+      for (int t = 0; t < threadCount; t++)
+      {
+         DynArray<Atom>* dest = &atoms[t];
+         threads.push_back(std::thread([dest, atomCount]()
+         {
+            for (int i = 0; i < atomCount; i++)
+               dest->append(Atom(String::format("thread-atom-%d", i)));
+         }));
+      }
+      for (auto& t : threads)
+         t.join();
+      bool same = true;
+      for (int t = 1; t < threadCount; t++)
+         for (int i = 0; i < atomCount; i++)
+            same = same && atoms[t][i] == atoms[0][i];
+      assertTrue(same);
+      assertTrue(atoms[0][42] == Atom("thread-atom-42"));
+   });
+
+KAREN_END_UNIT_TEST(AtomTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   AtomTestSuite suite;
+   suite.run(&rep, NULL, 0);
+}
@@ -0,0 +1,228 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <KarenCore/buffer-pool.h>
+#include <KarenCore/test.h>
+
+using namespace karen;
+
+static bool
+isAligned(const void* p, unsigned long alignment)
+{ return reinterpret_cast<std::uintptr_t>(p) % alignment == 0; }
+
+KAREN_BEGIN_UNIT_TEST(BufferPoolTestSuite);
+
+   KAREN_DECL_TEST(shouldRoundLengthsToSizeClasses,
+   {
+      assertEquals<unsigned long>(64, BufferPool::classLength(0));
+      assertEquals<unsigned long>(64, BufferPool::classLength(64));
+      assertEquals<unsigned long>(128, BufferPool::classLength(65));
+      assertEquals<unsigned long>(4096, BufferPool::classLength(4096));
+      assertEquals<unsigned long>(8192, BufferPool::classLength(5000));
+   });
+
+   KAREN_DECL_TEST(shouldFailWithInvalidSettings,
+   {
+      try
+      {
+         BufferPool pool(48);
+         assertionFailed("Expected InvalidInputException not thrown");
+      }
+      catch (InvalidInputException&) {}
+      try
+      {
+         BufferPool pool(64, 1000);
+         assertionFailed("Expected InvalidInputException not thrown");
+      }
+      catch (InvalidInputException&) {}
+      try
+      {
+         BufferPool pool(64, 32);
+         assertionFailed("Expected InvalidInputException not thrown");
+      }
+      catch (InvalidInputException&) {}
+   });
+
+   KAREN_DECL_TEST(shouldAlignMemory,
+   {
+      unsigned long alignments[] = { 
+         BufferPool::CACHE_LINE_ALIGNMENT, 
+         BufferPool::PAGE_ALIGNMENT, 
+         BufferPool::HUGE_PAGE_ALIGNMENT,
+      };
+      for (unsigned int i = 0; i < 3; i++)
+      {
+         BufferPool pool(alignments[i], 4 * 1024 * 1024);
+         void* small = pool.acquire(10);
+         void* large = pool.acquire(3 * 1024 * 1024);
+         void* unpooled = pool.acquire(5 * 1024 * 1024);
+         assertTrue(isAligned(small, alignments[i]));
+         assertTrue(isAligned(large, alignments[i]));
+         assertTrue(isAligned(unpooled, alignments[i]));
+         memset(large, 0xff, 3 * 1024 * 1024);
+         pool.release(small, 10);
+         pool.release(large, 3 * 1024 * 1024);
+         pool.release(unpooled, 5 * 1024 * 1024);
+      }
+   });
+
+   KAREN_DECL_TEST(shouldReuseReleasedMemory,
+   {
+      BufferPool pool;
+      void* p = pool.acquire(1000);
+      pool.release(p, 1000);
+      void* q = pool.acquire(900);
+      assertTrue(p == q);
+      void* r = pool.acquire(2000);
+      assertTrue(p != r);
+      BufferPoolStatistics stats = pool.statistics();
+      assertEquals<unsigned long>(1, stats.hits);
+      assertEquals<unsigned long>(2, stats.misses);
+      assertEquals<unsigned long>(1024 + 2048, stats.systemBytes);
+      pool.release(q, 900);
+      pool.release(r, 2000);
+   });
+
+   KAREN_DECL_TEST(shouldNotPoolLengthsAboveMaxClass,
+   {
+      BufferPool pool(64, 4096);
+      void* p = pool.acquire(10000);
+      assertEquals<unsigned long>(10000, pool.statistics().systemBytes);
+      pool.release(p, 10000);
+      assertEquals<unsigned long>(0, pool.statistics().systemBytes);
+      p = pool.acquire(10000);
+      pool.release(p, 10000);
+      assertEquals<unsigned long>(0, pool.statistics().hits);
+      assertEquals<unsigned long>(2, pool.statistics().misses);
+   });
+
+   KAREN_DECL_TEST(shouldTrimFreeMemory,
+   {
+      BufferPool pool;
+      std::vector<void*> blocks;
+      for (int i = 0; i < 500; i++)
+         blocks.push_back(pool.acquire(4096));
+      for (int i = 0; i < 500; i++)
+         pool.release(blocks[i], 4096);
+      assertEquals<unsigned long>(500 * 4096, pool.statistics().systemBytes);
+      pool.trim();
+      assertEquals<unsigned long>(0, pool.statistics().systemBytes);
+   });
+
+   KAREN_DECL_TEST(shouldReturnBufferMemoryToPool,
+   {
+      BufferPool pool(BufferPool::PAGE_ALIGNMENT);
+      void* data;
+      {
+         Buffer buf(pool, 3000);
+         assertTrue(buf.isBorrowed());
+         assertEquals<unsigned long>(3000, buf.length());
+         data = buf;
+         assertTrue(isAligned(data, BufferPool::PAGE_ALIGNMENT));
+         buf.set<UInt32>(0xcafe, 2996);
+         Buffer moved(std::move(buf));
+         assertEquals<UInt32>(0xcafe, moved.get<UInt32>(2996));
+      }
+      Buffer buf(pool, 2500);
+      assertTrue(data == (void*) buf);
+      assertEquals<unsigned long>(1, pool.statistics().hits);
+      assertEquals<unsigned long>(1, pool.statistics().misses);
+   });
+
+   KAREN_DECL_TEST(shouldExchangeBlocksBetweenThreads,
+   {
+      const unsigned int THREADS = 4;
+      const unsigned int BLOCKS = 300;
+      BufferPool pool;
+      std::vector<std::thread> threads;
+      for (unsigned int t = 0; t < THREADS; t++)
+         threads.push_back(std::thread([&pool, t]()
+         {
+            std::vector<void*> blocks;
+            for (unsigned int round = 0; round < 10; round++)
+            {
+               for (unsigned int i = 0; i < BLOCKS; i++)
+               {
+                  blocks.push_back(pool.acquire(256));
+                  memset(blocks.back(), t, 256);
+               }
+               for (unsigned int i = 0; i < BLOCKS; i++)
+                  pool.release(blocks[i], 256);
+               blocks.clear();
+            }
+         }));
+      for (auto& t : threads)
+         t.join();
+
+      // The caches of exited threads are flushed to the shared lists
+      BufferPoolStatistics stats = pool.statistics();
+      assertEquals<unsigned long>(
+            THREADS * BLOCKS * 10, stats.hits + stats.misses);
+      assertTrue(stats.misses < stats.hits);
+      void* p = pool.acquire(200);
+      assertEquals<unsigned long>(stats.hits + 1, pool.statistics().hits);
+      pool.release(p, 200);
+      pool.trim();
+      assertEquals<unsigned long>(0, pool.statistics().systemBytes);
+   });
+
+   KAREN_DECL_TEST(shouldDestroyPoolCachedByLiveThread,
+   {
+      std::atomic<int> step(0);
+      BufferPool* pool = new BufferPool();
+      std::thread thread([&step, pool]()
+      {
+         pool->release(pool->acquire(512), 512);
+         step = 1;
+         while (step != 2)
+            std::this_thread::yield();
+         // The cache of the destroyed pool is dropped to make room
+         for (int i = 0; i < 10; i++)
+         {
+            BufferPool other;
+            other.release(other.acquire(512), 512);
+         }
+      });
+      while (step != 1)
+         std::this_thread::yield();
+      delete pool;
+      step = 2;
+      thread.join();
+   });
+
+KAREN_END_UNIT_TEST(BufferPoolTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   BufferPoolTestSuite suite;
+   suite.run(&rep, NULL, 0);
+   return 0;
+}
@@ -228,6 +228,40 @@ KAREN_BEGIN_UNIT_TEST(BufferTestSuite);
       buf.markAsClean();
       assertFalse(buf.isDirty());
    });
+
+   KAREN_DECL_TEST(shouldViewBorrowedMemory,
+   {
+      UInt8 data[64] = { 0 };
+      {
+         Buffer buf(data, 64, NULL);
+         assertTrue(buf.isBorrowed());
+         buf.set<UInt8>(7, 32);
+         Buffer copy(buf);
+         assertFalse(copy.isBorrowed());
+         copy.set<UInt8>(9, 32);
+      }
+      assertEquals<int>(7, data[32]);
+   });
+
+   KAREN_DECL_TEST(shouldReleaseBorrowedMemory,
+   {
+      struct Releaser : BufferReleaser
+      {
+         void* released;
+         unsigned long releasedLength;
+         Releaser() : released(NULL), releasedLength(0) {}
+         virtual void releaseBuffer(void* data, unsigned long length)
+         { released = data; releasedLength = length; }
+      } releaser;
+      UInt8 data[64];
+      {
+         Buffer buf(data, 64, &releaser);
+         Buffer moved(std::move(buf));
+         assertTrue(releaser.released == NULL);
+      }
+      assertTrue(releaser.released == data);
+      assertEquals<unsigned long>(64, releaser.releasedLength);
+   });
       
 KAREN_END_UNIT_TEST(BufferTestSuite);
 
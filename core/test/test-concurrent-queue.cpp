@@ -0,0 +1,293 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <thread>
+#include <vector>
+
+#include <KarenCore/concurrent-queue.h>
+#include <KarenCore/string.h>
+#include <KarenCore/test.h>
+
+using namespace karen;
+
+/*
+ * Element type that counts how many instances are alive.
+ */
+static int liveCounted = 0;
+
+struct Counted
+{
+   int value;
+
+   Counted(int v = 0) : value(v) { liveCounted++; }
+   Counted(const Counted& c) : value(c.value) { liveCounted++; }
+   ~Counted() { liveCounted--; }
+   Counted& operator = (const Counted& c) 
+   { value = c.value; return *this; }
+};
+
+/*
+ * Put given number of sequential values tagged with given producer 
+ * number, and check that each consumer sees the values of each producer
+ * in order. 
+ */
+template <QueueConcurrency Concurrency>
+static bool
+runProducersConsumers(unsigned int producers, 
+                      unsigned int consumers, 
+                      int count)
+{
+   ConcurrentQueue<long, Concurrency> q(64);
+   std::vector<std::thread> threads;
+   std::vector<long> sums(consumers, 0);
+   std::vector<int> unordered(consumers, 0);
+   for (unsigned int p = 0; p < producers; p++)
+      threads.push_back(std::thread([&q, p, count]()
+      {
+         for (int i = 0; i < count; i++)
+            q.put(((long) p << 32) | i);
+      }));
+   for (unsigned int c = 0; c < consumers; c++)
+      threads.push_back(std::thread(
+            [&q, &sums, &unordered, c, producers, consumers, count]()
+      {
+         std::vector<long> last(producers, -1);
+         long total = (long) producers * count;
+         long share = total / consumers + 
+               ((c < total % consumers) ? 1 : 0);
+         for (long i = 0; i < share; i++)
+         {
+            long v = q.poll();
+            long p = v >> 32, n = v & 0xffffffff;
+            if (n <= last[p])
+               unordered[c]++;
+            last[p] = n;
+            sums[c] += n;
+         }
+      }));
+   for (auto& t : threads)
+      t.join();
+   long sum = 0;
+   for (unsigned int c = 0; c < consumers; c++)
+   {
+      if (unordered[c])
+         return false;
+      sum += sums[c];
+   }
+   return q.isEmpty() && 
+          sum == (long) producers * count * (count - 1) / 2;
+}
+
+KAREN_BEGIN_UNIT_TEST(ConcurrentQueueTestSuite);
+
+   KAREN_DECL_TEST(createEmptyQueue,
+   {
+      ConcurrentQueue<int> q(100);
+      assertTrue(q.isEmpty());
+      assertEquals<int>(0, q.size());
+      assertEquals<int>(128, q.capacity());
+      int i;
+      assertFalse(q.tryPoll(i));
+   });
+
+   KAREN_DECL_TEST(rejectQueueWithNoCapacity,
+   {
+      try
+      {
+         ConcurrentQueue<int> q(0);
+         assertionFailed("expected exception not raised");
+      }
+      catch (InvalidInputException&) {}
+   });
+
+   KAREN_DECL_TEST(pollElementsInOrder,
+   {
+      ConcurrentQueue<int> q(4);
+      for (int i = 0; i < 4; i++)
+         assertTrue(q.tryPut(i));
+      assertFalse(q.tryPut(4));
+      assertEquals<int>(4, q.size());
+      for (int i = 0; i < 4; i++)
+      {
+         int j = -1;
+         assertTrue(q.tryPoll(j));
+         assertEquals(i, j);
+      }
+      assertTrue(q.isEmpty());
+   });
+
+   KAREN_DECL_TEST(wrapAroundRing,
+   {
+      ConcurrentQueue<String> q(4);
+      String s;
+      for (int i = 0; i < 100; i++)
+      {
+         assertTrue(q.tryEmplace(String::format("value %d", i)));
+         if (i >= 2)
+         {
+            assertTrue(q.tryPoll(s));
+            assertEquals(String::format("value %d", i - 2), s);
+         }
+      }
+      assertEquals<int>(2, q.size());
+   });
+
+   KAREN_DECL_TEST(putAndPollInBatches,
+   {
+      ConcurrentQueue<int> q(8);
+      int in[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+      int out[10];
+      assertEquals<int>(6, q.putAll(in, 6));
+      assertEquals<int>(2, q.putAll(in + 6, 4));
+      assertEquals<int>(8, q.size());
+      assertEquals<int>(5, q.pollMany(out, 5));
+      assertEquals<int>(3, q.pollMany(out + 5, 5));
+      for (int i = 0; i < 8; i++)
+         assertEquals(i, out[i]);
+      assertEquals<int>(0, q.pollMany(out, 5));
+   });
+
+   KAREN_DECL_TEST(destroyRemainingElements,
+   {
+      liveCounted = 0;
+      {
+         ConcurrentQueue<Counted> q(8);
+         for (int i = 0; i < 6; i++)
+            q.tryEmplace(i);
+         Counted c;
+         q.tryPoll(c);
+         assertEquals(6, liveCounted);
+      }
+      assertEquals(0, liveCounted);
+   });
+
+   KAREN_DECL_TEST(timeOutWhenPollingEmptyQueue,
+   {
+      ConcurrentQueue<int> q(4);
+      int i;
+      assertFalse(q.tryPoll(i, 10));
+   });
+
+   KAREN_DECL_TEST(wakeUpWaitingConsumer,
+   {
+      ConcurrentQueue<int> q(4);
+      std::thread producer([&q]()
+      {
+         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+         q.tryPut(42);
+      });
+      assertEquals(42, q.poll());
+      producer.join();
+   });
+
+   KAREN_DECL_TEST(wakeUpWaitingProducer,
+   {
+      ConcurrentQueue<int> q(2);
+      q.put(1);
+      q.put(2);
+      std::thread consumer([&q]()
+      {
+         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+         q.poll();
+      });
+      q.put(3);
+      consumer.join();
+      assertEquals(2, q.poll());
+      assertEquals(3, q.poll());
+   });
+
+   KAREN_DECL_TEST(shareQueueAmongThreads,
+   {
+      assertTrue(runProducersConsumers<MULTIPLE_PRODUCERS_CONSUMERS>(
+            1, 1, 100000));
+      assertTrue(runProducersConsumers<MULTIPLE_PRODUCERS_CONSUMERS>(
+            4, 1, 25000));
+      assertTrue(runProducersConsumers<MULTIPLE_PRODUCERS_CONSUMERS>(
+            4, 4, 25000));
+   });
+
+KAREN_END_UNIT_TEST(ConcurrentQueueTestSuite);
+
+KAREN_BEGIN_UNIT_TEST(SingleProducerConsumerQueueTestSuite);
+
+   typedef ConcurrentQueue<int, SINGLE_PRODUCER_CONSUMER> IntQueue;
+
+   KAREN_DECL_TEST(pollElementsInOrder,
+   {
+      IntQueue q(4);
+      for (int i = 0; i < 4; i++)
+         assertTrue(q.tryPut(i));
+      assertFalse(q.tryPut(4));
+      for (int i = 0; i < 4; i++)
+      {
+         int j = -1;
+         assertTrue(q.tryPoll(j));
+         assertEquals(i, j);
+      }
+      int j;
+      assertFalse(q.tryPoll(j));
+   });
+
+   KAREN_DECL_TEST(putAndPollInBatches,
+   {
+      IntQueue q(8);
+      int in[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+      int out[10];
+      assertEquals<int>(6, q.putAll(in, 6));
+      assertEquals<int>(2, q.putAll(in + 6, 4));
+      assertEquals<int>(5, q.pollMany(out, 5));
+      assertEquals<int>(2, q.putAll(in + 8, 2));
+      assertEquals<int>(5, q.pollMany(out + 5, 10));
+      for (int i = 0; i < 10; i++)
+         assertEquals(i, out[i]);
+   });
+
+   KAREN_DECL_TEST(destroyRemainingElements,
+   {
+      liveCounted = 0;
+      {
+         ConcurrentQueue<Counted, SINGLE_PRODUCER_CONSUMER> q(8);
+         for (int i = 0; i < 6; i++)
+            q.tryEmplace(i);
+         assertEquals(6, liveCounted);
+      }
+      assertEquals(0, liveCounted);
+   });
+
+   KAREN_DECL_TEST(shareQueueBetweenThreads,
+   {
+      assertTrue(runProducersConsumers<SINGLE_PRODUCER_CONSUMER>(
+            1, 1, 200000));
+   });
+
+KAREN_END_UNIT_TEST(SingleProducerConsumerQueueTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   ConcurrentQueueTestSuite suite;
+   suite.run(&rep, NULL, 0);
+   SingleProducerConsumerQueueTestSuite spscSuite;
+   spscSuite.run(&rep, NULL, 0);
+}
@@ -0,0 +1,132 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <cstring>
+
+#include <KarenCore/exception.h>
+#include <KarenCore/string.h>
+#include <KarenCore/test.h>
+
+using namespace karen;
+
+KAREN_BEGIN_UNIT_TEST(ExceptionTestSuite);
+
+   KAREN_DECL_TEST(formatCauseWithoutArguments,
+   {
+      try
+      {
+         KAREN_THROW(InvalidInputException, "something went wrong");
+      }
+      catch (InvalidInputException& e)
+      {
+         assertEquals(String("something went wrong"), e.cause());
+         assertTrue(std::strstr(e.sourceFile(), "test-exception") != NULL);
+         assertTrue(e.sourceLine() > 0);
+      }
+   });
+
+   KAREN_DECL_TEST(formatCauseWithArguments,
+   {
+      try
+      {
+         unsigned long size = 10;
+         KAREN_THROW(OutOfBoundsException, 
+                     "index %d out of bounds [0, %lu) in %s: %.2f %c%%", 
+                     -3, size, String("array"), 1.5, 'x');
+      }
+      catch (OutOfBoundsException& e)
+      {
+         assertEquals(
+               String("index -3 out of bounds [0, 10) in array: 1.50 x%"),
+               e.cause());
+      }
+   });
+
+   KAREN_DECL_TEST(formatMissingArguments,
+   {
+      ExceptionCause cause("%s and %d", "foo");
+      assertEquals(String("foo and %d"), cause.format());
+   });
+
+   KAREN_DECL_TEST(truncateLongTextArguments,
+   {
+      char text[1000];
+      std::memset(text, 'a', sizeof(text) - 1);
+      text[sizeof(text) - 1] = '\0';
+      ExceptionCause cause("%s|%s", text, "bar");
+      String result = cause.format();
+      assertTrue(result.length() < 1000);
+      assertTrue(result.startsWith("aaaa"));
+   });
+
+   KAREN_DECL_TEST(formatNestedCause,
+   {
+      try
+      {
+         try
+         {
+            KAREN_THROW(IOException, "cannot read file %s", "foo.txt");
+         }
+         catch (IOException& e)
+         {
+            KAREN_THROW_NESTED(InvalidInputException, e, 
+                               "cannot load resource %d", 7);
+         }
+      }
+      catch (InvalidInputException& e)
+      {
+         assertEquals(
+               String("cannot load resource 7\ncannot read file foo.txt"),
+               e.cause());
+      }
+   });
+
+   KAREN_DECL_TEST(copyException,
+   {
+      InvalidStateException e(
+            ExceptionCause("state %d", 3), __FILE__, __LINE__);
+      InvalidStateException copy(e);
+      assertEquals(String("state 3"), copy.cause());
+      assertEquals(String("state 3"), e.cause());
+      InvalidStateException other(ExceptionCause("other"), __FILE__, 0);
+      other = copy;
+      assertEquals(String("state 3"), other.cause());
+      assertEquals<int>(e.sourceLine(), other.sourceLine());
+   });
+
+   KAREN_DECL_TEST(formatStringCause,
+   {
+      InvalidStateException e(String("eager cause"), __FILE__, __LINE__);
+      assertEquals(String("eager cause"), e.cause());
+      assertTrue(std::strstr(e.sourceFile(), "test-exception") != NULL);
+   });
+
+KAREN_END_UNIT_TEST(ExceptionTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   ExceptionTestSuite suite;
+   suite.run(&rep, NULL, 0);
+}
@@ -22,6 +22,10 @@
  * ---------------------------------------------------------------------
  */
 
+#include <cstring>
+#include <thread>
+#include <vector>
+
 #include <KarenCore/file.h>
 #include <KarenCore/test.h>
 
@@ -80,6 +84,291 @@ KAREN_BEGIN_UNIT_TEST(FileTestSuite);
       catch (IOException&) {}
    });
    
+   KAREN_DECL_TEST(shouldWriteAndReadThroughBufferedStreams,
+   {
+      {
+         File f("/tmp/foobar1", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         BufferedOutputStream os(&f, 64);
+         for (UInt32 i = 0; i < 1000; i++)
+            os.write<UInt32>(i);
+         os.flush();
+      }
+      {
+         File f("/tmp/foobar1", FileOpenMode::READ_ONLY_MODE);
+         BufferedInputStream is(&f, 64);
+         assertEquals<UInt32>(0, is.peek<UInt32>());
+         assertEquals<unsigned long>(400, is.skip(400));
+         UInt32 values[900];
+         is.readArray(values, 900);
+         assertEquals<UInt32>(100, values[0]);
+         assertEquals<UInt32>(999, values[899]);
+         assertEquals<unsigned long>(0, is.skip(4));
+      }
+   });
+   
+   KAREN_DECL_TEST(shouldMapFileForReading,
+   {
+      {
+         File f("/tmp/foobar1", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         for (UInt32 i = 0; i < 1000; i++)
+            f.write<UInt32>(i);
+      }
+      MappedFile mf("/tmp/foobar1", READ_ONLY_MAPPING);
+      assertEquals<unsigned long>(4000, mf.length());
+      assertTrue(mf.buffer().isBorrowed());
+      mf.advise(SEQUENTIAL_ACCESS);
+      mf.advise(WILL_NEED_ACCESS, 1000, 2000);
+      const UInt32* values = (const UInt32*) (const void*) mf.buffer();
+      for (UInt32 i = 0; i < 1000; i++)
+         assertEquals<UInt32>(i, values[i]);
+      assertEquals<UInt32>(999, mf.buffer().get<UInt32>(3996));
+   });
+
+   KAREN_DECL_TEST(shouldFailMappingMissingFileForReading,
+   {
+      try
+      {
+         MappedFile mf("/tmp/foobar2", READ_ONLY_MAPPING);
+         assertionFailed("Expected IOException not thrown");
+      }
+      catch (IOException&) {}
+   });
+
+   KAREN_DECL_TEST(shouldWriteThroughSharedMapping,
+   {
+      {
+         MappedFile mf("/tmp/foobar1", READ_WRITE_MAPPING);
+         mf.buffer().set<UInt32>(0xcafe, 400);
+         mf.sync(400, 4);
+      }
+      File f("/tmp/foobar1", FileOpenMode::READ_ONLY_MODE);
+      assertEquals<unsigned long>(400, f.skip(400));
+      assertEquals<UInt32>(0xcafe, f.read<UInt32>());
+   });
+
+   KAREN_DECL_TEST(shouldNotWriteThroughCopyOnWriteMapping,
+   {
+      {
+         MappedFile mf("/tmp/foobar1", COPY_ON_WRITE_MAPPING);
+         mf.buffer().set<UInt32>(0xbeef, 0);
+         assertEquals<UInt32>(0xbeef, mf.buffer().get<UInt32>(0));
+         mf.sync();
+         try
+         {
+            mf.resize(8000);
+            assertionFailed("Expected InvalidStateException not thrown");
+         }
+         catch (InvalidStateException&) {}
+      }
+      MappedFile mf("/tmp/foobar1", READ_ONLY_MAPPING);
+      assertEquals<UInt32>(0, mf.buffer().get<UInt32>(0));
+   });
+
+   KAREN_DECL_TEST(shouldGrowMappedFile,
+   {
+      {
+         File f("/tmp/foobar1", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+      }
+      {
+         MappedFile mf("/tmp/foobar1", READ_WRITE_MAPPING);
+         assertEquals<unsigned long>(0, mf.length());
+         mf.sync();
+         mf.resize(64);
+         mf.buffer().set<UInt64>(0x0123456789abcdefull, 56);
+         mf.resize(1024 * 1024);
+         assertEquals<UInt64>(0x0123456789abcdefull, 
+                              mf.buffer().get<UInt64>(56));
+         assertEquals<UInt64>(0, mf.buffer().get<UInt64>(1024 * 1024 - 8));
+         mf.buffer().set<UInt8>(7, 1024 * 1024 - 1);
+         mf.sync(0, 0, false);
+      }
+      MappedFile mf("/tmp/foobar1", READ_ONLY_MAPPING);
+      assertEquals<unsigned long>(1024 * 1024, mf.length());
+      assertEquals<UInt8>(7, mf.buffer().get<UInt8>(1024 * 1024 - 1));
+   });
+   
+   KAREN_DECL_TEST(shouldSeekAndTell,
+   {
+      {
+         File f("/tmp/foobar1", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         for (UInt32 i = 0; i < 1000; i++)
+            f.write<UInt32>(i);
+         assertEquals<unsigned long>(4000, f.size());
+      }
+      File f("/tmp/foobar1", FileOpenMode::READ_ONLY_MODE);
+      f.advise(SEQUENTIAL_ACCESS);
+      f.advise(WILL_NEED_ACCESS, 400, 400);
+      assertEquals<unsigned long>(4000, f.size());
+      assertEquals<unsigned long>(0, f.tell());
+      assertEquals<unsigned long>(400, f.seek(400));
+      assertEquals<UInt32>(100, f.read<UInt32>());
+      assertEquals<unsigned long>(408, f.seek(4, SEEK_FROM_CURRENT));
+      assertEquals<UInt32>(102, f.read<UInt32>());
+      assertEquals<unsigned long>(3996, f.seek(-4, SEEK_FROM_END));
+      assertEquals<UInt32>(999, f.read<UInt32>());
+      assertEquals<unsigned long>(4000, f.tell());
+      try
+      {
+         f.seek(-8);
+         assertionFailed("Expected IOException not thrown");
+      }
+      catch (IOException&) {}
+   });
+
+   KAREN_DECL_TEST(shouldReadAndWriteAtOffsets,
+   {
+      File f("/tmp/foobar1", FileOpenMode::READ_WRITE_MODE);
+      UInt32 value = 0xdead;
+      assertEquals<unsigned long>(4, f.writeAt(&value, 4, 4000));
+      assertEquals<unsigned long>(4004, f.size());
+      assertEquals<unsigned long>(0, f.tell());
+      UInt32 values[3];
+      assertEquals<unsigned long>(12, f.readAt(values, 12, 3992));
+      assertEquals<UInt32>(998, values[0]);
+      assertEquals<UInt32>(0xdead, values[2]);
+      assertEquals<unsigned long>(4, f.readAt(values, 12, 4000));
+      assertEquals<unsigned long>(0, f.readAt(values, 12, 5000));
+      assertEquals<unsigned long>(0, f.tell());
+   });
+
+   KAREN_DECL_TEST(shouldReadAndWriteVectors,
+   {
+      // More regions than a single system call batch.
+      UInt32 values[100];
+      IoVec vecs[100];
+      for (UInt32 i = 0; i < 100; i++)
+      {
+         values[i] = i * 7;
+         vecs[i].data = &values[i];
+         vecs[i].length = sizeof(UInt32);
+      }
+      {
+         File f("/tmp/foobar1", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         assertEquals<unsigned long>(400, f.writev(vecs, 100));
+      }
+      File f("/tmp/foobar1", FileOpenMode::READ_ONLY_MODE);
+      UInt32 head[10];
+      UInt8 tail[512];
+      IoVec rvecs[2] = { { head, sizeof(head) }, { tail, sizeof(tail) } };
+      assertEquals<unsigned long>(400, f.readv(rvecs, 2));
+      assertEquals<UInt32>(63, head[9]);
+      assertEquals<UInt32>(693, ((UInt32*) tail)[89]);
+      assertEquals<unsigned long>(0, f.readv(rvecs, 2));
+   });
+
+   KAREN_DECL_TEST(shouldReadDisjointRangesConcurrently,
+   {
+      const unsigned long COUNT = 64 * 1024;
+      {
+         File f("/tmp/foobar1", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         std::vector<UInt32> values(COUNT);
+         for (UInt32 i = 0; i < COUNT; i++)
+            values[i] = i;
+         f.writeArray(&values[0], COUNT);
+      }
+      File f("/tmp/foobar1", FileOpenMode::READ_ONLY_MODE);
+      const unsigned int THREADS = 4;
+      std::vector<std::thread> threads;
+      std::vector<unsigned long> mismatches(THREADS, 0);
+      for (unsigned int t = 0; t < THREADS; t++)
+         threads.push_back(std::thread([&f, &mismatches, t, COUNT]()
+         {
+            UInt32 chunk[256];
+            unsigned long share = COUNT / THREADS;
+            for (unsigned long i = t * share; i < (t + 1) * share; i += 256)
+            {
+               f.readAt(chunk, sizeof(chunk), i * sizeof(UInt32));
+               for (unsigned long j = 0; j < 256; j++)
+                  if (chunk[j] != i + j)
+                     mismatches[t]++;
+            }
+         }));
+      for (auto& t : threads)
+         t.join();
+      for (unsigned int t = 0; t < THREADS; t++)
+         assertEquals<unsigned long>(0, mismatches[t]);
+   });
+
+   KAREN_DECL_TEST(shouldCopyFile,
+   {
+      // Larger than a single transfer block.
+      const unsigned long COUNT = 800 * 1024;
+      UInt32* values = new UInt32[COUNT];
+      for (UInt32 i = 0; i < COUNT; i++)
+         values[i] = i;
+      {
+         File f("/tmp/foobar1", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         f.writeArray(values, COUNT);
+      }
+      assertEquals<unsigned long>(
+            COUNT * sizeof(UInt32), 
+            File::copyFile("/tmp/foobar1", "/tmp/foobar-copy"));
+      memset(values, 0, COUNT * sizeof(UInt32));
+      File f("/tmp/foobar-copy", FileOpenMode::READ_ONLY_MODE);
+      assertEquals<unsigned long>(COUNT * sizeof(UInt32), f.size());
+      f.readArray(values, COUNT);
+      assertEquals<UInt32>(0, values[0]);
+      assertEquals<UInt32>(300000, values[300000]);
+      assertEquals<UInt32>(COUNT - 1, values[COUNT - 1]);
+      delete[] values;
+   });
+
+   KAREN_DECL_TEST(shouldTransferRangeKeepingPositions,
+   {
+      UInt32 values[1000];
+      for (UInt32 i = 0; i < 1000; i++)
+         values[i] = i;
+      {
+         File f("/tmp/foobar1", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         f.writeArray(values, 1000);
+      }
+      File src("/tmp/foobar1", FileOpenMode::READ_ONLY_MODE);
+      src.seek(0, SEEK_FROM_END);
+      File dst("/tmp/foobar-copy", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+      dst.seek(8);
+      assertEquals<unsigned long>(400, File::transfer(src, 400, dst, 40, 400));
+      assertEquals<unsigned long>(4000, src.tell());
+      assertEquals<unsigned long>(8, dst.tell());
+      // Stops at the end of the source.
+      assertEquals<unsigned long>(
+            100, File::transfer(src, 3900, dst, 440, 1000));
+      
+      File f("/tmp/foobar-copy", FileOpenMode::READ_ONLY_MODE);
+      assertEquals<unsigned long>(540, f.size());
+      assertEquals<unsigned long>(500, f.readAt(values, 500, 40));
+      assertEquals<UInt32>(100, values[0]);
+      assertEquals<UInt32>(199, values[99]);
+      assertEquals<UInt32>(975, values[100]);
+      assertEquals<UInt32>(999, values[124]);
+   });
+
+   KAREN_DECL_TEST(shouldTransferThroughUserBuffer,
+   {
+      const unsigned long COUNT = 600 * 1024;
+      UInt32* values = new UInt32[COUNT];
+      for (UInt32 i = 0; i < COUNT; i++)
+         values[i] = i * 3;
+      {
+         File f("/tmp/foobar1", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         f.writeArray(values, COUNT);
+      }
+      File src("/tmp/foobar1", FileOpenMode::READ_ONLY_MODE);
+      File dst("/tmp/foobar-copy", FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+      Ptr<FileFactory> factory = FileFactory::getActiveFileFactory();
+      assertEquals<unsigned long>(
+            COUNT * sizeof(UInt32) - 4, 
+            factory->FileFactory::transfer(
+                  src, 4, dst, 0, COUNT * sizeof(UInt32)));
+      memset(values, 0, COUNT * sizeof(UInt32));
+      File f("/tmp/foobar-copy", FileOpenMode::READ_ONLY_MODE);
+      assertEquals<unsigned long>(
+            COUNT * sizeof(UInt32) - 4, 
+            f.readAt(values, COUNT * sizeof(UInt32), 0));
+      assertEquals<UInt32>(3, values[0]);
+      assertEquals<UInt32>((COUNT - 1) * 3, values[COUNT - 2]);
+      delete[] values;
+   });
+
 KAREN_END_UNIT_TEST(FileTestSuite);
 
 int main(int argc, char* argv[])
@@ -0,0 +1,192 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <climits>
+
+#include <KarenCore/format.h>
+#include <KarenCore/string.h>
+#include <KarenCore/test.h>
+
+using namespace karen;
+
+KAREN_BEGIN_UNIT_TEST(FormatTestSuite);
+
+   KAREN_DECL_TEST(appendText,
+   {
+      StringBuilder builder;
+      assertTrue(builder.isEmpty());
+      builder.append("foo").append(' ').append(StringView("barbaz", 3));
+      builder.append('!', 3);
+      assertEquals(String("foo bar!!!"), builder.toString());
+      assertEquals<int>(10, builder.length());
+      assertTrue(builder.data()[10] == '\0');
+      assertEquals(String("foo bar!!!"), String(builder.view()));
+   });
+
+   KAREN_DECL_TEST(growGeometrically,
+   {
+      StringBuilder builder;
+      assertEquals<int>(StringBuilder::INLINE_CAPACITY, builder.capacity());
+      unsigned int grows = 0;
+      unsigned long capacity = builder.capacity();
+      for (unsigned int i = 0; i < 100000; i++)
+      {
+         builder.append('a' + i % 26);
+         if (builder.capacity() != capacity)
+         {
+            capacity = builder.capacity();
+            grows++;
+         }
+      }
+      assertEquals<int>(100000, builder.length());
+      assertTrue(grows < 12);
+      assertTrue(builder.data()[26] == 'a' && builder.data()[99999] == 'd');
+      builder.clear();
+      assertTrue(builder.isEmpty());
+      assertEquals<int>(capacity, builder.capacity());
+   });
+
+   KAREN_DECL_TEST(formatIntegersByType,
+   {
+      StringBuilder builder;
+      unsigned long big = ULONG_MAX;
+      long long negative = LLONG_MIN;
+      KAREN_FORMAT(builder, "%d|%d|%i|%c|%d|%s", 
+                   big, negative, (short) -7, 'x', 'x', true);
+      assertEquals(String::format("%lu|%lld|-7|x|120|true", big, negative), 
+                   builder.toString());
+   });
+
+   KAREN_DECL_TEST(formatWithFlagsWidthAndPrecision,
+   {
+      StringBuilder builder;
+      KAREN_FORMAT(builder, "[%5d][%-5d][%05d][%+d][% d][%.4d]", 
+                   42, 42, -42, 42, 42, 42);
+      KAREN_FORMAT(builder, "[%x][%#X][%o][%#o][%p]", 
+                   255u, 255u, 8, 8, (void*) 0x10);
+      KAREN_FORMAT(builder, "[%.3f][%8.2f][%-8.1e][%g][%08.3f]", 
+                   3.14159, -2.5, 12345.0, 0.0001, -1.5);
+      KAREN_FORMAT(builder, "[%s][%.3s][%6s][%-6s]", 
+                   "text", String("truncated"), StringView("ab"), "cd");
+      assertEquals(String(
+            "[   42][42   ][-0042][+42][ 42][0042]"
+            "[ff][0XFF][10][010][0x10]"
+            "[3.142][   -2.50][1.2e+04 ][0.0001][-001.500]"
+            "[text][tru][    ab][cd    ]"), builder.toString());
+   });
+
+   KAREN_DECL_TEST(formatWithDefaultAndZeroPrecision,
+   {
+      StringBuilder builder;
+      KAREN_FORMAT(builder, "[%.0d][%.0x][%#.0o][%3.0d][%.0d]", 
+                   0, 0u, 0, 0, 7);
+      KAREN_FORMAT(builder, "[%a][%f][%e]", 
+                   3.141592653589793, 3.141592653589793, 0.5);
+      assertEquals(String(
+            "[][][0][   ][7]"
+            "[0x1.921fb54442d18p+1][3.141593][5.000000e-01]"), 
+            builder.toString());
+   });
+
+   KAREN_DECL_TEST(formatSignFlagsOnlyForSignedConversions,
+   {
+      StringBuilder builder;
+      KAREN_FORMAT(builder, "[%+x][% u][%+o][%+X][%+d][% i][%+u]", 
+                   255u, 3u, 8u, 255, 7u, 7, 7u);
+      KAREN_FORMAT(builder, "[%010a][%+010a][%-10a][%010A]", 
+                   1.0, -1.0, 1.0, 1.0);
+      assertEquals(String(
+            "[ff][3][10][FF][+7][ 7][7]"
+            "[0x00001p+0][-0x0001p+0][0x1p+0    ][0X00001P+0]"), 
+            builder.toString());
+   });
+
+   KAREN_DECL_TEST(formatAnyArgumentAsString,
+   {
+      StringBuilder builder;
+      KAREN_FORMAT(builder, "%s %s %s %s", -12, 0.1, 'c', 7u);
+      assertEquals(String("-12 0.1 c 7"), builder.toString());
+   });
+
+   KAREN_DECL_TEST(formatPercentAndMissingArguments,
+   {
+      StringBuilder builder;
+      builder.appendFormat("100%% of %s, %d and %-5.2f%", "foo");
+      assertEquals(String("100% of foo, %d and %-5.2f%"), builder.toString());
+      builder.clear();
+      builder.appendFormat("%s", "foo", "bar", 3);
+      assertEquals(String("foo"), builder.toString());
+   });
+
+   KAREN_DECL_TEST(formatBeyondInlineCapacity,
+   {
+      StringBuilder chunk;
+      chunk.append('x', 1000);
+      String text = chunk.toString();
+      StringBuilder builder;
+      KAREN_FORMAT(builder, "<%s|%s>", text, text);
+      assertEquals<int>(2003, builder.length());
+      assertTrue(builder.view().startsWith("<xxx"));
+      assertTrue(builder.view().endsWith("xxx>"));
+   });
+
+   KAREN_DECL_TEST(checkFormatsWhenCompiling,
+   {
+      static_assert(FormatChecker<>::accepts("no conversions, 100%%"), "");
+      static_assert(FormatChecker<int, const char*, double>::accepts(
+            "%-5d %s %.2f"), "");
+      static_assert(FormatChecker<unsigned long, String>::accepts(
+            "%lu %s"), "");
+      static_assert(!FormatChecker<int>::accepts("%d %d"), "");
+      static_assert(!FormatChecker<int, int>::accepts("%d"), "");
+      static_assert(!FormatChecker<double>::accepts("%d"), "");
+      static_assert(!FormatChecker<String>::accepts("%d"), "");
+      static_assert(!FormatChecker<int>::accepts("%p"), "");
+      assertTrue(true);
+   });
+
+   KAREN_DECL_TEST(assertValuesOfAnyFormattableType,
+   {
+      assertEquals<long>(1L << 40, 1L << 40);
+      assertEquals<double>(0.5, 0.5);
+      assertNotEquals<String>("foo", "bar");
+      try
+      {
+         assertEquals<unsigned long>(1, 2);
+      }
+      catch (InvalidAssertionException& e)
+      {
+         assertEquals(String("assertion failed: expected '1' is equals to '2'"),
+                      e.cause());
+      }
+   });
+
+KAREN_END_UNIT_TEST(FormatTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   FormatTestSuite suite;
+   suite.run(&rep, NULL, 0);
+}
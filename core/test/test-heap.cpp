@@ -0,0 +1,280 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <KarenCore/heap.h>
+#include <KarenCore/test.h>
+
+#include "test-tracked.h"
+
+using namespace karen;
+
+KAREN_BEGIN_UNIT_TEST(DaryHeapTestSuite);
+
+   typedef DaryHeap<int> IntHeap;
+
+   KAREN_DECL_TEST(createEmptyHeap,
+   {
+      IntHeap h;
+      assertTrue(h.isEmpty());
+      assertEquals<int>(0, h.size());
+      assertFalse(h.contains(0));
+      try
+      {
+         h.takeLast();
+         assertionFailed("expected exception not raised");
+      }
+      catch (NotFoundException&) {}
+   });
+
+   KAREN_DECL_TEST(takeElementsInOrder,
+   {
+      IntHeap h;
+      std::vector<int> expected;
+      for (int i = 0; i < 100; i++)
+      {
+         int v = (i * 37) % 101;
+         h.insert(v);
+         expected.push_back(v);
+      }
+      std::sort(expected.begin(), expected.end());
+      assertEquals<int>(100, h.size());
+      assertEquals(expected.back(), h.last());
+      for (int i = 99; i >= 0; i--)
+         assertEquals(expected[i], h.takeLast());
+      assertTrue(h.isEmpty());
+   });
+
+   KAREN_DECL_TEST(heapifyArray,
+   {
+      int elems[] = { 5, 1, 9, 3, 7, 2, 8, 6, 4, 0 };
+      IntHeap h(elems, 10);
+      assertEquals<int>(10, h.size());
+      for (int i = 0; i < 10; i++)
+         assertEquals(elems[i], h.get(i));
+      for (int i = 9; i >= 0; i--)
+         assertEquals(i, h.takeLast());
+   });
+
+   KAREN_DECL_TEST(iterateElements,
+   {
+      int elems[] = { 5, 1, 9, 3, 7 };
+      IntHeap h(elems, 5);
+      int sum = 0;
+      for (auto e : h.fast())
+         sum += e;
+      assertEquals(25, sum);
+      assertEquals(9, *h.begin());
+      assertTrue(h.hasElement(7));
+      assertFalse(h.hasElement(4));
+   });
+
+   KAREN_DECL_TEST(updateElementByHandle,
+   {
+      IntHeap h;
+      IntHeap::Handle h1 = h.insert(10);
+      IntHeap::Handle h2 = h.insert(20);
+      IntHeap::Handle h3 = h.insert(30);
+      h.update(h1, 40);
+      assertEquals(40, h.last());
+      h.update(h1, 5);
+      assertEquals(30, h.last());
+      assertEquals(5, h.get(h1));
+      assertEquals(20, h.get(h2));
+      assertEquals(30, h.get(h3));
+      assertEquals(30, h.takeLast());
+      assertEquals(20, h.takeLast());
+      assertEquals(5, h.takeLast());
+   });
+
+   KAREN_DECL_TEST(decreaseAndIncreaseKey,
+   {
+      IntHeap h;
+      IntHeap::Handle h1 = h.insert(10);
+      IntHeap::Handle h2 = h.insert(20);
+      h.decreaseKey(h2, 1);
+      assertEquals(10, h.last());
+      h.increaseKey(h2, 15);
+      assertEquals(15, h.last());
+      try
+      {
+         h.decreaseKey(h1, 11);
+         assertionFailed("expected exception not raised");
+      }
+      catch (InvalidInputException&) {}
+      try
+      {
+         h.increaseKey(h1, 9);
+         assertionFailed("expected exception not raised");
+      }
+      catch (InvalidInputException&) {}
+      assertEquals(10, h.get(h1));
+   });
+
+   KAREN_DECL_TEST(removeElementByHandle,
+   {
+      IntHeap h;
+      IntHeap::Handle h1 = h.insert(10);
+      IntHeap::Handle h2 = h.insert(20);
+      h.insert(30);
+      h.remove(h2);
+      assertFalse(h.contains(h2));
+      assertTrue(h.contains(h1));
+      assertEquals<int>(2, h.size());
+      try
+      {
+         h.remove(h2);
+         assertionFailed("expected exception not raised");
+      }
+      catch (NotFoundException&) {}
+      IntHeap::Handle h4 = h.insert(40);
+      assertTrue(h4 == h2);
+      assertEquals(40, h.get(h4));
+      assertEquals(40, h.takeLast());
+      assertEquals(30, h.takeLast());
+      assertEquals(10, h.takeLast());
+   });
+
+   KAREN_DECL_TEST(removeAllEquivalentElements,
+   {
+      IntHeap h;
+      IntHeap::Handle h1 = h.insert(3);
+      h.insert(7);
+      h.insert(3);
+      IntHeap::Handle h4 = h.insert(5);
+      h.insert(3);
+      h.removeAll(3);
+      assertEquals<int>(2, h.size());
+      assertFalse(h.contains(h1));
+      assertEquals(5, h.get(h4));
+      assertEquals(7, h.takeLast());
+      assertEquals(5, h.takeLast());
+   });
+
+   KAREN_DECL_TEST(removeElementsWithIterator,
+   {
+      int elems[] = { 5, 1, 9, 3, 7 };
+      IntHeap h(elems, 5);
+      Iterator<const int> it = h.begin();
+      h.remove(it);
+      assertEquals<int>(4, h.size());
+      assertEquals(7, h.last());
+      while (!h.isEmpty())
+      {
+         it = h.rbegin();
+         h.remove(it);
+         assertTrue(it.isNull() == h.isEmpty());
+      }
+      assertTrue(h.isEmpty());
+   });
+
+   KAREN_DECL_TEST(moveElementsWithoutCopying,
+   {
+      trackedCopies = 0;
+      DaryHeap<Tracked> h;
+      for (int i = 0; i < 16; i++)
+         h.insert(Tracked(i));
+      h.emplace(20);
+      h.update(0, Tracked(30));
+      assertEquals(30, h.takeLast().value);
+      assertEquals(20, h.takeLast().value);
+      assertEquals(15, h.takeLast().value);
+      assertEquals(0, trackedCopies);
+   });
+
+   KAREN_DECL_TEST(randomOperations,
+   {
+      // Replay random operations on a binary heap and check them against
+      // a multiset of (value, handle) pairs
+      DaryHeap<int, DefaultLessThan<int>, 2> h;
+      std::set<std::pair<int, unsigned long> > ref;
+      std::map<unsigned long, int> values;
+      srand(42);
+      for (int i = 0; i < 20000; i++)
+      {
+         int op = rand() % 5;
+         int v = rand() % 1000;
+         if (op < 2 || values.empty())
+         {
+            unsigned long hd = h.insert(v);
+            assertFalse(values.count(hd) > 0);
+            values[hd] = v;
+            ref.insert(std::make_pair(v, hd));
+         }
+         else if (op < 4)
+         {
+            std::map<unsigned long, int>::iterator it = values.begin();
+            std::advance(it, rand() % values.size());
+            unsigned long hd = it->first;
+            ref.erase(std::make_pair(it->second, hd));
+            if (op == 2)
+            {
+               h.update(hd, v);
+               it->second = v;
+               ref.insert(std::make_pair(v, hd));
+            }
+            else
+            {
+               h.remove(hd);
+               values.erase(it);
+            }
+         }
+         else
+         {
+            // Any of the elements equal to the greatest one may leave the 
+            // heap, so the reference forgets the one whose handle is gone
+            int top = h.takeLast();
+            assertEquals(ref.rbegin()->first, top);
+            for (std::map<unsigned long, int>::iterator it = values.begin();
+                 it != values.end(); it++)
+            {
+               if (!h.contains(it->first))
+               {
+                  assertEquals(top, it->second);
+                  ref.erase(std::make_pair(it->second, it->first));
+                  values.erase(it);
+                  break;
+               }
+            }
+         }
+         assertEquals<int>(ref.size(), h.size());
+      }
+      for (std::map<unsigned long, int>::iterator it = values.begin(); 
+           it != values.end(); it++)
+         assertEquals(it->second, h.get(it->first));
+   });
+
+KAREN_END_UNIT_TEST(DaryHeapTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   DaryHeapTestSuite suite;
+   suite.run(&rep, NULL, 0);
+}
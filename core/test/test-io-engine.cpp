@@ -0,0 +1,279 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <KarenCore/io-engine.h>
+#include <KarenCore/io-engine-uring.h>
+#include <KarenCore/test.h>
+
+using namespace karen;
+
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+namespace karen {
+
+struct UringIoEngineProbe
+{
+   /*
+    * Make the reaper wait for completions without a timeout, as it does
+    * on kernels lacking timed waits.
+    */
+   static void disableTimedWait(UringIoEngine& engine)
+   {
+      std::lock_guard<std::mutex> lock(engine._mutex);
+      engine._timedWait = false;
+   }
+};
+
+}; // namespace karen
+#endif
+
+static const char* ASYNC_FILE = "/tmp/karen-test-async";
+static const unsigned long BLOCK = 4096;
+
+/*
+ * Options of the engines created by the tests. The suite runs once with
+ * the best engine for the platform and once with the thread pool.
+ */
+static IoEngineOptions engineOptions;
+
+static void fillBlock(UInt8* block, unsigned long index)
+{
+   for (unsigned long i = 0; i < BLOCK; i++)
+      block[i] = (UInt8) (index * 31 + i);
+}
+
+static bool isBlock(const UInt8* block, unsigned long index)
+{
+   for (unsigned long i = 0; i < BLOCK; i++)
+      if (block[i] != (UInt8) (index * 31 + i))
+         return false;
+   return true;
+}
+
+static void writeBlocks(unsigned long count)
+{
+   File f(ASYNC_FILE, FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+   UInt8 block[BLOCK];
+   for (unsigned long i = 0; i < count; i++)
+   {
+      fillBlock(block, i);
+      f.writeArray(block, BLOCK);
+   }
+}
+
+struct CountingCallback : IoCallback
+{
+   std::atomic<unsigned int> completions;
+   std::atomic<unsigned int> failures;
+
+   CountingCallback() : completions(0), failures(0) {}
+
+   virtual void onIoCompletion(const IoCompletion& completion)
+   {
+      if (completion.result != (long) completion.request.length ||
+          !isBlock((const UInt8*) completion.request.data, 
+                   (unsigned long) completion.request.userData))
+         failures++;
+      completions++;
+   }
+};
+
+struct RecordingChannel : EventChannel
+{
+   mutable std::mutex mutex;
+   mutable std::vector<IoCompletion> completions;
+
+   virtual void sendEvent(const Event& event) const throw (IOException)
+   {
+      const IoCompletionEvent* ev = 
+            dynamic_cast<const IoCompletionEvent*>(&event);
+      if (ev)
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         completions.push_back(ev->completion);
+      }
+   }
+};
+
+KAREN_BEGIN_UNIT_TEST(IoEngineTestSuite);
+
+   KAREN_DECL_TEST(shouldCreateEngine,
+   {
+      AtomicPtr<IoEngine> engine = IoEngine::create(engineOptions);
+      assertFalse(engine.isNull());
+      assertTrue(!engineOptions.forceThreadPool || 
+                 !strcmp("thread-pool", engine->name()));
+   });
+
+   KAREN_DECL_TEST(shouldWriteAndReadWithFutures,
+   {
+      AtomicPtr<IoEngine> engine = IoEngine::create(engineOptions);
+      std::vector<UInt8> data(16 * BLOCK);
+      {
+         AsyncFile f(*engine, ASYNC_FILE, 
+                     FileOpenMode::TRUNCATE_AND_WRITE_MODE);
+         std::vector<IoFuture> futures;
+         for (unsigned long i = 0; i < 16; i++)
+         {
+            fillBlock(&data[i * BLOCK], i);
+            futures.push_back(f.write(&data[i * BLOCK], BLOCK, i * BLOCK));
+         }
+         assertFalse(futures[0].wait(10));
+         engine->submit();
+         for (unsigned long i = 0; i < 16; i++)
+            assertEquals<long>(BLOCK, futures[i].wait().result);
+         assertEquals<unsigned long>(16 * BLOCK, f.size());
+      }
+      memset(&data[0], 0, data.size());
+      AsyncFile f(*engine, ASYNC_FILE, FileOpenMode::READ_ONLY_MODE);
+      IoFuture first = f.read(&data[0], 8 * BLOCK, 0);
+      IoFuture second = f.read(&data[8 * BLOCK], 8 * BLOCK, 8 * BLOCK);
+      engine->submit();
+      assertTrue(first.wait(5000));
+      assertTrue(first.isReady());
+      assertEquals<long>(8 * BLOCK, first.wait().result);
+      assertEquals<long>(8 * BLOCK, second.wait().result);
+      for (unsigned long i = 0; i < 16; i++)
+         assertTrue(isBlock(&data[i * BLOCK], i));
+   });
+
+   KAREN_DECL_TEST(shouldNotifyCallbacksBeyondQueueDepth,
+   {
+      writeBlocks(64);
+      IoEngineOptions options = engineOptions;
+      options.queueDepth = 4;
+      options.workerThreads = 2;
+      AtomicPtr<IoEngine> engine = IoEngine::create(options);
+      AsyncFile f(*engine, ASYNC_FILE, FileOpenMode::READ_ONLY_MODE);
+      std::vector<UInt8> data(64 * BLOCK);
+      CountingCallback callback;
+      for (unsigned long round = 0; round < 4; round++)
+         for (unsigned long i = 0; i < 64; i++)
+            f.read(&data[i * BLOCK], BLOCK, i * BLOCK, &callback, (void*) i);
+      engine->drain();
+      assertEquals<unsigned int>(256, callback.completions);
+      assertEquals<unsigned int>(0, callback.failures);
+   });
+
+   KAREN_DECL_TEST(shouldSendEventsToChannel,
+   {
+      writeBlocks(8);
+      AtomicPtr<IoEngine> engine = IoEngine::create(engineOptions);
+      AsyncFile f(*engine, ASYNC_FILE, FileOpenMode::READ_ONLY_MODE);
+      std::vector<UInt8> data(8 * BLOCK);
+      RecordingChannel channel;
+      for (unsigned long i = 0; i < 8; i++)
+         f.read(&data[i * BLOCK], BLOCK, i * BLOCK, &channel, (void*) i);
+      engine->drain();
+      assertEquals<unsigned long>(8, channel.completions.size());
+      unsigned long seen = 0;
+      for (unsigned long i = 0; i < 8; i++)
+      {
+         const IoCompletion& c = channel.completions[i];
+         assertTrue(c.succeeded());
+         seen |= 1ul << (unsigned long) c.request.userData;
+      }
+      assertEquals<unsigned long>(0xff, seen);
+      for (unsigned long i = 0; i < 8; i++)
+         assertTrue(isBlock(&data[i * BLOCK], i));
+   });
+
+   KAREN_DECL_TEST(shouldReadIntoRegisteredBuffers,
+   {
+      writeBlocks(16);
+      AtomicPtr<IoEngine> engine = IoEngine::create(engineOptions);
+      std::vector<UInt8> data(16 * BLOCK);
+      IoVec vec = { &data[0], data.size() };
+      engine->registerBuffers(&vec, 1);
+      AsyncFile f(*engine, ASYNC_FILE, FileOpenMode::READ_ONLY_MODE);
+      CountingCallback callback;
+      for (unsigned long i = 0; i < 16; i++)
+         f.read(&data[i * BLOCK], BLOCK, i * BLOCK, &callback, (void*) i);
+      engine->drain();
+      assertEquals<unsigned int>(16, callback.completions);
+      assertEquals<unsigned int>(0, callback.failures);
+      engine->unregisterBuffers();
+   });
+
+   KAREN_DECL_TEST(shouldReportShortReadsAndErrors,
+   {
+      writeBlocks(1);
+      AtomicPtr<IoEngine> engine = IoEngine::create(engineOptions);
+      UInt8 block[BLOCK];
+      AsyncFile rf(*engine, ASYNC_FILE, FileOpenMode::READ_ONLY_MODE);
+      IoFuture past = rf.read(block, BLOCK, 2 * BLOCK);
+      IoFuture half = rf.read(block, BLOCK, BLOCK / 2);
+      AsyncFile wf(*engine, ASYNC_FILE, FileOpenMode::WRITE_ONLY_MODE);
+      IoFuture failed = wf.read(block, BLOCK, 0);
+      engine->drain();
+      assertEquals<long>(0, past.wait().result);
+      assertEquals<long>(BLOCK / 2, half.wait().result);
+      assertEquals<long>(-EBADF, failed.wait().result);
+   });
+
+#if KAREN_PLATFORM == KAREN_PLATFORM_LINUX
+   KAREN_DECL_TEST(shouldStopReaperBlockedWithoutTimeout,
+   {
+      if (engineOptions.forceThreadPool)
+         return;
+      Ptr<UringIoEngine> engine;
+      try
+      {
+         engine = new UringIoEngine(engineOptions);
+      }
+      catch (IOException&)
+      {
+         return; // The kernel lacks io_uring.
+      }
+      writeBlocks(1);
+      UInt8 block[BLOCK];
+      AsyncFile f(*engine, ASYNC_FILE, FileOpenMode::READ_ONLY_MODE);
+      UringIoEngineProbe::disableTimedWait(*engine);
+      IoFuture read = f.read(block, BLOCK, 0);
+      engine->drain();
+      assertEquals<long>(BLOCK, read.wait().result);
+      // Let the reaper leave any timed wait and block in the kernel. The
+      // engine must be released on scope exit without submitting any stop
+      // entry, or this test hangs.
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+   });
+#endif
+
+KAREN_END_UNIT_TEST(IoEngineTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   IoEngineTestSuite suite;
+   suite.run(&rep, NULL, 0);
+   engineOptions.forceThreadPool = true;
+   suite.run(&rep, NULL, 0);
+}
@@ -0,0 +1,176 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+
+#include <cstdlib>
+#include <new>
+
+#include <KarenCore/array.h>
+#include <KarenCore/list.h>
+#include <KarenCore/map.h>
+#include <KarenCore/queue.h>
+#include <KarenCore/set.h>
+#include <KarenCore/test.h>
+
+using namespace karen;
+
+/*
+ * Global allocation counter. Every heap allocation performed by this
+ * test program is accounted here, so the tests may check that fast 
+ * iteration does not allocate.
+ */
+static int allocationCount = 0;
+
+void* operator new(std::size_t size)
+{
+   allocationCount++;
+   void* p = malloc(size ? size : 1);
+   if (!p)
+      throw std::bad_alloc();
+   return p;
+}
+
+void operator delete(void* p) throw ()
+{ free(p); }
+
+KAREN_BEGIN_UNIT_TEST(IteratorTestSuite);
+
+   KAREN_DECL_TEST(shouldFastIterateArrayWithoutAllocating,
+   {
+      int raw[] = { 10, 11, 12, 13, 14, 15 };
+      DynArray<int> a(raw, 6);
+      int allocs = allocationCount;
+      int i = 0;
+      for (DynArray<int>::FastIterator it = a.fastBegin(), 
+           end = a.fastEnd(); it != end; ++it)
+         (*it)++;
+      for (DynArray<int>::FastIterator it = a.fastBegin(), 
+           end = a.fastEnd(); it != end; ++it)
+         i += (*it == raw[it - a.fastBegin()] + 1) ? 1 : 0;
+      assertEquals(allocs, allocationCount);
+      assertEquals(6, i);
+   });
+
+   KAREN_DECL_TEST(shouldFastIterateListWithoutAllocating,
+   {
+      LinkedList<int> l;
+      l.insertBack(10);
+      l.insertBack(11);
+      l.insertBack(12);
+      int allocs = allocationCount;
+      int i = 10;
+      for (LinkedList<int>::ConstFastIterator it = l.fastBegin(), 
+           end = l.fastEnd(); it != end; ++it)
+         assertEquals(i++, *it);
+      assertEquals(allocs, allocationCount);
+      assertEquals(13, i);
+   });
+
+   KAREN_DECL_TEST(shouldFastIterateMapWithoutAllocating,
+   {
+      TreeMap<int, int> m;
+      m.put(3, 30);
+      m.put(1, 10);
+      m.put(2, 20);
+      int allocs = allocationCount;
+      int i = 1;
+      for (TreeMap<int, int>::ConstFastIterator it = m.fastBegin(), 
+           end = m.fastEnd(); it != end; ++it)
+      {
+         assertEquals(i, it->get<0>());
+         assertEquals(i * 10, it->get<1>());
+         i++;
+      }
+      assertEquals(allocs, allocationCount);
+      assertEquals(4, i);
+   });
+
+   KAREN_DECL_TEST(shouldFastIterateSetWithoutAllocating,
+   {
+      TreeSet<int> s;
+      s.insert(7);
+      s.insert(5);
+      s.insert(6);
+      int allocs = allocationCount;
+      int i = 5;
+      for (TreeSet<int>::ConstFastIterator it = s.fastBegin(), 
+           end = s.fastEnd(); it != end; ++it)
+         assertEquals(i++, *it);
+      assertEquals(allocs, allocationCount);
+      assertEquals(8, i);
+   });
+
+   KAREN_DECL_TEST(shouldFastIteratePriorityQueueWithoutAllocating,
+   {
+      PriorityQueue<int> q;
+      q.put(4);
+      q.put(1);
+      q.put(9);
+      int allocs = allocationCount;
+      int sum = 0;
+      for (PriorityQueue<int>::ConstFastIterator it = q.fastBegin(), 
+           end = q.fastEnd(); it != end; ++it)
+         sum += *it;
+      assertEquals(allocs, allocationCount);
+      assertEquals(14, sum);
+   });
+
+   KAREN_DECL_TEST(shouldAllocateWhenIteratingThroughInterface,
+   {
+      LinkedList<int> l;
+      l.insertBack(10);
+      int allocs = allocationCount;
+      for (Iterator<int> it = l.begin(), end = l.end(); it != end; it++) {}
+      assertTrue(allocationCount > allocs);
+   });
+
+#ifdef KAREN_CXX11_HAVE_RANGE_FOR
+   KAREN_DECL_TEST(shouldFastIterateUsingForRange,
+   {
+      int raw[] = { 10, 11, 12, 13, 14, 15 };
+      DynArray<int> a(raw, 6);
+      LinkedList<int> l;
+      for (int n : a.fast())
+         l.insertBack(n);
+      int allocs = allocationCount;
+      int i = 0;
+      for (int n : l.fast())
+         assertEquals(raw[i++], n);
+      for (int& n : a.fast())
+         n = 0;
+      for (int n : a.fast())
+         assertEquals(0, n);
+      assertEquals(allocs, allocationCount);
+      assertEquals(6, i);
+   });
+#endif
+
+KAREN_END_UNIT_TEST(IteratorTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   IteratorTestSuite suite;
+   suite.run(&rep, NULL, 0);
+}
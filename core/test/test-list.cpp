@@ -257,6 +257,36 @@ KAREN_BEGIN_UNIT_TEST(ListTestSuite);
       assertEquals<int>(4, i);
       
    });
+
+   KAREN_DECL_TEST(takeFirstAndLast,
+   {
+      LinkedList<String> l;
+      l.insertBack(String("foo"));
+      l.emplaceBack("bar");
+      l.emplaceFront("xxxyz", 3);
+      assertEquals<int>(3, l.size());
+      assertEquals(String("xxx"), l.takeFirst());
+      assertEquals(String("bar"), l.takeLast());
+      assertEquals(String("foo"), l.takeFirst());
+      assertTrue(l.isEmpty());
+      try
+      {
+         l.takeFirst();
+         assertionFailed("expected exception not raised");
+      }
+      catch (NotFoundException&) {}
+   });
+
+   KAREN_DECL_TEST(tryFirstAndLast,
+   {
+      LinkedList<int> l;
+      assertTrue(l.tryFirst() == NULL);
+      assertTrue(l.tryLast() == NULL);
+      l.insertBack(1);
+      l.insertBack(2);
+      assertEquals(1, *l.tryFirst());
+      assertEquals(2, *l.tryLast());
+   });
    
 KAREN_END_UNIT_TEST(ListTestSuite);
 
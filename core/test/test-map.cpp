@@ -22,11 +22,25 @@
  * ---------------------------------------------------------------------
  */
 
+#include <map>
+#include <vector>
+
 #include <KarenCore/map.h>
 #include <KarenCore/test.h>
 
+#include "test-tracked.h"
+
 using namespace karen;
 
+/*
+ * Element type with no default constructor.
+ */
+struct NoDefault
+{
+   int value;
+
+   explicit NoDefault(int v) : value(v) {}
+};
 
 KAREN_BEGIN_UNIT_TEST(MapTestSuite);
 
@@ -109,11 +123,495 @@ KAREN_BEGIN_UNIT_TEST(MapTestSuite);
       }
    });
 
+   KAREN_DECL_TEST(shouldMoveElementsWithoutCopying,
+   {
+      trackedCopies = 0;
+      TreeMap<int, Tracked> d;
+      d.put(1, Tracked(10));
+      d.emplace(2, 20);
+      d.put(Tuple<const int, Tracked>(3, Tracked(30)));
+      assertEquals(0, trackedCopies);
+      assertEquals<int>(3, d.size());
+      assertEquals(10, d.get(1).value);
+      assertEquals(20, d.get(2).value);
+      assertEquals(30, d.get(3).value);
+   });
+
+   KAREN_DECL_TEST(shouldNotGetUndefinedKey,
+   {
+      TreeMap<String, int> d;
+      d.put("Mark", 45);
+      try
+      {
+         d.get("John");
+         assertionFailed("expected exception not raised");
+      }
+      catch (NotFoundException&) {}
+      assertFalse(d.hasKey("John"));
+   });
+
+   KAREN_DECL_TEST(shouldTryToGetElements,
+   {
+      TreeMap<String, NoDefault> d;
+      d.put("Mark", NoDefault(45));
+      assertTrue(d.tryGet("John") == NULL);
+      assertEquals(45, d.tryGet("Mark")->value);
+      d.tryGet("Mark")->value = 40;
+      const TreeMap<String, NoDefault>& cd = d;
+      assertEquals(40, cd.tryGet("Mark")->value);
+      assertTrue(cd.tryGet("John") == NULL);
+   });
+
+   KAREN_DECL_TEST(shouldComputeIfAbsent,
+   {
+      TreeMap<String, NoDefault> d;
+      int calls = 0;
+      auto make = [&calls]() { calls++; return NoDefault(7); };
+      assertEquals(7, d.computeIfAbsent("Mark", make).value);
+      d.computeIfAbsent("Mark", make).value = 8;
+      assertEquals(8, d.computeIfAbsent("Mark", make).value);
+      assertEquals(1, calls);
+      assertEquals<int>(1, d.size());
+   });
+
+   KAREN_DECL_TEST(shouldGetOrInsert,
+   {
+      TreeMap<String, int> d;
+      d.getOrInsert("Mark") += 2;
+      d.getOrInsert("Mark") += 3;
+      assertEquals(5, d.get("Mark"));
+      assertEquals<int>(1, d.size());
+   });
+
+   KAREN_DECL_TEST(shouldInsertOrAssign,
+   {
+      TreeMap<String, NoDefault> d;
+      assertTrue(d.insertOrAssign("Mark", NoDefault(1)));
+      NoDefault two(2);
+      assertFalse(d.insertOrAssign("Mark", two));
+      assertEquals<int>(1, d.size());
+      assertEquals(2, d.get("Mark").value);
+   });
+
 KAREN_END_UNIT_TEST(MapTestSuite);
 
+KAREN_BEGIN_UNIT_TEST(HashMapTestSuite);
+
+   KAREN_DECL_TEST(shouldCreateAnEmptyHashMap,
+   {
+      HashMap<String, int> d;
+      assertTrue(d.isEmpty());
+      assertEquals<int>(0, d.size());
+      assertFalse(d.hasKey("Mark"));
+   });
+
+   KAREN_DECL_TEST(shouldInsertOneElement,
+   {
+      HashMap<String, int> d;
+      d.put("Mark", 45);
+      assertFalse(d.isEmpty());
+      assertEquals<int>(1, d.size());
+      assertTrue(d.hasKey("Mark"));
+      assertEquals<int>(45, d["Mark"]);
+   });
+
+   KAREN_DECL_TEST(shouldUpdateAnExistingElement,
+   {
+      HashMap<String, int> d;
+      d.put("Mark", 45);
+      d["Mark"] = 40;
+      assertEquals<int>(1, d.size());
+      assertEquals<int>(40, d["Mark"]);
+   });
+
+   KAREN_DECL_TEST(shouldNotGetUndefinedKey,
+   {
+      HashMap<String, int> d;
+      d.put("Mark", 45);
+      try
+      {
+         d.get("John");
+         assertionFailed("expected exception not raised");
+      }
+      catch (NotFoundException&) {}
+   });
+
+   KAREN_DECL_TEST(shouldGrowWithManyElements,
+   {
+      HashMap<int, int> d;
+      for (int i = 0; i < 10000; i++)
+         d.put(i, i * 2);
+      assertEquals<int>(10000, d.size());
+      assertTrue(d.capacity() >= 10000);
+      for (int i = 0; i < 10000; i++)
+         assertEquals(i * 2, d.get(i));
+      assertFalse(d.hasKey(10000));
+   });
+
+   KAREN_DECL_TEST(shouldRemoveAndReinsertElements,
+   {
+      HashMap<int, int> d;
+      for (int round = 0; round < 4; round++)
+      {
+         for (int i = 0; i < 1000; i++)
+            d.put(i, i + round);
+         for (int i = 0; i < 1000; i += 2)
+            d.remove(i);
+         assertEquals<int>(500, d.size());
+         for (int i = 0; i < 1000; i++)
+            assertTrue((i % 2 == 1) == d.hasKey(i));
+         for (int i = 1; i < 1000; i += 2)
+            d.remove(i);
+         assertTrue(d.isEmpty());
+      }
+      assertTrue(d.capacity() <= 2048);
+   });
+
+   KAREN_DECL_TEST(shouldIterateAllEntries,
+   {
+      HashMap<int, int> d;
+      for (int i = 0; i < 100; i++)
+         d.put(i, i);
+      int sum = 0, count = 0;
+      for (Iterator<Tuple<const int, int> > it = d.begin(); it; it++)
+      {
+         sum += it->get<1>();
+         count++;
+      }
+      assertEquals(100, count);
+      assertEquals(4950, sum);
+      count = 0;
+      for (Iterator<Tuple<const int, int> > it = d.rbegin(); it; it++)
+         count++;
+      assertEquals(100, count);
+      count = 0;
+      for (auto& entry : d.fast())
+         count += entry.get<1>();
+      assertEquals(4950, count);
+   });
+
+   KAREN_DECL_TEST(shouldRemoveByIterator,
+   {
+      HashMap<int, int> d;
+      for (int i = 0; i < 10; i++)
+         d.put(i, i);
+      for (Iterator<Tuple<const int, int> > it = d.begin(); it; )
+      {
+         if (it->get<0>() % 2)
+            d.remove(it);
+         else
+            it++;
+      }
+      assertEquals<int>(5, d.size());
+      Iterator<Tuple<const int, int> > it = d.rbegin();
+      int key = it->get<0>();
+      d.remove(it);
+      assertEquals<int>(4, d.size());
+      assertFalse(d.hasKey(key));
+   });
+
+   KAREN_DECL_TEST(shouldUsePointerKeys,
+   {
+      int values[4];
+      HashMap<const int*, bool> d;
+      for (int i = 0; i < 4; i++)
+         d.put(&values[i], i % 2 == 0);
+      assertTrue(d.get(&values[2]));
+      assertFalse(d.get(&values[3]));
+      d.remove(&values[2]);
+      assertFalse(d.hasKey(&values[2]));
+   });
+
+   KAREN_DECL_TEST(shouldCopyHashMap,
+   {
+      HashMap<String, int> d;
+      d.put("Mark", 45);
+      d.put("John", 35);
+      HashMap<String, int> c(d);
+      c["Mark"] = 10;
+      assertEquals<int>(2, c.size());
+      assertEquals<int>(45, d["Mark"]);
+      assertEquals<int>(10, c["Mark"]);
+      assertEquals<int>(35, c["John"]);
+   });
+
+   KAREN_DECL_TEST(shouldPutValueOfAnotherEntry,
+   {
+      HashMap<int, String> d;
+      d.put(0, String("a string that lives out of line"));
+      for (int i = 1; i < 100; i++)
+         d.put(i, d.get(i - 1));
+      assertEquals(String("a string that lives out of line"), d.get(99));
+   });
+
+   KAREN_DECL_TEST(shouldTryToGetElements,
+   {
+      HashMap<String, NoDefault> d;
+      d.put("Mark", NoDefault(45));
+      assertTrue(d.tryGet("John") == NULL);
+      assertEquals(45, d.tryGet("Mark")->value);
+      d.tryGet("Mark")->value = 40;
+      const HashMap<String, NoDefault>& cd = d;
+      assertEquals(40, cd.tryGet("Mark")->value);
+      assertTrue(cd.tryGet("John") == NULL);
+   });
+
+   KAREN_DECL_TEST(shouldComputeIfAbsent,
+   {
+      HashMap<String, NoDefault> d;
+      int calls = 0;
+      auto make = [&calls]() { calls++; return NoDefault(7); };
+      assertEquals(7, d.computeIfAbsent("Mark", make).value);
+      d.computeIfAbsent("Mark", make).value = 8;
+      assertEquals(8, d.computeIfAbsent("Mark", make).value);
+      assertEquals(1, calls);
+      assertEquals<int>(1, d.size());
+   });
+
+   KAREN_DECL_TEST(shouldGetOrInsert,
+   {
+      HashMap<String, int> d;
+      d.getOrInsert("Mark") += 2;
+      d.getOrInsert("Mark") += 3;
+      assertEquals(5, d.get("Mark"));
+      assertEquals<int>(1, d.size());
+   });
+
+   KAREN_DECL_TEST(shouldInsertOrAssign,
+   {
+      HashMap<String, NoDefault> d;
+      assertTrue(d.insertOrAssign("Mark", NoDefault(1)));
+      NoDefault two(2);
+      assertFalse(d.insertOrAssign("Mark", two));
+      assertEquals<int>(1, d.size());
+      assertEquals(2, d.get("Mark").value);
+   });
+
+KAREN_END_UNIT_TEST(HashMapTestSuite);
+
+KAREN_BEGIN_UNIT_TEST(BTreeMapTestSuite);
+
+   KAREN_DECL_TEST(shouldCreateAnEmptyBTreeMap,
+   {
+      BTreeMap<String, int> d;
+      assertTrue(d.isEmpty());
+      assertEquals<int>(0, d.size());
+      assertFalse(d.hasKey("Mark"));
+      assertFalse(d.begin());
+      assertFalse(d.lowerBound("Mark"));
+   });
+
+   KAREN_DECL_TEST(shouldInsertAndUpdateElements,
+   {
+      BTreeMap<String, int> d;
+      d.put("Mark", 45);
+      d.put("John", 35);
+      d["Mark"] = 40;
+      assertEquals<int>(2, d.size());
+      assertEquals<int>(40, d["Mark"]);
+      assertEquals<int>(35, d.get("John"));
+      assertEquals(String("John"), d.begin()->get<0>());
+   });
+
+   KAREN_DECL_TEST(shouldNotGetUndefinedKey,
+   {
+      BTreeMap<String, int> d;
+      d.put("Mark", 45);
+      try
+      {
+         d.get("John");
+         assertionFailed("expected exception not raised");
+      }
+      catch (NotFoundException&) {}
+   });
+
+   KAREN_DECL_TEST(shouldMatchStdMapOnRandomOperations,
+   {
+      BTreeMap<int, int> d;
+      std::map<int, int> expected;
+      unsigned int seed = 12345;
+      for (int i = 0; i < 50000; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         int key = (seed >> 8) % 5000;
+         if ((seed >> 4) % 3)
+         {
+            d.put(key, i);
+            expected.insert(std::make_pair(key, i));
+         }
+         else
+         {
+            d.remove(key);
+            expected.erase(key);
+         }
+      }
+      assertEquals<int>(expected.size(), d.size());
+      std::map<int, int>::const_iterator eit = expected.begin();
+      for (auto& entry : d.fast())
+      {
+         assertEquals(eit->first, entry.get<0>());
+         assertEquals(eit->second, entry.get<1>());
+         eit++;
+      }
+      assertTrue(eit == expected.end());
+      std::map<int, int>::const_reverse_iterator rit = expected.rbegin();
+      for (Iterator<Tuple<const int, int> > it = d.rbegin(); it; it++)
+         assertEquals((rit++)->first, it->get<0>());
+      for (int i = 0; i < 5000; i++)
+         d.remove(i);
+      assertTrue(d.isEmpty());
+   });
+
+   KAREN_DECL_TEST(shouldBuildFromSortedEntries,
+   {
+      std::vector<Tuple<const int, int> > entries;
+      for (int i = 0; i < 10000; i++)
+         entries.push_back(Tuple<const int, int>(i * 2, i));
+      BTreeMap<int, int> d(&entries[0], entries.size());
+      assertEquals<int>(10000, d.size());
+      for (int i = 0; i < 10000; i++)
+         assertEquals(i, d.get(i * 2));
+      assertFalse(d.hasKey(3));
+      for (int i = 0; i < 10000; i += 3)
+         d.remove(i * 2);
+      for (int i = 0; i < 10000; i++)
+         assertTrue((i % 3 != 0) == d.hasKey(i * 2));
+   });
+
+   KAREN_DECL_TEST(shouldBuildFromUnsortedEntries,
+   {
+      Tuple<const int, int> entries[] =
+      {
+         Tuple<const int, int>(3, 30),
+         Tuple<const int, int>(1, 10),
+         Tuple<const int, int>(3, 31),
+         Tuple<const int, int>(2, 20),
+      };
+      BTreeMap<int, int> d(entries, 4);
+      assertEquals<int>(3, d.size());
+      assertEquals(30, d.get(3));
+      assertEquals(1, d.begin()->get<0>());
+   });
+
+   KAREN_DECL_TEST(shouldFindBounds,
+   {
+      BTreeMap<int, int> d;
+      for (int i = 0; i < 1000; i++)
+         d.put(i * 10, i);
+      assertEquals(500, d.lowerBound(500)->get<0>());
+      assertEquals(510, d.upperBound(500)->get<0>());
+      assertEquals(510, d.lowerBound(501)->get<0>());
+      assertFalse(d.lowerBound(9991));
+      assertFalse(d.upperBound(9990));
+      int count = 0, sum = 0;
+      for (auto& entry : d.fastRange(100, 200))
+      {
+         sum += entry.get<1>();
+         count++;
+      }
+      assertEquals(10, count);
+      assertEquals(145, sum);
+   });
+
+   KAREN_DECL_TEST(shouldRemoveByIterator,
+   {
+      BTreeMap<int, int> d;
+      for (int i = 0; i < 1000; i++)
+         d.put(i, i);
+      for (Iterator<Tuple<const int, int> > it = d.begin(); it; )
+      {
+         if (it->get<0>() % 2)
+            d.remove(it);
+         else
+            it++;
+      }
+      assertEquals<int>(500, d.size());
+      for (Iterator<Tuple<const int, int> > it = d.rbegin(); it; )
+      {
+         if (it->get<0>() % 4)
+            d.remove(it);
+         else
+            it++;
+      }
+      assertEquals<int>(250, d.size());
+      for (int i = 0; i < 1000; i++)
+         assertTrue((i % 4 == 0) == d.hasKey(i));
+   });
+
+   KAREN_DECL_TEST(shouldCopyBTreeMap,
+   {
+      BTreeMap<String, int> d;
+      for (int i = 0; i < 500; i++)
+         d.put(String::format("key%d", i), i);
+      BTreeMap<String, int> c(d);
+      c["key10"] = -1;
+      assertEquals<int>(500, c.size());
+      assertEquals(10, d["key10"]);
+      assertEquals(-1, c["key10"]);
+      assertEquals(499, c["key499"]);
+   });
+
+   KAREN_DECL_TEST(shouldPutValueOfAnotherEntry,
+   {
+      BTreeMap<int, String> d;
+      d.put(0, String("a string that lives out of line"));
+      for (int i = 1; i < 500; i++)
+         d.put(-i, d.get(1 - i));
+      assertEquals(String("a string that lives out of line"), d.get(-499));
+   });
+
+   KAREN_DECL_TEST(shouldTryToGetElements,
+   {
+      BTreeMap<String, NoDefault> d;
+      d.put("Mark", NoDefault(45));
+      assertTrue(d.tryGet("John") == NULL);
+      assertEquals(45, d.tryGet("Mark")->value);
+      d.tryGet("Mark")->value = 40;
+      const BTreeMap<String, NoDefault>& cd = d;
+      assertEquals(40, cd.tryGet("Mark")->value);
+      assertTrue(cd.tryGet("John") == NULL);
+   });
+
+   KAREN_DECL_TEST(shouldComputeIfAbsent,
+   {
+      BTreeMap<String, NoDefault> d;
+      int calls = 0;
+      auto make = [&calls]() { calls++; return NoDefault(7); };
+      assertEquals(7, d.computeIfAbsent("Mark", make).value);
+      d.computeIfAbsent("Mark", make).value = 8;
+      assertEquals(8, d.computeIfAbsent("Mark", make).value);
+      assertEquals(1, calls);
+      assertEquals<int>(1, d.size());
+   });
+
+   KAREN_DECL_TEST(shouldGetOrInsert,
+   {
+      BTreeMap<String, int> d;
+      d.getOrInsert("Mark") += 2;
+      d.getOrInsert("Mark") += 3;
+      assertEquals(5, d.get("Mark"));
+      assertEquals<int>(1, d.size());
+   });
+
+   KAREN_DECL_TEST(shouldInsertOrAssign,
+   {
+      BTreeMap<String, NoDefault> d;
+      assertTrue(d.insertOrAssign("Mark", NoDefault(1)));
+      NoDefault two(2);
+      assertFalse(d.insertOrAssign("Mark", two));
+      assertEquals<int>(1, d.size());
+      assertEquals(2, d.get("Mark").value);
+   });
+
+KAREN_END_UNIT_TEST(BTreeMapTestSuite);
+
 int main(int argc, char* argv[])
 {
    StdOutUnitTestReporter rep;
    MapTestSuite suite;
    suite.run(&rep, NULL, 0);
+   HashMapTestSuite hashSuite;
+   hashSuite.run(&rep, NULL, 0);
+   BTreeMapTestSuite btreeSuite;
+   btreeSuite.run(&rep, NULL, 0);
 }
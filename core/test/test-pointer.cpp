@@ -0,0 +1,325 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <thread>
+#include <vector>
+
+#include <KarenCore/pointer.h>
+#include <KarenCore/test.h>
+
+using namespace karen;
+
+/*
+ * Object type that counts how many instances are alive.
+ */
+static std::atomic<int> liveObjects(0);
+
+struct Object
+{
+   int value;
+
+   Object(int v = 0) : value(v) { liveObjects++; }
+   virtual ~Object() { liveObjects--; }
+};
+
+struct DerivedObject : public Object
+{
+   DerivedObject(int v = 0) : Object(v) {}
+};
+
+/*
+ * Object type that counts its references intrusively.
+ */
+struct CountedObject : public Object, public RefCounted<>
+{
+   CountedObject(int v = 0) : Object(v) {}
+};
+
+struct ThrowingObject : public Object
+{
+   ThrowingObject() : Object(0) { throw 1; }
+};
+
+KAREN_BEGIN_UNIT_TEST(PtrTestSuite);
+
+   KAREN_DECL_TEST(createNullPointer,
+   {
+      Ptr<Object> p;
+      assertTrue(p.isNull());
+      assertEquals<int>(0, p.count());
+      try
+      {
+         p->value = 1;
+         assertionFailed("expected exception not raised");
+      }
+      catch (NullPointerException&) {}
+   });
+
+   KAREN_DECL_TEST(shareObject,
+   {
+      liveObjects = 0;
+      {
+         Ptr<Object> p1 = new Object(7);
+         {
+            Ptr<Object> p2 = p1;
+            assertEquals<int>(2, p1.count());
+            assertTrue(p1 == p2);
+            assertEquals(7, p2->value);
+         }
+         assertEquals<int>(1, p1.count());
+         assertEquals(1, liveObjects.load());
+      }
+      assertEquals(0, liveObjects.load());
+   });
+
+   KAREN_DECL_TEST(moveObject,
+   {
+      Ptr<Object> p1 = new Object(7);
+      Ptr<Object> p2(std::move(p1));
+      assertTrue(p1.isNull());
+      assertEquals<int>(1, p2.count());
+   });
+
+   KAREN_DECL_TEST(castObject,
+   {
+      liveObjects = 0;
+      {
+         Ptr<DerivedObject> d = new DerivedObject(3);
+         Ptr<Object> o = d;
+         assertEquals<int>(2, d.count());
+         assertTrue(o.isOfClass<DerivedObject>());
+         Ptr<DerivedObject> back = o.dynCasting<DerivedObject>();
+         assertEquals<int>(3, back.count());
+      }
+      assertEquals(0, liveObjects.load());
+   });
+
+   KAREN_DECL_TEST(shareAtomicObject,
+   {
+      liveObjects = 0;
+      {
+         AtomicPtr<Object> p1 = new DerivedObject(7);
+         AtomicPtr<Object> p2 = p1;
+         assertEquals<int>(2, p1.count());
+         AtomicPtr<DerivedObject> d = p1.dynCasting<DerivedObject>();
+         assertEquals(7, d->value);
+      }
+      assertEquals(0, liveObjects.load());
+   });
+
+KAREN_END_UNIT_TEST(PtrTestSuite);
+
+KAREN_BEGIN_UNIT_TEST(MakePtrTestSuite);
+
+   KAREN_DECL_TEST(makeAndReleasePointer,
+   {
+      liveObjects = 0;
+      {
+         Ptr<Object> p1 = makePtr<Object>(7);
+         Ptr<Object> p2 = p1;
+         assertEquals(7, p2->value);
+         assertEquals<int>(2, p1.count());
+         assertEquals(1, liveObjects.load());
+      }
+      assertEquals(0, liveObjects.load());
+   });
+
+   KAREN_DECL_TEST(makeDerivedPointer,
+   {
+      liveObjects = 0;
+      {
+         Ptr<Object> o = makePtr<DerivedObject>(3);
+         assertTrue(o.isOfClass<DerivedObject>());
+         assertEquals(3, o.dynCasting<DerivedObject>()->value);
+      }
+      assertEquals(0, liveObjects.load());
+   });
+
+   KAREN_DECL_TEST(weakPointerOutlivesObject,
+   {
+      liveObjects = 0;
+      WeakPtr<Object> w;
+      {
+         AtomicPtr<Object> p = makePtr<Object, AtomicCounting>(5);
+         WeakPtr<Object, AtomicCounting> aw = p;
+         assertEquals(5, aw.lock()->value);
+         Ptr<Object> q = makePtr<Object>(6);
+         w = q;
+      }
+      assertEquals(0, liveObjects.load());
+      assertTrue(w.isExpired());
+      assertTrue(w.lock().isNull());
+   });
+
+   KAREN_DECL_TEST(makePointerFromThrowingConstructor,
+   {
+      liveObjects = 0;
+      try
+      {
+         makePtr<ThrowingObject>();
+         assertionFailed("expected exception not raised");
+      }
+      catch (int&) {}
+      assertEquals(0, liveObjects.load());
+   });
+
+   KAREN_DECL_TEST(shareIntrusiveObjectFromRawPointer,
+   {
+      liveObjects = 0;
+      {
+         CountedObject* obj = new CountedObject(4);
+         Ptr<CountedObject> p1 = obj;
+         Ptr<CountedObject> p2 = obj;
+         assertEquals<int>(2, p1.count());
+         assertTrue(p1 == p2);
+         Ptr<CountedObject> p3 = makePtr<CountedObject>(8);
+         assertEquals<int>(1, p3.count());
+         p3 = p2;
+         assertEquals<int>(3, p1.count());
+         assertEquals(1, liveObjects.load());
+      }
+      assertEquals(0, liveObjects.load());
+   });
+
+KAREN_END_UNIT_TEST(MakePtrTestSuite);
+
+KAREN_BEGIN_UNIT_TEST(WeakPtrTestSuite);
+
+   KAREN_DECL_TEST(createExpiredPointer,
+   {
+      WeakPtr<Object> w;
+      assertTrue(w.isExpired());
+      assertTrue(w.lock().isNull());
+   });
+
+   KAREN_DECL_TEST(lockLiveObject,
+   {
+      Ptr<Object> p = new Object(5);
+      WeakPtr<Object> w = p;
+      assertFalse(w.isExpired());
+      assertEquals<int>(1, w.count());
+      Ptr<Object> q = w.lock();
+      assertEquals<int>(2, p.count());
+      assertEquals(5, q->value);
+   });
+
+   KAREN_DECL_TEST(expireWhenObjectIsReleased,
+   {
+      liveObjects = 0;
+      WeakPtr<Object> w;
+      {
+         Ptr<Object> p = new Object(5);
+         w = p;
+         WeakPtr<Object> copy = w;
+         assertFalse(copy.isExpired());
+      }
+      assertEquals(0, liveObjects.load());
+      assertTrue(w.isExpired());
+      assertTrue(w.lock().isNull());
+      w.reset();
+      assertTrue(w.isExpired());
+   });
+
+   KAREN_DECL_TEST(referToBaseClass,
+   {
+      Ptr<DerivedObject> d = new DerivedObject(9);
+      WeakPtr<Object> w = d;
+      WeakPtr<Object> moved(std::move(w));
+      assertTrue(w.isExpired());
+      assertEquals(9, moved.lock()->value);
+   });
+
+KAREN_END_UNIT_TEST(WeakPtrTestSuite);
+
+KAREN_BEGIN_UNIT_TEST(AtomicPtrStressTestSuite);
+
+   KAREN_DECL_TEST(copyAndReleaseFromManyThreads,
+   {
+      liveObjects = 0;
+      {
+         AtomicPtr<Object> shared = new Object(1);
+         std::vector<std::thread> threads;
+         std::atomic<int> total(0);
+         for (int t = 0; t < 8; t++)
+            threads.push_back(std::thread([&shared, &total]()
+            {
+               int sum = 0;
+               for (int i = 0; i < 20000; i++)
+               {
+                  AtomicPtr<Object> copy = shared;
+                  AtomicPtr<Object> other = copy;
+                  sum += other->value;
+               }
+               total += sum;
+            }));
+         for (auto& t : threads)
+            t.join();
+         assertEquals(8 * 20000, total.load());
+         assertEquals<int>(1, shared.count());
+      }
+      assertEquals(0, liveObjects.load());
+   });
+
+   KAREN_DECL_TEST(lockWhileReleasingFromManyThreads,
+   {
+      liveObjects = 0;
+      for (int round = 0; round < 200; round++)
+      {
+         AtomicPtr<Object>* owner = new AtomicPtr<Object>(new Object(1));
+         WeakPtr<Object, AtomicCounting> weak = *owner;
+         std::vector<std::thread> threads;
+         std::atomic<int> errors(0);
+         for (int t = 0; t < 4; t++)
+            threads.push_back(std::thread([&weak, &errors]()
+            {
+               for (int i = 0; i < 200; i++)
+               {
+                  AtomicPtr<Object> p = weak.lock();
+                  if (p.isNotNull() && p->value != 1)
+                     errors++;
+               }
+            }));
+         delete owner;
+         for (auto& t : threads)
+            t.join();
+         assertEquals(0, errors.load());
+         assertTrue(weak.isExpired());
+      }
+      assertEquals(0, liveObjects.load());
+   });
+
+KAREN_END_UNIT_TEST(AtomicPtrStressTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   PtrTestSuite ptrSuite;
+   ptrSuite.run(&rep, NULL, 0);
+   MakePtrTestSuite makeSuite;
+   makeSuite.run(&rep, NULL, 0);
+   WeakPtrTestSuite weakSuite;
+   weakSuite.run(&rep, NULL, 0);
+   AtomicPtrStressTestSuite stressSuite;
+   stressSuite.run(&rep, NULL, 0);
+}
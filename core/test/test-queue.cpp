@@ -25,6 +25,8 @@
 #include <KarenCore/queue.h>
 #include <KarenCore/test.h>
 
+#include "test-tracked.h"
+
 using namespace karen;
 
 KAREN_BEGIN_UNIT_TEST(PriorityQueueTestSuite);
@@ -163,11 +165,153 @@ KAREN_BEGIN_UNIT_TEST(PriorityQueueTestSuite);
       }
    });
    
+   KAREN_DECL_TEST(moveElementsWithoutCopying,
+   {
+      trackedCopies = 0;
+      PriorityQueue<Tracked> q;
+      for (int i = 0; i < 4; i++)
+         q.put(Tracked(i));
+      q.emplace(10);
+      assertEquals(10, q.poll().value);
+      assertEquals(3, q.poll().value);
+      assertEquals(0, trackedCopies);
+   });
+   
+   KAREN_DECL_TEST(pullFromEmptyQueue,
+   {
+      PriorityQueue<int> q;
+      try
+      {
+         q.poll();
+         assertionFailed("expected exception not raised");
+      }
+      catch (NotFoundException&) {}
+   });
+   
 KAREN_END_UNIT_TEST(PriorityQueueTestSuite);
 
+KAREN_BEGIN_UNIT_TEST(HeapPriorityQueueTestSuite);
+
+   typedef PriorityQueue<int, DefaultLessThan<int>, 
+         DaryHeap<int> > IntQueue;
+
+   KAREN_DECL_TEST(createEmptyQueue,
+   {
+      IntQueue q;
+      assertTrue(q.isEmpty());
+      assertEquals<int>(0, q.size());
+   });
+
+   KAREN_DECL_TEST(pullElementsInOrder,
+   {
+      IntQueue q;
+      int elems[] = { 10, 4, 15, 1, 3, 15, 8 };
+      for (int i = 0; i < 7; i++)
+         q.put(elems[i]);
+      assertEquals<int>(7, q.size());
+      assertEquals(15, q.head());
+      int expected[] = { 15, 15, 10, 8, 4, 3, 1 };
+      for (int i = 0; i < 7; i++)
+         assertEquals(expected[i], q.poll());
+      assertTrue(q.isEmpty());
+   });
+
+   KAREN_DECL_TEST(removeElement,
+   {
+      IntQueue q;
+      q.put(10);
+      q.put(4);
+      q.put(15);
+      q.put(1);
+      q.put(15);
+      q.removeAll(15);
+      assertEquals<int>(3, q.size());
+      assertTrue(q.hasElement(1));
+      assertTrue(q.hasElement(4));
+      assertTrue(q.hasElement(10));
+      assertFalse(q.hasElement(15));
+      assertEquals<int>(10, q.head());
+   });
+
+   KAREN_DECL_TEST(pullFromEmptyQueue,
+   {
+      IntQueue q;
+      try
+      {
+         q.poll();
+         assertionFailed("expected exception not raised");
+      }
+      catch (NotFoundException&) {}
+   });
+
+   KAREN_DECL_TEST(moveElementsWithoutCopying,
+   {
+      trackedCopies = 0;
+      PriorityQueue<Tracked, DefaultLessThan<Tracked>, 
+            DaryHeap<Tracked> > q;
+      for (int i = 0; i < 4; i++)
+         q.put(Tracked(i));
+      q.emplace(10);
+      assertEquals(10, q.poll().value);
+      assertEquals(3, q.poll().value);
+      assertEquals(0, trackedCopies);
+   });
+
+KAREN_END_UNIT_TEST(HeapPriorityQueueTestSuite);
+
+KAREN_BEGIN_UNIT_TEST(QueueTestSuite);
+
+   KAREN_DECL_TEST(createEmptyQueue,
+   {
+      Queue<int> q;
+      assertTrue(q.isEmpty());
+      assertEquals<int>(0, q.size());
+   });
+
+   KAREN_DECL_TEST(pullElementsInOrder,
+   {
+      Queue<int> q;
+      for (int i = 0; i < 4; i++)
+         q.put(i);
+      assertEquals<int>(4, q.size());
+      assertEquals(0, q.head());
+      for (int i = 0; i < 4; i++)
+         assertEquals(i, q.poll());
+      assertTrue(q.isEmpty());
+   });
+
+   KAREN_DECL_TEST(pullFromEmptyQueue,
+   {
+      Queue<int> q;
+      try
+      {
+         q.poll();
+         assertionFailed("expected exception not raised");
+      }
+      catch (NotFoundException&) {}
+   });
+
+   KAREN_DECL_TEST(moveElementsWithoutCopying,
+   {
+      trackedCopies = 0;
+      Queue<Tracked> q;
+      Tracked t(1);
+      q.put(std::move(t));
+      q.emplace(2);
+      assertEquals(1, q.poll().value);
+      assertEquals(2, q.poll().value);
+      assertEquals(0, trackedCopies);
+   });
+
+KAREN_END_UNIT_TEST(QueueTestSuite);
+
 int main(int argc, char* argv[])
 {
    StdOutUnitTestReporter rep;
    PriorityQueueTestSuite suite;
    suite.run(&rep, NULL, 0);
+   HeapPriorityQueueTestSuite heapSuite;
+   heapSuite.run(&rep, NULL, 0);
+   QueueTestSuite queueSuite;
+   queueSuite.run(&rep, NULL, 0);
 }
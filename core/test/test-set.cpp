@@ -134,12 +134,122 @@ KAREN_BEGIN_UNIT_TEST(SetTestSuite);
       assertTrue(s.isEmpty());
       assertEquals<int>(0, s.size());
    });
+
+   KAREN_DECL_TEST(emplaceElements,
+   {
+      TreeSet<String> s;
+      s.emplace("xxxyz", 3);
+      s.insert(String("abc"));
+      s.emplace("abc");
+      assertEquals<int>(2, s.size());
+      assertEquals(String("abc"), *s.begin());
+      TreeMultiset<String> ms;
+      ms.emplace("abc");
+      ms.insert(String("abc"));
+      assertEquals<int>(2, ms.size());
+   });
    
+   KAREN_DECL_TEST(findElement,
+   {
+      TreeSet<String> s;
+      s.insert("foo");
+      s.insert("bar");
+      const String* found = s.find("bar");
+      assertTrue(found != NULL);
+      assertEquals(String("bar"), *found);
+      assertTrue(s.find("baz") == NULL);
+      TreeMultiset<int> ms;
+      ms.insert(4);
+      ms.insert(4);
+      assertEquals(4, *ms.find(4));
+      assertTrue(ms.find(5) == NULL);
+   });
+
 KAREN_END_UNIT_TEST(SetTestSuite);
 
+KAREN_BEGIN_UNIT_TEST(HashSetTestSuite);
+
+   KAREN_DECL_TEST(createEmptySet,
+   {
+      HashSet<int> s;
+      assertTrue(s.isEmpty());
+      assertEquals<int>(0, s.size());
+      assertFalse(s.contains(10));
+   });
+   
+   KAREN_DECL_TEST(insertDuplicatedElements,
+   {
+      HashSet<String> s;
+      s.insert("foo");
+      s.insert("bar");
+      s.insert("foo");
+      s.emplace("bar");
+      assertEquals<int>(2, s.size());
+      assertTrue(s.contains("foo"));
+      assertTrue(s.contains("bar"));
+      assertFalse(s.contains("baz"));
+   });
+
+   KAREN_DECL_TEST(insertManyElements,
+   {
+      HashSet<int> s;
+      for (int i = 0; i < 5000; i++)
+         s.insert(i * 7);
+      assertEquals<int>(5000, s.size());
+      for (int i = 0; i < 5000; i++)
+      {
+         assertTrue(s.contains(i * 7));
+         assertFalse(s.contains(i * 7 + 1));
+      }
+   });
+
+   KAREN_DECL_TEST(removeElements,
+   {
+      HashSet<int> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i);
+      for (int i = 0; i < 100; i += 3)
+         s.removeAll(i);
+      assertEquals<int>(66, s.size());
+      int sum = 0;
+      for (Iterator<const int> it = s.begin(); it; )
+      {
+         sum += *it;
+         s.remove(it);
+      }
+      assertTrue(s.isEmpty());
+      assertEquals(3267, sum);
+   });
+
+   KAREN_DECL_TEST(reserveCapacity,
+   {
+      HashSet<int> s;
+      s.reserve(1000);
+      unsigned long capacity = s.capacity();
+      assertTrue(capacity >= 1000);
+      for (int i = 0; i < 1000; i++)
+         s.insert(i);
+      assertEquals<int>(capacity, s.capacity());
+   });
+   
+   KAREN_DECL_TEST(findElement,
+   {
+      HashSet<int> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i * 3);
+      assertEquals(42, *s.find(42));
+      assertTrue(s.find(43) == NULL);
+      const Set<int>& base = s;
+      assertEquals(99, *base.find(99));
+   });
+   
+KAREN_END_UNIT_TEST(HashSetTestSuite);
+
 int main(int argc, char* argv[])
 {
    StdOutUnitTestReporter rep;
    SetTestSuite suite;
    suite.run(&rep, NULL, 0);
+   HashSetTestSuite hashSuite;
+   hashSuite.run(&rep, NULL, 0);
 }
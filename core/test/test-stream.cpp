@@ -0,0 +1,292 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#include <KarenCore/buffer.h>
+#include <KarenCore/stream.h>
+#include <KarenCore/test.h>
+
+using namespace karen;
+
+/*
+ * Input stream decorator counting the calls that reach its source.
+ */
+class CountingInputStream : public InputStream
+{
+public:
+
+   unsigned long calls;
+
+   inline CountingInputStream(InputStream* source) 
+    : calls(0), _source(source) {}
+
+   virtual unsigned long readBytes(void* dst, unsigned long len)
+         throw (IOException)
+   {
+      calls++;
+      return _source->readBytes(dst, len);
+   }
+
+private:
+
+   InputStream* _source;
+
+};
+
+/*
+ * Output stream decorator counting the calls that reach its target.
+ */
+class CountingOutputStream : public OutputStream
+{
+public:
+
+   unsigned long calls;
+
+   inline CountingOutputStream(OutputStream* target) 
+    : calls(0), _target(target) {}
+
+   virtual unsigned long writeBytes(const void* data, unsigned long len)
+         throw (IOException)
+   {
+      calls++;
+      return _target->writeBytes(data, len);
+   }
+
+private:
+
+   OutputStream* _target;
+
+};
+
+static void fillWithSequence(Buffer& buf)
+{
+   for (unsigned long i = 0; i < buf.length() / sizeof(UInt32); i++)
+      buf.set<UInt32>(i * sizeof(UInt32), i * sizeof(UInt32));
+}
+
+KAREN_BEGIN_UNIT_TEST(StreamTestSuite);
+
+   KAREN_DECL_TEST(shouldWriteAndReadArrays,
+   {
+      Buffer buf(4096);
+      UInt32 values[1024];
+      for (UInt32 i = 0; i < 1024; i++)
+         values[i] = i * 3;
+      BufferOutputStream os(&buf);
+      os.writeArray(values, 1024);
+      assertEquals<int>(0, os.bytesLeftToWrite());
+
+      UInt32 read[1024];
+      BufferInputStream is(&buf);
+      is.readArray(read, 1024);
+      for (UInt32 i = 0; i < 1024; i++)
+         assertEquals<UInt32>(i * 3, read[i]);
+   });
+
+   KAREN_DECL_TEST(shouldReadArrayWithOneCallPerChunk,
+   {
+      Buffer buf(4096);
+      BufferInputStream is(&buf);
+      CountingInputStream counter(&is);
+      UInt32 values[1024];
+      counter.readArray(values, 1024);
+      assertEquals<unsigned long>(1, counter.calls);
+   });
+
+   KAREN_DECL_TEST(shouldFailReadingArrayPastEndOfStream,
+   {
+      Buffer buf(16);
+      BufferInputStream is(&buf);
+      UInt32 values[5];
+      try
+      {
+         is.readArray(values, 5);
+         assertionFailed("Expected IOException not thrown");
+      }
+      catch (IOException&) {}
+   });
+
+   KAREN_DECL_TEST(shouldSkipBytes,
+   {
+      Buffer buf(64);
+      fillWithSequence(buf);
+      BufferInputStream is(&buf);
+      assertEquals<unsigned long>(8, is.skip(8));
+      assertEquals<UInt32>(8, is.read<UInt32>());
+      assertEquals<unsigned long>(52, is.skip(100));
+      assertEquals<unsigned long>(0, is.skip(1));
+   });
+
+   KAREN_DECL_TEST(shouldSkipBytesByReadingThem,
+   {
+      Buffer buf(4096);
+      fillWithSequence(buf);
+      BufferInputStream is(&buf);
+      CountingInputStream counter(&is);
+      assertEquals<unsigned long>(1024, counter.skip(1024));
+      assertEquals<UInt32>(1024, counter.read<UInt32>());
+      assertEquals<unsigned long>(3068, counter.skip(5000));
+   });
+
+   KAREN_DECL_TEST(shouldReadSourceInChunks,
+   {
+      Buffer buf(4096);
+      fillWithSequence(buf);
+      BufferInputStream is(&buf);
+      CountingInputStream counter(&is);
+      BufferedInputStream bis(&counter, 256);
+      for (UInt32 i = 0; i < 1024; i++)
+         assertEquals<UInt32>(i * 4, bis.read<UInt32>());
+      assertEquals<unsigned long>(16, counter.calls);
+      UInt8 end;
+      assertEquals<unsigned long>(0, bis.readBytes(&end, 1));
+   });
+
+   KAREN_DECL_TEST(shouldBypassBufferForLargeReads,
+   {
+      Buffer buf(4096);
+      fillWithSequence(buf);
+      BufferInputStream is(&buf);
+      CountingInputStream counter(&is);
+      BufferedInputStream bis(&counter, 256);
+      assertEquals<UInt32>(0, bis.read<UInt32>());
+      UInt32 values[1023];
+      bis.readArray(values, 1023);
+      assertEquals<UInt32>(4, values[0]);
+      assertEquals<UInt32>(4092, values[1022]);
+      assertEquals<unsigned long>(2, counter.calls);
+   });
+
+   KAREN_DECL_TEST(shouldPeekWithoutConsuming,
+   {
+      Buffer buf(64);
+      fillWithSequence(buf);
+      BufferInputStream is(&buf);
+      BufferedInputStream bis(&is, 16);
+      assertEquals<UInt32>(0, bis.peek<UInt32>());
+      assertEquals<UInt32>(0, bis.read<UInt32>());
+      bis.skip(8);
+      // The peeked element spans the end of the buffered bytes.
+      assertEquals<UInt64>(0x000000100000000Cull, bis.peek<UInt64>());
+      assertEquals<UInt32>(12, bis.read<UInt32>());
+      assertEquals<UInt32>(16, bis.read<UInt32>());
+      bis.skip(40);
+      UInt32 last[2];
+      assertEquals<unsigned long>(4, bis.peekBytes(last, 8));
+      assertEquals<UInt32>(60, last[0]);
+      try
+      {
+         bis.peek<UInt64>();
+         assertionFailed("Expected IOException not thrown");
+      }
+      catch (IOException&) {}
+   });
+
+   KAREN_DECL_TEST(shouldFailPeekingMoreThanBufferSize,
+   {
+      Buffer buf(64);
+      BufferInputStream is(&buf);
+      BufferedInputStream bis(&is, 16);
+      UInt8 data[32];
+      try
+      {
+         bis.peekBytes(data, 32);
+         assertionFailed("Expected InvalidInputException not thrown");
+      }
+      catch (InvalidInputException&) {}
+   });
+
+   KAREN_DECL_TEST(shouldSkipPastBufferedBytes,
+   {
+      Buffer buf(4096);
+      fillWithSequence(buf);
+      BufferInputStream is(&buf);
+      BufferedInputStream bis(&is, 256);
+      bis.read<UInt32>();
+      assertEquals<unsigned long>(1000, bis.skip(1000));
+      assertEquals<UInt32>(1004, bis.read<UInt32>());
+      assertEquals<unsigned long>(3088, bis.skip(5000));
+   });
+
+   KAREN_DECL_TEST(shouldWriteTargetInChunks,
+   {
+      Buffer buf(4096);
+      BufferOutputStream os(&buf);
+      CountingOutputStream counter(&os);
+      {
+         BufferedOutputStream bos(&counter, 256);
+         for (UInt32 i = 0; i < 1000; i++)
+            bos.write<UInt32>(i * 4);
+         assertEquals<unsigned long>(15, counter.calls);
+         assertEquals<unsigned long>(160, bos.bytesBuffered());
+         bos.flush();
+         assertEquals<unsigned long>(16, counter.calls);
+         assertEquals<unsigned long>(0, bos.bytesBuffered());
+         bos.write<UInt32>(4000);
+      }
+      assertEquals<unsigned long>(17, counter.calls);
+      for (UInt32 i = 0; i < 1001; i++)
+         assertEquals<UInt32>(i * 4, buf.get<UInt32>(i * 4));
+   });
+
+   KAREN_DECL_TEST(shouldBypassBufferForLargeWrites,
+   {
+      Buffer buf(4096);
+      BufferOutputStream os(&buf);
+      CountingOutputStream counter(&os);
+      BufferedOutputStream bos(&counter, 256);
+      UInt32 values[1000];
+      for (UInt32 i = 0; i < 1000; i++)
+         values[i] = i;
+      bos.write<UInt32>(7);
+      bos.writeArray(values, 1000);
+      assertEquals<unsigned long>(2, counter.calls);
+      assertEquals<unsigned long>(0, bos.bytesBuffered());
+      assertEquals<UInt32>(7, buf.get<UInt32>(0));
+      assertEquals<UInt32>(999, buf.get<UInt32>(4000));
+   });
+
+   KAREN_DECL_TEST(shouldFailFlushingWhenTargetIsFull,
+   {
+      Buffer buf(16);
+      BufferOutputStream os(&buf);
+      BufferedOutputStream bos(&os, 64);
+      UInt8 data[24] = { 0 };
+      bos.writeArray(data, 24);
+      try
+      {
+         bos.flush();
+         assertionFailed("Expected IOException not thrown");
+      }
+      catch (IOException&) {}
+      assertEquals<unsigned long>(8, bos.bytesBuffered());
+   });
+
+KAREN_END_UNIT_TEST(StreamTestSuite);
+
+int main(int argc, char* argv[])
+{
+   StdOutUnitTestReporter rep;
+   StreamTestSuite suite;
+   suite.run(&rep, NULL, 0);
+}
@@ -22,9 +22,16 @@
  * ---------------------------------------------------------------------
  */
 
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
 #include <KarenCore/numeric.h>
 #include <KarenCore/collection.h>
+#include <KarenCore/hash.h>
 #include <KarenCore/parsing.h>
+#include <KarenCore/simd.h>
 #include <KarenCore/string.h>
 #include <KarenCore/test.h>
 #include <KarenCore/types.h>
@@ -451,6 +458,83 @@ KAREN_BEGIN_UNIT_TEST(StringTestSuite);
       assertEquals<String>(s1, s2);
    });
    
+   KAREN_DECL_TEST(convertCaseInPlace,
+   {
+      String s("Welcome to the Jungle, 1987!");
+      s.toUpperCaseInPlace();
+      assertEquals<String>("WELCOME TO THE JUNGLE, 1987!", s);
+      s.toLowerCaseInPlace();
+      assertEquals<String>("welcome to the jungle, 1987!", s);
+      s.capitalizeInPlace();
+      assertEquals<String>("Welcome to the jungle, 1987!", s);
+   });
+
+   KAREN_DECL_TEST(findString,
+   {
+      String s("the quick brown fox jumps over the lazy dog");
+      assertEquals<int>(4, s.find("quick"));
+      assertEquals<int>(31, s.find("the", 1));
+      assertEquals<int>(0, s.find(""));
+      assertEquals<int>(40, s.find("dog"));
+      assertTrue(s.find("cat").isNull());
+      assertTrue(s.find("dogs").isNull());
+      assertTrue(s.find("the", 32).isNull());
+      assertTrue(s.find("x", 255).isNull());
+   });
+
+   KAREN_DECL_TEST(searchAndConvertWithEveryKernel,
+   {
+      String text;
+      unsigned seed = 3;
+      for (int i = 0; i < 3000; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         text.append("aAbB zZ{@`\xc3\xa9"[(seed >> 16) % 12], 1);
+      }
+      // Make sure a UTF-8 sequence followed by ASCII is found
+      text.append("\xc3\xa9" "a");
+      std::string raw((const std::string&) text);
+      std::string lower(raw), upper(raw);
+      for (unsigned long i = 0; i < raw.length(); i++)
+      {
+         char c = raw[i];
+         lower[i] = (c >= 'A' && c <= 'Z') ? c + 32 : c;
+         upper[i] = (c >= 'a' && c <= 'z') ? c - 32 : c;
+      }
+      const char* patterns[] = { 
+         "ab", "zZ{", "B zZ{@", "aaaa", "\xc3\xa9" "a" 
+      };
+
+      SimdLevel levels[] = { karen::SIMD_SCALAR, karen::SIMD_SSE2, 
+                             karen::SIMD_AVX2 };
+      for (SimdLevel level : levels)
+      {
+         setSimdLevel(level);
+         assertTrue(text.toLowerCase() == lower.c_str());
+         assertTrue(text.toUpperCase() == upper.c_str());
+         for (unsigned long from = 0; from < raw.length(); from += 997)
+         {
+            for (const char* pattern : patterns)
+            {
+               std::string::size_type expected = raw.find(pattern, from);
+               String::Position found = text.find(pattern, from);
+               assertTrue(expected == std::string::npos ? 
+                          found.isNull() : 
+                          !found.isNull() && found == expected);
+            }
+            for (char c : StringView("aZ@x"))
+            {
+               std::string::size_type expected = raw.rfind(c, from);
+               String::Position found = text.reverseFindChar(c, from);
+               assertTrue(expected == std::string::npos ? 
+                          found.isNull() : 
+                          !found.isNull() && found == expected);
+            }
+         }
+      }
+      setSimdLevel(detectSimdLevel());
+   });
+
    KAREN_DECL_TEST(toIntPositiveBase10,
    {
       String s("1234");
@@ -574,9 +658,544 @@ KAREN_BEGIN_UNIT_TEST(StringTestSuite);
 
 KAREN_END_UNIT_TEST(StringTestSuite);
 
+KAREN_BEGIN_UNIT_TEST(StringViewTestSuite);
+
+   KAREN_DECL_TEST(createEmptyView,
+   {
+      StringView v;
+      assertEquals<int>(0, v.length());
+      assertTrue(v.isEmpty());
+      assertTrue(v == "");
+   });
+
+   KAREN_DECL_TEST(createViewOfString,
+   {
+      String s("foobar");
+      StringView v(s);
+      assertEquals<int>(6, v.length());
+      assertTrue(v.data() == (const char*) s);
+      assertTrue(v == s);
+      assertTrue(s == v);
+      assertEquals<String>(s, String(v));
+   });
+
+   KAREN_DECL_TEST(createViewOfCharArray,
+   {
+      const char* raw = "foobar";
+      StringView v(raw, 3);
+      assertEquals<int>(3, v.length());
+      assertEquals<String>("foo", String(v));
+      assertTrue(v != StringView(raw));
+   });
+
+   KAREN_DECL_TEST(sliceViewWithoutCopying,
+   {
+      String s("Welcome Foobar");
+      StringView v = s.sliceView(3, 4);
+      assertTrue(v.data() == (const char*) s + 3);
+      assertTrue(v == "come");
+      assertTrue(s.headView(7) == "Welcome");
+      assertTrue(s.tailView(6) == "Foobar");
+      assertTrue(s.tailView(255) == s);
+      assertTrue(s.sliceView(10, 255) == "obar");
+      assertTrue(s.sliceView(255, 3).isEmpty());
+      assertTrue(v.slice(1, 2) == "om");
+   });
+
+   KAREN_DECL_TEST(removeHeadAndTailView,
+   {
+      String s("Welcome Foobar");
+      assertTrue(s.removeHeadView("Welcome ") == "Foobar");
+      assertTrue(s.removeTailView(" Foobar") == "Welcome");
+      assertTrue(s.removeHeadView("Foo") == s);
+      assertTrue(s.removeTailView("Welcome") == s);
+      StringView v(s);
+      assertTrue(v.removeHead("Wel").removeTail("bar") == "come Foo");
+   });
+
+   KAREN_DECL_TEST(startsAndEndsWith,
+   {
+      StringView v("Welcome Foobar");
+      assertTrue(v.startsWith("Welc"));
+      assertTrue(v.startsWith(""));
+      assertFalse(v.startsWith("Foo"));
+      assertTrue(v.endsWith("bar"));
+      assertFalse(v.endsWith("Welcome Foobar and more"));
+      String s("Welcome Foobar");
+      assertTrue(s.startsWith(v.head(3)));
+      assertTrue(s.endsWith(v.tail(3)));
+   });
+
+   KAREN_DECL_TEST(findCharInView,
+   {
+      String s("the quick brown fox");
+      StringView v = s.sliceView(4, 11);
+      assertEquals<int>(2, v.findChar('i'));
+      assertEquals<int>(8, v.findChar('o'));
+      assertTrue(v.findChar('f').isNull());
+      assertTrue(v.findChar('q', 1).isNull());
+      assertEquals<int>(8, v.reverseFindChar('o'));
+      assertEquals<int>(5, v.reverseFindChar(' ', 6));
+      assertTrue(v.reverseFindChar('t').isNull());
+   });
+
+   KAREN_DECL_TEST(compareViews,
+   {
+      StringView a("abc"), b("abd"), c("ab");
+      assertTrue(a < b);
+      assertTrue(b > a);
+      assertTrue(c < a);
+      assertTrue(a <= a);
+      assertTrue(a >= c);
+      assertEquals(0, a.compare("abc"));
+      assertTrue(a.compare(c) > 0);
+   });
+
+   KAREN_DECL_TEST(indexView,
+   {
+      StringView v("foobar", 3);
+      assertEquals<int>('o', v[2]);
+      try
+      {
+         v[3];
+         assertionFailed("expected exception not raised");
+      }
+      catch (OutOfBoundsException&) {}
+   });
+
+   KAREN_DECL_TEST(iterateViewUsingForRange,
+   {
+      StringView v("abc");
+      String s;
+      for (char c : v)
+         s.append(c, 1);
+      assertEquals<String>("abc", s);
+   });
+
+   KAREN_DECL_TEST(hashViewAsString,
+   {
+      String s("Welcome Foobar");
+      assertTrue(DefaultHash<String>()(s) ==
+                 DefaultHash<StringView>()(StringView(s)));
+      assertTrue(DefaultHash<StringView>()(s.headView(7)) ==
+                 DefaultHash<String>()("Welcome"));
+   });
+
+   KAREN_DECL_TEST(tokenizeView,
+   {
+      String s("  Welcome  to the jungle ");
+      DynArray<StringView> tokens;
+      karen::tokenizeString(s, tokens);
+      assertEquals<int>(4, tokens.size());
+      assertTrue(tokens[0] == "Welcome");
+      assertTrue(tokens[1] == "to");
+      assertTrue(tokens[2] == "the");
+      assertTrue(tokens[3] == "jungle");
+      assertTrue(tokens[1].data() == (const char*) s + 11);
+   });
+
+   KAREN_DECL_TEST(tokenizeOnlySeparators,
+   {
+      DynArray<StringView> tokens;
+      karen::tokenizeString(StringView(",,,"), tokens, ',');
+      assertEquals<int>(0, tokens.size());
+   });
+
+KAREN_END_UNIT_TEST(StringViewTestSuite);
+
+KAREN_BEGIN_UNIT_TEST(TokenizerTestSuite);
+
+   KAREN_DECL_TEST(iterateTokensLazily,
+   {
+      Tokenizer tokenizer;
+      String s("  Welcome to  the jungle ");
+      const char* expected[] = { "Welcome", "to", "the", "jungle" };
+      int i = 0;
+      for (const StringView& token : tokenizer.tokens(s))
+         assertTrue(token == expected[i++]);
+      assertEquals(4, i);
+      Tokenizer::TokenIterator it = tokenizer.begin(s);
+      assertTrue(it->data() == (const char*) s + 2);
+      assertTrue(it != tokenizer.end());
+      ++it; ++it; ++it; ++it;
+      assertTrue(it.isNull());
+      assertTrue(it == tokenizer.end());
+   });
+
+   KAREN_DECL_TEST(tokenizeWithSeparatorSet,
+   {
+      Tokenizer tokenizer(" \t,;");
+      DynArray<StringView> tokens;
+      assertEquals<int>(5, tokenizer.tokenize("a,b;\tc  d;;,e", tokens));
+      assertTrue(tokens[0] == "a");
+      assertTrue(tokens[2] == "c");
+      assertTrue(tokens[4] == "e");
+   });
+
+   KAREN_DECL_TEST(tokenizeKeepingEmptyTokens,
+   {
+      Tokenizer tokenizer(",", '\0', false);
+      DynArray<StringView> tokens;
+      assertEquals<int>(5, tokenizer.tokenize(",a,,b,", tokens));
+      assertTrue(tokens[0] == "");
+      assertTrue(tokens[1] == "a");
+      assertTrue(tokens[2] == "");
+      assertTrue(tokens[3] == "b");
+      assertTrue(tokens[4] == "");
+      assertEquals<int>(0, tokenizer.tokenize("", tokens));
+   });
+
+   KAREN_DECL_TEST(tokenizeQuotedFields,
+   {
+      Tokenizer tokenizer(",", '"', false);
+      DynArray<StringView> tokens;
+      assertEquals<int>(4, tokenizer.tokenize(
+            "\"a,b\",c,\"\",\"unterminated, field", tokens));
+      assertTrue(tokens[0] == "a,b");
+      assertTrue(tokens[1] == "c");
+      assertTrue(tokens[2] == "");
+      assertTrue(tokens[3] == "unterminated, field");
+   });
+
+   KAREN_DECL_TEST(tokenizeTextAfterClosingQuote,
+   {
+      Tokenizer tokenizer(" ", '"');
+      DynArray<StringView> tokens;
+      assertEquals<int>(3, tokenizer.tokenize("\"a b\"c d", tokens));
+      assertTrue(tokens[0] == "a b");
+      assertTrue(tokens[1] == "c");
+      assertTrue(tokens[2] == "d");
+
+      Tokenizer csv(",", '"', false);
+      assertEquals<int>(4, csv.tokenize("\"a\"b,\"c\",", tokens));
+      assertTrue(tokens[0] == "a");
+      assertTrue(tokens[1] == "b");
+      assertTrue(tokens[2] == "c");
+      assertTrue(tokens[3] == "");
+   });
+
+   KAREN_DECL_TEST(tokenizeInBatches,
+   {
+      Tokenizer tokenizer;
+      StringView input("one two three four five");
+      TokenSpan spans[2];
+      const char* expected[] = { "one", "two", "three", "four", "five" };
+      int found = 0;
+      unsigned long offset = 0, n;
+      while ((n = tokenizer.tokenize(input, spans, 2, offset)) > 0)
+      {
+         for (unsigned long i = 0; i < n; i++)
+         {
+            StringView token = input.slice(spans[i].offset, spans[i].length);
+            assertTrue(token == expected[found++]);
+         }
+      }
+      assertEquals(5, found);
+   });
+
+   KAREN_DECL_TEST(tokenizeInBatchesWithQuotesAndEmptyTokens,
+   {
+      Tokenizer tokenizers[] = {
+         Tokenizer(" ", '"'),
+         Tokenizer(",", '\0', false),
+         Tokenizer(",", '"', false),
+      };
+      const char* inputs[] = { 
+         "\"a b\" c", "a,", ",", ",,a,,", "\"x,y\"z,,\"w\"", "",
+      };
+      for (unsigned int t = 0; t < 3; t++)
+         for (unsigned int i = 0; i < 6; i++)
+            for (unsigned long maxSpans = 1; maxSpans <= 3; maxSpans++)
+            {
+               StringView input(inputs[i]);
+               DynArray<StringView> expected;
+               tokenizers[t].tokenize(input, expected);
+               TokenSpan spans[3];
+               unsigned long offset = 0, n, found = 0, calls = 0;
+               while ((n = tokenizers[t].tokenize(
+                     input, spans, maxSpans, offset)) > 0)
+               {
+                  assertTrue(++calls <= expected.size());
+                  for (unsigned long j = 0; j < n; j++)
+                  {
+                     StringView token = input.slice(
+                           spans[j].offset, spans[j].length);
+                     assertTrue(token == expected[found++]);
+                  }
+               }
+               assertEquals<unsigned long>(expected.size(), found);
+            }
+   });
+
+   KAREN_DECL_TEST(tokenizeLongInputWithEveryKernel,
+   {
+      String input;
+      unsigned seed = 7;
+      for (int i = 0; i < 5000; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+         const char* pieces[] = { "x", "yy", " ", ",", "zzzzzzzzzzzz", "\t" };
+         input.append(pieces[(seed >> 16) % 6]);
+      }
+
+      // Reference tokens found with a plain scan
+      DynArray<StringView> expected;
+      const char* p = input;
+      const char* end = p + input.length();
+      while (p != end)
+      {
+         while (p != end && (*p == ' ' || *p == ',' || *p == '\t'))
+            p++;
+         const char* b = p;
+         while (p != end && *p != ' ' && *p != ',' && *p != '\t')
+            p++;
+         if (p != b)
+            expected.append(StringView(b, p - b));
+      }
+
+      SimdLevel levels[] = { karen::SIMD_SCALAR, karen::SIMD_SSE2, 
+                             karen::SIMD_AVX2 };
+      for (SimdLevel level : levels)
+      {
+         setSimdLevel(level);
+         Tokenizer tokenizer(" ,\t");
+         DynArray<StringView> tokens;
+         tokenizer.tokenize(input, tokens);
+         assertEquals<int>(expected.size(), tokens.size());
+         for (unsigned long i = 0; i < tokens.size(); i++)
+            assertTrue(tokens[i].data() == expected[i].data() &&
+                       tokens[i].length() == expected[i].length());
+
+         DynArray<TokenSpan> spans(expected.size() + 1);
+         assertEquals<int>(expected.size(), 
+               tokenizer.tokenize(input, &spans[0], spans.size()));
+         for (unsigned long i = 0; i < expected.size(); i++)
+            assertTrue(input.view().data() + spans[i].offset == 
+                             expected[i].data() &&
+                       spans[i].length == expected[i].length());
+      }
+      setSimdLevel(detectSimdLevel());
+   });
+
+   KAREN_DECL_TEST(tokenizeWithManySeparators,
+   {
+      Tokenizer tokenizer("0123456789");
+      DynArray<StringView> tokens;
+      assertEquals<int>(3, tokenizer.tokenize("ab12cd345ef6", tokens));
+      assertTrue(tokens[0] == "ab");
+      assertTrue(tokens[1] == "cd");
+      assertTrue(tokens[2] == "ef");
+   });
+
+KAREN_END_UNIT_TEST(TokenizerTestSuite);
+
+KAREN_BEGIN_UNIT_TEST(NumericTestSuite);
+
+   KAREN_DECL_TEST(parseLong,
+   {
+      const char* text = "-1234567890123abc";
+      long value = 0;
+      ParseResult res = Integer::parse(text, text + 17, value);
+      assertTrue(res.ok());
+      assertTrue(res.end == text + 14);
+      assertTrue(value == -1234567890123L);
+      assertTrue(Integer::parse(StringView("ff"), value, 16).ok());
+      assertEquals<int>(255, value);
+      assertTrue(Integer::parse(StringView("7"), value).ok());
+      assertEquals<int>(7, value);
+   });
+
+   KAREN_DECL_TEST(parseLongWithoutDigits,
+   {
+      const char* inputs[] = { "", "-", "+1", " 1", "abc", "z" };
+      for (const char* input : inputs)
+      {
+         long value = 42;
+         StringView str(input);
+         ParseResult res = Integer::parse(str, value);
+         assertTrue(res.error == PARSE_INVALID && res.end == str.begin());
+         assertEquals<int>(42, value);
+      }
+   });
+
+   KAREN_DECL_TEST(parseLongOutOfRange,
+   {
+      long value = 42;
+      StringView max("9223372036854775807");
+      StringView min("-9223372036854775808");
+      StringView over("9223372036854775808");
+      StringView under("-9223372036854775809");
+      assertTrue(Integer::parse(max, value).ok() && value == LONG_MAX);
+      assertTrue(Integer::parse(min, value).ok() && value == LONG_MIN);
+      value = 42;
+      ParseResult res = Integer::parse(over, value);
+      assertTrue(res.error == PARSE_OUT_OF_RANGE && res.end == over.end());
+      res = Integer::parse(under, value);
+      assertTrue(res.error == PARSE_OUT_OF_RANGE && res.end == under.end());
+      assertEquals<int>(42, value);
+   });
+
+   KAREN_DECL_TEST(parseDouble,
+   {
+      const char* inputs[] = { 
+         "0", "-0.5", "1234.5678", ".25", "3.", "1e10", "2.5E-3", 
+         "123456789012345678901234567890", "4.9e-324", "1.7976931348623157e308",
+         "0.1000000000000000055511151231257827", "9007199254740993",
+         "2.2250738585072011e-308", "1e22", "1e23", "123e30",
+      };
+      for (const char* input : inputs)
+      {
+         double value = -1.0;
+         StringView str(input);
+         ParseResult res = Float::parse(str, value);
+         assertTrue(res.ok() && res.end == str.end());
+         assertTrue(value == std::strtod(input, NULL));
+      }
+   });
+
+   KAREN_DECL_TEST(parseDoubleStopsAtFirstInvalidCharacter,
+   {
+      StringView str("1.5e+x");
+      double value = 0.0;
+      ParseResult res = Float::parse(str, value);
+      assertTrue(res.ok() && res.end == str.begin() + 3 && value == 1.5);
+      str = StringView("-.e1");
+      res = Float::parse(str, value);
+      assertTrue(res.error == PARSE_INVALID && res.end == str.begin());
+      assertTrue(value == 1.5);
+   });
+
+   KAREN_DECL_TEST(parseDoubleSpecialValues,
+   {
+      double value = 0.0;
+      assertTrue(Float::parse(StringView("-Infinity"), value).ok());
+      assertTrue(std::isinf(value) && value < 0.0);
+      assertTrue(Float::parse(StringView("inf"), value).ok());
+      assertTrue(std::isinf(value) && value > 0.0);
+      assertTrue(Float::parse(StringView("NaN"), value).ok());
+      assertTrue(std::isnan(value));
+      value = 0.0;
+      assertTrue(Float::parse(StringView("1e400"), value).error == 
+                 PARSE_OUT_OF_RANGE);
+      assertTrue(Float::parse(StringView("1e-400"), value).error == 
+                 PARSE_OUT_OF_RANGE);
+      assertTrue(value == 0.0);
+   });
+
+   KAREN_DECL_TEST(parseLists,
+   {
+      DynArray<long> longs;
+      ParseResult res = Integer::parseList(" 1, -22 ,333,\t4444 ", longs);
+      assertTrue(res.ok());
+      assertEquals<int>(4, longs.size());
+      assertEquals<int>(-22, longs[1]);
+      assertEquals<int>(4444, longs[3]);
+
+      DynArray<double> doubles;
+      res = Float::parseList("1.5 2.5\n3e2", doubles, ' ');
+      assertTrue(res.ok());
+      assertEquals<int>(3, doubles.size());
+      assertTrue(doubles[2] == 300.0);
+
+      assertTrue(Integer::parseList("  ", longs).ok());
+      assertEquals<int>(4, longs.size());
+   });
+
+   KAREN_DECL_TEST(parseListWithInvalidValue,
+   {
+      StringView str("1,2,,3");
+      DynArray<long> values;
+      ParseResult res = Integer::parseList(str, values);
+      assertTrue(res.error == PARSE_INVALID && res.end == str.begin() + 4);
+      assertEquals<int>(2, values.size());
+      str = StringView("1 2");
+      res = Integer::parseList(str, values);
+      assertTrue(res.error == PARSE_INVALID && res.end == str.begin() + 2);
+      str = StringView("1,");
+      res = Integer::parseList(str, values);
+      assertTrue(res.error == PARSE_INVALID && res.end == str.end());
+   });
+
+   KAREN_DECL_TEST(formatLong,
+   {
+      char buffer[Integer::FORMAT_LENGTH];
+      long values[] = { 0, 7, -10, 99, 100, 1234567, LONG_MAX, LONG_MIN };
+      for (long value : values)
+      {
+         unsigned int len = Integer::format(value, buffer);
+         assertEquals(String::format("%ld", value), String(buffer, len));
+         assertEquals(String::format("%ld", value), String::fromLong(value));
+      }
+   });
+
+   KAREN_DECL_TEST(formatShortestDouble,
+   {
+      double values[] = { 
+         0.1, 0.3, -0.0, 1.0, 100.0, 1e20, 1e21, 1e-6, 1e-7, 123.456, 
+         1.0 / 3.0, 5e-324, 1.7976931348623157e308, 1e23, 
+      };
+      const char* expected[] = { 
+         "0.1", "0.3", "-0", "1", "100", "100000000000000000000", "1e+21",
+         "0.000001", "1e-7", "123.456", "0.3333333333333333", "5e-324",
+         "1.7976931348623157e+308", "1e+23",
+      };
+      for (unsigned i = 0; i < sizeof(values) / sizeof(double); i++)
+         assertEquals(String(expected[i]), Float::toString(values[i]));
+      assertEquals(String("-inf"), Float::toString(-HUGE_VAL));
+      assertEquals(String("nan"), Float::toString(NAN));
+   });
+
+   KAREN_DECL_TEST(formatDoubleRoundTrip,
+   {
+      unsigned long long bits = 0x123456789ABCDEFULL;
+      bool roundTrip = true;
+      for (unsigned i = 0; i < 20000; i++)
+      {
+         bits = bits * 6364136223846793005ULL + 1442695040888963407ULL;
+         double value;
+         std::memcpy(&value, &bits, sizeof(value));
+         if (std::isnan(value))
+            continue;
+         char buffer[Float::FORMAT_LENGTH];
+         unsigned int len = Float::format(value, buffer);
+         double parsed = 0.0;
+         ParseResult res = Float::parse(buffer, buffer + len, parsed);
+         roundTrip = roundTrip && res.ok() && res.end == buffer + len && 
+               parsed == value && 
+               std::strtod(String(buffer, len), NULL) == value;
+      }
+      assertTrue(roundTrip);
+   });
+
+   KAREN_DECL_TEST(toLongOutOfRange,
+   {
+      try
+      {
+         Integer::toLong("99999999999999999999");
+         assertionFailed("expected InvalidConversion exception not raised");
+      }
+      catch (InvalidConversionException&) {}
+   });
+
+   KAREN_DECL_TEST(toLongWithSignAndBasePrefix,
+   {
+      assertEquals<int>(-12, Integer::toLong("  -12"));
+      assertEquals<int>(12, Integer::toLong("+12"));
+      assertEquals<int>(15, Integer::toLong("017", 0));
+      assertEquals<int>(26, Integer::toLong("0x1a", 0));
+   });
+
+KAREN_END_UNIT_TEST(NumericTestSuite);
+
 int main(int argc, char* argv[])
 {
    StdOutUnitTestReporter rep;
    StringTestSuite suite;
    suite.run(&rep, NULL, 0);
+   StringViewTestSuite viewSuite;
+   viewSuite.run(&rep, NULL, 0);
+   TokenizerTestSuite tokenizerSuite;
+   tokenizerSuite.run(&rep, NULL, 0);
+   NumericTestSuite numericSuite;
+   numericSuite.run(&rep, NULL, 0);
 }
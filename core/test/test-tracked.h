@@ -0,0 +1,48 @@
+/*
+ * ---------------------------------------------------------------------
+ * This file is part of Karen
+ *
+ * Copyright (c) 2007-2012 Alvaro Polo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  
+ * 02110-1301 USA
+ * 
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef KAREN_CORE_TEST_TRACKED_H
+#define KAREN_CORE_TEST_TRACKED_H
+
+/*
+ * Element type that counts how many times it has been copied. It is shared
+ * by the collection tests that check elements are moved rather than copied.
+ */
+static int trackedCopies = 0;
+
+struct Tracked
+{
+   int value;
+
+   Tracked(int v = 0) : value(v) {}
+   Tracked(const Tracked& t) : value(t.value) { trackedCopies++; }
+   Tracked(Tracked&& t) throw () : value(t.value) {}
+   Tracked& operator = (const Tracked& t) 
+   { value = t.value; trackedCopies++; return *this; }
+   Tracked& operator = (Tracked&& t) throw () 
+   { value = t.value; return *this; }
+   bool operator < (const Tracked& t) const { return value < t.value; }
+};
+
+#endif
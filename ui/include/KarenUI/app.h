@@ -25,6 +25,7 @@
 #ifndef KAREN_APP_H
 #define KAREN_APP_H
 
+#include <KarenCore/atom.h>
 #include <KarenCore/collection.h>
 #include <KarenCore/platform.h>
 #include <KarenCore/string.h>
@@ -42,34 +43,34 @@ public:
 
    /**
     * Application properties type. This dictionary type is used to indicate
-    * the properties of a Karen application.
+    * the properties of a Karen application, keyed by interned names.
     */
-   typedef Map<String, String> Properties;
+   typedef Map<Atom, String> Properties;
    
    /**
     * The name of the UI engine property.
     */
-   static const String UI_ENGINE_PROPERTY;
+   static const Atom UI_ENGINE_PROPERTY;
    
    /**
     * The screen width property.
     */
-   static const String SCREEN_WIDTH_PROPERTY;
+   static const Atom SCREEN_WIDTH_PROPERTY;
    
    /**
     * The screen height property.
     */
-   static const String SCREEN_HEIGHT_PROPERTY;
+   static const Atom SCREEN_HEIGHT_PROPERTY;
    
    /**
     * The fullscreen property.
     */
-   static const String FULLSCREEN_PROPERTY;
+   static const Atom FULLSCREEN_PROPERTY;
    
    /**
     * The double buffer property.
     */
-   static const String DOUBLE_BUFFER_PROPERTY;
+   static const Atom DOUBLE_BUFFER_PROPERTY;
    
    /**
     * Initialize an application object from given properties. If any property 
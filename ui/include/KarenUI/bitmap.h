@@ -25,6 +25,7 @@
 #ifndef KAREN_UI_BITMAP_H
 #define KAREN_UI_BITMAP_H
 
+#include <KarenCore/buffer-pool.h>
 #include <KarenCore/buffer.h>
 #include <KarenCore/collection.h>
 #include <KarenCore/exception.h>
@@ -94,6 +95,32 @@ public:
    Bitmap(const IVector& dims, const IVector& pitch, const PixelFormat& format) 
          throw (InvalidInputException);
          
+   /**
+    * Create a bitmap with given dimensions, pitch and format whose pixels
+    * are stored in given memory, such as a region of a mapped file. The 
+    * pixels are neither copied nor deallocated by the bitmap, so they must
+    * outlive it. If given dimensions or pitch are not valid, a 
+    * InvalidInputException is thrown.
+    */
+   Bitmap(const IVector& dims, 
+          const IVector& pitch, 
+          const PixelFormat& format,
+          void* pixels) 
+         throw (InvalidInputException);
+         
+   /**
+    * Create an empty bitmap with given dimensions, pitch and format whose
+    * pixels are borrowed from given pool and returned to it when the bitmap
+    * is destroyed. It suits scratch images created over and over, like 
+    * those of each frame. The pool must outlive the bitmap. If given 
+    * dimensions or pitch are not valid, a InvalidInputException is thrown.
+    */
+   Bitmap(const IVector& dims, 
+          const IVector& pitch, 
+          const PixelFormat& format,
+          BufferPool& pool) 
+         throw (InvalidInputException);
+         
    /**
     * Create an empty bitmap with given dimensions and format. If given
     * dimensions are not valid, a InvalidInputException is thrown.
@@ -212,6 +239,12 @@ private:
    Ptr<Buffer>   _pixels;
    LockCoordinator*     _lockCoord;
 
+   /*
+    * Check the dimensions and pitch of this bitmap, and obtain the length
+    * of the buffer its pixels take. 
+    */
+   unsigned long bufferLength() const throw (InvalidInputException);
+
 };
 
 }}; /* Namespace karen::ui */
@@ -29,6 +29,7 @@
 #include "KarenUI/draw.h"
 #include "KarenUI/euclidean.h"
 #include <KarenCore/collection.h>
+#include <KarenCore/map.h>
 #include <KarenCore/pointer.h>
 
 #if KAREN_PLATFORM == KAREN_PLATFORM_OSX
@@ -73,7 +74,7 @@ private:
        : textureName(0), bitmap(&bmp), locked(false) {}
    };      
 
-   TreeMap<const Bitmap*, Ptr<BitmapInfo>> _bitmapInfo;
+   HashMap<const Bitmap*, Ptr<BitmapInfo>> _bitmapInfo;
    
    void updateTextureName(BitmapInfo& info);
    
@@ -36,6 +36,7 @@
 #include "KarenUI/euclidean.h"
 
 using karen::DynArray;
+using karen::SmallDynArray;
 
 namespace karen { namespace ui {
 
@@ -83,11 +84,11 @@ public:
     */
    struct BezierParams
    {
-      DynArray<DVector>  points; //!< Line points
-      float          lineWidth;  //!< Bezier line width
-      float          curvature;  //!< Bezier curvature
-      float          precision;  //!< Number of segments that comprise the line
-      Color          color;      //!< Bezier line color
+      SmallDynArray<DVector, 16> points;     //!< Line points
+      float                      lineWidth;  //!< Bezier line width
+      float                      curvature;  //!< Bezier curvature
+      float                      precision;  //!< Number of segments that comprise the line
+      Color                      color;      //!< Bezier line color
    };
    
    /**
@@ -229,6 +229,19 @@ public:
    virtual void removeEventConsumer(EventConsumer* consumer)
          throw (NotFoundException) = 0;
 
+   /**
+    * Post an input event to be consumed later by the thread that calls
+    * dispatchPostedEvents(). This may be called from any thread with no
+    * locking. It returns false if too many events are pending, in which
+    * case the event is discarded. 
+    */
+   virtual bool postEvent(const Event& ev) = 0;
+
+   /**
+    * Send the posted events to all registered consumers, in the order 
+    * they were posted. It returns the number of dispatched events. 
+    */
+   virtual unsigned long dispatchPostedEvents() = 0;
 
 };
 
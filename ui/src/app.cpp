@@ -31,30 +31,26 @@ namespace karen { namespace ui {
 static Nullable<String>
 getStringProperty(
    const Application::Properties& props,
-   const String& propKey,
+   const Atom& propKey,
    const String& propName,
    bool mandatory)
 throw (InvalidInputException)
 {
    Nullable<String> res;
-   try
-   {
-      res = props.get(propKey);
-   }
-   catch (NotFoundException&)
-   {
-      if (mandatory)
-         KAREN_THROW(InvalidInputException, 
-            "cannot initialize Karen application: missing %s property", 
-            (const char*) propName);
-   }
+   const String* value = props.tryGet(propKey);
+   if (value)
+      res = *value;
+   else if (mandatory)
+      KAREN_THROW(InvalidInputException, 
+         "cannot initialize Karen application: missing %s property", 
+         (const char*) propName);
    return res;
 }
 
 static Nullable<long>
 getLongProperty(
    const Application::Properties& props,
-   const String& propKey,
+   const Atom& propKey,
    const String& propName,
    bool mandatory)
 throw (InvalidInputException)
@@ -79,7 +75,7 @@ throw (InvalidInputException)
 static Nullable<bool>
 getBoolProperty(
    const Application::Properties& props,
-   const String& propKey,
+   const Atom& propKey,
    const String& propName,
    bool mandatory)
 throw (InvalidInputException)
@@ -166,11 +162,11 @@ private:
 
 static Application* __app_instance = NULL;
 
-const String Application::UI_ENGINE_PROPERTY       ("ui-engine");
-const String Application::SCREEN_WIDTH_PROPERTY    ("screen-width");
-const String Application::SCREEN_HEIGHT_PROPERTY   ("screen-height");
-const String Application::FULLSCREEN_PROPERTY      ("fullscreen");
-const String Application::DOUBLE_BUFFER_PROPERTY   ("double-buffer");
+const Atom Application::UI_ENGINE_PROPERTY       ("ui-engine");
+const Atom Application::SCREEN_WIDTH_PROPERTY    ("screen-width");
+const Atom Application::SCREEN_HEIGHT_PROPERTY   ("screen-height");
+const Atom Application::FULLSCREEN_PROPERTY      ("fullscreen");
+const Atom Application::DOUBLE_BUFFER_PROPERTY   ("double-buffer");
 
 Application&
 Application::init(const Properties& props)
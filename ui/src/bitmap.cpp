@@ -26,6 +26,7 @@
 
 #include "KarenUI/bitmap.h"
 #include <KarenCore/exception.h>
+#include <KarenCore/map.h>
 
 namespace karen { namespace ui {
 
@@ -111,8 +112,8 @@ public:
 
    inline virtual bool isLocked(const Bitmap& bmp) const
    {
-      try { return _locks.get(&bmp); }
-      catch (NotFoundException&) { return false; }
+      const bool* locked = _locks.tryGet(&bmp);
+      return locked && *locked;
    }
    
    inline virtual void lock(const Bitmap& bmp)
@@ -129,7 +130,7 @@ public:
 
 private:
 
-   TreeMap<const Bitmap*, bool> _locks;
+   HashMap<const Bitmap*, bool> _locks;
    
    inline DefaultLockCoordinator() {}
 
@@ -217,15 +218,31 @@ Bitmap::Bitmap(const IVector& dims,
 throw (InvalidInputException)
  : _size(dims), _pitch(pitch), _format(format), _pixels(NULL), _lockCoord(NULL)
 {
-   if (pitch.x < dims.x || pitch.y < dims.y)
-      KAREN_THROW(InvalidInputException, 
-         "cannot initialize image object: invalid pitch as input");
-   unsigned long npixels = pitch.x * pitch.y;
-   if (npixels <= 0)
-      KAREN_THROW(InvalidInputException, 
-         "cannot initialize image object: invalid dimensions as input");
-   unsigned long buflen = npixels * format.bytesPerPixel();
-   _pixels = new Buffer(buflen);
+   _pixels = new Buffer(bufferLength());
+   
+   setLockCoordinator(&DefaultLockCoordinator::instance());
+}
+
+Bitmap::Bitmap(const IVector& dims, 
+               const IVector& pitch, 
+               const PixelFormat& format,
+               void* pixels)
+throw (InvalidInputException)
+ : _size(dims), _pitch(pitch), _format(format), _pixels(NULL), _lockCoord(NULL)
+{
+   _pixels = new Buffer(pixels, bufferLength(), NULL);
+   
+   setLockCoordinator(&DefaultLockCoordinator::instance());
+}
+
+Bitmap::Bitmap(const IVector& dims, 
+               const IVector& pitch, 
+               const PixelFormat& format,
+               BufferPool& pool)
+throw (InvalidInputException)
+ : _size(dims), _pitch(pitch), _format(format), _pixels(NULL), _lockCoord(NULL)
+{
+   _pixels = new Buffer(pool, bufferLength());
    
    setLockCoordinator(&DefaultLockCoordinator::instance());
 }
@@ -284,6 +301,20 @@ Bitmap::operator = (Bitmap&& bmp)
    return *this;
 }
 
+unsigned long
+Bitmap::bufferLength() const
+throw (InvalidInputException)
+{
+   if (_pitch.x < _size.x || _pitch.y < _size.y)
+      KAREN_THROW(InvalidInputException, 
+         "cannot initialize image object: invalid pitch as input");
+   unsigned long npixels = _pitch.x * _pitch.y;
+   if (npixels <= 0)
+      KAREN_THROW(InvalidInputException, 
+         "cannot initialize image object: invalid dimensions as input");
+   return npixels * _format.bytesPerPixel();
+}
+
 void
 Bitmap::setLockCoordinator(LockCoordinator* lockCoord)
 {
@@ -65,37 +65,33 @@ throw (InvalidInputException)
 bool
 GLTextureStore::isLocked(const Bitmap& bmp) const
 {
-   try { return _bitmapInfo.get(&bmp)->locked; }
-   catch (NotFoundException&) { return false; }
+   const Ptr<BitmapInfo>* info = _bitmapInfo.tryGet(&bmp);
+   return info && (*info)->locked;
 }
 
 void
 GLTextureStore::lock(const Bitmap& bmp)
 {
-   try
-   {
-      Ptr<BitmapInfo>& info = _bitmapInfo.get(&bmp);
-      info->locked = true;
-   }
-   catch (NotFoundException&) {}
+   Ptr<BitmapInfo>* info = _bitmapInfo.tryGet(&bmp);
+   if (info)
+      (*info)->locked = true;
 }
 
 void
 GLTextureStore::unlock(const Bitmap& bmp)
 {
-   try
+   Ptr<BitmapInfo>* info = _bitmapInfo.tryGet(&bmp);
+   if (info)
    {
-      Ptr<BitmapInfo>& info = _bitmapInfo.get(&bmp);
-      info->locked = false;
-      updateTextureName(*info);
+      (*info)->locked = false;
+      updateTextureName(**info);
    }
-   catch (NotFoundException&) {}
 }
 
 void
 GLTextureStore::onBind(const Bitmap& bmp)
 {
-   Ptr<BitmapInfo> info = new BitmapInfo(bmp);
+   Ptr<BitmapInfo> info = makePtr<BitmapInfo>(bmp);
    _bitmapInfo.put(&bmp, info);
    updateTextureName(*info);
 }
@@ -103,25 +99,19 @@ GLTextureStore::onBind(const Bitmap& bmp)
 void
 GLTextureStore::onDispose(const Bitmap& bmp)
 {
-   try
+   Ptr<BitmapInfo>* info = _bitmapInfo.tryGet(&bmp);
+   if (info)
    {
-      Ptr<BitmapInfo>& info(_bitmapInfo.get(&bmp));
-      releaseTextureName(*info);
+      releaseTextureName(**info);
       _bitmapInfo.remove(&bmp);
-
    }
-   catch (NotFoundException&) {}   
 }
 
 GLint
 GLTextureStore::textureName(const Bitmap& bmp)
 {
-   try
-   {
-      Ptr<BitmapInfo>& info(_bitmapInfo.get(&bmp));
-      return info->textureName;
-   }
-   catch (NotFoundException&) { return 0; }   
+   const Ptr<BitmapInfo>* info = _bitmapInfo.tryGet(&bmp);
+   return info ? (*info)->textureName : 0;
 }
 
 void
@@ -317,7 +307,7 @@ OpenGLCanvas::drawBezier(const BezierParams& line)
                ctrl1 == bc.ctrl1 && ctrl2 == bc.ctrl2; }
    };
    
-   DynArray<BezierCurve> curves(numPoints - 1);
+   SmallDynArray<BezierCurve, 16> curves(numPoints - 1);
    for (int i = 0; i < numPoints - 1; i++)
    {
       curves[i].orig = line.points[i];
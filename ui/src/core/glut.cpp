@@ -26,6 +26,7 @@
 #include "KarenUI/core/gl.h"
 #include "KarenUI/core/glut.h"
 #include <KarenCore/collection.h>
+#include <KarenCore/queue.h>
 #include <KarenCore/timing.h>
 
 #include <GLUT/GLUT.h>
@@ -72,10 +73,15 @@ private:
       double         timestamp;      
    };
    
+   /*
+    * A timer is less than another when it expires later, so the head of
+    * the queue is the timer that expires first.
+    */
    struct TimerInfoLessThan
    {
-      inline bool operator () (const TimerInfo& lhs, const TimerInfo& rhs)
-      { return (lhs.timestamp + lhs.ms) < (rhs.timestamp + rhs.ms); }
+      inline bool operator () (const TimerInfo& lhs, 
+                               const TimerInfo& rhs) const
+      { return (lhs.timestamp + lhs.ms) > (rhs.timestamp + rhs.ms); }
    };
    
    static void glutHandler(int val)
@@ -97,7 +103,8 @@ private:
    }
    
    static GlutTimer* _instance;
-   PriorityQueue<TimerInfo, TimerInfoLessThan> _callbacks;
+   PriorityQueue<TimerInfo, TimerInfoLessThan, 
+         DaryHeap<TimerInfo, TimerInfoLessThan> > _callbacks;
 
 };
 
@@ -25,6 +25,7 @@
 #include "KarenUI/event.h"
 
 #include <KarenCore/collection.h>
+#include <KarenCore/concurrent-queue.h>
 
 namespace karen { namespace ui {
 
@@ -62,9 +63,11 @@ class EventChannelImpl : public EventChannel
 {
 public:
 
+   EventChannelImpl() : _postedEvents(POSTED_EVENTS_CAPACITY) {}
+
    virtual void consumeEvent(const Event& ev)
    {
-      for (auto c : _consumers)
+      for (auto c : _consumers.fast())
          c->consumeEvent(ev);
    }
 
@@ -86,15 +89,39 @@ public:
       _consumers.removeAll(consumer);
    }
 
+   virtual bool postEvent(const Event& ev)
+   { return _postedEvents.tryPut(ev); }
+
+   virtual unsigned long dispatchPostedEvents()
+   {
+      Event evs[DISPATCH_BATCH_SIZE];
+      unsigned long total = 0;
+      unsigned long n;
+      while ((n = _postedEvents.pollMany(evs, DISPATCH_BATCH_SIZE)) > 0)
+      {
+         for (unsigned long i = 0; i < n; i++)
+            consumeEvent(evs[i]);
+         total += n;
+      }
+      return total;
+   }
+
 private:
 
+   enum
+   {
+      POSTED_EVENTS_CAPACITY = 1024,
+      DISPATCH_BATCH_SIZE = 32,
+   };
+
    LinkedList<EventConsumer*> _consumers;
+   ConcurrentQueue<Event> _postedEvents;
 
 };
 
 Ptr<EventChannel>
 EventChannel::newInstance()
-{ return new EventChannelImpl(); }
+{ return makePtr<EventChannelImpl>(); }
 
 void
 EventResponder::respondToMouseButtonPressed(
@@ -71,7 +71,7 @@ throw (InvalidInputException)
       KAREN_THROW(InvalidInputException, 
         "cannot add widget to container: widget already has a parent");
    
-   for (auto child : _children)
+   for (auto& child : _children.fast())
       if (child.widget == widget)
          KAREN_THROW(InvalidInputException, 
          "cannot add widget to container: widget already added");
@@ -109,7 +109,7 @@ GridContainer::activateWidgetAtPos(const IVector& localPos)
 void
 GridContainer::draw(Canvas& canvas)
 {
-   for (auto child : _children)
+   for (auto& child : _children.fast())
       child.widget->draw(canvas);
 }
 
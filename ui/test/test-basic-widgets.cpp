@@ -42,7 +42,7 @@ int main(int argc, char* argv[])
 {
    try
    {
-      TreeMap<String, String> props;
+      AtomMap<String> props;
       props.put(Application::UI_ENGINE_PROPERTY,
                    "karen.core.cocoa-engine");
       props.put(Application::SCREEN_WIDTH_PROPERTY,